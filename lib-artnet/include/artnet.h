@@ -125,7 +125,7 @@ enum TArtNetNodeReportCode {
 /**
  * Merge is implemented in either LTP or HTP mode as specified by the ArtAddress packet.
  */
-enum TMerge {
+enum TArtNetMerge {
 	ARTNET_MERGE_HTP,		///< Highest Takes Precedence (HTP)
 	ARTNET_MERGE_LTP		///< Latest Takes Precedence (LTP)
 };
@@ -32,6 +32,7 @@
 #ifndef ARTNETCONTROLLER_H_
 #define ARTNETCONTROLLER_H_
 
+#include <stdint.h>
 #include <time.h>
 
 #include "packets.h"
@@ -39,6 +40,26 @@
 #include "artnetpolltable.h"
 #include "artnetipprog.h"
 
+enum {
+	ARTNET_CONTROLLER_MAX_UNIVERSES = 1024,		///< Default size of the universe table
+	ARTNET_CONTROLLER_MAX_UNICAST = 8,			///< More subscribers to a universe than this and its ArtDmx is broadcast
+	ARTNET_CONTROLLER_DEFAULT_FPS = 44			///< Default frame rate
+};
+
+#define ARTNET_CONTROLLER_UNIVERSE_NONE		0xFFFF	///< Port-Address not in the universe table
+
+/**
+ * A universe sent by the controller. The ArtDmx is built in place.
+ */
+struct TArtNetControllerUniverse {
+	struct TArtDmx ArtDmx;								///< Data holds the latest DMX data
+	uint16_t nLength;									///< Length of the DMX data
+	uint32_t nMillis;									///< The latest time the ArtDmx was sent
+	bool IsDataChanged;									///< Changed since the latest ArtDmx
+	uint8_t nDestinations;								///< Unicast destinations, 0 is broadcast
+	uint32_t Destinations[ARTNET_CONTROLLER_MAX_UNICAST];	///< Subscribers from the poll table
+};
+
 class ArtNetController: public ArtNetPollTable {
 public:
 	ArtNetController(void);
@@ -54,20 +75,55 @@ public:
 
 	void SendIpProg(const uint32_t, const struct TArtNetIpProg *);
 
+	bool SetData(uint16_t, const uint8_t *, uint16_t);
+
+	void SetMaxUniverses(uint16_t);
+	uint16_t GetMaxUniverses(void) const;
+	uint16_t GetUniverses(void) const;
+
+	void SetFps(uint8_t);
+	uint8_t GetFps(void) const;
+
+	void SetKeepAlive(uint16_t);
+	uint16_t GetKeepAlive(void) const;
+
+	void SetSynchronous(bool);
+	bool IsSynchronous(void) const;
+
 private:
 	void SendPoll(void);
 	void HandlePollReply(void);
 	void SendIpProg(void);
 	void HandleIpProgReply(void);
 
+	void HandleTransmit(void);
+	void SendUniverse(uint16_t, uint32_t);
+	void SendSync(void);
+	void UpdateDestinations(uint16_t);
+
 private:
 	struct TArtNetPacket	*m_pArtNetPacket;
 	struct TArtPoll			m_ArtNetPoll;
 	struct TArtIpProg 		m_ArtIpProg;
-	time_t 					m_nLastPollTime;
+	uint32_t				m_nLastPollMillis;
+	uint32_t				m_nPollIntervalMillis;	///< Fast while the node population is changing, else m_nPollInterVal
+	uint32_t				m_nPollChanges;			///< m_nChanges at the latest poll
+	uint8_t					m_nPollStable;			///< Polls without changes
 	uint32_t				m_IPAddressLocal;
 	uint32_t				m_IPAddressBroadcast;
 	uint8_t					m_nPollInterVal;
+	struct TArtNetControllerUniverse *m_pUniverses;	///< Allocated with the first SetData, m_nMaxUniverses entries
+	uint16_t				*m_pUniverseIndex;		///< Port-Address to index in m_pUniverses
+	uint16_t				m_nMaxUniverses;
+	uint16_t				m_nUniverses;
+	uint16_t				m_nFrameIndex;			///< Next universe of the current frame
+	uint16_t				m_nFrameDmxCount;		///< ArtDmx sent in the current frame
+	bool					m_IsFrameActive;
+	bool					m_IsSynchronous;		///< Close each frame with ArtSync
+	uint8_t					m_nFps;
+	uint16_t				m_nKeepAliveMillis;		///< Resend unchanged universes
+	uint32_t				m_nFrameMillis;			///< Start of the current frame
+	struct TArtSync			m_ArtSync;
 };
 
 #endif /* ARTNETCONTROLLER_H_ */
@@ -0,0 +1,50 @@
+/**
+ * @file artnetdiscovery.h
+ *
+ */
+/**
+ * Art-Net Designed by and Copyright Artistic Licence Holdings Ltd.
+ *
+ * Art-Net 3 Protocol Release V1.4 Document Revision 1.4bk 23/1/2016
+ *
+ */
+/* Copyright (C) 2018 by Arjan van Vught mailto:info@raspberrypi-dmx.nl
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef ARTNETDISCOVERY_H_
+#define ARTNETDISCOVERY_H_
+
+struct TArtNetNodeEntry;
+
+/**
+ * Changes of the node population seen by the controller.
+ * The entry is only valid during the call.
+ */
+class ArtNetDiscovery {
+public:
+	virtual ~ArtNetDiscovery(void);
+
+	virtual void Added(const struct TArtNetNodeEntry *)= 0;		///< The first ArtPollReply of a node, or of a page of a node
+	virtual void Removed(const struct TArtNetNodeEntry *)= 0;	///< No ArtPollReply within the expiry time
+	virtual void Changed(const struct TArtNetNodeEntry *)= 0;	///< Names, status, output Port-Addresses or ArtIpProgReply have changed
+};
+
+#endif /* ARTNETDISCOVERY_H_ */
@@ -46,10 +46,14 @@
 #include "common.h"
 
 #include "lightset.h"
+#include "dmxkernel.h"
+#include "dmxmerge.h"
+#include "dmxlosspolicy.h"
 #include "ledblink.h"
 
 #include "artnettimecode.h"
 #include "artnettimesync.h"
+#include "artnettrigger.h"
 #include "artnetrdm.h"
 #include "artnetipprog.h"
 
@@ -64,20 +68,50 @@ struct TArtNetNodeState {
 	TArtNetNodeReportCode reportCode;			///< See \ref TArtNetNodeReportCode
 	TNodeStatus status;							///< See \ref TNodeStatus
 	bool IsSynchronousMode;						///< ArtSync received
-	time_t ArtSyncTime;							///< Latest ArtSync received time
-	bool IsMergeMode;							///< Is the Node in merging mode?
+	uint32_t ArtSyncMillis;						///< Latest ArtSync received time
+	bool IsFramePending;						///< An ArtDMX is received since the latest frame commit
+	uint32_t FramePendingMillis;				///< Time of the first ArtDMX of the pending frame
+	uint8_t nFrameDmxCount;						///< Number of ArtDMX received for the pending frame
 	bool IsChanged;								///< Is the DMX changed? Update output DMX
+	bool IsPollReplyPending;					///< ArtPoll received, the ArtPollReply is delayed by a random back-off
+	uint32_t PollReplyMillis;					///< Time to send the pending ArtPollReply
 	uint8_t nActivePorts;						///< Number of active ports
+	uint8_t nActiveInputPorts;					///< Number of active input ports
 	time_t nNetworkDataLossTimeout;				///<
 };
 
+struct TArtNetSyncStats {
+	uint32_t nFramesSync;						///< Frames committed by ArtSync
+	uint32_t nFramesFallback;					///< Frames committed without ArtSync : frame deadline, missed ArtSync or synchronous mode timeout
+	uint16_t nSyncIntervalMillis;				///< Average time between ArtSync packets
+	uint8_t nDmxPerFrame;						///< Number of ArtDMX in the latest frame committed by ArtSync
+};
+
+enum {
+	ARTNET_LATENCY_BINS = 20			///< Bin k counts the latencies from 2^k up to 2^(k+1) - 1 microseconds, the last bin also counts all above
+};
+
+/**
+ * Per output port counters. Only the node writes them. Each counter is an aligned 32-bit word,
+ * so a reader in another context gets a consistent value per counter without a lock.
+ */
+struct TArtNetPortStats {
+	uint32_t nDmx;						///< ArtDMX received
+	uint32_t nDmxPerSecond;				///< ArtDMX received during the latest second
+	uint32_t nDiscarded;				///< ArtDMX discarded : the source table is full
+	uint32_t nMerges;					///< A second source started a merge
+	uint32_t nSyncMissed;				///< The port was part of a frame committed without ArtSync
+	uint32_t nOutputs;					///< LightSet SetData calls
+	uint32_t nLatency[ARTNET_LATENCY_BINS];	///< log2 histogram of the time from receiving the ArtDMX until SetData returns
+};
+
 struct TArtNetNode {
 	uint8_t MACAddressLocal[ARTNET_MAC_SIZE];		///< The local MAC Address
 	uint32_t IPAddressLocal;						///< Local IP Address
 	uint32_t IPAddressBroadcast;					///< The broadcast IP Address
 	uint32_t IPSubnetMask;							///< The subnet mask
-	uint8_t  NetSwitch;								///< Bits 14-8 of the 15 bit Port-Address are encoded into the bottom 7 bits of this field.
-	uint8_t  SubSwitch;								///< Bits 7-4 of the 15 bit Port-Address are encoded into the bottom 4 bits of this field.
+	uint8_t  NetSwitch[ARTNET_MAX_PAGES];			///< Per page : Bits 14-8 of the 15 bit Port-Address are encoded into the bottom 7 bits of this field.
+	uint8_t  SubSwitch[ARTNET_MAX_PAGES];			///< Per page : Bits 7-4 of the 15 bit Port-Address are encoded into the bottom 4 bits of this field.
 	uint8_t  Oem[2];								///< The Oem word describes the equipment vendor and the feature set available.
 	uint8_t  ShortName[ARTNET_SHORT_NAME_LENGTH];	///< The array represents a null terminated short name for the Node.
 	uint8_t  LongName[ARTNET_LONG_NAME_LENGTH];		///< The array represents a null terminated long name for the Node.
@@ -95,23 +129,61 @@ struct TGenericPort {
 };
 
 struct TOutputPort {
-	uint8_t data[ARTNET_DMX_LENGTH];	///< Data sent
-	uint16_t nLength;					///< Length of sent DMX data
-	uint8_t dataA[ARTNET_DMX_LENGTH];	///< The data received from Port A
-	time_t timeA;						///< The latest time of the data received from Port A
-	uint32_t ipA;						///< The IP address for port A
-	uint8_t dataB[ARTNET_DMX_LENGTH];	///< The data received from Port B
-	time_t timeB;						///< The latest time of the data received from Port B
-	uint32_t ipB;						///< The IP address for Port B
-	TMerge mergeMode;					///< \ref TMerge
+	DmxMerge merge;						///< The sources and the data sent, \ref DmxMerge
+	struct TDmxSlotRange tDirty;		///< Slots changed since the latest output
+	bool IsMergeCancel;					///< ArtAddress cancel merge : the next ArtDMX source becomes the only source
 	bool IsDataPending;					///< ArtDMX received and waiting for ArtSync
+	bool IsInFrame;						///< ArtDMX received for the pending frame
+	bool IsStartCodeOutput;				///< The output holds ArtNzs data, the DMX data must be sent again
+	bool bIsEnabled;					///< Is the port enabled ?
+	TGenericPort port;					///< \ref TGenericPort
+	uint8_t nNextPortIndex;				///< Next port in the same Port-Address hash bucket
+	uint32_t nDataMicros;				///< Receive time of the ArtDMX waiting for output
+	uint32_t nDmxPrevious;				///< tStats.nDmx at the start of the current second
+	struct TArtNetPortStats tStats;		///< \ref TArtNetPortStats
+};
+
+struct TInputPort {
+	struct TArtDmx ArtDmx;				///< The ArtDmx packet, built in place : Data holds the latest DMX input
+	uint16_t nLength;					///< Length of the DMX input
+	uint32_t nMillis;					///< The latest time an ArtDmx was sent
+	bool IsDataPending;					///< DMX input changed, held back by the rate limit
 	bool bIsEnabled;					///< Is the port enabled ?
 	TGenericPort port;					///< \ref TGenericPort
 };
 
+/**
+ * The input ports unicast ArtDmx to the controllers sending ArtPoll
+ * and to the nodes reporting an output port with the same Port-Address in ArtPollReply.
+ * Without subscribers ArtDmx is broadcast.
+ */
+struct TArtNetSubscriber {
+	uint32_t nIPAddress;				///< Destination of the ArtDmx
+	uint16_t nPortAddress;				///< Subscribed Port-Address, not used for a controller
+	bool IsController;					///< ArtPoll sender, subscribed to all input ports
+	uint32_t nMillis;					///< The latest time the ArtPoll or ArtPollReply was received
+};
+
+enum {
+	ARTNET_MAX_SUBSCRIBERS = 16			///< Size of the subscriber table
+};
+
+enum {
+	ARTNET_MAX_BATCH = 32				///< Maximum number of packets received by one HandlePackets call
+};
+
+/**
+ * Port-Address to output port lookup.
+ * The 15 bit Port-Address is hashed on its low bits. Ports sharing a bucket (or a Port-Address) are chained.
+ */
+enum {
+	ARTNET_PORT_ADDRESS_HASH_SIZE = 64,		///< Must be a power of 2, not less than ARTNET_MAX_PAGES * ARTNET_MAX_PORTS
+	ARTNET_PORT_INDEX_NONE = 0xFF			///< End of a port chain
+};
+
 class ArtNetNode {
 public:
-	ArtNetNode(void);
+	ArtNetNode(uint8_t nPages = 1);
 	~ArtNetNode(void);
 
 	void SetOutput(LightSet *);
@@ -119,6 +191,7 @@ public:
 
 	void SetTimeCodeHandler(ArtNetTimeCode *);
 	void SetTimeSyncHandler(ArtNetTimeSync *);
+	void SetTriggerHandler(ArtNetTrigger *);
 	void SetRdmHandler(ArtNetRdm *, bool isResponder = false);
 	void SetIpProgHandler(ArtNetIpProg *);
 
@@ -139,11 +212,17 @@ public:
 	uint8_t GetUniverseSwitch(uint8_t) const;
 	int SetUniverseSwitch(uint8_t, TArtNetPortDir, uint8_t);
 
-	uint8_t GetNetSwitch(void) const;
-	void SetNetSwitch(uint8_t);
+	uint8_t GetNetSwitch(uint8_t nPage = 0) const;
+	void SetNetSwitch(uint8_t, uint8_t nPage = 0);
+
+	uint8_t GetSubnetSwitch(uint8_t nPage = 0) const;
+	void SetSubnetSwitch(uint8_t, uint8_t nPage = 0);
+
+	uint8_t GetPages(void) const;
+	uint8_t GetPorts(void) const;
 
-	uint8_t GetSubnetSwitch(void) const;
-	void SetSubnetSwitch(uint8_t);
+	uint32_t GetMemoryPerPort(void) const;
+	uint32_t GetMemoryUsed(void) const;
 
 	const uint8_t *GetManufacturerId(void);
 	void SetManufacturerId(const uint8_t *);
@@ -154,43 +233,102 @@ public:
 	time_t GetNetworkTimeout(void) const;
 	void SetNetworkTimeout(time_t);
 
+	uint32_t GetNetworkTimeoutMillis(void) const;
+	void SetNetworkTimeoutMillis(uint32_t);
+
+	TDmxLossPolicy GetLossPolicy(void) const;
+	void SetLossPolicy(TDmxLossPolicy, uint32_t nFadeMillis = DMX_LOSS_POLICY_FADE_MILLIS);
+	bool SetLossPreset(uint8_t, const uint8_t *, uint16_t);
+
+	uint16_t GetFrameDeadline(void) const;
+	void SetFrameDeadline(uint16_t);
+
+	uint16_t GetSyncTimeout(void) const;
+	void SetSyncTimeout(uint16_t);
+
+	void GetSyncStats(struct TArtNetSyncStats &) const;
+
+	uint32_t GetPacketsInvalid(void) const;
+
+	int GetPortStats(uint8_t, struct TArtNetPortStats &) const;
+	void ClearPortStats(void);
+	void SendPortStats(void);
+
+	uint16_t GetPortStatsInterval(void) const;
+	void SetPortStatsInterval(uint16_t);
+
 	uint8_t GetActiveOutputPorts(void) const;
 	uint8_t GetActiveInputPorts(void) const;
 
 	void SendDiag(const char *, TPriorityCodes);
 	void SendTimeCode(const struct TArtNetTimeCode *);
 
+	void SendDmx(uint8_t, const uint8_t *, uint16_t);
+
+	uint16_t GetInputKeepAlive(void) const;
+	void SetInputKeepAlive(uint16_t);
+
+	uint16_t GetInputMinInterval(void) const;
+	void SetInputMinInterval(uint16_t);
+
+	uint16_t GetPollReplyBackoff(void) const;
+	void SetPollReplyBackoff(uint16_t);
+
 	int HandlePacket(void);
+	int HandlePackets(uint16_t nMaxBatch = ARTNET_MAX_BATCH);
+
+	// When the datagrams are received by the caller
+	int HandleDatagram(const uint8_t *, uint16_t, uint32_t, uint16_t);
+	void HandleTimers(void);
 
 private:
+	int HandleReceived(void);
 	void GetType(void);
 
-	void FillPollReply(void);
+	void FillPollReply(uint8_t);
+	void InvalidatePollReply(uint8_t);
 	void FillDiagData(void);
 	void FillTimeCodeData(void);
 
-	uint16_t MakePortAddress(uint16_t);
+	uint16_t MakePortAddress(uint16_t, uint8_t nPage = 0);
 
 	void HandlePoll(void);
+	void HandlePollReply(void);
 	void HandleDmx(void);
+	void HandleNzs(void);
 	void HandleSync(void);
 	void HandleAddress(void);
 	void HandleTimeCode(void);
 	void HandleTimeSync(void);
+	void HandleTrigger(void);
 	void HandleTodRequest(void);
 	void HandleTodControl(void);
 	void HandleRdm(void);
 	void HandleIpProg(void);
 
-	bool IsMergedDmxDataChanged(uint8_t, const uint8_t *, uint16_t);
-	void CheckMergeTimeouts(uint8_t);
-	bool IsDmxDataChanged(uint8_t, const uint8_t *, uint16_t);
+	void HandleDmxPort(uint8_t, const uint8_t *, uint16_t);
+	void UpdatePortAddressMap(void);
+
+	void UpdateMergeStatus(uint8_t);
+	void SendPortData(uint8_t);
+	void CommitFrame(bool);
+	void CheckFrameTimeouts(void);
 
 	void SendPollRelply(bool);
+	void SchedulePollReply(void);
+	void FormatNodeReport(char *) const;
+	uint32_t Random(void);
 	void SendTod(void);
 
 	void SetNetworkDataLossCondition(void);
 
+	void UpdateLatency(uint8_t);
+	void UpdatePortStats(void);
+
+	void SendInputPort(uint8_t, uint32_t);
+	void CheckInputPorts(void);
+	void AddSubscriber(uint32_t, uint16_t, bool);
+
 private:
 	LightSet    			*m_pLightSet;		///<
 	LedBlink				*m_pLedBlink;		///<
@@ -199,25 +337,49 @@ private:
 	ArtNetTimeSync			*m_pArtNetTimeSync;	///<
 	ArtNetRdm				*m_pArtNetRdm;		///<
 	ArtNetIpProg			*m_pArtNetIpProg;	///<
-	//ArtNetTrigger			*m_pArtNetTrigger;	///<
+	ArtNetTrigger			*m_pArtNetTrigger;	///<
 
 	struct TArtNetNode		m_Node;				///< Struct describing the node
 	struct TArtNetNodeState m_State;			///< The current state of the node
 
 	struct TArtNetPacket 	m_ArtNetPacket;		///< The received Art-Net package
-	struct TArtPollReply	m_PollReply;		///<
+	struct TArtNetPacket	*m_pArtNetPacket;	///< The package being handled : m_ArtNetPacket or an entry of m_pBatchPackets
+	struct TArtNetPacket	*m_pBatchPackets;	///< HandlePackets : ARTNET_MAX_BATCH receive buffers, allocated at the first call
+	struct TNetworkDatagram	*m_pBatchDatagrams;	///< HandlePackets : one per receive buffer
+	struct TArtPollReply	*m_pPollReplies;	///< Per page ArtPollReply template
+	uint16_t				m_nPollReplyInvalid;	///< Bit per page : the template must be rebuilt before it is sent
 	struct TArtDiagData		m_DiagData;			///<
 	struct TArtTimeCode		m_TimeCodeData;		///<
 	struct TArtTodData		*m_pTodData;		///<
 	struct TArtIpProgReply	*m_pIpProgReply;	///<
 
-	struct TOutputPort		m_OutputPorts[ARTNET_MAX_PORTS];	///<
+	uint8_t					m_nPages;			///< Number of pages, each page has ARTNET_MAX_PORTS ports
+	uint8_t					m_nPorts;			///< m_nPages * ARTNET_MAX_PORTS
+	struct TOutputPort		*m_pOutputPorts;	///< Pool of m_nPorts output ports
+	uint8_t					m_PortAddressHash[ARTNET_PORT_ADDRESS_HASH_SIZE];	///< First port index per bucket, \ref ARTNET_PORT_INDEX_NONE when empty
+
+	struct TInputPort		*m_pInputPorts;		///< Pool of m_nPorts input ports, allocated when the first input port is enabled
+	struct TArtNetSubscriber m_Subscribers[ARTNET_MAX_SUBSCRIBERS];	///<
+	uint8_t					m_nSubscribers;		///< Used entries of m_Subscribers
+	uint16_t				m_nInputKeepAliveMillis;	///< Resend unchanged DMX input
+	uint16_t				m_nInputMinIntervalMillis;	///< Minimum time between two ArtDmx of an input port
 
 	bool					m_bDirectUpdate;
+	uint16_t				m_nFrameDeadlineMillis;	///< Synchronous mode : commit a pending frame when no ArtSync is received in time, 0 = wait for ArtSync
+	uint16_t				m_nSyncTimeoutMillis;	///< Leave synchronous mode when no ArtSync is received in time
+	struct TArtNetSyncStats	m_SyncStats;		///<
+
+	uint16_t				m_nPollReplyBackoffMillis;	///< Maximum random delay of the ArtPollReply to an ArtPoll, 0 = reply immediately
+	uint32_t				m_nRandom;			///< Back-off pseudo random generator state
+
+	uint32_t				m_nStatsMillis;		///< Start of the current statistics second
+	uint16_t				m_nStatsInterval;	///< Send the port statistics as ArtDiagData every m_nStatsInterval seconds, 0 = disabled
+	uint16_t				m_nStatsSeconds;	///< Seconds since the latest port statistics ArtDiagData
+	uint32_t				m_nPacketsInvalid;	///< Art-Net packets too short for their OpCode
 
-	time_t 					m_nCurrentPacketTime;
-	time_t					m_nPreviousPacketTime;
-	TOpCodes				m_tOpCodePrevious;
+	uint32_t				m_nCurrentPacketMillis;
+	uint32_t				m_nCurrentPacketMicros;
+	DmxLossPolicy			m_LossPolicy;		///< Network data loss, checked with every \ref HandleTimers
 
 	bool					m_IsLightSetRunning;
 	bool					m_IsRdmResponder;
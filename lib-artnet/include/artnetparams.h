@@ -65,6 +65,8 @@ public:
 	TOutputType GetOutputType(void) const;
 	const uint8_t *GetManufacturerId(void) const;
 	time_t GetNetworkTimeout(void) const;
+	uint16_t GetFrameDeadline(void) const;
+	uint16_t GetSyncTimeout(void) const;
 
 	bool IsUseTimeCode(void) const;
 	bool IsUseTimeSync(void) const;
@@ -104,6 +106,8 @@ private:
 	uint8_t m_aManufacturerId[2];
 	uint8_t m_aOemValue[2];
 	time_t m_nNetworkTimeout;
+	uint16_t m_nFrameDeadline;
+	uint16_t m_nSyncTimeout;
 };
 
 #endif /* ARTNETPARAMS_H_ */
@@ -39,6 +39,17 @@
 #include "common.h"
 #include "packets.h"
 
+#include "artnetdiscovery.h"
+
+enum {
+	ARTNET_POLL_TABLE_SIZE = 1024,				///< Maximum number of entries, one per IP address and BindIndex
+	ARTNET_POLL_TABLE_HASH_SIZE = 1024,			///< Buckets of the IP address hash, a power of 2
+	ARTNET_POLL_TABLE_PORT_HASH_SIZE = 1024,	///< Buckets of the Port-Address index, a power of 2
+	ARTNET_POLL_TABLE_EXPIRY_SECONDS = 30		///< Default time after the latest ArtPollReply before a node is removed
+};
+
+#define ARTNET_POLL_TABLE_NONE	0xFFFF
+
 struct TIpProg {
 	uint32_t IPAddress;
 	uint32_t SubMask;
@@ -47,6 +58,7 @@ struct TIpProg {
 
 struct TArtNetNodeEntry {
 	uint32_t IPAddress;
+	uint8_t  BindIndex;									///< Pages of a node have the same IP address and a different BindIndex
 	uint8_t  Mac[ARTNET_MAC_SIZE];
 	uint8_t  ShortName[ARTNET_SHORT_NAME_LENGTH];
 	uint8_t  LongName[ARTNET_LONG_NAME_LENGTH];
@@ -54,6 +66,17 @@ struct TArtNetNodeEntry {
 	uint8_t  Status2;
 	time_t	 LastUpdate;
 	struct TIpProg IpProg;
+	uint8_t  nOutputPorts;								///< Number of valid entries in OutputPortAddress
+	uint16_t OutputPortAddress[ARTNET_MAX_PORTS];		///< The Port-Address of each output port
+};
+
+/**
+ * The chains of an entry : the IP address hash bucket, and per output port the Port-Address index bucket.
+ * A port link is (entry << 2) | port.
+ */
+struct TArtNetPollTableLinks {
+	uint16_t nNext;
+	uint16_t nNextPort[ARTNET_MAX_PORTS];
 };
 
 class ArtNetPollTable {
@@ -62,18 +85,44 @@ public:
 	~ArtNetPollTable(void);
 
 	bool isChanged(void);
-	const uint8_t GetEntries(void);
-	bool GetEntry(const uint8_t, struct TArtNetNodeEntry *);
+	uint16_t GetEntries(void) const;
+	bool GetEntry(uint16_t, struct TArtNetNodeEntry *) const;
 
 	bool Add(const struct TArtPollReply *);
 	bool Add(const struct TArtIpProgReply *);
 
+	uint16_t RemoveExpired(void);
+	void SetExpiry(uint16_t);
+	uint16_t GetExpiry(void) const;
+
+	uint8_t GetSubscribers(uint16_t, uint32_t *, uint8_t) const;
+
+	void SetDiscoveryHandler(ArtNetDiscovery *);
+
 	void Dump(void);
+
+protected:
+	bool m_IsOutputPortsChanged;	///< A node was added or removed, or the output Port-Addresses of a node have changed
+	uint32_t m_nChanges;			///< Nodes added, removed or changed
+
+private:
+	uint16_t Find(uint32_t, uint8_t) const;
+	void Remove(uint16_t);
+	void LinkEntry(uint16_t);
+	void UnlinkEntry(uint16_t);
+	void LinkPorts(uint16_t);
+	void UnlinkPorts(uint16_t);
+
 private:
 	bool m_bIsChanged;
-	uint8_t m_nEntries;
-	TArtNetNodeEntry *m_pPollTable;
+	uint16_t m_nEntries;
+	uint16_t m_nExpirySeconds;
+	TArtNetNodeEntry *m_pPollTable;				///< ARTNET_POLL_TABLE_SIZE entries, the first m_nEntries are in use
+	struct TArtNetPollTableLinks *m_pLinks;		///< Per entry
+	uint16_t *m_pHash;							///< IP address hash : first entry of each bucket
+	uint16_t *m_pPortHash;						///< Port-Address index : first port link of each bucket
 	time_t m_nLastUpdate;
+	ArtNetDiscovery *m_pArtNetDiscovery;
 };
 
 #endif /* ARTNETPOLLTABLE_H_ */
@@ -0,0 +1,64 @@
+/**
+ * @file artnettrigger.h
+ *
+ */
+/**
+ * Art-Net Designed by and Copyright Artistic Licence Holdings Ltd.
+ *
+ * Art-Net 3 Protocol Release V1.4 Document Revision 1.4bk 23/1/2016
+ *
+ */
+/* Copyright (C) 2018 by Arjan van Vught mailto:info@raspberrypi-dmx.nl
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef ARTNETTRIGGER_H_
+#define ARTNETTRIGGER_H_
+
+#include <stdint.h>
+
+#if  ! defined (PACKED)
+#define PACKED __attribute__((packed))
+#endif
+
+/**
+ * Table 7 – ArtTrigger Key values
+ */
+enum TArtNetTriggerKey {
+	ARTNET_TRIGGER_KEY_ASCII = 0,	///< The SubKey field contains an ASCII character which the receiving device should process as if it were a keyboard press.
+	ARTNET_TRIGGER_KEY_MACRO = 1,	///< The SubKey field contains the number of a Macro which the receiving device should execute.
+	ARTNET_TRIGGER_KEY_SOFT = 2,	///< The SubKey field contains a soft-key number which the receiving device should process as if it were a soft-key keyboard press.
+	ARTNET_TRIGGER_KEY_SHOW = 3		///< The SubKey field contains the number of a Show which the receiving device should run.
+};
+
+struct TArtNetTrigger {
+	uint8_t Key;			///< The Trigger Key. See \ref TArtNetTriggerKey
+	uint8_t SubKey;			///< The Trigger SubKey.
+	uint8_t Data[512];		///< The interpretation of the payload is defined by the Key.
+} PACKED;
+
+class ArtNetTrigger {
+public:
+	virtual ~ArtNetTrigger(void);
+
+	virtual void Handler(const struct TArtNetTrigger *)= 0;
+};
+
+#endif /* ARTNETTRIGGER_H_ */
@@ -55,6 +55,14 @@ enum {
 	ARTNET_MAX_PORTS = 4
 };
 
+/**
+ * The maximum number of pages (ArtPollReply BindIndex) per node.
+ * Each page describes \ref ARTNET_MAX_PORTS ports.
+ */
+enum {
+	ARTNET_MAX_PAGES = 16
+};
+
 /**
  * The length of the short name field. Always 18
  */
@@ -49,6 +49,7 @@ enum TOpCodes {
 	OP_POLLREPLY = 0x2100,	///< This is an ArtPollReply Packet. It contains device status information.
 	OP_DIAGDATA = 0x2300,	///< Diagnostics and data logging packet.
 	OP_DMX = 0x5000,		///< This is an ArtDmx data packet. It contains zero start code DMX512 information for a single Universe.
+	OP_NZS = 0x5100,		///< This is an ArtNzs data packet. It contains non-zero start code (except RDM) DMX512 information for a single Universe.
 	OP_SYNC = 0x5200,		///< This is an ArtSync data packet. It is used to force synchronous transfer of ArtDmx packets to a node’s output.
 	OP_ADDRESS = 0x6000,	///< This is an ArtAddress packet. It contains remote programming information for a Node.
 	OP_TODREQUEST = 0x8000,	///< This is an ArtTodRequest packet. It is used to request a Table of Devices (ToD) for RDM discovery.
@@ -57,6 +58,7 @@ enum TOpCodes {
 	OP_RDM = 0x8300, 		///< This is an ArtRdm packet. It is used to send all non discovery RDM messages.
 	OP_TIMECODE = 0x9700,	///< This is an ArtTimeCode packet. It is used to transport time code over the network.
 	OP_TIMESYNC = 0x9800,	///< Used to synchronize real time date and clock
+	OP_TRIGGER = 0x9900,	///< This is an ArtTrigger packet. It is used to send trigger macros to the network.
 	OP_IPPROG = 0xF800,		///< This is an ArtIpProg packet. It is used to re-programme the IP, Mask and Port address of the Node.
 	OP_IPPROGREPLY = 0xF900,///< This is an ArtIpProgReply packet. It is returned by the node to acknowledge receipt of an ArtIpProg packet.
 	OP_NOT_DEFINED = 0x0000	///< OP_NOT_DEFINED
@@ -131,6 +133,22 @@ struct TArtDmx {
 	uint8_t Data[ARTNET_DMX_LENGTH];///< A variable length array of DMX512 lighting data.
 }PACKED;
 
+/**
+ * ArtNzs is the data packet used to transfer DMX512 data with non-zero start codes (except RDM).
+ */
+struct TArtNzs {
+	uint8_t Id[8];			///< Array of 8 characters, the final character is a null termination. Value = ‘A’ ‘r’ ‘t’ ‘-‘ ‘N’ ‘e’ ‘t’ 0x00
+	uint16_t OpCode;		///< OpNzs \ref TOpCodes
+	uint8_t ProtVerHi;		///< High byte of the Art-Net protocol revision number.
+	uint8_t ProtVerLo;		///< Low byte of the Art-Net protocol revision number. Current value 14.
+	uint8_t Sequence;		///< The sequence number is used to ensure that ArtNzs packets are used in the correct order.
+	uint8_t StartCode;		///< The DMX512 start code of this packet. Must not be Zero or RDM.
+	uint16_t PortAddress;	///< The 15 bit Port-Address to which this packet is destined.
+	uint8_t LengthHi;		///< The length of the data array. This value should be in the range 1 – 512.
+	uint8_t Length;			///< Low Byte of above.
+	uint8_t Data[ARTNET_DMX_LENGTH];///< A variable length array of DMX512 data.
+}PACKED;
+
 /**
  * ArtDiagData is a general purpose packet that allows a node or controller to send diagnostics data for display.
  */
@@ -171,7 +189,7 @@ struct TArtAddress {
 	uint8_t ProtVerHi;		///< High byte of the Art-Net protocol revision number.
 	uint8_t ProtVerLo;		///< Low byte of the Art-Net protocol revision number. Current value 14.
 	uint8_t NetSwitch;		///< This value is ignored unless bit 7 is high. Send 0x00 to reset this value to the physical switch setting. Use value 0x7f for no change.
-	uint8_t Filler2;		///< Pad length to match ArtPoll.
+	uint8_t BindIndex;		///< The BindIndex defines the bound node which originated this packet. 0 or 1 is the root device. (Art-Net 4, was Filler2)
 	uint8_t ShortName[ARTNET_SHORT_NAME_LENGTH];///< The Node will ignore this value if the string is null.
 	uint8_t LongName[ARTNET_LONG_NAME_LENGTH];	///< The Node will ignore this value if the string is null.
 	uint8_t SwIn[ARTNET_MAX_PORTS];		///< This value is ignored unless bit 7 is high. Send 0x00 to reset this value to the physical switch setting. Use value 0x7f for no change.
@@ -386,9 +404,11 @@ struct TArtIpProgReply {
  */
 struct TArtTrigger {
 	uint8_t Id[8];		///< Array of 8 characters, the final character is a null termination. Value = ‘A’ ‘r’ ‘t’ ‘-‘ ‘N’ ‘e’ ‘t’ 0x00
-	uint16_t OpCode;	///< OpPollReply \ref TOpCodes
+	uint16_t OpCode;	///< OpTrigger \ref TOpCodes
 	uint8_t ProtVerHi;	///< High byte of the Art-Net protocol revision number.
 	uint8_t ProtVerLo;	///< Low byte of the Art-Net protocol revision number. Current value 14.
+	uint8_t Filler1;	///< Pad length to match ArtPoll.
+	uint8_t Filler2;	///< Pad length to match ArtPoll.
 	uint8_t OemCodeHi;	///< The manufacturer code (high byte) of nodes that shall accept this trigger.
 	uint8_t OemCodeLo;	///< The manufacturer code (low byte) of nodes that shall accept this trigger.
 	uint8_t Key;		///< The Trigger Key.
@@ -403,6 +423,7 @@ union UArtPacket {
 	struct TArtPoll ArtPoll;				///< ArtPoll packet
 	struct TArtPollReply ArtPollReply;		///< ArtPollReply packet
 	struct TArtDmx ArtDmx;					///< ArtDmx packet
+	struct TArtNzs ArtNzs;					///< ArtNzs packet
 	struct TArtDiagData ArtDiagData;		///< ArtDiagData packet
 	struct TArtSync ArtSync;				///< ArtSync packet
 	struct TArtAddress ArtAddress;			///< ArtAddress packet
@@ -425,6 +446,7 @@ struct TArtNetPacket {
 	int length;						///<
 	uint32_t IPAddressFrom;			///<
 	uint32_t IPAddressTo;			///<
+	uint16_t PortFrom;				///< UDP source port
 	TOpCodes OpCode;				///<
 	union UArtPacket ArtPacket;		///<
 };
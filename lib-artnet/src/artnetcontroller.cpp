@@ -32,6 +32,11 @@
 #include <stdint.h>
 #include <stdio.h>
 #include <time.h>
+#include <assert.h>
+
+extern "C" {
+extern uint32_t millis(void);
+}
 
 #if defined (__linux__) || defined (__CYGWIN__)
 #include <string.h>
@@ -44,6 +49,8 @@
 #include "artnetcontroller.h"
 #include "artnetpolltable.h"
 
+#include "dmxkernel.h"
+
 #include "network.h"
 
 #define ARTNET_UDP_PORT				0x1936
@@ -52,8 +59,31 @@
 #define ARTNET_ID					"Art-Net"
 
 #define POLL_INTERVAL_MIN			8	//< Seconds
-
-ArtNetController::ArtNetController(void) : m_nLastPollTime(0), m_IPAddressLocal(0), m_IPAddressBroadcast(0), m_nPollInterVal(POLL_INTERVAL_MIN) {
+#define POLL_INTERVAL_FAST_MILLIS	2500	///< While nodes are added, removed or changed
+#define POLL_STABLE_COUNT			3		///< Polls without changes before returning to the poll interval
+
+#define KEEP_ALIVE_MILLIS			1000	///< Art-Net 4 : unchanged data is resent every 800 - 1000 ms
+
+ArtNetController::ArtNetController(void) :
+		m_nLastPollMillis(0),
+		m_nPollIntervalMillis(0),
+		m_nPollChanges(0),
+		m_nPollStable(0),
+		m_IPAddressLocal(0),
+		m_IPAddressBroadcast(0),
+		m_nPollInterVal(POLL_INTERVAL_MIN),
+		m_pUniverses(0),
+		m_pUniverseIndex(0),
+		m_nMaxUniverses(ARTNET_CONTROLLER_MAX_UNIVERSES),
+		m_nUniverses(0),
+		m_nFrameIndex(0),
+		m_nFrameDmxCount(0),
+		m_IsFrameActive(false),
+		m_IsSynchronous(true),
+		m_nFps(ARTNET_CONTROLLER_DEFAULT_FPS),
+		m_nKeepAliveMillis(KEEP_ALIVE_MILLIS),
+		m_nFrameMillis(0)
+{
 	m_pArtNetPacket = new (struct TArtNetPacket);
 
 	memset((void *) &m_ArtNetPoll, 0, sizeof(struct TArtPoll));
@@ -66,9 +96,20 @@ ArtNetController::ArtNetController(void) : m_nLastPollTime(0), m_IPAddressLocal(
 	memcpy((void *) &m_ArtIpProg, (const char *) ARTNET_ID, 8);
 	m_ArtIpProg.OpCode = OP_IPPROG;
 	m_ArtIpProg.ProtVerLo = (uint8_t) ARTNET_PROTOCOL_REVISION;
+
+	memset((void *) &m_ArtSync, 0, sizeof(struct TArtSync));
+	memcpy((void *) &m_ArtSync, (const char *) ARTNET_ID, 8);
+	m_ArtSync.OpCode = OP_SYNC;
+	m_ArtSync.ProtVerLo = (uint8_t) ARTNET_PROTOCOL_REVISION;
 }
 
 ArtNetController::~ArtNetController(void) {
+	delete[] m_pUniverseIndex;
+	m_pUniverseIndex = 0;
+
+	delete[] m_pUniverses;
+	m_pUniverses = 0;
+
 	delete m_pArtNetPacket;
 }
 
@@ -88,19 +129,40 @@ void ArtNetController::SetPollInterval(const uint8_t nPollInterval) {
 	}
 
 	m_nPollInterVal = nPollInterval;
+
+	// A node is removed after missing three polls
+	const uint16_t nExpiry = 3 * (uint16_t) nPollInterval;
+	SetExpiry(nExpiry > ARTNET_POLL_TABLE_EXPIRY_SECONDS ? nExpiry : (uint16_t) ARTNET_POLL_TABLE_EXPIRY_SECONDS);
 }
 
 const uint8_t ArtNetController::GetPollInterval(void) {
 	return m_nPollInterVal;
 }
 
+/**
+ * Poll every POLL_INTERVAL_FAST_MILLIS while the node population is changing,
+ * and every m_nPollInterVal seconds once it has been stable for POLL_STABLE_COUNT polls.
+ */
 void ArtNetController::SendPoll(void) {
-	const time_t nTime = time(NULL);
+	const uint32_t nMillis = millis();
+
+	if ((nMillis - m_nLastPollMillis) < m_nPollIntervalMillis) {
+		return;
+	}
+
+	network_sendto((const uint8_t *)&m_ArtNetPoll, sizeof(struct TArtPoll), m_IPAddressBroadcast, ARTNET_UDP_PORT);
+	m_nLastPollMillis = nMillis;
+
+	RemoveExpired();
 
-	if (nTime - m_nLastPollTime >= 8) {
-		network_sendto((const uint8_t *)&m_ArtNetPoll, sizeof(struct TArtPoll), m_IPAddressBroadcast, ARTNET_UDP_PORT);
-		m_nLastPollTime= nTime;
+	if (m_nChanges != m_nPollChanges) {
+		m_nPollChanges = m_nChanges;
+		m_nPollStable = 0;
+	} else if (m_nPollStable < POLL_STABLE_COUNT) {
+		m_nPollStable++;
 	}
+
+	m_nPollIntervalMillis = (m_nPollStable < POLL_STABLE_COUNT) ? POLL_INTERVAL_FAST_MILLIS : (uint32_t) m_nPollInterVal * 1000;
 }
 
 void ArtNetController::HandlePollReply(void) {
@@ -110,7 +172,10 @@ void ArtNetController::HandlePollReply(void) {
 
 	printf("%.2d-%.2d-%.4d %.2d:%.2d:%.2d\n", tm.tm_mday, tm.tm_mon + 1, tm.tm_year + 1900, tm.tm_hour, tm.tm_min, tm.tm_sec);
 #endif
-	if (!Add(&m_pArtNetPacket->ArtPacket.ArtPollReply)) {
+	const struct TArtPollReply *pArtPollReply = &m_pArtNetPacket->ArtPacket.ArtPollReply;
+
+	// The ArtIpProgReply applies to all pages of a node, so query the root device only
+	if (!Add(pArtPollReply) && (pArtPollReply->BindIndex <= 1)) {
 		SendIpProg();
 	}
 }
@@ -136,12 +201,225 @@ void ArtNetController::SendIpProg(const uint32_t nRemoteIp, const struct TArtNet
 	network_sendto((const uint8_t *)&ArtIpProg, sizeof(struct TArtIpProg), nRemoteIp, ARTNET_UDP_PORT);
 }
 
+/**
+ * The size of the universe table. Only before the first \ref SetData.
+ */
+void ArtNetController::SetMaxUniverses(uint16_t nMaxUniverses) {
+	if ((m_pUniverses != 0) || (nMaxUniverses == 0) || (nMaxUniverses == ARTNET_CONTROLLER_UNIVERSE_NONE)) {
+		return;
+	}
+
+	m_nMaxUniverses = nMaxUniverses;
+}
+
+uint16_t ArtNetController::GetMaxUniverses(void) const {
+	return m_nMaxUniverses;
+}
+
+uint16_t ArtNetController::GetUniverses(void) const {
+	return m_nUniverses;
+}
+
+void ArtNetController::SetFps(uint8_t nFps) {
+	if (nFps == 0) {
+		return;
+	}
+
+	m_nFps = nFps;
+}
+
+uint8_t ArtNetController::GetFps(void) const {
+	return m_nFps;
+}
+
+void ArtNetController::SetKeepAlive(uint16_t nKeepAliveMillis) {
+	m_nKeepAliveMillis = nKeepAliveMillis;
+}
+
+uint16_t ArtNetController::GetKeepAlive(void) const {
+	return m_nKeepAliveMillis;
+}
+
+void ArtNetController::SetSynchronous(bool IsSynchronous) {
+	m_IsSynchronous = IsSynchronous;
+}
+
+bool ArtNetController::IsSynchronous(void) const {
+	return m_IsSynchronous;
+}
+
+/**
+ * Store the DMX data of Port-Address \a nPortAddress, it is sent with the next frame.
+ * A new Port-Address is added to the universe table, false when the table is full.
+ */
+bool ArtNetController::SetData(uint16_t nPortAddress, const uint8_t *pData, uint16_t nLength) {
+	assert(pData != 0);
+
+	nPortAddress &= 0x7FFF;
+
+	if (nLength > ARTNET_DMX_LENGTH) {
+		nLength = ARTNET_DMX_LENGTH;
+	}
+
+	if (m_pUniverses == 0) {
+		m_pUniverses = new TArtNetControllerUniverse[m_nMaxUniverses];
+		assert(m_pUniverses != 0);
+
+		m_pUniverseIndex = new uint16_t[0x8000];
+		assert(m_pUniverseIndex != 0);
+
+		for (unsigned i = 0; i < 0x8000; i++) {
+			m_pUniverseIndex[i] = ARTNET_CONTROLLER_UNIVERSE_NONE;
+		}
+	}
+
+	uint16_t nIndex = m_pUniverseIndex[nPortAddress];
+
+	if (nIndex == ARTNET_CONTROLLER_UNIVERSE_NONE) {
+		if (m_nUniverses == m_nMaxUniverses) {
+			return false;
+		}
+
+		nIndex = m_nUniverses++;
+		m_pUniverseIndex[nPortAddress] = nIndex;
+
+		struct TArtNetControllerUniverse *pUniverse = &m_pUniverses[nIndex];
+
+		memset((void *) &pUniverse->ArtDmx, 0, sizeof(struct TArtDmx));
+		memcpy((void *) &pUniverse->ArtDmx, (const char *) ARTNET_ID, 8);
+		pUniverse->ArtDmx.OpCode = OP_DMX;
+		pUniverse->ArtDmx.ProtVerLo = (uint8_t) ARTNET_PROTOCOL_REVISION;
+		pUniverse->ArtDmx.PortAddress = nPortAddress;
+		pUniverse->nLength = 0;
+		pUniverse->nMillis = 0;
+		pUniverse->IsDataChanged = true;	// A new universe is sent with the next Run, also with length 0
+
+		UpdateDestinations(nIndex);
+	}
+
+	struct TArtNetControllerUniverse *pUniverse = &m_pUniverses[nIndex];
+
+	if (nLength != pUniverse->nLength) {
+		dmx_kernel_copy_ltp(pUniverse->ArtDmx.Data, pData, nLength);
+		if ((nLength & 0x01) != 0) {
+			pUniverse->ArtDmx.Data[nLength] = 0;	// The ArtDmx length is even
+		}
+		pUniverse->nLength = nLength;
+		pUniverse->IsDataChanged = true;
+	} else if (dmx_kernel_copy_changed(pUniverse->ArtDmx.Data, pData, nLength, 0)) {
+		pUniverse->IsDataChanged = true;
+	}
+
+	return true;
+}
+
+/**
+ * The nodes with an output port bound to the universe, broadcast when there are none or too many.
+ */
+void ArtNetController::UpdateDestinations(uint16_t nIndex) {
+	struct TArtNetControllerUniverse *pUniverse = &m_pUniverses[nIndex];
+
+	const uint8_t nFound = GetSubscribers(pUniverse->ArtDmx.PortAddress, pUniverse->Destinations, ARTNET_CONTROLLER_MAX_UNICAST);
+
+	pUniverse->nDestinations = nFound <= ARTNET_CONTROLLER_MAX_UNICAST ? nFound : 0;
+}
+
+void ArtNetController::SendUniverse(uint16_t nIndex, uint32_t nMillis) {
+	struct TArtNetControllerUniverse *pUniverse = &m_pUniverses[nIndex];
+	struct TArtDmx *pArtDmx = &pUniverse->ArtDmx;
+
+	pArtDmx->Sequence = pArtDmx->Sequence == 0xFF ? 1 : pArtDmx->Sequence + 1;	// 0 disables resequencing
+
+	const uint16_t nDataLength = pUniverse->nLength < 2 ? 2 : (pUniverse->nLength + 1) & ~1;
+	pArtDmx->LengthHi = (uint8_t) (nDataLength >> 8);
+	pArtDmx->Length = (uint8_t) (nDataLength & 0xFF);
+
+	const uint16_t nSize = (uint16_t) (sizeof(struct TArtDmx) - ARTNET_DMX_LENGTH + nDataLength);
+
+	if (pUniverse->nDestinations == 0) {
+		network_sendto((const uint8_t *) pArtDmx, nSize, m_IPAddressBroadcast, ARTNET_UDP_PORT);
+	} else {
+		for (unsigned i = 0; i < pUniverse->nDestinations; i++) {
+			network_sendto((const uint8_t *) pArtDmx, nSize, pUniverse->Destinations[i], ARTNET_UDP_PORT);
+		}
+	}
+
+	pUniverse->nMillis = nMillis;
+	pUniverse->IsDataChanged = false;
+	m_nFrameDmxCount++;
+}
+
+void ArtNetController::SendSync(void) {
+	network_sendto((const uint8_t *) &m_ArtSync, sizeof(struct TArtSync), m_IPAddressBroadcast, ARTNET_UDP_PORT);
+}
+
+/**
+ * One frame per 1000 / fps milliseconds. Each frame sends the changed universes
+ * and the universes due for a keep-alive, spread over the first half of the frame time,
+ * and closes with ArtSync.
+ */
+void ArtNetController::HandleTransmit(void) {
+	if (m_nUniverses == 0) {
+		return;
+	}
+
+	const uint32_t nMillis = millis();
+	const uint32_t nFrameMillis = 1000 / m_nFps;
+
+	if (!m_IsFrameActive) {
+		if ((nMillis - m_nFrameMillis) < nFrameMillis) {
+			return;
+		}
+
+		// Keep the frame rate, unless too far behind
+		m_nFrameMillis += nFrameMillis;
+		if ((nMillis - m_nFrameMillis) >= nFrameMillis) {
+			m_nFrameMillis = nMillis;
+		}
+
+		m_IsFrameActive = true;
+		m_nFrameIndex = 0;
+		m_nFrameDmxCount = 0;
+
+		if (m_IsOutputPortsChanged) {
+			m_IsOutputPortsChanged = false;
+			for (unsigned i = 0; i < m_nUniverses; i++) {
+				UpdateDestinations(i);
+			}
+		}
+	}
+
+	const uint32_t nElapsed = nMillis - m_nFrameMillis;
+	const uint32_t nSpread = nFrameMillis / 2;
+	uint32_t nDue = m_nUniverses;
+
+	if (nElapsed < nSpread) {
+		nDue = ((uint32_t) m_nUniverses * (nElapsed + 1)) / (nSpread + 1);
+	}
+
+	for (; m_nFrameIndex < nDue; m_nFrameIndex++) {
+		const struct TArtNetControllerUniverse *pUniverse = &m_pUniverses[m_nFrameIndex];
+
+		if (pUniverse->IsDataChanged || ((nMillis - pUniverse->nMillis) >= m_nKeepAliveMillis)) {
+			SendUniverse(m_nFrameIndex, nMillis);
+		}
+	}
+
+	if (m_nFrameIndex == m_nUniverses) {
+		if (m_IsSynchronous && (m_nFrameDmxCount != 0)) {
+			SendSync();
+		}
+		m_IsFrameActive = false;
+	}
+}
+
 int ArtNetController::Run(void) {
 	const char *packet = (char *)(&m_pArtNetPacket->ArtPacket);
 	uint16_t nForeignPort;
 	TOpCodes OpCode;
 
 	SendPoll();
+	HandleTransmit();
 
 	const int nBytesReceived = network_recvfrom((const uint8_t *)packet, (const uint16_t)sizeof(struct TArtNetPacket), &m_pArtNetPacket->IPAddressFrom, &nForeignPort) ;
 
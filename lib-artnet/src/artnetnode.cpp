@@ -53,15 +53,32 @@
 #include "packets.h"
 
 #include "lightset.h"
+#include "dmxkernel.h"
 #include "ledblink.h"
 
 #include "artnetrdm.h"
 #include "artnettimecode.h"
 #include "artnettimesync.h"
+#include "artnettrigger.h"
 #include "artnetipprog.h"
 
 #include "network.h"
 
+#if defined (__circle__)
+static inline uint32_t millis(void) {
+	return CTimer::Get()->GetTicks() * (1000 / HZ);
+}
+
+static inline uint32_t micros(void) {
+	return CTimer::Get()->GetClockTicks();
+}
+#else
+extern "C" {
+extern uint32_t millis(void);
+extern uint32_t micros(void);
+}
+#endif
+
 /**
  * Defines output status of the node.
  */
@@ -75,6 +92,13 @@ enum TGoodOutput {
 	GO_MERGE_MODE_LTP = (1 << 1)				///< Bit 1 Set – Merge Mode is LTP.
 };
 
+/**
+ * Defines input status of the node.
+ */
+enum TGoodInput {
+	GI_DATA_RECEIVED = (1 << 7)					///< Bit 7 Set – Data received.
+};
+
 /**
  *
  */
@@ -111,59 +135,126 @@ static const uint8_t DEVICE_SOFTWARE_VERSION[] = {0x01, 0x13 };	///<
 static const uint8_t DEVICE_OEM_VALUE[] = { 0x20, 0xE0 };		///< OemArtRelay , 0x00FF = developer code
 
 #define ARTNET_MIN_HEADER_SIZE			12						///< \ref TArtPoll \ref TArtSync
+#define RDM_MESSAGE_MINIMUM_SIZE		24						///< ANSI E1.20 : StartCode up to and including the Parameter Data Length
 #define ARTNET_MERGE_TIMEOUT_SECONDS	10						///<
 
 #define NETWORK_DATA_LOSS_TIMEOUT		10						///< Seconds
+#define ARTNET_FRAME_DEADLINE_MILLIS	50						///< Synchronous mode : a little more than 2 frames at 44 Hz
+#define ARTNET_SYNC_TIMEOUT_MILLIS		4000					///< Art-Net 4 : revert to non-synchronous mode after 4 seconds without ArtSync
+
+#define ARTNET_INPUT_KEEP_ALIVE_MILLIS	1000					///< Art-Net 4 : unchanged data is resent every 800 - 1000 ms
+#define ARTNET_INPUT_MIN_INTERVAL_MILLIS	23					///< No more than 44 ArtDmx per second per input port
+#define ARTNET_SUBSCRIBER_TIMEOUT_MILLIS	(10 * 1000)			///< Controllers poll every 2.5 - 3 seconds
 
 #define PORT_IN_STATUS_DISABLED_MASK	0x08
 
-ArtNetNode::ArtNetNode(void) :
+#define ARTNET_IDLE_WAIT_MILLIS			10					///< HandlePackets : maximum wait for a packet when there is nothing pending
+
+#define ARTNET_POLL_REPLY_BACKOFF_MILLIS	1000				///< ArtPollReply to an ArtPoll is delayed by a random time up to 1 second
+
+#if defined (__circle__)
+ #define NODE_REPORT_TEXT	"RPi AvV " CIRCLE_NAME " " CIRCLE_VERSION_STRING
+#else
+ #define NODE_REPORT_TEXT	"RPi AvV"
+#endif
+
+#define NZS_START_CODE_RDM				0xCC					///< RDM is not carried by ArtNzs
+
+ArtNetNode::ArtNetNode(uint8_t nPages) :
 		m_pLightSet(0),
 		m_pLedBlink(0),
 		m_pArtNetTimeCode(0),
 		m_pArtNetTimeSync(0),
 		m_pArtNetRdm(0),
 		m_pArtNetIpProg(0),
+		m_pArtNetTrigger(0),
+		m_pArtNetPacket(&m_ArtNetPacket),
+		m_pBatchPackets(0),
+		m_pBatchDatagrams(0),
+		m_pPollReplies(0),
+		m_nPollReplyInvalid(0),
 		m_pTodData(0),
 		m_pIpProgReply(0),
+		m_pInputPorts(0),
+		m_nSubscribers(0),
+		m_nInputKeepAliveMillis(ARTNET_INPUT_KEEP_ALIVE_MILLIS),
+		m_nInputMinIntervalMillis(ARTNET_INPUT_MIN_INTERVAL_MILLIS),
 		m_bDirectUpdate(false),
-		m_nCurrentPacketTime(0),
-		m_nPreviousPacketTime(0),
+		m_nFrameDeadlineMillis(ARTNET_FRAME_DEADLINE_MILLIS),
+		m_nSyncTimeoutMillis(ARTNET_SYNC_TIMEOUT_MILLIS),
+		m_nPollReplyBackoffMillis(ARTNET_POLL_REPLY_BACKOFF_MILLIS),
+		m_nRandom(1),
+		m_nStatsMillis(0),
+		m_nStatsInterval(0),
+		m_nStatsSeconds(0),
+		m_nPacketsInvalid(0),
+		m_nCurrentPacketMillis(0),
+		m_nCurrentPacketMicros(0),
 		m_IsLightSetRunning(false),
 		m_IsRdmResponder(false)
 
  {
 	memset(&m_Node, 0, sizeof (struct TArtNetNode));
 
-	for (unsigned i = 0; i < ARTNET_MAX_PORTS; i++) {
-		m_OutputPorts[i].port.nStatus = (uint8_t) 0;
-		m_OutputPorts[i].port.nPortAddress = (uint16_t) 0;
-		m_OutputPorts[i].port.nDefaultAddress = (uint8_t) 0;
-		m_OutputPorts[i].mergeMode = ARTNET_MERGE_HTP;
-		m_OutputPorts[i].IsDataPending = false;
-		m_OutputPorts[i].bIsEnabled = false;
-		m_OutputPorts[i].nLength = (uint16_t) 0;
-		m_OutputPorts[i].ipA = (uint32_t) 0;
-		m_OutputPorts[i].ipB = (uint32_t) 0;
+	if (nPages == 0) {
+		nPages = 1;
+	} else if (nPages > ARTNET_MAX_PAGES) {
+		nPages = ARTNET_MAX_PAGES;
 	}
 
+	m_nPages = nPages;
+	m_nPorts = nPages * ARTNET_MAX_PORTS;
+
+	m_pOutputPorts = new TOutputPort[m_nPorts];
+	assert(m_pOutputPorts != 0);
+
+	for (unsigned i = 0; i < m_nPorts; i++) {
+		m_pOutputPorts[i].port.nStatus = (uint8_t) 0;
+		m_pOutputPorts[i].port.nPortAddress = (uint16_t) 0;
+		m_pOutputPorts[i].port.nDefaultAddress = (uint8_t) 0;
+		m_pOutputPorts[i].merge.SetTimeout((uint32_t) (ARTNET_MERGE_TIMEOUT_SECONDS * 1000));
+		m_pOutputPorts[i].IsMergeCancel = false;
+		m_pOutputPorts[i].IsDataPending = false;
+		m_pOutputPorts[i].IsInFrame = false;
+		m_pOutputPorts[i].IsStartCodeOutput = false;
+		m_pOutputPorts[i].bIsEnabled = false;
+		dmx_slot_range_clear(&m_pOutputPorts[i].tDirty);
+		m_pOutputPorts[i].nNextPortIndex = ARTNET_PORT_INDEX_NONE;
+		m_pOutputPorts[i].nDataMicros = (uint32_t) 0;
+		m_pOutputPorts[i].nDmxPrevious = (uint32_t) 0;
+		memset(&m_pOutputPorts[i].tStats, 0, sizeof(struct TArtNetPortStats));
+	}
+
+	UpdatePortAddressMap();
+
+	m_pPollReplies = new TArtPollReply[m_nPages];
+	assert(m_pPollReplies != 0);
+	InvalidatePollReply(ARTNET_MAX_PAGES);
+
 	m_Node.Status1 = STATUS1_INDICATOR_NORMAL_MODE | STATUS1_PAP_FRONT_PANEL;
 	m_Node.Status2 = STATUS2_DHCP_CAPABLE | STATUS2_PORT_ADDRESS_15BIT;
 
 	m_State.IsSynchronousMode = false;
+	m_State.ArtSyncMillis = 0;
+	m_State.IsFramePending = false;
+	m_State.FramePendingMillis = 0;
+	m_State.nFrameDmxCount = 0;
 	m_State.SendArtDiagData = false;
-	m_State.IsMergeMode = false;
 	m_State.IsChanged = false;
+	m_State.IsPollReplyPending = false;
+	m_State.PollReplyMillis = 0;
 	m_State.SendArtPollReplyOnChange = false;
 	m_State.ArtPollReplyCount = (uint32_t)0;
 	m_State.IPAddressArtPoll = (uint32_t)0;
 	m_State.IsMultipleControllersReqDiag = false;
 	m_State.reportCode = ARTNET_RCPOWEROK;
 	m_State.nActivePorts = 0;
+	m_State.nActiveInputPorts = 0;
 	m_State.status = ARTNET_STANDBY;
 	m_State.nNetworkDataLossTimeout = NETWORK_DATA_LOSS_TIMEOUT;
+	m_LossPolicy.SetTimeout(NETWORK_DATA_LOSS_TIMEOUT * 1000);
 
-	m_tOpCodePrevious = OP_NOT_DEFINED;
+	memset(&m_SyncStats, 0, sizeof(struct TArtNetSyncStats));
 
 	SetShortName((const char *)NODE_DEFAULT_SHORT_NAME);
 	SetLongName((const char *)NODE_DEFAULT_LONG_NAME);
@@ -191,8 +282,14 @@ ArtNetNode::~ArtNetNode(void) {
 		delete m_pIpProgReply;
 	}
 
+	delete[] m_pPollReplies;
+	delete[] m_pBatchPackets;
+	delete[] m_pBatchDatagrams;
+	delete[] m_pInputPorts;
+	delete[] m_pOutputPorts;
+	m_pOutputPorts = 0;
+
 	memset(&m_Node, 0, sizeof (struct TArtNetNode));
-	memset(&m_PollReply, 0, sizeof (struct TArtPollReply));
 	memset(&m_DiagData, 0, sizeof (struct TArtDiagData));
 	memset(&m_TimeCodeData, 0, sizeof (struct TArtTimeCode));
 }
@@ -203,19 +300,17 @@ void ArtNetNode::Start(void) {
 	network_get_macaddr(m_Node.MACAddressLocal);
 	m_Node.Status2 = (m_Node.Status2 & ~(1 << 1)) | (network_is_dhcp_used() ? STATUS2_IP_DHCP : STATUS2_IP_MANUALY);
 
-	FillPollReply();
+	m_nRandom = m_Node.IPAddressLocal ^ ((uint32_t) m_Node.MACAddressLocal[4] << 16) ^ ((uint32_t) m_Node.MACAddressLocal[5] << 24) ^ millis();
+	if (m_nRandom == 0) {
+		m_nRandom = 1;
+	}
+
+	InvalidatePollReply(ARTNET_MAX_PAGES);
 	FillDiagData();
 	FillTimeCodeData();
 
 	network_begin(ARTNET_UDP_PORT);
 
-	m_PollReply.NumPortsLo = m_State.nActivePorts;
-
-	for (unsigned i = 0 ; i < ARTNET_MAX_PORTS; i++) {
-		if (m_OutputPorts[i].bIsEnabled) {
-			m_PollReply.PortTypes[i] = ARTNET_ENABLE_OUTPUT | ARTNET_PORT_DMX;
-		}
-	}
 	m_State.status = ARTNET_ON;
 
 	//if (m_pLightSet != 0) {
@@ -267,62 +362,149 @@ uint8_t ArtNetNode::GetActiveOutputPorts(void) const{
 }
 
 uint8_t ArtNetNode::GetActiveInputPorts(void) const {
-	return 0;
+	return m_State.nActiveInputPorts;
+}
+
+uint8_t ArtNetNode::GetPages(void) const {
+	return m_nPages;
+}
+
+uint8_t ArtNetNode::GetPorts(void) const {
+	return m_nPorts;
+}
+
+uint32_t ArtNetNode::GetMemoryPerPort(void) const {
+	return (uint32_t) sizeof(struct TOutputPort);
+}
+
+uint32_t ArtNetNode::GetMemoryUsed(void) const {
+	uint32_t nMemory = (uint32_t) sizeof(ArtNetNode) + (uint32_t) m_nPorts * GetMemoryPerPort();
+
+	nMemory += (uint32_t) m_nPages * (uint32_t) sizeof(struct TArtPollReply);
+
+	if (m_pInputPorts != 0) {
+		nMemory += (uint32_t) m_nPorts * (uint32_t) sizeof(struct TInputPort);
+	}
+
+	return nMemory;
 }
 
 uint8_t ArtNetNode::GetUniverseSwitch(uint8_t nPortId) const {
-	if (nPortId >= ARTNET_MAX_PORTS) {
+	if (nPortId >= m_nPorts) {
 		return ARTNET_EARG;
 	}
-	return m_OutputPorts[nPortId].port.nDefaultAddress;
+	return m_pOutputPorts[nPortId].port.nDefaultAddress;
 }
 
 int ArtNetNode::SetUniverseSwitch(const uint8_t nPortIndex, const TArtNetPortDir dir, const uint8_t nAddress) {
-	if (nPortIndex >= ARTNET_MAX_PORTS) {
+	if (nPortIndex >= m_nPorts) {
 		return ARTNET_EARG;
 	}
 
 	if (dir == ARTNET_INPUT_PORT) {
-		// Not supported. We have output ports only.
-		return ARTNET_EACTION;
+		if (m_pInputPorts == 0) {
+			m_pInputPorts = new TInputPort[m_nPorts];
+			assert(m_pInputPorts != 0);
+
+			for (unsigned i = 0; i < m_nPorts; i++) {
+				struct TArtDmx *pArtDmx = &m_pInputPorts[i].ArtDmx;
+
+				memset(pArtDmx, 0, sizeof(struct TArtDmx));
+				memcpy(pArtDmx->Id, (const char *) NODE_ID, sizeof pArtDmx->Id);
+				pArtDmx->OpCode = OP_DMX;
+				pArtDmx->ProtVerHi = (uint8_t) 0;
+				pArtDmx->ProtVerLo = (uint8_t) ARTNET_PROTOCOL_REVISION;
+				pArtDmx->Physical = (uint8_t) (i & 0x03);
+
+				m_pInputPorts[i].nLength = (uint16_t) 0;
+				m_pInputPorts[i].nMillis = (uint32_t) 0;
+				m_pInputPorts[i].IsDataPending = false;
+				m_pInputPorts[i].bIsEnabled = false;
+				m_pInputPorts[i].port.nStatus = (uint8_t) 0;
+				m_pInputPorts[i].port.nPortAddress = (uint16_t) 0;
+				m_pInputPorts[i].port.nDefaultAddress = (uint8_t) 0;
+			}
+		}
+
+		if (!m_pInputPorts[nPortIndex].bIsEnabled) {
+			m_State.nActiveInputPorts = m_State.nActiveInputPorts + 1;
+			assert(m_State.nActiveInputPorts <= m_nPorts);
+		}
+
+		m_pInputPorts[nPortIndex].bIsEnabled = true;
+		m_pInputPorts[nPortIndex].port.nDefaultAddress = nAddress & (uint16_t)0x0F;	// Universe : Bits 3-0
+		m_pInputPorts[nPortIndex].port.nPortAddress = MakePortAddress((uint16_t)nAddress, nPortIndex / ARTNET_MAX_PORTS);
+
+		InvalidatePollReply(nPortIndex / ARTNET_MAX_PORTS);
+
+		return ARTNET_EOK;
 	} else if (dir == ARTNET_OUTPUT_PORT) {
-		if (!m_OutputPorts[nPortIndex].bIsEnabled) {
+		if (!m_pOutputPorts[nPortIndex].bIsEnabled) {
 			m_State.nActivePorts = m_State.nActivePorts + 1;
-			assert(m_State.nActivePorts <= ARTNET_MAX_PORTS);
+			assert(m_State.nActivePorts <= m_nPorts);
 		}
-		m_OutputPorts[nPortIndex].bIsEnabled = true;
+		m_pOutputPorts[nPortIndex].bIsEnabled = true;
 	} else {
 		return ARTNET_EARG;
 	}
 
-	m_OutputPorts[nPortIndex].port.nDefaultAddress = nAddress & (uint16_t)0x0F;		// Universe : Bits 3-0
-	m_OutputPorts[nPortIndex].port.nPortAddress = MakePortAddress((uint16_t)nAddress);
+	m_pOutputPorts[nPortIndex].port.nDefaultAddress = nAddress & (uint16_t)0x0F;		// Universe : Bits 3-0
+	m_pOutputPorts[nPortIndex].port.nPortAddress = MakePortAddress((uint16_t)nAddress, nPortIndex / ARTNET_MAX_PORTS);
+
+	UpdatePortAddressMap();
+	InvalidatePollReply(nPortIndex / ARTNET_MAX_PORTS);
 
 	return ARTNET_EOK;
 }
 
-uint8_t ArtNetNode::GetSubnetSwitch(void) const {
-	return m_Node.SubSwitch;
+uint8_t ArtNetNode::GetSubnetSwitch(const uint8_t nPage) const {
+	if (nPage >= m_nPages) {
+		return 0;
+	}
+	return m_Node.SubSwitch[nPage];
 }
 
-void ArtNetNode::SetSubnetSwitch(const uint8_t nAddress) {
-	m_Node.SubSwitch = nAddress;
+void ArtNetNode::SetSubnetSwitch(const uint8_t nAddress, const uint8_t nPage) {
+	if (nPage >= m_nPages) {
+		return;
+	}
 
-	for (unsigned i = 0; i < ARTNET_MAX_PORTS; i++) {
-		m_OutputPorts[i].port.nPortAddress = MakePortAddress(m_OutputPorts[i].port.nPortAddress);
+	m_Node.SubSwitch[nPage] = nAddress;
+
+	for (unsigned i = nPage * ARTNET_MAX_PORTS; i < (unsigned) (nPage + 1) * ARTNET_MAX_PORTS; i++) {
+		m_pOutputPorts[i].port.nPortAddress = MakePortAddress(m_pOutputPorts[i].port.nPortAddress, nPage);
+		if (m_pInputPorts != 0) {
+			m_pInputPorts[i].port.nPortAddress = MakePortAddress(m_pInputPorts[i].port.nPortAddress, nPage);
+		}
 	}
+
+	UpdatePortAddressMap();
+	InvalidatePollReply(nPage);
 }
 
-uint8_t ArtNetNode::GetNetSwitch(void) const{
-	return m_Node.NetSwitch;
+uint8_t ArtNetNode::GetNetSwitch(const uint8_t nPage) const{
+	if (nPage >= m_nPages) {
+		return 0;
+	}
+	return m_Node.NetSwitch[nPage];
 }
 
-void ArtNetNode::SetNetSwitch(uint8_t nAddress) {
-	m_Node.NetSwitch = nAddress;
+void ArtNetNode::SetNetSwitch(const uint8_t nAddress, const uint8_t nPage) {
+	if (nPage >= m_nPages) {
+		return;
+	}
 
-	for (unsigned i = 0; i < ARTNET_MAX_PORTS; i++) {
-		m_OutputPorts[i].port.nPortAddress = MakePortAddress(m_OutputPorts[i].port.nPortAddress);
+	m_Node.NetSwitch[nPage] = nAddress;
+
+	for (unsigned i = nPage * ARTNET_MAX_PORTS; i < (unsigned) (nPage + 1) * ARTNET_MAX_PORTS; i++) {
+		m_pOutputPorts[i].port.nPortAddress = MakePortAddress(m_pOutputPorts[i].port.nPortAddress, nPage);
+		if (m_pInputPorts != 0) {
+			m_pInputPorts[i].port.nPortAddress = MakePortAddress(m_pInputPorts[i].port.nPortAddress, nPage);
+		}
 	}
+
+	UpdatePortAddressMap();
+	InvalidatePollReply(nPage);
 }
 
 const char *ArtNetNode::GetShortName(void) {
@@ -338,7 +520,7 @@ void ArtNetNode::SetShortName(const char *pName) {
 	strncpy((char *) m_Node.ShortName, pName, ARTNET_SHORT_NAME_LENGTH);
 	m_Node.ShortName[ARTNET_SHORT_NAME_LENGTH-1] = '\0';
 
-	memcpy (m_PollReply.ShortName, m_Node.ShortName, ARTNET_SHORT_NAME_LENGTH);
+	InvalidatePollReply(ARTNET_MAX_PAGES);
 }
 
 const char *ArtNetNode::GetLongName(void) {
@@ -354,12 +536,14 @@ void ArtNetNode::SetLongName(const char *pName) {
 	strncpy((char *) m_Node.LongName, pName, ARTNET_LONG_NAME_LENGTH);
 	m_Node.LongName[ARTNET_LONG_NAME_LENGTH-1] = '\0';
 
-	memcpy (m_PollReply.LongName, m_Node.LongName, ARTNET_LONG_NAME_LENGTH);
+	InvalidatePollReply(ARTNET_MAX_PAGES);
 }
 
 void ArtNetNode::SetManufacturerId(const uint8_t *pEsta) {
 	m_Node.Esta[0] = pEsta[1];
 	m_Node.Esta[1] = pEsta[0];
+
+	InvalidatePollReply(ARTNET_MAX_PAGES);
 }
 
 const uint8_t* ArtNetNode::GetManufacturerId(void) {
@@ -369,6 +553,8 @@ const uint8_t* ArtNetNode::GetManufacturerId(void) {
 void ArtNetNode::SetOemValue(const uint8_t *pOem) {
 	m_Node.Oem[0] = pOem[0];
 	m_Node.Oem[1] = pOem[1];
+
+	InvalidatePollReply(ARTNET_MAX_PAGES);
 }
 
 const uint8_t* ArtNetNode::GetOemValue(void) {
@@ -379,50 +565,178 @@ time_t ArtNetNode::GetNetworkTimeout(void) const {
 	return m_State.nNetworkDataLossTimeout;
 }
 
+uint16_t ArtNetNode::GetFrameDeadline(void) const {
+	return m_nFrameDeadlineMillis;
+}
+
+void ArtNetNode::SetFrameDeadline(uint16_t nFrameDeadlineMillis) {
+	m_nFrameDeadlineMillis = nFrameDeadlineMillis;
+}
+
+uint16_t ArtNetNode::GetSyncTimeout(void) const {
+	return m_nSyncTimeoutMillis;
+}
+
+void ArtNetNode::SetSyncTimeout(uint16_t nSyncTimeoutMillis) {
+	if (nSyncTimeoutMillis != 0) {
+		m_nSyncTimeoutMillis = nSyncTimeoutMillis;
+	}
+}
+
+void ArtNetNode::GetSyncStats(struct TArtNetSyncStats &tSyncStats) const {
+	tSyncStats = m_SyncStats;
+}
+
+uint32_t ArtNetNode::GetPacketsInvalid(void) const {
+	return m_nPacketsInvalid;
+}
+
 void ArtNetNode::SetNetworkTimeout(time_t nNetworkDataLossTimeout) {
 	if (nNetworkDataLossTimeout != 0) {
 		m_State.nNetworkDataLossTimeout = nNetworkDataLossTimeout;
+		m_LossPolicy.SetTimeout((uint32_t) nNetworkDataLossTimeout * 1000);
+	}
+}
+
+uint32_t ArtNetNode::GetNetworkTimeoutMillis(void) const {
+	return m_LossPolicy.GetTimeout();
+}
+
+/**
+ * The network data loss timeout with a millisecond resolution, \ref GetNetworkTimeout is rounded up.
+ */
+void ArtNetNode::SetNetworkTimeoutMillis(uint32_t nNetworkDataLossTimeoutMillis) {
+	if (nNetworkDataLossTimeoutMillis != 0) {
+		m_State.nNetworkDataLossTimeout = (time_t) ((nNetworkDataLossTimeoutMillis + 999) / 1000);
+		m_LossPolicy.SetTimeout(nNetworkDataLossTimeoutMillis);
 	}
 }
 
-uint16_t ArtNetNode::MakePortAddress(const uint16_t nCurrentAddress) {
+TDmxLossPolicy ArtNetNode::GetLossPolicy(void) const {
+	return m_LossPolicy.GetPolicy();
+}
+
+/**
+ * The output on a network data loss. DMX_LOSS_POLICY_BLACKOUT stops the LightSet, this is the default.
+ * The fade time is only used with DMX_LOSS_POLICY_FADE.
+ */
+void ArtNetNode::SetLossPolicy(TDmxLossPolicy tPolicy, uint32_t nFadeMillis) {
+	m_LossPolicy.SetPolicy(tPolicy);
+	m_LossPolicy.SetFadeTime(nFadeMillis);
+}
+
+/**
+ * The scene output by DMX_LOSS_POLICY_PRESET, a length of 0 removes the preset.
+ */
+bool ArtNetNode::SetLossPreset(uint8_t nPortIndex, const uint8_t *pData, uint16_t nLength) {
+	if (nPortIndex >= m_nPorts) {
+		return false;
+	}
+
+	return m_LossPolicy.SetPreset(nPortIndex, pData, nLength);
+}
+
+/**
+ * Rebuild the Port-Address hash. Must be called whenever a Port-Address or the enabled state of a port changes.
+ * The chains are built backwards so that each chain is in ascending port order.
+ */
+void ArtNetNode::UpdatePortAddressMap(void) {
+	for (unsigned i = 0; i < ARTNET_PORT_ADDRESS_HASH_SIZE; i++) {
+		m_PortAddressHash[i] = ARTNET_PORT_INDEX_NONE;
+	}
+
+	for (int i = m_nPorts - 1; i >= 0; i--) {
+		if (m_pOutputPorts[i].bIsEnabled) {
+			const unsigned nBucket = m_pOutputPorts[i].port.nPortAddress & (ARTNET_PORT_ADDRESS_HASH_SIZE - 1);
+			m_pOutputPorts[i].nNextPortIndex = m_PortAddressHash[nBucket];
+			m_PortAddressHash[nBucket] = (uint8_t) i;
+		} else {
+			m_pOutputPorts[i].nNextPortIndex = ARTNET_PORT_INDEX_NONE;
+		}
+	}
+}
+
+uint16_t ArtNetNode::MakePortAddress(const uint16_t nCurrentAddress, const uint8_t nPage) {
 	// PortAddress Bit 15 = 0
-	uint16_t newAddress = (m_Node.NetSwitch & 0x7F) << 8;	// Net : Bits 14-8
-	newAddress |= (m_Node.SubSwitch & (uint8_t)0x0F) << 4;	// Sub-Net : Bits 7-4
+	uint16_t newAddress = (m_Node.NetSwitch[nPage] & 0x7F) << 8;	// Net : Bits 14-8
+	newAddress |= (m_Node.SubSwitch[nPage] & (uint8_t)0x0F) << 4;	// Sub-Net : Bits 7-4
 	newAddress |= nCurrentAddress & (uint16_t)0x0F;			// Universe : Bits 3-0
 
 	return newAddress;
 }
 
-void ArtNetNode::FillPollReply(void) {
-	memset(&m_PollReply, 0, sizeof (struct TArtPollReply));
+/**
+ * Mark the ArtPollReply template of \a nPage for a rebuild, \ref ARTNET_MAX_PAGES marks all pages.
+ */
+void ArtNetNode::InvalidatePollReply(const uint8_t nPage) {
+	if (nPage >= ARTNET_MAX_PAGES) {
+		m_nPollReplyInvalid = (uint16_t) ~0;
+	} else {
+		m_nPollReplyInvalid |= (uint16_t) (1 << nPage);
+	}
+}
+
+/**
+ * Build the ArtPollReply template of \a nPage.
+ * NodeReport, GoodInput and GoodOutput are filled in when the reply is sent.
+ */
+void ArtNetNode::FillPollReply(const uint8_t nPage) {
+	struct TArtPollReply *pPollReply = &m_pPollReplies[nPage];
+	uint8_t nPorts = 0;
+
+	memset(pPollReply, 0, sizeof (struct TArtPollReply));
 
-	memcpy (m_PollReply.Id, (const char *)NODE_ID, sizeof m_PollReply.Id);
-	m_PollReply.OpCode = OP_POLLREPLY;
+	memcpy (pPollReply->Id, (const char *)NODE_ID, sizeof pPollReply->Id);
+	pPollReply->OpCode = OP_POLLREPLY;
 
 	ip.u32 = m_Node.IPAddressLocal;
-	memcpy(m_PollReply.IPAddress, ip.u8, sizeof m_PollReply.IPAddress);
-	m_PollReply.Port = (uint16_t) ARTNET_UDP_PORT;
-	m_PollReply.VersInfoH = DEVICE_SOFTWARE_VERSION[0];
-	m_PollReply.VersInfoL = DEVICE_SOFTWARE_VERSION[1];
-	m_PollReply.NetSwitch = m_Node.NetSwitch;
-	m_PollReply.SubSwitch = m_Node.SubSwitch;
-	m_PollReply.OemHi = m_Node.Oem[0];
-	m_PollReply.Oem = m_Node.Oem[1];
-	m_PollReply.Status1 = m_Node.Status1;
-	m_PollReply.EstaMan[0] = m_Node.Esta[0];
-	m_PollReply.EstaMan[1] = m_Node.Esta[1];
-	memcpy(m_PollReply.ShortName, m_Node.ShortName, sizeof m_PollReply.ShortName);
-	memcpy(m_PollReply.LongName, m_Node.LongName, sizeof m_PollReply.LongName);
-
-	// Disable all input
+	memcpy(pPollReply->IPAddress, ip.u8, sizeof pPollReply->IPAddress);
+	pPollReply->Port = (uint16_t) ARTNET_UDP_PORT;
+	pPollReply->VersInfoH = DEVICE_SOFTWARE_VERSION[0];
+	pPollReply->VersInfoL = DEVICE_SOFTWARE_VERSION[1];
+	pPollReply->NetSwitch = m_Node.NetSwitch[nPage];
+	pPollReply->SubSwitch = m_Node.SubSwitch[nPage];
+	pPollReply->OemHi = m_Node.Oem[0];
+	pPollReply->Oem = m_Node.Oem[1];
+	pPollReply->Status1 = m_Node.Status1;
+	pPollReply->EstaMan[0] = m_Node.Esta[0];
+	pPollReply->EstaMan[1] = m_Node.Esta[1];
+	memcpy(pPollReply->ShortName, m_Node.ShortName, sizeof pPollReply->ShortName);
+	memcpy(pPollReply->LongName, m_Node.LongName, sizeof pPollReply->LongName);
+
 	for (unsigned i = 0 ; i < ARTNET_MAX_PORTS; i++) {
-		m_PollReply.GoodInput[i] = PORT_IN_STATUS_DISABLED_MASK;
+		const struct TOutputPort *pPort = &m_pOutputPorts[(nPage * ARTNET_MAX_PORTS) + i];
+
+		if (pPort->bIsEnabled) {
+			pPollReply->PortTypes[i] = ARTNET_ENABLE_OUTPUT | ARTNET_PORT_DMX;
+		}
+		pPollReply->SwOut[i] = pPort->port.nDefaultAddress;
+
+		if (m_pInputPorts != 0) {
+			const struct TInputPort *pInputPort = &m_pInputPorts[(nPage * ARTNET_MAX_PORTS) + i];
+
+			if (pInputPort->bIsEnabled) {
+				pPollReply->PortTypes[i] |= ARTNET_ENABLE_INPUT | ARTNET_PORT_DMX;
+				pPollReply->SwIn[i] = pInputPort->port.nDefaultAddress;
+			}
+		}
+
+		if (pPollReply->PortTypes[i] != 0) {
+			nPorts++;
+		}
 	}
 
-	m_PollReply.Style = ARTNET_ST_NODE;
-	memcpy (m_PollReply.MAC, m_Node.MACAddressLocal, sizeof m_PollReply.MAC);
-	m_PollReply.Status2 = m_Node.Status2;
+	pPollReply->NumPortsLo = nPorts;
+
+	pPollReply->Style = ARTNET_ST_NODE;
+	memcpy (pPollReply->MAC, m_Node.MACAddressLocal, sizeof pPollReply->MAC);
+
+	// All pages are bound to this node
+	memcpy(pPollReply->BindIp, pPollReply->IPAddress, sizeof pPollReply->BindIp);
+	pPollReply->BindIndex = nPage + 1;
+	pPollReply->Status2 = m_Node.Status2;
+
+	m_nPollReplyInvalid &= (uint16_t) ~(1 << nPage);
 }
 
 void ArtNetNode::FillDiagData(void) {
@@ -444,23 +758,124 @@ void ArtNetNode::FillTimeCodeData(void) {
 	m_TimeCodeData.ProtVerLo = (uint8_t) ARTNET_PROTOCOL_REVISION;	// low byte of the Art-Net protocol revision number.
 }
 
+/**
+ * The minimum length of each OpCode handled : every field read by its handler has been received.
+ */
+static uint16_t get_minimum_length(const TOpCodes OpCode) {
+	switch (OpCode) {
+	case OP_POLL:
+		return (uint16_t) sizeof(struct TArtPoll);
+	case OP_POLLREPLY:
+		return (uint16_t) __builtin_offsetof(struct TArtPollReply, SwVideo);
+	case OP_DMX:
+		return (uint16_t) __builtin_offsetof(struct TArtDmx, Data);
+	case OP_NZS:
+		return (uint16_t) __builtin_offsetof(struct TArtNzs, Data);
+	case OP_ADDRESS:
+		return (uint16_t) sizeof(struct TArtAddress);
+	case OP_TIMECODE:
+		return (uint16_t) sizeof(struct TArtTimeCode);
+	case OP_TIMESYNC:
+		return (uint16_t) sizeof(struct TArtTimeSync);
+	case OP_TRIGGER:
+		return (uint16_t) __builtin_offsetof(struct TArtTrigger, Data);
+	case OP_TODREQUEST:
+		return (uint16_t) __builtin_offsetof(struct TArtTodRequest, Address) + 1;
+	case OP_TODCONTROL:
+		return (uint16_t) sizeof(struct TArtTodControl);
+	case OP_RDM:
+		return (uint16_t) __builtin_offsetof(struct TArtRdm, RdmPacket) + 2;	// Sub-StartCode, Message Length
+	case OP_IPPROG:
+		return (uint16_t) __builtin_offsetof(struct TArtIpProg, Spare1_8);
+	default:
+		return (uint16_t) ARTNET_MIN_HEADER_SIZE;
+	}
+}
+
+/**
+ * Every field of a received packet is untrusted : packets too short for their OpCode are OP_NOT_DEFINED.
+ */
 void ArtNetNode::GetType(void) {
-	char *data = (char *) &(m_ArtNetPacket.ArtPacket);
+	const uint8_t *data = (const uint8_t *) &(m_pArtNetPacket->ArtPacket);
+
+	m_pArtNetPacket->OpCode = OP_NOT_DEFINED;
 
-	if (m_ArtNetPacket.length < ARTNET_MIN_HEADER_SIZE) {
-		m_ArtNetPacket.OpCode = OP_NOT_DEFINED;
+	if (m_pArtNetPacket->length < ARTNET_MIN_HEADER_SIZE) {
+		m_nPacketsInvalid++;
 		return;
 	}
 
-	if ((data[10] != 0) || (data[11] != (char) ARTNET_PROTOCOL_REVISION)) {
-		m_ArtNetPacket.OpCode = OP_NOT_DEFINED;
+	if (memcmp(data, "Art-Net\0", 8) != 0) {
 		return;
 	}
 
-	if (memcmp(data, "Art-Net\0", 8) == 0) {
-		m_ArtNetPacket.OpCode = (TOpCodes) ((uint16_t)(data[9] << 8) + data[8]);
-	} else {
-		m_ArtNetPacket.OpCode = OP_NOT_DEFINED;
+	const TOpCodes OpCode = (TOpCodes) (((uint16_t) data[9] << 8) + data[8]);
+
+	// ArtPollReply has no ProtVer, bytes 10 and 11 are the IP address
+	if ((OpCode != OP_POLLREPLY) && ((data[10] != 0) || (data[11] != (uint8_t) ARTNET_PROTOCOL_REVISION))) {
+		return;
+	}
+
+	if (m_pArtNetPacket->length < (int) get_minimum_length(OpCode)) {
+		m_nPacketsInvalid++;
+		return;
+	}
+
+	m_pArtNetPacket->OpCode = OpCode;
+}
+
+static char *format_hex16(char *p, const uint16_t n) {
+	static const char hex[] = "0123456789abcdef";
+
+	*p++ = hex[(n >> 12) & 0x0F];
+	*p++ = hex[(n >> 8) & 0x0F];
+	*p++ = hex[(n >> 4) & 0x0F];
+	*p++ = hex[n & 0x0F];
+
+	return p;
+}
+
+static char *format_uint32(char *p, uint32_t n, const unsigned nMinDigits) {
+	char digits[10];
+	unsigned i = 0;
+
+	do {
+		digits[i++] = (char) ('0' + (n % 10));
+		n /= 10;
+	} while (n != 0);
+
+	while (i < nMinDigits) {
+		digits[i++] = '0';
+	}
+
+	while (i != 0) {
+		*p++ = digits[--i];
+	}
+
+	return p;
+}
+
+/**
+ * NodeReport "#xxxx [yyyy] text" without printf : \a pReport is ARTNET_REPORT_LENGTH bytes, zero padded.
+ */
+void ArtNetNode::FormatNodeReport(char *pReport) const {
+	char *p = format_hex16(pReport, (uint16_t) m_State.reportCode);
+
+	*p++ = ' ';
+	*p++ = '[';
+	p = format_uint32(p, m_State.ArtPollReplyCount, 4);
+	*p++ = ']';
+	*p++ = ' ';
+
+	const char *pText = NODE_REPORT_TEXT;
+	char *pEnd = &pReport[ARTNET_REPORT_LENGTH - 1];
+
+	while ((*pText != '\0') && (p < pEnd)) {
+		*p++ = *pText++;
+	}
+
+	while (p <= pEnd) {
+		*p++ = '\0';
 	}
 }
 
@@ -470,308 +885,716 @@ void ArtNetNode::SendPollRelply(const bool bResponse) {
 		m_State.ArtPollReplyCount++;
 	}
 
-	for (unsigned i = 0 ; i < ARTNET_MAX_PORTS; i++) {
-		m_PollReply.GoodOutput[i] = m_OutputPorts[i].port.nStatus;
-		m_PollReply.SwOut[i] = m_OutputPorts[i].port.nDefaultAddress;
+	char report[ARTNET_REPORT_LENGTH];
+	FormatNodeReport(report);
+
+	// One ArtPollReply per page. The first page is always reported, the other pages only when they have enabled ports.
+	for (uint8_t nPage = 0; nPage < m_nPages; nPage++) {
+		struct TArtPollReply *pPollReply = &m_pPollReplies[nPage];
+
+		if (m_nPollReplyInvalid & (1 << nPage)) {
+			FillPollReply(nPage);
+		}
+
+		if ((nPage != 0) && (pPollReply->NumPortsLo == 0)) {
+			continue;
+		}
+
+		memcpy(pPollReply->NodeReport, report, ARTNET_REPORT_LENGTH);
+
+		// The port status follows the data flow, it is not part of the template
+		for (unsigned i = 0 ; i < ARTNET_MAX_PORTS; i++) {
+			pPollReply->GoodOutput[i] = m_pOutputPorts[(nPage * ARTNET_MAX_PORTS) + i].port.nStatus;
+
+			if ((m_pInputPorts != 0) && m_pInputPorts[(nPage * ARTNET_MAX_PORTS) + i].bIsEnabled) {
+				pPollReply->GoodInput[i] = m_pInputPorts[(nPage * ARTNET_MAX_PORTS) + i].port.nStatus;
+			} else {
+				pPollReply->GoodInput[i] = PORT_IN_STATUS_DISABLED_MASK;
+			}
+		}
+
+		network_sendto((const uint8_t *)pPollReply, (const uint16_t)sizeof (struct TArtPollReply), m_Node.IPAddressBroadcast, (uint16_t)ARTNET_UDP_PORT);
 	}
+}
 
-#if defined (__circle__)
-	CString Report;
-	Report.Format("%04x [%04d] RPi AvV " CIRCLE_NAME " " CIRCLE_VERSION_STRING, m_State.reportCode, m_State.ArtPollReplyCount);
-	strncpy((char *)m_PollReply.NodeReport, (const char *)Report, Report.GetLength() < ARTNET_REPORT_LENGTH ? Report.GetLength() : ARTNET_REPORT_LENGTH); //
-#else
-	char report[ARTNET_REPORT_LENGTH];
-	sprintf(report, "%04x [%04d] RPi AvV", (int)m_State.reportCode, (int)m_State.ArtPollReplyCount);
-	strncpy((char *)m_PollReply.NodeReport, report, strlen(report) < ARTNET_REPORT_LENGTH ? strlen(report) : ARTNET_REPORT_LENGTH);
+/**
+ * ArtPollReply to an ArtPoll : a random back-off, so that the nodes of a large installation do not reply at once.
+ * An ArtPoll received while a reply is pending is answered by that reply.
+ */
+void ArtNetNode::SchedulePollReply(void) {
+	if (m_nPollReplyBackoffMillis == 0) {
+		SendPollRelply(true);
+		return;
+	}
+
+	if (!m_State.IsPollReplyPending) {
+		m_State.IsPollReplyPending = true;
+		m_State.PollReplyMillis = m_nCurrentPacketMillis + (Random() % ((uint32_t) m_nPollReplyBackoffMillis + 1));
+	}
+}
+
+/**
+ * xorshift32
+ */
+uint32_t ArtNetNode::Random(void) {
+	m_nRandom ^= m_nRandom << 13;
+	m_nRandom ^= m_nRandom >> 17;
+	m_nRandom ^= m_nRandom << 5;
+
+	return m_nRandom;
+}
+
+uint16_t ArtNetNode::GetPollReplyBackoff(void) const {
+	return m_nPollReplyBackoffMillis;
+}
+
+void ArtNetNode::SetPollReplyBackoff(uint16_t nPollReplyBackoffMillis) {
+	m_nPollReplyBackoffMillis = nPollReplyBackoffMillis;
+}
+
+void ArtNetNode::SendDiag(const char *text, TPriorityCodes nPriority) {
+	if (!m_State.SendArtDiagData) {
+		return;
+	}
+
+	if (nPriority < m_State.Priority) {
+		return;
+	}
+
+	m_DiagData.Priority = nPriority;
+
+	strncpy((char *) m_DiagData.Data, text, sizeof m_DiagData.Data);
+	m_DiagData.Data[sizeof(m_DiagData.Data) - 1] = '\0';				// Just be sure we have a last '\0'
+	m_DiagData.LengthLo = strlen((const char *) m_DiagData.Data) + 1;	// Text length including the '\0'
+
+	unsigned size = sizeof(struct TArtDiagData) - sizeof(m_DiagData.Data) + m_DiagData.LengthLo;
+
+	network_sendto((const uint8_t *)&(m_DiagData), (const uint16_t)size, m_State.IPAddressDiagSend, (uint16_t)ARTNET_UDP_PORT);
+}
+
+static char *format_text(char *p, const char *pText) {
+	while (*pText != '\0') {
+		*p++ = *pText++;
+	}
+
+	return p;
+}
+
+/**
+ * Called after SendPortData for a port with new data : the time since the ArtDMX was received.
+ */
+void ArtNetNode::UpdateLatency(const uint8_t nPortIndex) {
+	struct TOutputPort *pPort = &m_pOutputPorts[nPortIndex];
+	const uint32_t nMicros = micros() - pPort->nDataMicros;
+
+	unsigned nBin = (nMicros == 0) ? 0 : (31 - (unsigned) __builtin_clz(nMicros));
+
+	if (nBin >= ARTNET_LATENCY_BINS) {
+		nBin = ARTNET_LATENCY_BINS - 1;
+	}
+
+	pPort->tStats.nLatency[nBin]++;
+}
+
+/**
+ * Once per second : the packet rate, and the ArtDiagData dump when enabled.
+ */
+void ArtNetNode::UpdatePortStats(void) {
+	m_nStatsMillis = m_nCurrentPacketMillis;
+
+	for (unsigned i = 0; i < m_nPorts; i++) {
+		struct TOutputPort *pPort = &m_pOutputPorts[i];
+
+		pPort->tStats.nDmxPerSecond = pPort->tStats.nDmx - pPort->nDmxPrevious;
+		pPort->nDmxPrevious = pPort->tStats.nDmx;
+	}
+
+	if (m_nStatsInterval != 0) {
+		m_nStatsSeconds++;
+
+		if (m_nStatsSeconds >= m_nStatsInterval) {
+			m_nStatsSeconds = 0;
+			SendPortStats();
+		}
+	}
+}
+
+int ArtNetNode::GetPortStats(uint8_t nPortIndex, struct TArtNetPortStats &tPortStats) const {
+	if (nPortIndex >= m_nPorts) {
+		return ARTNET_EARG;
+	}
+
+	tPortStats = m_pOutputPorts[nPortIndex].tStats;
+
+	return ARTNET_EOK;
+}
+
+void ArtNetNode::ClearPortStats(void) {
+	for (unsigned i = 0; i < m_nPorts; i++) {
+		memset(&m_pOutputPorts[i].tStats, 0, sizeof(struct TArtNetPortStats));
+		m_pOutputPorts[i].nDmxPrevious = 0;
+	}
+}
+
+/**
+ * One ArtDiagData per enabled output port, for example :
+ * "Port 0 [0001] 44/s dmx 1320 out 1298 drop 0 merge 0 miss 2 lat 50% <512us max <2048us"
+ * Only sent when a controller has requested diagnostics.
+ */
+void ArtNetNode::SendPortStats(void) {
+	if (!m_State.SendArtDiagData) {
+		return;
+	}
+
+	char text[192];
+
+	for (unsigned i = 0; i < m_nPorts; i++) {
+		const struct TOutputPort *pPort = &m_pOutputPorts[i];
+
+		if (!pPort->bIsEnabled) {
+			continue;
+		}
+
+		const struct TArtNetPortStats *pStats = &pPort->tStats;
+		char *p = format_text(text, "Port ");
+		p = format_uint32(p, i, 1);
+		p = format_text(p, " [");
+		p = format_hex16(p, pPort->port.nPortAddress);
+		p = format_text(p, "] ");
+		p = format_uint32(p, pStats->nDmxPerSecond, 1);
+		p = format_text(p, "/s dmx ");
+		p = format_uint32(p, pStats->nDmx, 1);
+		p = format_text(p, " out ");
+		p = format_uint32(p, pStats->nOutputs, 1);
+		p = format_text(p, " drop ");
+		p = format_uint32(p, pStats->nDiscarded, 1);
+		p = format_text(p, " merge ");
+		p = format_uint32(p, pStats->nMerges, 1);
+		p = format_text(p, " miss ");
+		p = format_uint32(p, pStats->nSyncMissed, 1);
+
+		uint32_t nTotal = 0;
+		unsigned nMax = 0;
+
+		for (unsigned nBin = 0; nBin < ARTNET_LATENCY_BINS; nBin++) {
+			if (pStats->nLatency[nBin] != 0) {
+				nTotal += pStats->nLatency[nBin];
+				nMax = nBin;
+			}
+		}
+
+		if (nTotal != 0) {
+			uint32_t nCount = 0;
+			unsigned nMedian = 0;
+
+			while ((nCount += pStats->nLatency[nMedian]) * 2 < nTotal) {
+				nMedian++;
+			}
+
+			p = format_text(p, " lat 50% <");
+			p = format_uint32(p, (uint32_t) 1 << (nMedian + 1), 1);
+			p = format_text(p, "us max <");
+			p = format_uint32(p, (uint32_t) 1 << (nMax + 1), 1);
+			p = format_text(p, "us");
+		}
+
+		*p = '\0';
+
+		SendDiag(text, ARTNET_DP_MED);
+	}
+}
+
+uint16_t ArtNetNode::GetPortStatsInterval(void) const {
+	return m_nStatsInterval;
+}
+
+void ArtNetNode::SetPortStatsInterval(uint16_t nSeconds) {
+	m_nStatsInterval = nSeconds;
+	m_nStatsSeconds = 0;
+}
+
+/**
+ * Output the port data, passing the slots changed since the latest output.
+ */
+void ArtNetNode::SendPortData(const uint8_t nPortIndex) {
+	struct TOutputPort *pPort = &m_pOutputPorts[nPortIndex];
+
+	if (pPort->tDirty.nFirst == DMX_SLOT_NONE) {
+		// Direct update without changes, or a clear command : all slots
+		dmx_slot_range_add(&pPort->tDirty, 0, pPort->merge.GetLength() != 0 ? pPort->merge.GetLength() - 1 : 0);
+	}
+
+	m_pLightSet->SetDataRange(nPortIndex, pPort->merge.GetData(), pPort->merge.GetLength(), pPort->tDirty.nFirst, pPort->tDirty.nLast);
+	pPort->tStats.nOutputs++;
+
+	dmx_slot_range_clear(&pPort->tDirty);
+	pPort->IsStartCodeOutput = false;
+
+	if (!m_IsLightSetRunning) {
+		m_pLightSet->Start();
+		m_IsLightSetRunning = true;
+	}
+}
+
+/**
+ * Output all ports waiting for ArtSync, then let the output show them as one frame.
+ */
+void ArtNetNode::CommitFrame(bool bIsSync) {
+	if (!m_State.IsFramePending) {
+		return;
+	}
+
+	for (unsigned i = 0; i < m_nPorts; i++) {
+		if (m_pOutputPorts[i].IsDataPending) {
+			SendPortData(i);
+			m_pOutputPorts[i].IsDataPending = false;
+			UpdateLatency(i);
+		}
+		if (!bIsSync && m_pOutputPorts[i].IsInFrame) {
+			m_pOutputPorts[i].tStats.nSyncMissed++;
+		}
+		m_pOutputPorts[i].IsInFrame = false;
+	}
+
+	m_State.IsFramePending = false;
+
+	if (bIsSync) {
+		m_SyncStats.nFramesSync++;
+		m_SyncStats.nDmxPerFrame = m_State.nFrameDmxCount;
+	} else {
+		m_SyncStats.nFramesFallback++;
+	}
+
+	m_pLightSet->Sync();
+}
+
+/**
+ * Synchronous mode : commit the pending frame when its ArtSync is late,
+ * and leave synchronous mode when ArtSync is no longer received.
+ */
+void ArtNetNode::CheckFrameTimeouts(void) {
+	if (m_State.IsFramePending && (m_nFrameDeadlineMillis != 0)) {
+		// Do not run ahead of a controller with a low ArtSync rate
+		uint32_t nDeadline = m_SyncStats.nSyncIntervalMillis + (m_SyncStats.nSyncIntervalMillis / 2);
+
+		if (nDeadline < m_nFrameDeadlineMillis) {
+			nDeadline = m_nFrameDeadlineMillis;
+		}
+
+		if ((m_nCurrentPacketMillis - m_State.FramePendingMillis) >= nDeadline) {
+			CommitFrame(false);
+		}
+	}
+
+	if ((m_nCurrentPacketMillis - m_State.ArtSyncMillis) >= m_nSyncTimeoutMillis) {
+		m_State.IsSynchronousMode = false;
+		m_SyncStats.nSyncIntervalMillis = 0;
+		CommitFrame(false);
+	}
+}
+
+/**
+ * Follow the merge state of the port in the port status, counting each start of a merge.
+ */
+void ArtNetNode::UpdateMergeStatus(const uint8_t nPortIndex) {
+	struct TOutputPort *pPort = &m_pOutputPorts[nPortIndex];
+	const bool IsMerging = pPort->merge.IsMerging();
+
+	if (IsMerging == ((pPort->port.nStatus & GO_OUTPUT_IS_MERGING) != 0)) {
+		return;
+	}
+
+	m_State.IsChanged = true;
+
+	if (IsMerging) {
+		pPort->tStats.nMerges++;
+		pPort->port.nStatus = pPort->port.nStatus | GO_OUTPUT_IS_MERGING;
+#ifdef SENDDIAG
+		SendDiag("Entering Merging Mode", ARTNET_DP_LOW);
+#endif
+	} else {
+		pPort->port.nStatus = pPort->port.nStatus & ~GO_OUTPUT_IS_MERGING;
+#ifdef SENDDIAG
+		SendDiag("Leaving Merging Mode", ARTNET_DP_LOW);
 #endif
-	network_sendto((const uint8_t *)&(m_PollReply), (const uint16_t)sizeof (struct TArtPollReply), m_Node.IPAddressBroadcast, (uint16_t)ARTNET_UDP_PORT);
+	}
+}
+
+void ArtNetNode::HandlePoll(void) {
+	const struct TArtPoll *packet = (struct TArtPoll *)&(m_pArtNetPacket->ArtPacket.ArtPoll);
+
+	if (packet->TalkToMe & TTM_SEND_ARTP_ON_CHANGE) {
+		m_State.SendArtPollReplyOnChange = true;
+	} else {
+		m_State.SendArtPollReplyOnChange = false;
+	}
+
+	// If any controller requests diagnostics, the node will send diagnostics. (ArtPoll->TalkToMe->2).
+	if (packet->TalkToMe & TTM_SEND_DIAG_MESSAGES) {
+		m_State.SendArtDiagData = true;
+
+		if (m_State.IPAddressArtPoll == 0) {
+			m_State.IPAddressArtPoll = m_pArtNetPacket->IPAddressFrom;
+		} else if (!m_State.IsMultipleControllersReqDiag && (m_State.IPAddressArtPoll != m_pArtNetPacket->IPAddressFrom)) {
+			// If there are multiple controllers requesting diagnostics, diagnostics shall be broadcast.
+			m_State.IPAddressDiagSend = m_Node.IPAddressBroadcast;
+			m_State.IsMultipleControllersReqDiag = true;
+		}
+
+		if (m_State.IsMultipleControllersReqDiag ) {
+			// The lowest minimum value of Priority shall be used. (Ignore ArtPoll->Priority).
+			m_State.Priority = min(m_State.Priority , packet->Priority);
+		} else {
+			m_State.Priority = packet->Priority;
+		}
+
+		// If there are multiple controllers requesting diagnostics, diagnostics shall be broadcast. (Ignore ArtPoll->TalkToMe->3).
+		if (!m_State.IsMultipleControllersReqDiag && (packet->TalkToMe & TTM_SEND_DIAG_UNICAST)) {
+			m_State.IPAddressDiagSend = m_pArtNetPacket->IPAddressFrom;
+		} else {
+			m_State.IPAddressDiagSend = m_Node.IPAddressBroadcast;
+		}
+	} else {
+		m_State.SendArtDiagData = false;
+		m_State.IPAddressDiagSend = (uint32_t) 0;
+	}
+
+	if (m_State.nActiveInputPorts != 0) {
+		AddSubscriber(m_pArtNetPacket->IPAddressFrom, 0, true);
+	}
+
+	SchedulePollReply();
+}
+
+/**
+ * Input ports : a node with an output port on the same Port-Address subscribes to the ArtDmx.
+ */
+void ArtNetNode::HandlePollReply(void) {
+	const struct TArtPollReply *packet = (struct TArtPollReply *) &(m_pArtNetPacket->ArtPacket.ArtPollReply);
+
+	if (m_pArtNetPacket->IPAddressFrom == m_Node.IPAddressLocal) {
+		return;
+	}
+
+	for (unsigned i = 0; i < ARTNET_MAX_PORTS; i++) {
+		if ((packet->PortTypes[i] & ARTNET_ENABLE_OUTPUT) == 0) {
+			continue;
+		}
+
+		uint16_t nPortAddress = (packet->NetSwitch & 0x7F) << 8;
+		nPortAddress |= (packet->SubSwitch & (uint8_t)0x0F) << 4;
+		nPortAddress |= packet->SwOut[i] & (uint16_t)0x0F;
+
+		for (unsigned j = 0; j < m_nPorts; j++) {
+			if (m_pInputPorts[j].bIsEnabled && (m_pInputPorts[j].port.nPortAddress == nPortAddress)) {
+				AddSubscriber(m_pArtNetPacket->IPAddressFrom, nPortAddress, false);
+				break;
+			}
+		}
+	}
+}
+
+void ArtNetNode::AddSubscriber(const uint32_t nIPAddress, const uint16_t nPortAddress, const bool IsController) {
+	const uint32_t nMillis = millis();
+	unsigned nEntry = ARTNET_MAX_SUBSCRIBERS;
+
+	for (unsigned i = 0; i < m_nSubscribers; i++) {
+		struct TArtNetSubscriber *pSubscriber = &m_Subscribers[i];
+
+		if ((pSubscriber->nIPAddress == nIPAddress) && (pSubscriber->IsController == IsController) && (IsController || (pSubscriber->nPortAddress == nPortAddress))) {
+			pSubscriber->nMillis = nMillis;
+			return;
+		}
+
+		if ((nEntry == ARTNET_MAX_SUBSCRIBERS) && ((nMillis - pSubscriber->nMillis) >= ARTNET_SUBSCRIBER_TIMEOUT_MILLIS)) {
+			nEntry = i;	// Reuse an expired entry
+		}
+	}
+
+	if (nEntry == ARTNET_MAX_SUBSCRIBERS) {
+		if (m_nSubscribers == ARTNET_MAX_SUBSCRIBERS) {
+			return;		// Table is full
+		}
+		nEntry = m_nSubscribers++;
+	}
+
+	m_Subscribers[nEntry].nIPAddress = nIPAddress;
+	m_Subscribers[nEntry].nPortAddress = nPortAddress;
+	m_Subscribers[nEntry].IsController = IsController;
+	m_Subscribers[nEntry].nMillis = nMillis;
+}
+
+uint16_t ArtNetNode::GetInputKeepAlive(void) const {
+	return m_nInputKeepAliveMillis;
+}
+
+void ArtNetNode::SetInputKeepAlive(uint16_t nInputKeepAliveMillis) {
+	if (nInputKeepAliveMillis != 0) {
+		m_nInputKeepAliveMillis = nInputKeepAliveMillis;
+	}
 }
 
-void ArtNetNode::SendDiag(const char *text, TPriorityCodes nPriority) {
-	if (!m_State.SendArtDiagData) {
+uint16_t ArtNetNode::GetInputMinInterval(void) const {
+	return m_nInputMinIntervalMillis;
+}
+
+void ArtNetNode::SetInputMinInterval(uint16_t nInputMinIntervalMillis) {
+	m_nInputMinIntervalMillis = nInputMinIntervalMillis;
+}
+
+/**
+ * DMX input for an input port. The changed slots are copied into the ArtDmx packet of the port,
+ * which is sent at once unless the rate limit holds it back.
+ */
+void ArtNetNode::SendDmx(const uint8_t nPortIndex, const uint8_t *pDmxData, uint16_t nLength) {
+	assert(pDmxData != 0);
+
+	if ((m_pInputPorts == 0) || (nPortIndex >= m_nPorts) || !m_pInputPorts[nPortIndex].bIsEnabled) {
+		return;
+	}
+
+	struct TInputPort *pPort = &m_pInputPorts[nPortIndex];
+
+	if (nLength > ARTNET_DMX_LENGTH) {
+		nLength = ARTNET_DMX_LENGTH;
+	}
+
+	if (nLength != pPort->nLength) {
+		dmx_kernel_copy_ltp(pPort->ArtDmx.Data, pDmxData, nLength);
+		if ((nLength & 0x01) != 0) {
+			pPort->ArtDmx.Data[nLength] = 0;	// The ArtDmx length is even
+		}
+		pPort->nLength = nLength;
+	} else if (!dmx_kernel_copy_changed(pPort->ArtDmx.Data, pDmxData, nLength, 0)) {
 		return;
 	}
 
-	if (nPriority < m_State.Priority) {
-		return;
+	pPort->port.nStatus = pPort->port.nStatus | GI_DATA_RECEIVED;
+
+	const uint32_t nMillis = millis();
+
+	if ((nMillis - pPort->nMillis) >= m_nInputMinIntervalMillis) {
+		SendInputPort(nPortIndex, nMillis);
+	} else {
+		pPort->IsDataPending = true;
 	}
+}
 
-	m_DiagData.Priority = nPriority;
+void ArtNetNode::SendInputPort(const uint8_t nPortIndex, const uint32_t nMillis) {
+	struct TInputPort *pPort = &m_pInputPorts[nPortIndex];
+	struct TArtDmx *pArtDmx = &pPort->ArtDmx;
 
-	strncpy((char *) m_DiagData.Data, text, sizeof m_DiagData.Data);
-	m_DiagData.Data[sizeof(m_DiagData.Data) - 1] = '\0';				// Just be sure we have a last '\0'
-	m_DiagData.LengthLo = strlen((const char *) m_DiagData.Data) + 1;	// Text length including the '\0'
+	const uint16_t nDataLength = pPort->nLength < 2 ? 2 : (pPort->nLength + 1) & ~1;
+	const uint16_t nSize = (uint16_t) (sizeof(struct TArtDmx) - ARTNET_DMX_LENGTH + nDataLength);
 
-	unsigned size = sizeof(struct TArtDiagData) - sizeof(m_DiagData.Data) + m_DiagData.LengthLo;
+	if (++pArtDmx->Sequence == 0) {
+		pArtDmx->Sequence = 1;	// 0 disables the sequence check
+	}
 
-	network_sendto((const uint8_t *)&(m_DiagData), (const uint16_t)size, m_State.IPAddressDiagSend, (uint16_t)ARTNET_UDP_PORT);
-}
+	pArtDmx->PortAddress = pPort->port.nPortAddress;
+	pArtDmx->LengthHi = (uint8_t) (nDataLength >> 8);
+	pArtDmx->Length = (uint8_t) (nDataLength & 0xFF);
 
-bool ArtNetNode::IsDmxDataChanged(const uint8_t nPortId, const uint8_t *pData, const uint16_t nLength) {
-	bool isChanged = false;
+	bool bIsSent = false;
 
-	uint8_t *src = (uint8_t *) pData;
-	uint8_t *dst = m_OutputPorts[nPortId].data;
+	for (unsigned i = 0; i < m_nSubscribers; i++) {
+		const struct TArtNetSubscriber *pSubscriber = &m_Subscribers[i];
 
-	if (nLength != m_OutputPorts[nPortId].nLength) {
-		m_OutputPorts[nPortId].nLength = nLength;
+		if ((nMillis - pSubscriber->nMillis) >= ARTNET_SUBSCRIBER_TIMEOUT_MILLIS) {
+			continue;
+		}
 
-		for (unsigned i = 0 ; i < ARTNET_DMX_LENGTH; i++) {
-			*dst++ = *src++;
+		if (pSubscriber->IsController || (pSubscriber->nPortAddress == pPort->port.nPortAddress)) {
+			network_sendto((const uint8_t *) pArtDmx, nSize, pSubscriber->nIPAddress, (uint16_t) ARTNET_UDP_PORT);
+			bIsSent = true;
 		}
-		return true;
 	}
 
-	for (unsigned i = 0; i < ARTNET_DMX_LENGTH; i++) {
-		if (*dst != *src) {
-			*dst = *src;
-			isChanged = true;
-		}
-		dst++;
-		src++;
+	if (!bIsSent) {
+		network_sendto((const uint8_t *) pArtDmx, nSize, m_Node.IPAddressBroadcast, (uint16_t) ARTNET_UDP_PORT);
 	}
 
-	return isChanged;
+	pPort->nMillis = nMillis;
+	pPort->IsDataPending = false;
 }
 
-bool ArtNetNode::IsMergedDmxDataChanged(const uint8_t nPortId, const uint8_t *pData, const uint16_t nLength) {
-	bool isChanged = false;
+/**
+ * Send the DMX input held back by the rate limit, and the keep-alive of unchanged DMX input.
+ */
+void ArtNetNode::CheckInputPorts(void) {
+	for (unsigned i = 0; i < m_nPorts; i++) {
+		const struct TInputPort *pPort = &m_pInputPorts[i];
+
+		if (!pPort->bIsEnabled || (pPort->nLength == 0)) {
+			continue;
+		}
+
+		const uint32_t nElapsed = m_nCurrentPacketMillis - pPort->nMillis;
 
-	if (!m_State.IsMergeMode) {
-		m_State.IsMergeMode = true;
-		m_State.IsChanged = true;
-		uint8_t nStatus = m_OutputPorts[nPortId].port.nStatus;
-		m_OutputPorts[nPortId].port.nStatus = nStatus | (1 << 3);	// Bit 3 : Set – Output is merging ArtNet data.
+		if ((pPort->IsDataPending && (nElapsed >= m_nInputMinIntervalMillis)) || (nElapsed >= m_nInputKeepAliveMillis)) {
+			SendInputPort(i, m_nCurrentPacketMillis);
+		}
 	}
+}
 
+void ArtNetNode::HandleDmx(void) {
+	const struct TArtDmx *packet = (struct TArtDmx *)&(m_pArtNetPacket->ArtPacket.ArtDmx);
 
-	if (m_OutputPorts[nPortId].mergeMode == ARTNET_MERGE_HTP) {
+	if ((m_State.nActiveInputPorts != 0) && (m_pArtNetPacket->IPAddressFrom == m_Node.IPAddressLocal)) {
+		return;	// The broadcast of our own input ports
+	}
 
-		if (nLength != m_OutputPorts[nPortId].nLength) {
-			m_OutputPorts[nPortId].nLength = nLength;
-			for (unsigned i = 0; i < nLength; i++) {
-				uint8_t data = max(m_OutputPorts[nPortId].dataA[i], m_OutputPorts[nPortId].dataB[i]);
-				m_OutputPorts[nPortId].data[i] = data;
-			}
-			return true;
-		}
+	unsigned data_length = (unsigned) ((packet->LengthHi << 8) & 0xff00) | (packet->Length);
+	data_length = min(data_length, ARTNET_DMX_LENGTH);
+	data_length = min(data_length, (unsigned) m_pArtNetPacket->length - (unsigned) __builtin_offsetof(struct TArtDmx, Data));
 
-		for (unsigned i = 0; i < nLength; i++) {
-			uint8_t data = max(m_OutputPorts[nPortId].dataA[i], m_OutputPorts[nPortId].dataB[i]);
-			if (data != m_OutputPorts[nPortId].data[i]) {
-				m_OutputPorts[nPortId].data[i] = data;
-				isChanged = true;
-			}
-		}
+	const uint16_t nPortAddress = packet->PortAddress;
 
-		return isChanged;
-	} else {
-		return IsDmxDataChanged(nPortId, pData, nLength);
+	// More than one local port can be bound to the same Port-Address
+	for (uint8_t i = m_PortAddressHash[nPortAddress & (ARTNET_PORT_ADDRESS_HASH_SIZE - 1)]; i != ARTNET_PORT_INDEX_NONE; i = m_pOutputPorts[i].nNextPortIndex) {
+		if (m_pOutputPorts[i].port.nPortAddress == nPortAddress) {
+			HandleDmxPort(i, packet->Data, (uint16_t) data_length);
+		}
 	}
 }
 
-void ArtNetNode::CheckMergeTimeouts(const uint8_t nPortId) {
-	const time_t timeOutA = m_nCurrentPacketTime - m_OutputPorts[nPortId].timeA;
-	const time_t timeOutB = m_nCurrentPacketTime - m_OutputPorts[nPortId].timeB;
+/**
+ * ArtNzs : the data is passed on from the receive buffer, it is not merged and not stored.
+ */
+void ArtNetNode::HandleNzs(void) {
+	const struct TArtNzs *packet = (struct TArtNzs *)&(m_pArtNetPacket->ArtPacket.ArtNzs);
 
-	if (timeOutA > (time_t)ARTNET_MERGE_TIMEOUT_SECONDS) {
-		m_OutputPorts[nPortId].ipA = 0;
-		m_State.IsMergeMode = false;
+	if ((packet->StartCode == 0) || (packet->StartCode == NZS_START_CODE_RDM)) {
+		return;
 	}
 
-	if (timeOutB > (time_t)ARTNET_MERGE_TIMEOUT_SECONDS) {
-		m_OutputPorts[nPortId].ipB = 0;
-		m_State.IsMergeMode = false;
+	if ((m_State.nActiveInputPorts != 0) && (m_pArtNetPacket->IPAddressFrom == m_Node.IPAddressLocal)) {
+		return;
 	}
 
-	if (!m_State.IsMergeMode) {
-		m_State.IsChanged = true;
-		const uint8_t nStatus = m_OutputPorts[nPortId].port.nStatus;
-		m_OutputPorts[nPortId].port.nStatus = nStatus & ~GO_OUTPUT_IS_MERGING;
-#ifdef SENDDIAG
-		SendDiag("Leaving Merging Mode", ARTNET_DP_LOW);
-#endif
+	unsigned data_length = (unsigned) ((packet->LengthHi << 8) & 0xff00) | (packet->Length);
+	data_length = min(data_length, ARTNET_DMX_LENGTH);
+	data_length = min(data_length, (unsigned) m_pArtNetPacket->length - (unsigned) __builtin_offsetof(struct TArtNzs, Data));
+
+	const uint16_t nPortAddress = packet->PortAddress;
+
+	for (uint8_t i = m_PortAddressHash[nPortAddress & (ARTNET_PORT_ADDRESS_HASH_SIZE - 1)]; i != ARTNET_PORT_INDEX_NONE; i = m_pOutputPorts[i].nNextPortIndex) {
+		struct TOutputPort *pPort = &m_pOutputPorts[i];
+
+		if (pPort->port.nPortAddress != nPortAddress) {
+			continue;
+		}
+
+		m_pLightSet->SetStartCodeData(i, packet->StartCode, packet->Data, (uint16_t) data_length);
+
+		// The next ArtDmx restores all slots of the output
+		if (pPort->merge.GetLength() != 0) {
+			dmx_slot_range_add(&pPort->tDirty, 0, pPort->merge.GetLength() - 1);
+		}
+		pPort->IsStartCodeOutput = true;
 	}
 }
 
-void ArtNetNode::HandlePoll(void) {
-	const struct TArtPoll *packet = (struct TArtPoll *)&(m_ArtNetPacket.ArtPacket.ArtPoll);
+void ArtNetNode::HandleDmxPort(const uint8_t i, const uint8_t *pData, const uint16_t nLength) {
+	struct TOutputPort *pPort = &m_pOutputPorts[i];
 
-	if (packet->TalkToMe & TTM_SEND_ARTP_ON_CHANGE) {
-		m_State.SendArtPollReplyOnChange = true;
-	} else {
-		m_State.SendArtPollReplyOnChange = false;
+	pPort->port.nStatus = pPort->port.nStatus | GO_DATA_IS_BEING_TRANSMITTED;
+	pPort->tStats.nDmx++;
+
+	if (pPort->IsMergeCancel) {
+		pPort->IsMergeCancel = false;
+		pPort->merge.Reset();
 	}
 
-	// If any controller requests diagnostics, the node will send diagnostics. (ArtPoll->TalkToMe->2).
-	if (packet->TalkToMe & TTM_SEND_DIAG_MESSAGES) {
-		m_State.SendArtDiagData = true;
+	// A source timing out changes the output as well
+	bool sendNewData = pPort->merge.CheckTimeouts(m_nCurrentPacketMillis, &pPort->tDirty);
 
-		if (m_State.IPAddressArtPoll == 0) {
-			m_State.IPAddressArtPoll = m_ArtNetPacket.IPAddressFrom;
-		} else if (!m_State.IsMultipleControllersReqDiag && (m_State.IPAddressArtPoll != m_ArtNetPacket.IPAddressFrom)) {
-			// If there are multiple controllers requesting diagnostics, diagnostics shall be broadcast.
-			m_State.IPAddressDiagSend = m_Node.IPAddressBroadcast;
-			m_State.IsMultipleControllersReqDiag = true;
+	if (m_State.IsSynchronousMode) {
+		if (pPort->IsInFrame && !pPort->merge.IsMerging()) {
+			// A second ArtDMX for this port within the frame : the ArtSync has been missed
+			CommitFrame(false);
 		}
 
-		if (m_State.IsMultipleControllersReqDiag ) {
-			// The lowest minimum value of Priority shall be used. (Ignore ArtPoll->Priority).
-			m_State.Priority = min(m_State.Priority , packet->Priority);
-		} else {
-			m_State.Priority = packet->Priority;
+		if (!m_State.IsFramePending) {
+			m_State.IsFramePending = true;
+			m_State.FramePendingMillis = m_nCurrentPacketMillis;
+			m_State.nFrameDmxCount = 0;
 		}
 
-		// If there are multiple controllers requesting diagnostics, diagnostics shall be broadcast. (Ignore ArtPoll->TalkToMe->3).
-		if (!m_State.IsMultipleControllersReqDiag && (packet->TalkToMe & TTM_SEND_DIAG_UNICAST)) {
-			m_State.IPAddressDiagSend = m_ArtNetPacket.IPAddressFrom;
-		} else {
-			m_State.IPAddressDiagSend = m_Node.IPAddressBroadcast;
+		pPort->IsInFrame = true;
+
+		if (m_State.nFrameDmxCount != (uint8_t) ~0) {
+			m_State.nFrameDmxCount++;
 		}
-	} else {
-		m_State.SendArtDiagData = false;
-		m_State.IPAddressDiagSend = (uint32_t) 0;
 	}
 
-	SendPollRelply(true);
-}
-
-void ArtNetNode::HandleDmx(void) {
-	const struct TArtDmx *packet = (struct TArtDmx *)&(m_ArtNetPacket.ArtPacket.ArtDmx);
+	uint8_t nSource = pPort->merge.FindSource(m_pArtNetPacket->IPAddressFrom, m_pArtNetPacket->PortFrom);
 
-	unsigned data_length = (unsigned) ((packet->LengthHi << 8) & 0xff00) | (packet->Length);
-	data_length = min(data_length, ARTNET_DMX_LENGTH);
+	if (nSource == DMX_MERGE_SOURCE_NONE) {
+		nSource = pPort->merge.AddSource(m_pArtNetPacket->IPAddressFrom, m_pArtNetPacket->PortFrom, m_nCurrentPacketMillis);
 
-	for (unsigned i = 0; i < ARTNET_MAX_PORTS; i++) {
-		if ((packet->PortAddress == m_OutputPorts[i].port.nPortAddress) &&  m_OutputPorts[i].bIsEnabled) {
+		if (nSource == DMX_MERGE_SOURCE_NONE) {
+			SendDiag("Source table full, discarding data", ARTNET_DP_LOW);
+			pPort->tStats.nDiscarded++;
+			UpdateMergeStatus(i);
+			return;
+		}
+	}
 
-			uint32_t ipA = m_OutputPorts[i].ipA;
-			uint32_t ipB = m_OutputPorts[i].ipB;
+	m_LossPolicy.Received(m_nCurrentPacketMillis);
 
-			bool sendNewData = false;
+	// Art-Net has no priority : all sources are merged
+	if (pPort->merge.SetSourceData(nSource, pData, nLength, DMX_MERGE_PRIORITY_DEFAULT, m_nCurrentPacketMillis, &pPort->tDirty)) {
+		sendNewData = true;
+	}
 
-			m_OutputPorts[i].port.nStatus = m_OutputPorts[i].port.nStatus |GO_DATA_IS_BEING_TRANSMITTED;
+	UpdateMergeStatus(i);
 
-			if (m_State.IsMergeMode) {
-				CheckMergeTimeouts(i);
-			}
+	if (sendNewData || m_bDirectUpdate || m_pOutputPorts[i].IsStartCodeOutput) {
+		if (!m_pOutputPorts[i].IsDataPending) {
+			m_pOutputPorts[i].nDataMicros = m_nCurrentPacketMicros;
+		}
 
-			if (ipA == 0 && ipB == 0) {
-#ifdef SENDDIAG
-				SendDiag("1. first packet recv on this port", ARTNET_DP_LOW);
-#endif
-				m_OutputPorts[i].ipA = m_ArtNetPacket.IPAddressFrom;
-				m_OutputPorts[i].timeA = m_nCurrentPacketTime;
-				memcpy(&m_OutputPorts[i].dataA, packet->Data, data_length);
-				sendNewData = IsDmxDataChanged(i, packet->Data, data_length);
-			} else if (ipA == m_ArtNetPacket.IPAddressFrom && ipB == 0) {
-#ifdef SENDDIAG
-				SendDiag("2. continued transmission from the same ip (source A)", ARTNET_DP_LOW);
-#endif
-				m_OutputPorts[i].timeA = m_nCurrentPacketTime;
-				memcpy(&m_OutputPorts[i].dataA, packet->Data, data_length);
-				sendNewData = IsDmxDataChanged(i, packet->Data, data_length);
-			} else if (ipA == 0 && ipB == m_ArtNetPacket.IPAddressFrom) {
-#ifdef SENDDIAG
-				SendDiag("3. continued transmission from the same ip (source B)", ARTNET_DP_LOW);
-#endif
-				m_OutputPorts[i].timeB = m_nCurrentPacketTime;
-				memcpy(&m_OutputPorts[i].dataB, packet->Data, data_length);
-				sendNewData = IsDmxDataChanged(i, packet->Data, data_length);
-			} else if (ipA != m_ArtNetPacket.IPAddressFrom && ipB == 0) {
-#ifdef SENDDIAG
-				SendDiag("4. new source, start the merge", ARTNET_DP_LOW);
-#endif
-				m_OutputPorts[i].ipB = m_ArtNetPacket.IPAddressFrom;
-				m_OutputPorts[i].timeB = m_nCurrentPacketTime;
-				memcpy(&m_OutputPorts[i].dataB, packet->Data, data_length);
-				sendNewData = IsMergedDmxDataChanged(i, m_OutputPorts[i].dataB, data_length);
-			} else if (ipA == 0 && ipB != m_ArtNetPacket.IPAddressFrom) {
+		if (!m_State.IsSynchronousMode) {
 #ifdef SENDDIAG
-				SendDiag("5. new source, start the merge", ARTNET_DP_LOW);
+			SendDiag("Send new data", ARTNET_DP_LOW);
 #endif
-				m_OutputPorts[i].ipA = m_ArtNetPacket.IPAddressFrom;
-				m_OutputPorts[i].timeA = m_nCurrentPacketTime;
-				memcpy(&m_OutputPorts[i].dataA, packet->Data, data_length);
-				sendNewData = IsMergedDmxDataChanged(i, m_OutputPorts[i].dataA, data_length);
-			} else if (ipA == m_ArtNetPacket.IPAddressFrom && ipB != m_ArtNetPacket.IPAddressFrom) {
+			SendPortData(i);
+			UpdateLatency(i);
+		} else {
 #ifdef SENDDIAG
-				SendDiag("6. continue merge", ARTNET_DP_LOW);
+			SendDiag("DMX data pending", ARTNET_DP_LOW);
 #endif
-				m_OutputPorts[i].timeA = m_nCurrentPacketTime;
-				memcpy(&m_OutputPorts[i].dataA, packet->Data, data_length);
-				sendNewData = IsMergedDmxDataChanged(i, m_OutputPorts[i].dataA, data_length);
-			} else if (ipA != m_ArtNetPacket.IPAddressFrom && ipB == m_ArtNetPacket.IPAddressFrom) {
+			m_pOutputPorts[i].IsDataPending = true;
+		}
+	} else {
 #ifdef SENDDIAG
-				SendDiag("7. continue merge", ARTNET_DP_LOW);
+		SendDiag("Data not changed", ARTNET_DP_LOW);
 #endif
-				m_OutputPorts[i].timeB = m_nCurrentPacketTime;
-				memcpy(&m_OutputPorts[i].dataB, packet->Data, data_length);
-				sendNewData = IsMergedDmxDataChanged(i, m_OutputPorts[i].dataB, data_length);
-			} else if (ipA == m_ArtNetPacket.IPAddressFrom && ipB == m_ArtNetPacket.IPAddressFrom) {
-				SendDiag("8. Source matches both buffers, this shouldn't be happening!", ARTNET_DP_LOW);
-				return;
-			} else if (ipA != m_ArtNetPacket.IPAddressFrom && ipB != m_ArtNetPacket.IPAddressFrom) {
-				SendDiag("9. More than two sources, discarding data", ARTNET_DP_LOW);
-				return;
-			} else {
-				SendDiag("0. No cases matched, this shouldn't happen!", ARTNET_DP_LOW);
-				return;
-			}
+	}
+}
 
-			if (sendNewData || m_bDirectUpdate) {
-				if (!m_State.IsSynchronousMode) {
-#ifdef SENDDIAG
-					SendDiag("Send new data", ARTNET_DP_LOW);
-#endif
-					m_pLightSet->SetData(i, m_OutputPorts[i].data, m_OutputPorts[i].nLength);
+void ArtNetNode::HandleSync(void) {
+	if (m_State.IsSynchronousMode) {
+		const uint32_t nInterval = m_nCurrentPacketMillis - m_State.ArtSyncMillis;
 
-					if(!m_IsLightSetRunning) {
-						m_pLightSet->Start();
-						m_IsLightSetRunning = true;
-					}
-				} else {
-#ifdef SENDDIAG
-					SendDiag("DMX data pending", ARTNET_DP_LOW);
-#endif
-					m_OutputPorts[i].IsDataPending = true;
-				}
-			} else {
-#ifdef SENDDIAG
-				SendDiag("Data not changed", ARTNET_DP_LOW);
-#endif
-			}
-			// Discontinue the loop. No need to return for other ports
-			return;
+		if (m_SyncStats.nSyncIntervalMillis == 0) {
+			m_SyncStats.nSyncIntervalMillis = (uint16_t) nInterval;
+		} else {
+			m_SyncStats.nSyncIntervalMillis = (uint16_t) (((3 * (uint32_t) m_SyncStats.nSyncIntervalMillis) + nInterval) / 4);
 		}
 	}
-}
 
-void ArtNetNode::HandleSync(void) {
 	m_State.IsSynchronousMode = true;
-#if defined (__circle__)
-	m_State.ArtSyncTime = CTimer::Get ()->GetTime ();
-#else
-	m_State.ArtSyncTime = time(NULL);
-#endif
-	for (unsigned i = 0; i < ARTNET_MAX_PORTS; i++) {
-		if (m_OutputPorts[i].IsDataPending) {
+	m_State.ArtSyncMillis = m_nCurrentPacketMillis;
 #ifdef SENDDIAG
-			SendDiag("Send pending data", ARTNET_DP_LOW);
+	SendDiag("Send pending data", ARTNET_DP_LOW);
 #endif
-			m_pLightSet->SetData(i, m_OutputPorts[i].data, 	m_OutputPorts[i].nLength);
-			if(!m_IsLightSetRunning) {
-				m_pLightSet->Start();
-				m_IsLightSetRunning = true;
-			}
-			m_OutputPorts[i].IsDataPending = false;
-		}
-	}
+	CommitFrame(true);
 }
 
 void ArtNetNode::HandleAddress(void) {
-	const struct TArtAddress *packet = (struct TArtAddress *) &(m_ArtNetPacket.ArtPacket.ArtAddress);
-	bool bClearCommand = false;
+	const struct TArtAddress *packet = (struct TArtAddress *) &(m_pArtNetPacket->ArtPacket.ArtAddress);
 
 	m_State.reportCode = ARTNET_RCPOWEROK;
 
@@ -791,33 +1614,57 @@ void ArtNetNode::HandleAddress(void) {
 		m_State.reportCode = ARTNET_RCLONAMEOK;
 	}
 
+	// BindIndex 0 and 1 both address the root device (page 0)
+	const uint8_t nPage = packet->BindIndex > 0 ? packet->BindIndex - 1 : 0;
+
+	if (nPage >= m_nPages) {
+		return;
+	}
+
+	const uint8_t nPageOffset = nPage * ARTNET_MAX_PORTS;
+
 	if (packet->SubSwitch == PROGRAM_DEFAULTS) {
-		SetSubnetSwitch(NODE_DEFAULT_SUBNET_SWITCH);
+		SetSubnetSwitch(NODE_DEFAULT_SUBNET_SWITCH, nPage);
 	} else if (packet->SubSwitch & PROGRAM_CHANGE_MASK) {
-		SetSubnetSwitch(packet->SubSwitch & ~PROGRAM_CHANGE_MASK);
+		SetSubnetSwitch(packet->SubSwitch & ~PROGRAM_CHANGE_MASK, nPage);
 	}
 
 	if (packet->NetSwitch == PROGRAM_DEFAULTS) {
-		SetNetSwitch(NODE_DEFAULT_NET_SWITCH);
+		SetNetSwitch(NODE_DEFAULT_NET_SWITCH, nPage);
 	} else if (packet->NetSwitch & PROGRAM_CHANGE_MASK) {
-		SetNetSwitch(packet->NetSwitch & ~PROGRAM_CHANGE_MASK);
+		SetNetSwitch(packet->NetSwitch & ~PROGRAM_CHANGE_MASK, nPage);
+	}
+
+	for (unsigned i = 0; i < ARTNET_MAX_PORTS; i++) {
+		if ((m_pInputPorts == 0) || !m_pInputPorts[nPageOffset + i].bIsEnabled || (packet->SwIn[i] == PROGRAM_NO_CHANGE)) {
+			continue;
+		} else if (packet->SwIn[i] == PROGRAM_DEFAULTS) {
+			SetUniverseSwitch(nPageOffset + i, ARTNET_INPUT_PORT, NODE_DEFAULT_UNIVERSE);
+		} else if (packet->SwIn[i] & PROGRAM_CHANGE_MASK) {
+			SetUniverseSwitch(nPageOffset + i, ARTNET_INPUT_PORT, packet->SwIn[i] & ~PROGRAM_CHANGE_MASK);
+		}
 	}
 
 	for (unsigned i = 0; i < ARTNET_MAX_PORTS; i++) {
 		if (packet->SwOut[i] == PROGRAM_NO_CHANGE) {
 			continue;
 		} else if (packet->SwOut[i] == PROGRAM_DEFAULTS) {
-			SetUniverseSwitch(i, ARTNET_OUTPUT_PORT, NODE_DEFAULT_UNIVERSE);
+			SetUniverseSwitch(nPageOffset + i, ARTNET_OUTPUT_PORT, NODE_DEFAULT_UNIVERSE);
 		} else if (packet->SwOut[i] & PROGRAM_CHANGE_MASK) {
-			SetUniverseSwitch(i, ARTNET_OUTPUT_PORT, packet->SwOut[i] & ~PROGRAM_CHANGE_MASK);
+			SetUniverseSwitch(nPageOffset + i, ARTNET_OUTPUT_PORT, packet->SwOut[i] & ~PROGRAM_CHANGE_MASK);
 		}
 	}
+
+	// The port commands apply to the ports of the addressed page
+	const uint8_t nPortIndex = nPageOffset + (packet->Command & 0x03);
+
 	switch (packet->Command) {
 	case ARTNET_PC_CANCEL:
 		// If Node is currently in merge mode, cancel merge mode upon receipt of next ArtDmx packet.
-		m_State.IsMergeMode = false;
-		for (unsigned i = 0; i < ARTNET_MAX_PORTS; i++) {
-			m_OutputPorts[i].port.nStatus = m_OutputPorts[i].port.nStatus & ~GO_OUTPUT_IS_MERGING;
+		for (unsigned i = nPageOffset; i < (unsigned) nPageOffset + ARTNET_MAX_PORTS; i++) {
+			if (m_pOutputPorts[i].merge.IsMerging()) {
+				m_pOutputPorts[i].IsMergeCancel = true;
+			}
 		}
 #ifdef SENDDIAG
 		SendDiag("Leaving Merging Mode", ARTNET_DP_LOW);
@@ -839,103 +1686,43 @@ void ArtNetNode::HandleAddress(void) {
 		}
 		break;
 	case ARTNET_PC_MERGE_LTP_O:
-		m_OutputPorts[0].mergeMode = ARTNET_MERGE_LTP;
-		m_OutputPorts[0].port.nStatus = m_OutputPorts[0].port.nStatus | GO_MERGE_MODE_LTP;
-#ifdef SENDDIAG
-		SendDiag("Setting Merge Mode LTP_0", ARTNET_DP_LOW);
-#endif
-		break;
 	case ARTNET_PC_MERGE_LTP_1:
-		m_OutputPorts[1].mergeMode = ARTNET_MERGE_LTP;
-		m_OutputPorts[1].port.nStatus = m_OutputPorts[1].port.nStatus | GO_MERGE_MODE_LTP;
-#ifdef SENDDIAG
-		SendDiag("Setting Merge Mode LTP_1", ARTNET_DP_LOW);
-#endif
-		break;
 	case ARTNET_PC_MERGE_LTP_2:
-		m_OutputPorts[2].mergeMode = ARTNET_MERGE_LTP;
-		m_OutputPorts[2].port.nStatus = m_OutputPorts[2].port.nStatus | GO_MERGE_MODE_LTP;
-#ifdef SENDDIAG
-		SendDiag("Setting Merge Mode LTP_2", ARTNET_DP_LOW);
-#endif
-		break;
 	case ARTNET_PC_MERGE_LTP_3:
-		m_OutputPorts[3].mergeMode = ARTNET_MERGE_LTP;
-		m_OutputPorts[3].port.nStatus = m_OutputPorts[3].port.nStatus | GO_MERGE_MODE_LTP;
+		m_pOutputPorts[nPortIndex].merge.SetMode(DMX_MERGE_LTP);
+		m_pOutputPorts[nPortIndex].port.nStatus = m_pOutputPorts[nPortIndex].port.nStatus | GO_MERGE_MODE_LTP;
 #ifdef SENDDIAG
-		SendDiag("Setting Merge Mode LTP_1", ARTNET_DP_LOW);
+		SendDiag("Setting Merge Mode LTP", ARTNET_DP_LOW);
 #endif
 		break;
 	case ARTNET_PC_MERGE_HTP_0:
-		m_OutputPorts[0].mergeMode = ARTNET_MERGE_HTP;
-		m_OutputPorts[0].port.nStatus = m_OutputPorts[0].port.nStatus & ~GO_MERGE_MODE_LTP;
-#ifdef SENDDIAG
-		SendDiag("Setting Merge Mode HTP_0", ARTNET_DP_LOW);
-#endif
-		break;
 	case ARTNET_PC_MERGE_HTP_1:
-		m_OutputPorts[1].mergeMode = ARTNET_MERGE_HTP;
-		m_OutputPorts[1].port.nStatus = m_OutputPorts[1].port.nStatus & ~GO_MERGE_MODE_LTP;
-#ifdef SENDDIAG
-		SendDiag("Setting Merge Mode HTP_1", ARTNET_DP_LOW);
-#endif
-		break;
 	case ARTNET_PC_MERGE_HTP_2:
-		m_OutputPorts[2].mergeMode = ARTNET_MERGE_HTP;
-		m_OutputPorts[2].port.nStatus = m_OutputPorts[2].port.nStatus & ~GO_MERGE_MODE_LTP;
-#ifdef SENDDIAG
-		SendDiag("Setting Merge Mode HTP_2", ARTNET_DP_LOW);
-#endif
-		break;
 	case ARTNET_PC_MERGE_HTP_3:
-		m_OutputPorts[3].mergeMode = ARTNET_MERGE_HTP;
-		m_OutputPorts[3].port.nStatus = m_OutputPorts[3].port.nStatus & ~GO_MERGE_MODE_LTP;
+		m_pOutputPorts[nPortIndex].merge.SetMode(DMX_MERGE_HTP);
+		m_pOutputPorts[nPortIndex].port.nStatus = m_pOutputPorts[nPortIndex].port.nStatus & ~GO_MERGE_MODE_LTP;
 #ifdef SENDDIAG
-		SendDiag("Setting Merge Mode HTP_3", ARTNET_DP_LOW);
+		SendDiag("Setting Merge Mode HTP", ARTNET_DP_LOW);
 #endif
 		break;
 	case ARTNET_PC_CLR_0:
-		for (unsigned i = 0; i < ARTNET_DMX_LENGTH; i++) {
-			m_OutputPorts[0].data[i] = 0;
-		}
-		m_pLightSet->SetData (0, m_OutputPorts[0].data, m_OutputPorts[0].nLength);
-		bClearCommand = true;
-		break;
 	case ARTNET_PC_CLR_1:
-		for (unsigned i = 0; i < ARTNET_DMX_LENGTH; i++) {
-			m_OutputPorts[1].data[i] = 0;
-		}
-		m_pLightSet->SetData (1, m_OutputPorts[1].data, m_OutputPorts[1].nLength);
-		bClearCommand = true;
-		break;
 	case ARTNET_PC_CLR_2:
-		for (unsigned i = 0; i < ARTNET_DMX_LENGTH; i++) {
-			m_OutputPorts[2].data[i] = 0;
-		}
-		m_pLightSet->SetData (2, m_OutputPorts[2].data, m_OutputPorts[2].nLength);
-		bClearCommand = true;
-		break;
 	case ARTNET_PC_CLR_3:
-		for (unsigned i = 0; i < ARTNET_DMX_LENGTH; i++) {
-			m_OutputPorts[3].data[i] = 0;
-		}
-		m_pLightSet->SetData (3, m_OutputPorts[3].data, m_OutputPorts[3].nLength);
-		bClearCommand = true;
+		m_pOutputPorts[nPortIndex].merge.Clear();
+		dmx_slot_range_clear(&m_pOutputPorts[nPortIndex].tDirty);	// All slots
+		m_pOutputPorts[nPortIndex].IsDataPending = false;
+		SendPortData(nPortIndex);
 		break;
 	default:
 		break;
 	}
 
-	if (bClearCommand && !m_IsLightSetRunning) {
-		m_pLightSet->Start();
-		m_IsLightSetRunning = true;
-	}
-
 	SendPollRelply(true);
 }
 
 void ArtNetNode::HandleTimeCode(void) {
-	const struct TArtTimeCode *packet = (struct TArtTimeCode *) &(m_ArtNetPacket.ArtPacket.ArtTimeCode);
+	const struct TArtTimeCode *packet = (struct TArtTimeCode *) &(m_pArtNetPacket->ArtPacket.ArtTimeCode);
 	m_pArtNetTimeCode->Handler((struct TArtNetTimeCode *)&packet->Frames);
 }
 
@@ -957,13 +1744,34 @@ void ArtNetNode::SendTimeCode(const struct TArtNetTimeCode *pArtNetTimeCode) {
 }
 
 void ArtNetNode::HandleTimeSync(void) {
-	struct TArtTimeSync *packet = (struct TArtTimeSync *) &(m_ArtNetPacket.ArtPacket.ArtTimeSync);
+	struct TArtTimeSync *packet = (struct TArtTimeSync *) &(m_pArtNetPacket->ArtPacket.ArtTimeSync);
 
 	m_pArtNetTimeSync->Handler((struct TArtNetTimeSync *)&packet->tm_sec);
 
 	packet->Prog = (uint8_t) 0;
 
-	network_sendto((const uint8_t *) packet, (const uint16_t) sizeof(struct TArtTimeSync), m_ArtNetPacket.IPAddressFrom, (uint16_t) ARTNET_UDP_PORT);
+	network_sendto((const uint8_t *) packet, (const uint16_t) sizeof(struct TArtTimeSync), m_pArtNetPacket->IPAddressFrom, (uint16_t) ARTNET_UDP_PORT);
+}
+
+/**
+ * An OEM code of 0xFFFF addresses all nodes.
+ */
+void ArtNetNode::HandleTrigger(void) {
+	struct TArtTrigger *packet = (struct TArtTrigger *) &(m_pArtNetPacket->ArtPacket.ArtTrigger);
+
+	// The handler has no length, the payload not received is zero
+	const unsigned nReceived = (unsigned) m_pArtNetPacket->length - (unsigned) __builtin_offsetof(struct TArtTrigger, Data);
+	if (nReceived < sizeof(packet->Data)) {
+		memset(&packet->Data[nReceived], 0, sizeof(packet->Data) - nReceived);
+	}
+
+	if (((packet->OemCodeHi == 0xFF) && (packet->OemCodeLo == 0xFF)) || ((packet->OemCodeHi == m_Node.Oem[0]) && (packet->OemCodeLo == m_Node.Oem[1]))) {
+		m_pArtNetTrigger->Handler((struct TArtNetTrigger *) &packet->Key);
+	}
+}
+
+void ArtNetNode::SetTriggerHandler(ArtNetTrigger *pArtNetTrigger) {
+	m_pArtNetTrigger = pArtNetTrigger;
 }
 
 void ArtNetNode::SetTimeSyncHandler(ArtNetTimeSync *pArtNetTimeSync) {
@@ -971,10 +1779,10 @@ void ArtNetNode::SetTimeSyncHandler(ArtNetTimeSync *pArtNetTimeSync) {
 }
 
 void ArtNetNode::HandleTodControl(void) {
-	const struct TArtTodControl *packet = (struct TArtTodControl *) &(m_ArtNetPacket.ArtPacket.ArtTodControl);
+	const struct TArtTodControl *packet = (struct TArtTodControl *) &(m_pArtNetPacket->ArtPacket.ArtTodControl);
 	const uint16_t portAddress = (uint16_t)(packet->Net << 8) | (uint16_t)(packet->Address);
 
-	if ((portAddress == m_OutputPorts[0].port.nPortAddress) && m_OutputPorts[0].bIsEnabled) {
+	if ((portAddress == m_pOutputPorts[0].port.nPortAddress) && m_pOutputPorts[0].bIsEnabled) {
 		m_pLightSet->Stop();
 		m_IsLightSetRunning = false;
 
@@ -989,17 +1797,17 @@ void ArtNetNode::HandleTodControl(void) {
 }
 
 void ArtNetNode::HandleTodRequest(void) {
-	const struct TArtTodRequest *packet = (struct TArtTodRequest *) &(m_ArtNetPacket.ArtPacket.ArtTodRequest);
+	const struct TArtTodRequest *packet = (struct TArtTodRequest *) &(m_pArtNetPacket->ArtPacket.ArtTodRequest);
 	const uint16_t portAddress = (uint16_t)(packet->Net << 8) | (uint16_t)(packet->Address[0]);
 
-	if ((portAddress == m_OutputPorts[0].port.nPortAddress) && m_OutputPorts[0].bIsEnabled) {
+	if ((portAddress == m_pOutputPorts[0].port.nPortAddress) && m_pOutputPorts[0].bIsEnabled) {
 		SendTod();
 	}
 }
 
 void ArtNetNode::SendTod(void) {
-	m_pTodData->Net = m_Node.NetSwitch;
-	m_pTodData->Address = m_OutputPorts[0].port.nDefaultAddress;
+	m_pTodData->Net = m_Node.NetSwitch[0];
+	m_pTodData->Address = m_pOutputPorts[0].port.nDefaultAddress;
 
 	const uint8_t discovered = m_pArtNetRdm->GetUidCount();
 
@@ -1016,10 +1824,17 @@ void ArtNetNode::SendTod(void) {
 }
 
 void ArtNetNode::HandleRdm(void) {
-	struct TArtRdm *packet = (struct TArtRdm *) &(m_ArtNetPacket.ArtPacket.ArtRdm);
+	struct TArtRdm *packet = (struct TArtRdm *) &(m_pArtNetPacket->ArtPacket.ArtRdm);
+
+	// RdmPacket[1] is the Message Length, which includes the StartCode and excludes the checksum
+	if ((packet->RdmPacket[1] < RDM_MESSAGE_MINIMUM_SIZE) || (m_pArtNetPacket->length < (int) (__builtin_offsetof(struct TArtRdm, RdmPacket) + packet->RdmPacket[1] + 1))) {
+		m_nPacketsInvalid++;
+		return;
+	}
+
 	const uint16_t portAddress = (uint16_t) (packet->Net << 8) | (uint16_t) (packet->Address);
 
-	if ((portAddress == m_OutputPorts[0].port.nPortAddress) && m_OutputPorts[0].bIsEnabled) {
+	if ((portAddress == m_pOutputPorts[0].port.nPortAddress) && m_pOutputPorts[0].bIsEnabled) {
 
 		if (!m_IsRdmResponder) {
 			m_pLightSet->Stop();
@@ -1035,7 +1850,7 @@ void ArtNetNode::HandleRdm(void) {
 
 			const uint16_t nLength = (uint16_t) sizeof(struct TArtRdm) - (uint16_t) sizeof(packet->RdmPacket) + nMessageLength;
 
-			network_sendto((const uint8_t *) packet, (const uint16_t) nLength, m_ArtNetPacket.IPAddressFrom, (uint16_t) ARTNET_UDP_PORT);
+			network_sendto((const uint8_t *) packet, (const uint16_t) nLength, m_pArtNetPacket->IPAddressFrom, (uint16_t) ARTNET_UDP_PORT);
 		} else {
 			//printf("\n==> No response <==\n");
 		}
@@ -1055,6 +1870,7 @@ void ArtNetNode::SetRdmHandler(ArtNetRdm *pArtNetTRdm, bool IsResponder) {
 		m_pTodData = new TArtTodData;
 		if (m_pTodData != 0) {
 			m_Node.Status1 |= STATUS1_RDM_CAPABLE;
+			InvalidatePollReply(ARTNET_MAX_PAGES);
 			memset(m_pTodData, 0, sizeof(struct TArtTodData));
 			memcpy(m_pTodData->Id, (const char *) NODE_ID, sizeof(m_pTodData->Id));
 			m_pTodData->OpCode = OP_TODDATA;
@@ -1067,11 +1883,11 @@ void ArtNetNode::SetRdmHandler(ArtNetRdm *pArtNetTRdm, bool IsResponder) {
 }
 
 void ArtNetNode::HandleIpProg(void) {
-	struct TArtIpProg *packet = (struct TArtIpProg *) &(m_ArtNetPacket.ArtPacket.ArtIpProg);
+	struct TArtIpProg *packet = (struct TArtIpProg *) &(m_pArtNetPacket->ArtPacket.ArtIpProg);
 
 	m_pArtNetIpProg->Handler((const TArtNetIpProg *)&packet->Command, (TArtNetIpProgReply *)&m_pIpProgReply->ProgIpHi);
 
-	network_sendto((const uint8_t *)m_pIpProgReply, (const uint16_t)sizeof(struct TArtIpProgReply), m_ArtNetPacket.IPAddressFrom, (uint16_t)ARTNET_UDP_PORT);
+	network_sendto((const uint8_t *)m_pIpProgReply, (const uint16_t)sizeof(struct TArtIpProgReply), m_pArtNetPacket->IPAddressFrom, (uint16_t)ARTNET_UDP_PORT);
 
 	memcpy(ip.u8, &m_pIpProgReply->ProgIpHi, ARTNET_IP_SIZE);
 
@@ -1081,7 +1897,7 @@ void ArtNetNode::HandleIpProg(void) {
 		m_Node.IPAddressBroadcast = m_Node.IPAddressLocal | ~network_get_netmask();
 		m_Node.Status2 = (m_Node.Status2 & ~(1 << 1)) | (network_is_dhcp_used() ? STATUS2_IP_DHCP : STATUS2_IP_MANUALY);
 		// Update PollReply for new IPAddress
-		memcpy(m_PollReply.IPAddress, &m_pIpProgReply->ProgIpHi, ARTNET_IP_SIZE);
+		InvalidatePollReply(ARTNET_MAX_PAGES);
 
 		if (m_State.SendArtPollReplyOnChange) {
 			SendPollRelply(true);
@@ -1108,18 +1924,57 @@ void ArtNetNode::SetIpProgHandler(ArtNetIpProg *pArtNetIpProg) {
 
 
 void ArtNetNode::SetNetworkDataLossCondition(void) {
-	if(m_IsLightSetRunning) {
+	for (unsigned i = 0; i < m_nPorts; i++) {
+		m_LossPolicy.SetLook((uint8_t) i, m_pOutputPorts[i].merge.GetData(), m_pOutputPorts[i].merge.GetLength());
+	}
+
+	if (m_IsLightSetRunning && (m_LossPolicy.GetPolicy() == DMX_LOSS_POLICY_BLACKOUT)) {
 		m_pLightSet->Stop();
 		m_IsLightSetRunning = false;
+	}
 
-		m_State.IsSynchronousMode = false;
+	m_State.IsSynchronousMode = false;
+	m_State.IsFramePending = false;
+	m_SyncStats.nSyncIntervalMillis = 0;
+
+	for (unsigned i = 0; i < m_nPorts; i++) {
+		m_pOutputPorts[i].IsDataPending = false;
+		m_pOutputPorts[i].IsInFrame = false;
+		m_pOutputPorts[i].port.nStatus = m_pOutputPorts[i].port.nStatus & ~(GO_DATA_IS_BEING_TRANSMITTED | GO_OUTPUT_IS_MERGING);
+		m_pOutputPorts[i].IsMergeCancel = false;
+		m_pOutputPorts[i].merge.Reset();
+		dmx_slot_range_clear(&m_pOutputPorts[i].tDirty);
+	}
 
-		for (unsigned i = 0; i < ARTNET_MAX_PORTS; i++) {
-			m_OutputPorts[i].port.nStatus = m_OutputPorts[i].port.nStatus & (~GO_DATA_IS_BEING_TRANSMITTED);
-			m_OutputPorts[i].nLength = (uint16_t) 0;
-			m_OutputPorts[i].ipA = (uint32_t) 0;
-			m_OutputPorts[i].ipB = (uint32_t) 0;
-		}
+	m_LossPolicy.Begin(m_pLightSet, m_nCurrentPacketMillis);
+}
+
+void ArtNetNode::HandleTimers(void) {
+	m_nCurrentPacketMillis = millis();
+	m_nCurrentPacketMicros = micros();
+
+	if ((m_nCurrentPacketMillis - m_nStatsMillis) >= 1000) {
+		UpdatePortStats();
+	}
+
+	// Checked with every call, so the detection does not depend on the packets received
+	if (m_LossPolicy.IsTimeout(m_nCurrentPacketMillis)) {
+		SetNetworkDataLossCondition();
+	}
+
+	m_LossPolicy.Run(m_pLightSet, m_nCurrentPacketMillis);
+
+	if (m_State.IsSynchronousMode) {
+		CheckFrameTimeouts();
+	}
+
+	if (m_State.nActiveInputPorts != 0) {
+		CheckInputPorts();
+	}
+
+	if (m_State.IsPollReplyPending && ((int32_t) (m_nCurrentPacketMillis - m_State.PollReplyMillis) >= 0)) {
+		m_State.IsPollReplyPending = false;
+		SendPollRelply(true);
 	}
 }
 
@@ -1129,47 +1984,113 @@ int ArtNetNode::HandlePacket(void) {
 
 	const int nBytesReceived = network_recvfrom((const uint8_t *)packet, (const uint16_t)sizeof(m_ArtNetPacket.ArtPacket), &m_ArtNetPacket.IPAddressFrom, &nForeignPort) ;
 
-#if defined (__circle__)
-	m_nCurrentPacketTime = CTimer::Get()->GetTime();
-#else
-	m_nCurrentPacketTime = time(NULL);
-#endif
+	m_ArtNetPacket.PortFrom = nForeignPort;
+
+	HandleTimers();
 
 	if (nBytesReceived == 0) {
-		if ((m_nCurrentPacketTime - m_nPreviousPacketTime) >= m_State.nNetworkDataLossTimeout) {
-			SetNetworkDataLossCondition();
-		}
 		return 0;
 	}
 
-	m_ArtNetPacket.length = nBytesReceived;
-	m_nPreviousPacketTime = m_nCurrentPacketTime;
+	m_pArtNetPacket = &m_ArtNetPacket;
+	m_pArtNetPacket->length = nBytesReceived;
 
-	GetType();
+	return HandleReceived();
+}
 
-	if (m_State.IsSynchronousMode) {
-		if ((m_ArtNetPacket.OpCode == OP_DMX) && (m_tOpCodePrevious == OP_DMX)) {
-			// WiFi UDP : We have missed the OP_SYNC
-			m_State.IsSynchronousMode = false;
-			for (unsigned i = 0; i < ARTNET_MAX_PORTS; i++) {
-				m_OutputPorts[i].IsDataPending = false;
-			}
-		} else {
-			if (m_nCurrentPacketTime - m_State.ArtSyncTime >= 4) {
-				m_State.IsSynchronousMode = false;
-			}
+int ArtNetNode::HandlePackets(uint16_t nMaxBatch) {
+	if (nMaxBatch > ARTNET_MAX_BATCH) {
+		nMaxBatch = ARTNET_MAX_BATCH;
+	} else if (nMaxBatch == 0) {
+		nMaxBatch = 1;
+	}
+
+	if (m_pBatchPackets == 0) {
+		m_pBatchPackets = new TArtNetPacket[ARTNET_MAX_BATCH];
+		assert(m_pBatchPackets != 0);
+
+		m_pBatchDatagrams = new TNetworkDatagram[ARTNET_MAX_BATCH];
+		assert(m_pBatchDatagrams != 0);
+
+		for (unsigned i = 0; i < ARTNET_MAX_BATCH; i++) {
+			m_pBatchDatagrams[i].pData = (uint8_t *) &(m_pBatchPackets[i].ArtPacket);
+			m_pBatchDatagrams[i].nSize = (uint16_t) sizeof(m_pBatchPackets[i].ArtPacket);
 		}
 	}
 
-	switch (m_ArtNetPacket.OpCode) {
+	// Pending frames, input ports and a loss fade need the timers serviced, otherwise sleep until a packet arrives
+	uint32_t nWaitMillis = ARTNET_IDLE_WAIT_MILLIS;
+
+	if (m_State.IsFramePending || (m_State.nActiveInputPorts != 0) || m_LossPolicy.IsFading()) {
+		nWaitMillis = 1;
+	}
+
+	const uint16_t nReceived = network_recvmmsg(m_pBatchDatagrams, nMaxBatch, nWaitMillis);
+
+	HandleTimers();
+
+	if (nReceived == 0) {
+		return 0;
+	}
+
+	for (unsigned i = 0; i < nReceived; i++) {
+		m_pArtNetPacket = &m_pBatchPackets[i];
+		m_pArtNetPacket->length = m_pBatchDatagrams[i].nLength;
+		m_pArtNetPacket->IPAddressFrom = m_pBatchDatagrams[i].nFromIp;
+		m_pArtNetPacket->PortFrom = m_pBatchDatagrams[i].nFromPort;
+
+		(void) HandleReceived();
+	}
+
+	m_pArtNetPacket = &m_ArtNetPacket;
+
+	return nReceived;
+}
+
+/**
+ * A datagram received by the caller on ARTNET_UDP_PORT, e.g. by the Gateway.
+ * The caller calls \ref HandleTimers with every loop as well.
+ */
+int ArtNetNode::HandleDatagram(const uint8_t *pData, uint16_t nLength, uint32_t nFromIp, uint16_t nFromPort) {
+	assert(pData != 0);
+
+	if (nLength > sizeof(m_ArtNetPacket.ArtPacket)) {
+		nLength = (uint16_t) sizeof(m_ArtNetPacket.ArtPacket);
+	}
+
+	memcpy(&m_ArtNetPacket.ArtPacket, pData, nLength);
+
+	m_ArtNetPacket.length = nLength;
+	m_ArtNetPacket.IPAddressFrom = nFromIp;
+	m_ArtNetPacket.PortFrom = nFromPort;
+
+	m_pArtNetPacket = &m_ArtNetPacket;
+
+	return HandleReceived();
+}
+
+int ArtNetNode::HandleReceived(void) {
+	GetType();
+
+	switch (m_pArtNetPacket->OpCode) {
 	case OP_POLL:
 		HandlePoll();
 		break;
+	case OP_POLLREPLY:
+		if (m_State.nActiveInputPorts != 0) {
+			HandlePollReply();
+		}
+		break;
 	case OP_DMX:
 		if (m_pLightSet != 0) {
 			HandleDmx();
 		}
 		break;
+	case OP_NZS:
+		if (m_pLightSet != 0) {
+			HandleNzs();
+		}
+		break;
 	case OP_SYNC:
 		if (m_pLightSet != 0) {
 			HandleSync();
@@ -1188,6 +2109,11 @@ int ArtNetNode::HandlePacket(void) {
 			HandleTimeSync();
 		}
 		break;
+	case OP_TRIGGER:
+		if (m_pArtNetTrigger != 0) {
+			HandleTrigger();
+		}
+		break;
 	case OP_TODREQUEST:
 		if (m_pArtNetRdm != 0) {
 			HandleTodRequest();
@@ -1220,7 +2146,5 @@ int ArtNetNode::HandlePacket(void) {
 		m_State.IsChanged = false;
 	}
 
-	m_tOpCodePrevious = m_ArtNetPacket.OpCode;
-
-	return m_ArtNetPacket.length;
+	return m_pArtNetPacket->length;
 }
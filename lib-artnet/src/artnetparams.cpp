@@ -64,6 +64,8 @@
 #define SET_ID_MASK			1<<9
 #define SET_OEM_VALUE_MASK	1<<10
 #define SET_NETWORK_TIMEOUT	1<<11
+#define SET_FRAME_DEADLINE	1<<12
+#define SET_SYNC_TIMEOUT	1<<13
 
 static const char PARAMS_FILE_NAME[] ALIGNED = "artnet.txt";
 static const char PARAMS_NET[] ALIGNED = "net";											///< 0 {default}
@@ -79,6 +81,8 @@ static const char PARAMS_NODE_LONG_NAME[] ALIGNED = "long_name";
 static const char PARAMS_NODE_MANUFACTURER_ID[] ALIGNED = "manufacturer_id";
 static const char PARAMS_NODE_OEM_VALUE[] ALIGNED = "oem_value";
 static const char PARAMS_NODE_NETWORK_DATA_LOSS_TIMEOUT[] = "network_data_loss_timeout";///< 10 {default}
+static const char PARAMS_NODE_FRAME_DEADLINE[] = "frame_deadline";						///< Milliseconds to wait for ArtSync, 0 = no deadline, 50 {default}
+static const char PARAMS_NODE_SYNC_TIMEOUT[] = "sync_timeout";							///< Milliseconds without ArtSync before leaving synchronous mode, 4000 {default}
 
 void ArtNetParams::staticCallbackFunction(void *p, const char *s) {
 	assert(p != 0);
@@ -93,6 +97,7 @@ void ArtNetParams::callbackFunction(const char *pLine) {
 	char value[128];
 	uint8_t len;
 	uint8_t value8;
+	uint16_t value16;
 
 	if (Sscan::Uint8(pLine, PARAMS_TIMECODE, &value8) == SSCAN_OK) {
 		if (value8 != 0) {
@@ -181,6 +186,20 @@ void ArtNetParams::callbackFunction(const char *pLine) {
 		return;
 	}
 
+	if (Sscan::Uint16(pLine, PARAMS_NODE_FRAME_DEADLINE, &value16) == SSCAN_OK) {
+		m_nFrameDeadline = value16;
+		m_bSetList |= SET_FRAME_DEADLINE;
+		return;
+	}
+
+	if (Sscan::Uint16(pLine, PARAMS_NODE_SYNC_TIMEOUT, &value16) == SSCAN_OK) {
+		if (value16 != 0) {
+			m_nSyncTimeout = value16;
+		}
+		m_bSetList |= SET_SYNC_TIMEOUT;
+		return;
+	}
+
 	if (Sscan::Uint8(pLine, PARAMS_NET, &value8) == SSCAN_OK) {
 		m_nNet = value8;
 		m_bSetList |= SET_NET_MASK;
@@ -204,6 +223,8 @@ ArtNetParams::ArtNetParams(void): m_bSetList(0) {
 	m_bEnableRdm = false;
 	m_bRdmDiscovery = false;
 	m_nNetworkTimeout = 10;
+	m_nFrameDeadline = 50;
+	m_nSyncTimeout = 4000;
 
 	memset(m_aShortName, 0, ARTNET_SHORT_NAME_LENGTH);
 	memset(m_aLongName, 0, ARTNET_LONG_NAME_LENGTH);
@@ -260,6 +281,14 @@ time_t ArtNetParams::GetNetworkTimeout(void) const {
 	return m_nNetworkTimeout;
 }
 
+uint16_t ArtNetParams::GetFrameDeadline(void) const {
+	return m_nFrameDeadline;
+}
+
+uint16_t ArtNetParams::GetSyncTimeout(void) const {
+	return m_nSyncTimeout;
+}
+
 bool ArtNetParams::Load(void) {
 	m_bSetList = 0;
 
@@ -301,6 +330,14 @@ void ArtNetParams::Set(ArtNetNode *pArtNetNode) {
 	if(isMaskSet(SET_NETWORK_TIMEOUT)) {
 		pArtNetNode->SetNetworkTimeout(m_nNetworkTimeout);
 	}
+
+	if(isMaskSet(SET_FRAME_DEADLINE)) {
+		pArtNetNode->SetFrameDeadline(m_nFrameDeadline);
+	}
+
+	if(isMaskSet(SET_SYNC_TIMEOUT)) {
+		pArtNetNode->SetSyncTimeout(m_nSyncTimeout);
+	}
 }
 
 void ArtNetParams::Dump(void) {
@@ -361,6 +398,14 @@ void ArtNetParams::Dump(void) {
 	if (isMaskSet(SET_NETWORK_TIMEOUT)) {
 		printf(" Network data loss timeout : %ds\n", (int) m_nNetworkTimeout);
 	}
+
+	if (isMaskSet(SET_FRAME_DEADLINE)) {
+		printf(" Frame deadline : %dms\n", (int) m_nFrameDeadline);
+	}
+
+	if (isMaskSet(SET_SYNC_TIMEOUT)) {
+		printf(" Sync timeout : %dms\n", (int) m_nSyncTimeout);
+	}
 #endif
 }
 
@@ -38,6 +38,7 @@
 #include "util.h"
 #endif
 
+#include "artnet.h"
 #include "artnetpolltable.h"
 
 #include "packets.h"
@@ -53,11 +54,49 @@ union uip {
 	uint8_t u8[4];
 } static ip;
 
-ArtNetPollTable::ArtNetPollTable(void) : m_bIsChanged(false), m_nEntries(0), m_nLastUpdate(0) {
-	m_pPollTable = new TArtNetNodeEntry[255];
+static inline unsigned hash_ip(uint32_t nIp) {
+	nIp ^= nIp >> 16;
+	nIp ^= nIp >> 8;
+	return nIp & (ARTNET_POLL_TABLE_HASH_SIZE - 1);
+}
+
+static inline unsigned hash_port_address(uint16_t nPortAddress) {
+	return nPortAddress & (ARTNET_POLL_TABLE_PORT_HASH_SIZE - 1);
+}
+
+ArtNetPollTable::ArtNetPollTable(void) :
+		m_IsOutputPortsChanged(false),
+		m_nChanges(0),
+		m_bIsChanged(false),
+		m_nEntries(0),
+		m_nExpirySeconds(ARTNET_POLL_TABLE_EXPIRY_SECONDS),
+		m_nLastUpdate(0),
+		m_pArtNetDiscovery(0)
+{
+	m_pPollTable = new TArtNetNodeEntry[ARTNET_POLL_TABLE_SIZE];
+	m_pLinks = new TArtNetPollTableLinks[ARTNET_POLL_TABLE_SIZE];
+	m_pHash = new uint16_t[ARTNET_POLL_TABLE_HASH_SIZE];
+	m_pPortHash = new uint16_t[ARTNET_POLL_TABLE_PORT_HASH_SIZE];
+
+	for (unsigned i = 0; i < ARTNET_POLL_TABLE_HASH_SIZE; i++) {
+		m_pHash[i] = ARTNET_POLL_TABLE_NONE;
+	}
+
+	for (unsigned i = 0; i < ARTNET_POLL_TABLE_PORT_HASH_SIZE; i++) {
+		m_pPortHash[i] = ARTNET_POLL_TABLE_NONE;
+	}
 }
 
 ArtNetPollTable::~ArtNetPollTable(void) {
+	delete[] m_pPortHash;
+	m_pPortHash = 0;
+
+	delete[] m_pHash;
+	m_pHash = 0;
+
+	delete[] m_pLinks;
+	m_pLinks = 0;
+
 	delete[] m_pPollTable;
 	m_pPollTable = 0;
 }
@@ -66,80 +105,286 @@ bool ArtNetPollTable::isChanged(void) {
 	return m_bIsChanged;
 }
 
-const uint8_t ArtNetPollTable::GetEntries(void) {
+uint16_t ArtNetPollTable::GetEntries(void) const {
 	return m_nEntries;
 }
 
-bool ArtNetPollTable::Add(const struct TArtPollReply *pPollReply) {
-	bool bFound = false;
-	uint8_t i;
+void ArtNetPollTable::SetExpiry(uint16_t nSeconds) {
+	m_nExpirySeconds = nSeconds;
+}
+
+uint16_t ArtNetPollTable::GetExpiry(void) const {
+	return m_nExpirySeconds;
+}
+
+void ArtNetPollTable::SetDiscoveryHandler(ArtNetDiscovery *pArtNetDiscovery) {
+	m_pArtNetDiscovery = pArtNetDiscovery;
+}
+
+uint16_t ArtNetPollTable::Find(uint32_t nIp, uint8_t nBindIndex) const {
+	for (uint16_t i = m_pHash[hash_ip(nIp)]; i != ARTNET_POLL_TABLE_NONE; i = m_pLinks[i].nNext) {
+		if ((m_pPollTable[i].IPAddress == nIp) && (m_pPollTable[i].BindIndex == nBindIndex)) {
+			return i;
+		}
+	}
+
+	return ARTNET_POLL_TABLE_NONE;
+}
+
+void ArtNetPollTable::LinkEntry(uint16_t nEntry) {
+	const unsigned nBucket = hash_ip(m_pPollTable[nEntry].IPAddress);
+
+	m_pLinks[nEntry].nNext = m_pHash[nBucket];
+	m_pHash[nBucket] = nEntry;
+
+	LinkPorts(nEntry);
+}
+
+void ArtNetPollTable::UnlinkEntry(uint16_t nEntry) {
+	UnlinkPorts(nEntry);
+
+	uint16_t *pLink = &m_pHash[hash_ip(m_pPollTable[nEntry].IPAddress)];
+
+	while (*pLink != nEntry) {
+		pLink = &m_pLinks[*pLink].nNext;
+	}
+
+	*pLink = m_pLinks[nEntry].nNext;
+}
+
+void ArtNetPollTable::LinkPorts(uint16_t nEntry) {
+	const struct TArtNetNodeEntry *pEntry = &m_pPollTable[nEntry];
+
+	for (unsigned i = 0; i < pEntry->nOutputPorts; i++) {
+		const unsigned nBucket = hash_port_address(pEntry->OutputPortAddress[i]);
+
+		m_pLinks[nEntry].nNextPort[i] = m_pPortHash[nBucket];
+		m_pPortHash[nBucket] = (uint16_t) ((nEntry << 2) | i);
+	}
+}
+
+void ArtNetPollTable::UnlinkPorts(uint16_t nEntry) {
+	const struct TArtNetNodeEntry *pEntry = &m_pPollTable[nEntry];
+
+	for (unsigned i = 0; i < pEntry->nOutputPorts; i++) {
+		const uint16_t nPortLink = (uint16_t) ((nEntry << 2) | i);
+		uint16_t *pLink = &m_pPortHash[hash_port_address(pEntry->OutputPortAddress[i])];
+
+		while (*pLink != nPortLink) {
+			pLink = &m_pLinks[*pLink >> 2].nNextPort[*pLink & 0x03];
+		}
+
+		*pLink = m_pLinks[nEntry].nNextPort[i];
+	}
+}
+
+/**
+ * The last entry takes the place of the removed entry, so the entries in use stay contiguous.
+ */
+void ArtNetPollTable::Remove(uint16_t nEntry) {
+	const uint16_t nLast = m_nEntries - 1;
+
+	UnlinkEntry(nEntry);
+
+	if (nEntry != nLast) {
+		UnlinkEntry(nLast);
+		memcpy((void *) &m_pPollTable[nEntry], (const void *) &m_pPollTable[nLast], sizeof(struct TArtNetNodeEntry));
+		LinkEntry(nEntry);
+	}
+
+	m_nEntries--;
+}
 
+bool ArtNetPollTable::Add(const struct TArtPollReply *pPollReply) {
 	m_nLastUpdate = time(NULL);
 
 	memcpy(ip.u8, pPollReply->IPAddress, 4);
 
-	for (i = 0; i < m_nEntries; i++) {
-		if (m_pPollTable[i].IPAddress == ip.u32) {
-			bFound = true;
-			break;
+	uint16_t i = Find(ip.u32, pPollReply->BindIndex);
+	const bool bFound = (i != ARTNET_POLL_TABLE_NONE);
+
+	if (!bFound) {
+		if (m_nEntries == ARTNET_POLL_TABLE_SIZE) {
+			return false;
 		}
-	}
 
-	if(bFound) {
-		m_bIsChanged = false;
-	} else {
-		m_nEntries++;
+		i = m_nEntries++;
 		m_bIsChanged = true;
-		m_pPollTable[i].IpProg.IPAddress = 0;
-		m_pPollTable[i].IpProg.SubMask = 0;
-		m_pPollTable[i].IpProg.Status = 0;
+		memset((void *) &m_pPollTable[i], 0, sizeof(struct TArtNetNodeEntry));
+		m_pPollTable[i].IPAddress = ip.u32;
+		m_pPollTable[i].BindIndex = pPollReply->BindIndex;
+		LinkEntry(i);
+	}
+
+	struct TArtNetNodeEntry *pEntry = &m_pPollTable[i];
+	bool IsChanged = false;
+
+	if ((memcmp(pEntry->Mac, pPollReply->MAC, ARTNET_MAC_SIZE) != 0)
+			|| (memcmp(pEntry->ShortName, pPollReply->ShortName, ARTNET_SHORT_NAME_LENGTH) != 0)
+			|| (memcmp(pEntry->LongName, pPollReply->LongName, ARTNET_LONG_NAME_LENGTH) != 0)
+			|| (pEntry->Status1 != pPollReply->Status1) || (pEntry->Status2 != pPollReply->Status2)) {
+		memcpy(pEntry->Mac, pPollReply->MAC, ARTNET_MAC_SIZE);
+		memcpy(pEntry->ShortName, pPollReply->ShortName, ARTNET_SHORT_NAME_LENGTH);
+		memcpy(pEntry->LongName, pPollReply->LongName, ARTNET_LONG_NAME_LENGTH);
+		pEntry->Status1 = pPollReply->Status1;
+		pEntry->Status2 = pPollReply->Status2;
+		IsChanged = true;
+	}
+
+	pEntry->LastUpdate = m_nLastUpdate;
+
+	// The output ports of the reply
+	uint16_t OutputPortAddress[ARTNET_MAX_PORTS];
+	uint8_t nOutputPorts = 0;
+	const unsigned nPorts = pPollReply->NumPortsLo < ARTNET_MAX_PORTS ? pPollReply->NumPortsLo : ARTNET_MAX_PORTS;
+
+	for (unsigned j = 0; j < nPorts; j++) {
+		if ((pPollReply->PortTypes[j] & ARTNET_ENABLE_OUTPUT) != 0) {
+			OutputPortAddress[nOutputPorts++] = (uint16_t) ((pPollReply->NetSwitch & 0x7F) << 8) | (uint16_t) ((pPollReply->SubSwitch & 0x0F) << 4) | (uint16_t) (pPollReply->SwOut[j] & 0x0F);
+		}
+	}
+
+	if ((nOutputPorts != pEntry->nOutputPorts) || (memcmp(OutputPortAddress, pEntry->OutputPortAddress, nOutputPorts * sizeof(uint16_t)) != 0)) {
+		UnlinkPorts(i);
+		memcpy(pEntry->OutputPortAddress, OutputPortAddress, nOutputPorts * sizeof(uint16_t));
+		pEntry->nOutputPorts = nOutputPorts;
+		LinkPorts(i);
+		m_IsOutputPortsChanged = true;
+		IsChanged = true;
 	}
 
-	m_pPollTable[i].IPAddress = ip.u32;
-	memcpy(m_pPollTable[i].Mac, pPollReply->MAC, ARTNET_MAC_SIZE);
-	memcpy(m_pPollTable[i].ShortName, pPollReply->ShortName, ARTNET_SHORT_NAME_LENGTH);
-	memcpy(m_pPollTable[i].LongName, pPollReply->LongName, ARTNET_LONG_NAME_LENGTH);
-	m_pPollTable[i].Status1 = pPollReply->Status1;
-	m_pPollTable[i].Status2 = pPollReply->Status2;
-	m_pPollTable[i].LastUpdate = m_nLastUpdate;
+	if (!bFound) {
+		m_nChanges++;
+		if (m_pArtNetDiscovery != 0) {
+			m_pArtNetDiscovery->Added(pEntry);
+		}
+	} else if (IsChanged) {
+		m_bIsChanged = true;
+		m_nChanges++;
+		if (m_pArtNetDiscovery != 0) {
+			m_pArtNetDiscovery->Changed(pEntry);
+		}
+	}
 
 	return bFound;
 }
 
+/**
+ * The reply applies to all entries with the IP address.
+ */
 bool ArtNetPollTable::Add(const struct TArtIpProgReply *pIpProgReply) {
 	bool bFound = false;
-	uint8_t i;
+	union uip mask;
 
 	memcpy(ip.u8, &pIpProgReply->ProgIpHi, 4);
+	memcpy(mask.u8, &pIpProgReply->ProgSmHi, 4);
 
-	for (i = 0; i < m_nEntries; i++) {
+	for (uint16_t i = m_pHash[hash_ip(ip.u32)]; i != ARTNET_POLL_TABLE_NONE; i = m_pLinks[i].nNext) {
 		if (m_pPollTable[i].IPAddress == ip.u32) {
+			struct TIpProg *pIpProg = &m_pPollTable[i].IpProg;
 			bFound = true;
-			break;
+
+			if ((pIpProg->IPAddress != ip.u32) || (pIpProg->SubMask != mask.u32) || (pIpProg->Status != pIpProgReply->Status)) {
+				pIpProg->IPAddress = ip.u32;
+				pIpProg->SubMask = mask.u32;
+				pIpProg->Status = pIpProgReply->Status;
+				m_bIsChanged = true;
+				m_nChanges++;
+				if (m_pArtNetDiscovery != 0) {
+					m_pArtNetDiscovery->Changed(&m_pPollTable[i]);
+				}
+			}
 		}
 	}
 
-	m_pPollTable[i].IpProg.IPAddress = ip.u32;
-	memcpy(ip.u8, &pIpProgReply->ProgSmHi, 4);
-	m_pPollTable[i].IpProg.SubMask = ip.u32;
-	m_pPollTable[i].IpProg.Status = pIpProgReply->Status;
-
 	return bFound;
 }
 
+/**
+ * Remove the nodes without an ArtPollReply within the expiry time.
+ * Returns the number of entries removed.
+ */
+uint16_t ArtNetPollTable::RemoveExpired(void) {
+	const time_t nNow = time(NULL);
+	uint16_t nRemoved = 0;
+
+	// Downwards : Remove moves the last entry
+	for (unsigned i = m_nEntries; i-- > 0;) {
+		if ((nNow - m_pPollTable[i].LastUpdate) > (time_t) m_nExpirySeconds) {
+			if (m_pPollTable[i].nOutputPorts != 0) {
+				m_IsOutputPortsChanged = true;
+			}
+			if (m_pArtNetDiscovery != 0) {
+				m_pArtNetDiscovery->Removed(&m_pPollTable[i]);
+			}
+			Remove((uint16_t) i);
+			nRemoved++;
+		}
+	}
+
+	if (nRemoved != 0) {
+		m_bIsChanged = true;
+		m_nChanges += nRemoved;
+	}
+
+	return nRemoved;
+}
+
+/**
+ * Fill \a pIPAddresses with at most \a nMax nodes having an output port with Port-Address \a nPortAddress.
+ * Returns the number of nodes found, which can be more than \a nMax.
+ */
+uint8_t ArtNetPollTable::GetSubscribers(uint16_t nPortAddress, uint32_t *pIPAddresses, uint8_t nMax) const {
+	unsigned nFound = 0;
+
+	for (uint16_t nPortLink = m_pPortHash[hash_port_address(nPortAddress)]; nPortLink != ARTNET_POLL_TABLE_NONE; nPortLink = m_pLinks[nPortLink >> 2].nNextPort[nPortLink & 0x03]) {
+		const struct TArtNetNodeEntry *pEntry = &m_pPollTable[nPortLink >> 2];
+
+		if (pEntry->OutputPortAddress[nPortLink & 0x03] != nPortAddress) {
+			continue;
+		}
+
+		// More ports or pages of a node with the same Port-Address
+		bool IsDuplicate = false;
+		for (unsigned j = 0; (j < nFound) && (j < nMax); j++) {
+			if (pIPAddresses[j] == pEntry->IPAddress) {
+				IsDuplicate = true;
+				break;
+			}
+		}
+
+		if (IsDuplicate) {
+			continue;
+		}
+
+		if (nFound < nMax) {
+			pIPAddresses[nFound] = pEntry->IPAddress;
+		}
+
+		if (nFound < 0xFF) {
+			nFound++;
+		}
+	}
+
+	return (uint8_t) nFound;
+}
+
 void ArtNetPollTable::Dump(void) {
 	printf("Entries : %d\n", m_nEntries);
 
-	for (uint8_t i = 0; i < m_nEntries; i++) {
-		printf("\t" IPSTR " [" MACSTR "] %.18s:%.64s:%x:%x:%d\n", IP2STR(m_pPollTable[i].IPAddress), MAC2STR(m_pPollTable[i].Mac), m_pPollTable[i].ShortName, m_pPollTable[i].LongName, m_pPollTable[i].Status1, m_pPollTable[i].Status2, (int)(m_nLastUpdate - m_pPollTable[i].LastUpdate));
+	for (unsigned i = 0; i < m_nEntries; i++) {
+		printf("\t" IPSTR ":%d [" MACSTR "] %.18s:%.64s:%x:%x:%d\n", IP2STR(m_pPollTable[i].IPAddress), m_pPollTable[i].BindIndex, MAC2STR(m_pPollTable[i].Mac), m_pPollTable[i].ShortName, m_pPollTable[i].LongName, m_pPollTable[i].Status1, m_pPollTable[i].Status2, (int)(m_nLastUpdate - m_pPollTable[i].LastUpdate));
 		printf("\t\t" IPSTR IPSTR "\n", IP2STR(m_pPollTable[i].IpProg.IPAddress), IP2STR(m_pPollTable[i].IpProg.SubMask));
 	}
 
 	m_bIsChanged = false;
 }
 
-bool ArtNetPollTable::GetEntry(const uint8_t nEntry, struct TArtNetNodeEntry *pEntry) {
-	if ((pEntry == 0) || (nEntry == 0)) {
+/**
+ * \a nEntry is 1 .. \ref GetEntries
+ */
+bool ArtNetPollTable::GetEntry(uint16_t nEntry, struct TArtNetNodeEntry *pEntry) const {
+	if ((pEntry == 0) || (nEntry == 0) || (nEntry > m_nEntries)) {
 		return false;
 	}
 
@@ -147,4 +392,3 @@ bool ArtNetPollTable::GetEntry(const uint8_t nEntry, struct TArtNetNodeEntry *pE
 
 	return true;
 }
-
@@ -169,11 +169,21 @@ void dmx_set_send_data(const uint8_t *data, const uint16_t length) {
  * @param length
  */
 void dmx_set_send_data_without_sc(const uint8_t *data, const uint16_t length) {
+	dmx_set_send_data_with_sc(DMX512_START_CODE, data, length);
+}
+
+/**
+ *
+ * @param start_code
+ * @param data
+ * @param length
+ */
+void dmx_set_send_data_with_sc(const uint8_t start_code, const uint8_t *data, const uint16_t length) {
 	do {
 		dmb();
 	} while (dmx_send_state != IDLE && dmx_send_state != DMXINTER);
 
-	dmx_data[0].data[0] = DMX512_START_CODE;
+	dmx_data[0].data[0] = start_code;
 	(void *) memcpy(&dmx_data[0].data[1], data, (size_t) length);
 	dmx_set_send_data_length(length + 1);
 }
@@ -30,6 +30,7 @@
 #include "dmxrdm.h"
 
 #include "lightset.h"
+#include "dmxkernel.h"
 
 #include "gpio.h"
 
@@ -58,6 +59,7 @@ private:
 	bool m_IsActive;
 	uint8_t m_Data[DMX_UNIVERSE_SIZE];
 	uint16_t m_nLength;
+	struct TDmxSlotRange m_tDirty;
 };
 
 #endif /* DMXCONTROLLER_H_ */
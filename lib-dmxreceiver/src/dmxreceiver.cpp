@@ -29,6 +29,7 @@
 #include "dmxreceiver.h"
 
 #include "dmxrdm.h"
+#include "dmxkernel.h"
 
 DMXReceiver::DMXReceiver(uint8_t nGpioPin) : m_pLightSet(0), m_IsActive(false), m_nLength(0) {
 }
@@ -54,31 +55,19 @@ void DMXReceiver::Stop(void) {
 }
 
 bool DMXReceiver::IsDmxDataChanged(const uint8_t *pData, uint16_t nLength) {
-	bool isChanged = false;
-
-	uint8_t *src = (uint8_t *) pData;
-	uint8_t *dst = (uint8_t *) m_Data;
+	if (nLength > DMX_UNIVERSE_SIZE) {
+		nLength = DMX_UNIVERSE_SIZE;
+	}
 
 	if (nLength != m_nLength) {
 		m_nLength = nLength;
-
-		for (unsigned i = 0 ; i < DMX_UNIVERSE_SIZE; i++) {
-			*dst++ = *src++;
-		}
+		dmx_kernel_copy_ltp(m_Data, pData, nLength);
+		m_tDirty.nFirst = 0;
+		m_tDirty.nLast = nLength != 0 ? nLength - 1 : 0;
 		return true;
 	}
 
-	for (unsigned i = 0; i < DMX_UNIVERSE_SIZE; i++) {
-		if (*dst != *src) {
-			*dst = *src;
-			isChanged = true;
-		}
-		dst++;
-		src++;
-	}
-
-	return isChanged;
-
+	return dmx_kernel_copy_changed(m_Data, pData, nLength, &m_tDirty);
 }
 
 int DMXReceiver::Run(void) {
@@ -96,7 +85,7 @@ int DMXReceiver::Run(void) {
 			const uint16_t length = (uint16_t) (dmx_statistics->Statistics.SlotsInPacket);
 
 			if (IsDmxDataChanged(++p, length)) {  // Skip DMX START CODE
-				m_pLightSet->SetData(0, p, length);
+				m_pLightSet->SetDataRange(0, p, length, m_tDirty.nFirst, m_tDirty.nLast);
 			}
 
 			if (!m_IsActive) {
@@ -41,6 +41,7 @@ public:
 	void Stop(void);
 
 	void SetData(uint8_t, const uint8_t *, uint16_t);
+	void SetStartCodeData(uint8_t, uint8_t, const uint8_t *, uint16_t);
 
 private:
 	bool m_bIsStarted;
@@ -59,3 +59,8 @@ void DMXSend::SetData(uint8_t nPortId, const uint8_t *pData, uint16_t nLength) {
 	dmx_set_send_data_without_sc(pData, nLength);
 }
 
+void DMXSend::SetStartCodeData(uint8_t nPortId, uint8_t nStartCode, const uint8_t *pData, uint16_t nLength) {
+	// The output repeats this packet until the next SetData
+	dmx_set_send_data_with_sc(nStartCode, pData, nLength);
+}
+
@@ -101,6 +101,14 @@ enum TPriority {
 	E131_PRIORITY_HIGHEST	= 200	///<
 };
 
+/**
+ * 7.7 Property Values (DMX512-A Data) : the first property value is the START Code
+ */
+enum TStartCode {
+	E131_START_CODE_DMX			= 0x00,	///< Null START Code, the slot levels
+	E131_START_CODE_PRIORITY	= 0xDD	///< Per address priority, 0 is not used, 1 to 200 as 6.4
+};
+
 /**
  * 6.2.6 Options
  */
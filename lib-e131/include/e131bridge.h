@@ -30,15 +30,17 @@
 
 #include "e131.h"
 #include "lightset.h"
+#include "dmxkernel.h"
+#include "dmxmerge.h"
+#include "dmxlosspolicy.h"
 #include "e131packets.h"
+#include "e131discovery.h"
 
 /**
  *
  */
 struct TE131BridgeState {
-	uint8_t nPriority;
 	bool IsNetworkDataLoss;			///<
-	bool IsMergeMode;				///< Is the Bridge in merging mode?
 	bool IsTransmitting;			///<
 	bool IsSynchronized;			///< “Synchronized” or an “Unsynchronized” state.
 	bool IsForcedSynchronized;		///<
@@ -48,27 +50,47 @@ struct TE131BridgeState {
 };
 
 /**
- *
+ * 6.7.2 Sequence Numbering : the data packets of a source
+ */
+struct TE131SequenceStats {
+	uint32_t nAccepted;				///< In sequence
+	uint32_t nDuplicate;			///< The sequence number of the latest accepted packet
+	uint32_t nOutOfOrder;			///< Up to 19 before the latest accepted packet
+};
+
+/**
+ * The E1.31 state of a source, indexed by the \ref DmxMerge source
  */
-struct TSource {
-	uint32_t time;					///< The latest time of the data received from source
-	uint32_t ip;					///< The IP address for source
-	uint8_t data[E131_DMX_LENGTH];	///< The data received from source
+struct TE131Source {
 	uint8_t cid[E131_CID_LENGTH];	///< Sender's CID. Sender's unique ID
-	uint8_t sequenceNumberData;
+	uint8_t sequenceNumberData;		///< The latest accepted sequence number
+	struct TE131SequenceStats tStats;	///< Since the source was added
 };
 
 /**
  * struct to represent an output port
  *
  */
-struct TOutputPort {
-	uint8_t data[E131_DMX_LENGTH];	///< Data sent
-	uint16_t length;				///< Length of sent DMX data
-	TMerge mergeMode;				///< \ref TMerge
+struct TE131OutputPort {
+	DmxMerge merge;					///< The sources and the data sent, \ref DmxMerge
+	struct TDmxSlotRange tDirty;	///< Slots changed since the latest output
 	bool IsDataPending;				///<
-	struct TSource sourceA;			///<
-	struct TSource sourceB;			///<
+	bool IsSampling;				///< Within the sampling period, the output waits for all sources
+	bool IsEnabled;					///< A universe is set
+	bool IsJoined;					///< The port holds the multicast group of nJoinedUniverse
+	uint8_t nNextPortIndex;			///< Next port in the same universe hash bucket
+	uint16_t nUniverse;				///<
+	uint16_t nJoinedUniverse;		///< Differs from nUniverse until the next \ref E131Bridge::UpdateGroups
+	uint32_t nSamplingMillis;		///< Start of the sampling period
+	struct TE131SequenceStats tStats;	///< All sources of the port
+	struct TE131Source sources[DMX_MERGE_MAX_SOURCES];	///<
+};
+
+enum {
+	E131_MAX_PORTS = 64,			///< The LightSet port index is the port index
+	E131_UNIVERSE_HASH_SIZE = 64,	///< Must be a power of 2, not less than E131_MAX_PORTS
+	E131_PORT_INDEX_NONE = 0xFF,	///< End of a port chain
+	E131_SAMPLING_PERIOD_MILLIS = 1500	///< After a universe is set, the sources are collected before the first output
 };
 
 /**
@@ -76,7 +98,7 @@ struct TOutputPort {
  */
 class E131Bridge {
 public:
-	E131Bridge(void);
+	E131Bridge(uint8_t nPorts = 1);
 	~E131Bridge(void);
 
 	void SetOutput(LightSet *);
@@ -86,6 +108,29 @@ public:
 	const uint16_t getUniverse(void);
 	void setUniverse(const uint16_t);
 
+	uint8_t GetPorts(void) const;
+	uint8_t GetActiveOutputPorts(void) const;
+
+	bool GetUniverse(uint8_t, uint16_t &) const;
+	bool SetUniverse(uint8_t, uint16_t);
+
+	bool GetPortStats(uint8_t, struct TE131SequenceStats &) const;
+	bool GetSourceStats(uint8_t, uint8_t, struct TE131SequenceStats &, uint8_t[E131_CID_LENGTH]) const;
+	void ClearPortStats(void);
+
+	void SetJoinOnDiscovery(bool);
+	bool IsJoinOnDiscovery(void) const;
+
+	bool GetPriority(uint8_t, uint8_t &) const;
+	bool GetSourcePriority(uint8_t, uint8_t, uint8_t &, bool &) const;
+
+	void SetNetworkDataLossTimeout(uint32_t);
+	uint32_t GetNetworkDataLossTimeout(void) const;
+
+	void SetLossPolicy(TDmxLossPolicy, uint32_t nFadeMillis = DMX_LOSS_POLICY_FADE_MILLIS);
+	TDmxLossPolicy GetLossPolicy(void) const;
+	bool SetLossPreset(uint8_t, const uint8_t *, uint16_t);
+
 	const TMerge getMergeMode(void);
 	void setMergeMode(TMerge);
 
@@ -97,40 +142,55 @@ public:
 
 	int Run(void);
 
+	// When the datagrams are received by the caller
+	int HandleDatagram(const uint8_t *, uint16_t, uint32_t, uint16_t);
+	void HandleTimers(void);
+
 private:
+	int HandleReceived(uint16_t);
+
 	void Start(void);
 	void Stop(void);
+	void Reset(void);
 
 	void FillDiscoveryPacket(void);
+	void UpdateUniverseMap(void);
+	void UpdateGroups(void);
+	bool IsGroupJoined(uint16_t) const;
 
 	const bool IsValidRoot(void);
 	const bool IsValidDataPacket(void);
 
 	void SetNetworkDataLossCondition(void);
-	void CheckMergeTimeouts(void);
-	const bool IsPriorityTimeOut(void);
-	const bool isIpCidMatch(const struct TSource *);
-	const bool IsDmxDataChanged(const uint8_t *, const uint16_t);
-	const bool IsMergedDmxDataChanged(const uint8_t *, const uint16_t );
+	void SendData(uint8_t);
 
 	void SendDiscoveryPacket(void);
 
-	void HandleDmx(void);
+	void HandleDmx(uint8_t);
+	void HandleStreamTerminated(uint8_t, uint8_t);
 	void HandleSynchronization(void);
+	void HandleDiscovery(uint16_t);
+	void CheckSampling(void);
 
 private:
 	LightSet *m_pLightSet;
-	uint16_t m_nUniverse;
+	uint8_t m_nPorts;
+	uint8_t m_nActivePorts;
+	uint8_t m_nSamplingPorts;			///< Ports within the sampling period
+	bool m_IsGroupsPending;				///< A multicast group is to be joined or left
+	E131DiscoveryTable *m_pDiscoveryTable;	///< Only with join on discovery
+	bool m_IsDiscoveryJoined;			///< The multicast group of E131_UNIVERSE_DISCOVERY has been joined
 	uint8_t m_Cid[E131_CID_LENGTH];
 	char m_SourceName[E131_SOURCE_NAME_LENGTH];
 
 	uint32_t m_DiscoveryIpAddress;
 
 	uint32_t m_nCurrentPacketMillis;
-	uint32_t m_nPreviousPacketMillis;
+	DmxLossPolicy m_LossPolicy;			///< Network data loss, checked with every \ref Run
 
 	struct TE131BridgeState m_State;
-	struct TOutputPort m_OutputPort;
+	struct TE131OutputPort *m_pOutputPorts;					///< Pool of m_nPorts output ports
+	uint8_t m_UniverseHash[E131_UNIVERSE_HASH_SIZE];	///< First port index per bucket, \ref E131_PORT_INDEX_NONE when empty
 
 	struct TE131 m_E131;
 	struct TE131DiscoveryPacket m_E131DiscoveryPacket;
@@ -0,0 +1,130 @@
+/**
+ * @file e131controller.h
+ *
+ */
+/* Copyright (C) 2018 by Arjan van Vught mailto:info@raspberrypi-dmx.nl
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef E131CONTROLLER_H_
+#define E131CONTROLLER_H_
+
+#include <stdint.h>
+
+#include "e131.h"
+#include "e131packets.h"
+#include "e131discovery.h"
+
+enum {
+	E131_CONTROLLER_MAX_UNIVERSES = 512,	///< Default size of the universe table
+	E131_CONTROLLER_DEFAULT_FPS = 44,		///< Default frame rate
+	E131_CONTROLLER_REPEAT = 3				///< 6.6.1 Unchanged data is sent this many times more before the keep-alive rate
+};
+
+#define E131_CONTROLLER_UNIVERSE_NONE	0xFFFF	///< Universe not in the universe table
+
+/**
+ * A universe sent by the controller. The packet is built once, sending patches the sequence number only.
+ */
+struct TE131ControllerUniverse {
+	struct TE131DataPacket E131DataPacket;	///< PropertyValues holds the START Code and the latest data
+	uint32_t nMulticastIp;					///< 9.3.1 Allocation of IPv4 Multicast Addresses
+	uint32_t nMillis;						///< The latest time the packet was sent
+	uint16_t nLength;						///< Length of the DMX data
+	uint8_t nRepeat;						///< Sends left at the frame rate
+	bool IsDataChanged;						///< Changed since the latest packet
+};
+
+/**
+ * E1.31 source : the data of up to m_nMaxUniverses universes is multicast at a fixed frame rate.
+ * No allocation after the first \ref SetData.
+ */
+class E131Controller {
+public:
+	E131Controller(void);
+	~E131Controller(void);
+
+	void Start(void);
+	void Stop(void);
+
+	void Run(void);
+
+	bool SetData(uint16_t, const uint8_t *, uint16_t);
+
+	void SetCid(const uint8_t[E131_CID_LENGTH]);
+	const uint8_t *GetCid(void) const;
+
+	void SetSourceName(const char *);
+	const char *GetSourceName(void) const;
+
+	void SetPriority(uint8_t);
+	uint8_t GetPriority(void) const;
+
+	void SetMaxUniverses(uint16_t);
+	uint16_t GetMaxUniverses(void) const;
+	uint16_t GetUniverses(void) const;
+
+	void SetFps(uint8_t);
+	uint8_t GetFps(void) const;
+
+	void SetKeepAlive(uint16_t);
+	uint16_t GetKeepAlive(void) const;
+
+	void SetSynchronizationUniverse(uint16_t);
+	uint16_t GetSynchronizationUniverse(void) const;
+
+private:
+	void FillDataPacket(struct TE131DataPacket *, uint16_t);
+	void SetDataLength(struct TE131DataPacket *, uint16_t);
+
+	void FillDiscoveryPackets(void);
+	void SendDiscoveryPackets(void);
+
+	void HandleTransmit(void);
+	void SendUniverse(uint16_t, uint32_t);
+	void SendSync(void);
+
+private:
+	uint8_t m_Cid[E131_CID_LENGTH];
+	char m_SourceName[E131_SOURCE_NAME_LENGTH];
+	uint8_t m_nPriority;
+	struct TE131ControllerUniverse *m_pUniverses;	///< Allocated with the first SetData, m_nMaxUniverses entries
+	uint16_t *m_pUniverseIndex;						///< Universe to index in m_pUniverses
+	uint16_t m_nMaxUniverses;
+	uint16_t m_nUniverses;
+	uint16_t m_nFrameIndex;							///< Next universe of the current frame
+	uint16_t m_nFrameDataCount;						///< Data packets sent in the current frame
+	bool m_IsStarted;
+	bool m_IsFrameActive;
+	uint8_t m_nFps;
+	uint16_t m_nKeepAliveMillis;					///< Resend unchanged universes
+	uint32_t m_nFrameMillis;						///< Start of the current frame
+	uint16_t m_nSynchronizationUniverse;			///< 0 is no synchronization
+	uint32_t m_nSynchronizationIp;
+	struct TE131SynchronizationPacket m_E131SynchronizationPacket;
+	struct TE131DiscoveryPacket *m_pDiscoveryPackets;	///< Allocated with the universe table, one per page
+	uint16_t *m_pDiscoveryLengths;
+	uint8_t m_nDiscoveryPages;
+	bool m_IsDiscoveryChanged;						///< The pages are rebuilt before sending
+	uint32_t m_nDiscoveryMillis;					///< The latest time the pages were sent
+	uint32_t m_nDiscoveryIp;
+};
+
+#endif /* E131CONTROLLER_H_ */
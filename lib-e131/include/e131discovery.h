@@ -0,0 +1,91 @@
+/**
+ * @file e131discovery.h
+ *
+ */
+/* Copyright (C) 2018 by Arjan van Vught mailto:info@raspberrypi-dmx.nl
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef E131DISCOVERY_H_
+#define E131DISCOVERY_H_
+
+#include <stdint.h>
+
+#include "e131.h"
+#include "e131packets.h"
+
+enum {
+	E131_DISCOVERY_UNIVERSES_PER_PAGE = 512,	///< 8 Universe Discovery Layer
+	E131_DISCOVERY_TABLE_SIZE = 8,				///< Sources
+	E131_DISCOVERY_BITMAP_SIZE = (E131_UNIVERSE_MAX + 8) / 8,	///< One bit per universe, per source
+	E131_DISCOVERY_EXPIRY_SECONDS = 3 * E131_UNIVERSE_DISCOVERY_INTERVAL_SECONDS	///< A source is removed after missing three discovery intervals
+};
+
+/**
+ * A source advertising its universes with E1.31 Universe Discovery
+ */
+struct TE131DiscoverySource {
+	uint8_t Cid[E131_CID_LENGTH];	///< Sender's CID
+	uint32_t nMillis;				///< The latest page received
+	uint16_t nLastUniverse;			///< The highest universe of the latest page received
+	uint8_t nNextPage;				///< The page following the latest page received
+	bool IsActive;					///< Is the entry in use ?
+	uint8_t *pUniverses;			///< Bitmap of the universes sent
+};
+
+/**
+ * The universes being sent by the other sources on the network.
+ *
+ * Each page replaces the universes from the end of the previous page up to its
+ * last universe, the last page up to E131_UNIVERSE_MAX. Pages received out of
+ * order only add universes.
+ */
+class E131DiscoveryTable {
+public:
+	E131DiscoveryTable(void);
+	~E131DiscoveryTable(void);
+
+	bool Add(const struct TE131DiscoveryPacket *, uint16_t, uint32_t);
+	uint8_t RemoveExpired(uint32_t);
+
+	bool IsSent(uint16_t) const;
+
+	inline uint8_t GetSources(void) const {
+		return m_nSources;
+	}
+
+	inline uint32_t GetChanges(void) const {
+		return m_nChanges;
+	}
+
+private:
+	struct TE131DiscoverySource m_Sources[E131_DISCOVERY_TABLE_SIZE];
+	uint8_t *m_pBitmaps;
+	uint8_t m_nSources;
+	uint32_t m_nChanges;		///< Incremented when a universe is added or removed
+};
+
+/**
+ * Build page \a nPage of the universe discovery of a source, \a pUniverses is sorted and
+ * has up to E131_DISCOVERY_UNIVERSES_PER_PAGE entries. Returns the packet length.
+ */
+extern uint16_t e131_discovery_fill_page(struct TE131DiscoveryPacket *pPacket, const uint8_t *pCid, const char *pSourceName, uint8_t nPage, uint8_t nLastPage, const uint16_t *pUniverses, uint16_t nUniverses);
+
+#endif /* E131DISCOVERY_H_ */
@@ -23,8 +23,8 @@
  * THE SOFTWARE.
  */
 
-#ifndef PACKETS_H_
-#define PACKETS_H_
+#ifndef E131PACKETS_H_
+#define E131PACKETS_H_
 
 #include <stdint.h>
 
@@ -161,7 +161,8 @@ struct TE131 {
 	int length;						///<
 	uint32_t IPAddressFrom;			///<
 	uint32_t IPAddressTo;			///<
+	uint16_t PortFrom;				///< UDP source port
 	union UE131Packet E131Packet;	///<
 };
 
-#endif /* PACKETS_H_ */
+#endif /* E131PACKETS_H_ */
@@ -45,8 +45,10 @@ extern uint32_t millis(void);
 #include "e131.h"
 #include "e131packets.h"
 #include "e131bridge.h"
+#include "e131discovery.h"
 
 #include "lightset.h"
+#include "dmxkernel.h"
 
 #include "network.h"
 
@@ -55,38 +57,71 @@ static const uint8_t ACN_PACKET_IDENTIFIER[E131_PACKET_IDENTIFIER_LENGTH] = { 0x
 
 #define DEFAULT_SOURCE_NAME  "Raspberry Pi Wifi sACN E1.31 http://www.raspberrypi-dmx.org"
 
+/**
+ * 9.3.1 Allocation of IPv4 Multicast Addresses : 239.255.UHB.ULB
+ */
+static uint32_t universe_to_multicast_ip(const uint16_t nUniverse) {
+	struct in_addr addr;
+	(void)inet_aton("239.255.0.0", &addr);
+
+	return addr.s_addr | ((uint32_t)(((uint32_t)nUniverse & (uint32_t)0xFF) << 24)) | ((uint32_t)(((uint32_t)nUniverse & (uint32_t)0xFF00) << 8));
+}
+
 /**
  *
  */
-E131Bridge::E131Bridge(void) :
+E131Bridge::E131Bridge(uint8_t nPorts) :
 		m_pLightSet(0),
-		m_nUniverse(E131_UNIVERSE_DEFAULT),
-		m_nCurrentPacketMillis(0),
-		m_nPreviousPacketMillis(0) {
+		m_nPorts(0),
+		m_nActivePorts(0),
+		m_nSamplingPorts(0),
+		m_IsGroupsPending(false),
+		m_pDiscoveryTable(0),
+		m_IsDiscoveryJoined(false),
+		m_nCurrentPacketMillis(0) {
+
+	if (nPorts == 0) {
+		nPorts = 1;
+	} else if (nPorts > E131_MAX_PORTS) {
+		nPorts = E131_MAX_PORTS;
+	}
 
-	memset(&m_OutputPort, 0, sizeof(struct TOutputPort));
-	m_OutputPort.mergeMode = E131_MERGE_HTP;
-	m_OutputPort.IsDataPending = false;
+	m_nPorts = nPorts;
+
+	m_pOutputPorts = new TE131OutputPort[m_nPorts];
+	assert(m_pOutputPorts != 0);
+
+	for (unsigned i = 0; i < m_nPorts; i++) {
+		m_pOutputPorts[i].merge.SetTimeout((uint32_t) (E131_MERGE_TIMEOUT_SECONDS * 1000));
+		m_pOutputPorts[i].merge.SetPriorityTimeout((uint32_t) (E131_PRIORITY_TIMEOUT_SECONDS * 1000));
+		dmx_slot_range_clear(&m_pOutputPorts[i].tDirty);
+		m_pOutputPorts[i].IsDataPending = false;
+		m_pOutputPorts[i].IsSampling = false;
+		m_pOutputPorts[i].IsEnabled = false;
+		m_pOutputPorts[i].IsJoined = false;
+		m_pOutputPorts[i].nNextPortIndex = E131_PORT_INDEX_NONE;
+		m_pOutputPorts[i].nUniverse = 0;
+		m_pOutputPorts[i].nJoinedUniverse = 0;
+		m_pOutputPorts[i].nSamplingMillis = 0;
+		memset(&m_pOutputPorts[i].tStats, 0, sizeof(struct TE131SequenceStats));
+	}
 
 	memset(&m_State, 0, sizeof(struct TE131BridgeState));
 	m_State.IsNetworkDataLoss = true;
-	m_State.IsMergeMode = false;
 	m_State.IsTransmitting = false;
 	m_State.IsSynchronized = false;
 	m_State.IsForcedSynchronized = false;
-	m_State.nPriority = E131_PRIORITY_LOWEST;
 	m_State.DiscoveryTime = 0;
 
-	m_DiscoveryIpAddress = 0;
+	m_DiscoveryIpAddress = universe_to_multicast_ip(E131_UNIVERSE_DISCOVERY);
 
-	struct in_addr addr;
-	(void)inet_aton("239.255.0.0", &addr);
-	m_DiscoveryIpAddress = addr.s_addr | ((uint32_t)(((uint32_t)E131_UNIVERSE_DISCOVERY & (uint32_t)0xFF) << 24)) | ((uint32_t)(((uint32_t)E131_UNIVERSE_DISCOVERY & (uint32_t)0xFF00) << 8));
+	m_LossPolicy.SetTimeout((uint32_t) (E131_NETWORK_DATA_LOSS_TIMEOUT_SECONDS * 1000));
 
+	memset(m_Cid, 0, E131_CID_LENGTH);
 	setSourceName(DEFAULT_SOURCE_NAME);
-	setUniverse(E131_UNIVERSE_DEFAULT);
 
-	FillDiscoveryPacket();
+	// Port 0 is the default universe
+	(void) SetUniverse(0, E131_UNIVERSE_DEFAULT);
 }
 
 /**
@@ -97,6 +132,12 @@ E131Bridge::~E131Bridge(void) {
 		m_pLightSet->Stop();
 		m_pLightSet = 0;
 	}
+
+	delete m_pDiscoveryTable;
+	m_pDiscoveryTable = 0;
+
+	delete[] m_pOutputPorts;
+	m_pOutputPorts = 0;
 }
 
 
@@ -119,16 +160,24 @@ void E131Bridge::Start(void) {
  */
 void E131Bridge::Stop(void) {
 	m_pLightSet->Stop();
-	//
-	m_State.IsNetworkDataLoss = true;
-	m_State.IsMergeMode = false;
 	m_State.IsTransmitting = false;
+
+	Reset();
+}
+
+/**
+ * Forget all sources, the LightSet keeps its output.
+ */
+void E131Bridge::Reset(void) {
+	m_State.IsNetworkDataLoss = true;
 	m_State.IsSynchronized = false;
 	m_State.IsForcedSynchronized = false;
-	m_State.nPriority = E131_PRIORITY_LOWEST;
 	//
-	m_OutputPort.length = 0;
-	m_OutputPort.IsDataPending = false;
+	for (unsigned i = 0; i < m_nPorts; i++) {
+		m_pOutputPorts[i].merge.Reset();
+		dmx_slot_range_clear(&m_pOutputPorts[i].tDirty);
+		m_pOutputPorts[i].IsDataPending = false;
+	}
 }
 
 /**
@@ -153,277 +202,524 @@ void E131Bridge::SetOutput(LightSet *pLightSet) {
  * @return
  */
 const uint16_t E131Bridge::getUniverse() {
-	return m_nUniverse;
+	return m_pOutputPorts[0].nUniverse;
 }
 
 /**
+ * The universe of port 0
  *
  * @param nUniverse
  */
 void E131Bridge::setUniverse(const uint16_t nUniverse) {
 	assert((nUniverse >= E131_UNIVERSE_DEFAULT) && (nUniverse <= E131_UNIVERSE_MAX));
 
-	m_nUniverse = nUniverse;
+	(void) SetUniverse(0, nUniverse);
 }
 
 /**
  *
  * @return
  */
-const uint8_t* E131Bridge::GetCid(void) {
-	return m_Cid;
+uint8_t E131Bridge::GetPorts(void) const {
+	return m_nPorts;
 }
 
 /**
  *
- * @param
+ * @return
  */
-void E131Bridge::setCid(const uint8_t aCid[E131_CID_LENGTH]) {
-	assert(aCid != 0);
+uint8_t E131Bridge::GetActiveOutputPorts(void) const {
+	return m_nActivePorts;
+}
 
-	memcpy(m_Cid, aCid, E131_CID_LENGTH);
-	memcpy(m_E131DiscoveryPacket.RootLayer.Cid, aCid, E131_CID_LENGTH);
+/**
+ *
+ * @param nPortIndex
+ * @param nUniverse
+ * @return false when the port has no universe
+ */
+bool E131Bridge::GetUniverse(uint8_t nPortIndex, uint16_t &nUniverse) const {
+	if ((nPortIndex >= m_nPorts) || !m_pOutputPorts[nPortIndex].IsEnabled) {
+		return false;
+	}
+
+	nUniverse = m_pOutputPorts[nPortIndex].nUniverse;
+	return true;
 }
 
 /**
+ * The data of \a nUniverse is output on LightSet port \a nPortIndex.
+ * More than one port can have the same universe.
+ * The multicast group is joined, and the group of the previous universe left, with the next \ref Run.
+ * The port is not output before the end of the sampling period.
  *
- * @return
+ * @param nPortIndex
+ * @param nUniverse
+ * @return false when the port or the universe is out of range
  */
-const char* E131Bridge::GetSourceName(void) {
-	return m_SourceName;
+bool E131Bridge::SetUniverse(uint8_t nPortIndex, uint16_t nUniverse) {
+	if ((nPortIndex >= m_nPorts) || (nUniverse < E131_UNIVERSE_DEFAULT) || (nUniverse > E131_UNIVERSE_MAX)) {
+		return false;
+	}
+
+	struct TE131OutputPort *pPort = &m_pOutputPorts[nPortIndex];
+
+	if (pPort->IsEnabled && (pPort->nUniverse == nUniverse)) {
+		return true;
+	}
+
+	if (!pPort->IsEnabled) {
+		pPort->IsEnabled = true;
+		m_nActivePorts++;
+	}
+
+	// The data of the previous universe is not valid for the new universe
+	pPort->merge.Reset();
+	dmx_slot_range_clear(&pPort->tDirty);
+	pPort->IsDataPending = false;
+
+	pPort->nUniverse = nUniverse;
+	m_IsGroupsPending = true;
+
+	// A lower priority source must not be output while a higher priority source has not been received yet
+	if (!pPort->IsSampling) {
+		pPort->IsSampling = true;
+		m_nSamplingPorts++;
+	}
+	pPort->nSamplingMillis = millis();
+
+	UpdateUniverseMap();
+	FillDiscoveryPacket();
+
+	return true;
 }
 
 /**
  *
- * @param
+ * @param nPortIndex
+ * @param tStats
+ * @return false when the port has no universe
  */
-void E131Bridge::setSourceName(const char aSourceName[E131_SOURCE_NAME_LENGTH]) {
-	memcpy(m_SourceName, aSourceName, E131_SOURCE_NAME_LENGTH);
-	memcpy(m_E131DiscoveryPacket.FrameLayer.SourceName, aSourceName, E131_SOURCE_NAME_LENGTH);
+bool E131Bridge::GetPortStats(uint8_t nPortIndex, struct TE131SequenceStats &tStats) const {
+	if ((nPortIndex >= m_nPorts) || !m_pOutputPorts[nPortIndex].IsEnabled) {
+		return false;
+	}
+
+	tStats = m_pOutputPorts[nPortIndex].tStats;
+	return true;
 }
 
 /**
+ * \a nSource is 0 .. DMX_MERGE_MAX_SOURCES - 1
  *
- * @return
+ * @param nPortIndex
+ * @param nSource
+ * @param tStats
+ * @param aCid the CID of the source
+ * @return false when the source is not active
  */
-const TMerge E131Bridge::getMergeMode(void) {
-	return m_OutputPort.mergeMode;
+bool E131Bridge::GetSourceStats(uint8_t nPortIndex, uint8_t nSource, struct TE131SequenceStats &tStats, uint8_t aCid[E131_CID_LENGTH]) const {
+	if ((nPortIndex >= m_nPorts) || (nSource >= DMX_MERGE_MAX_SOURCES)) {
+		return false;
+	}
+
+	const struct TE131OutputPort *pPort = &m_pOutputPorts[nPortIndex];
+
+	if (!pPort->merge.GetSource(nSource)->IsActive) {
+		return false;
+	}
+
+	tStats = pPort->sources[nSource].tStats;
+	memcpy(aCid, pPort->sources[nSource].cid, E131_CID_LENGTH);
+	return true;
 }
 
 /**
  *
- * @param mergeMode
  */
-void E131Bridge::setMergeMode(TMerge mergeMode) {
-	m_OutputPort.mergeMode = mergeMode;
+void E131Bridge::ClearPortStats(void) {
+	for (unsigned i = 0; i < m_nPorts; i++) {
+		memset(&m_pOutputPorts[i].tStats, 0, sizeof(struct TE131SequenceStats));
+
+		for (unsigned j = 0; j < DMX_MERGE_MAX_SOURCES; j++) {
+			memset(&m_pOutputPorts[i].sources[j].tStats, 0, sizeof(struct TE131SequenceStats));
+		}
+	}
 }
 
 /**
+ * The highest priority of the sources received, these are merged.
  *
+ * @param nPortIndex
+ * @param nPriority
+ * @return false when the port has no universe
  */
-void E131Bridge::FillDiscoveryPacket(void) {
-	uint16_t root_layer_length = sizeof(struct TRootLayer);
-	uint16_t framing_layer_size = sizeof(struct TDiscoveryFrameLayer);
-	uint16_t discovery_layer_size = sizeof(struct TUniverseDiscoveryLayer) - (511 * 2);
+bool E131Bridge::GetPriority(uint8_t nPortIndex, uint8_t &nPriority) const {
+	if ((nPortIndex >= m_nPorts) || !m_pOutputPorts[nPortIndex].IsEnabled) {
+		return false;
+	}
 
-	m_State.DiscoveryPacketLength = root_layer_length + framing_layer_size + discovery_layer_size;
+	nPriority = m_pOutputPorts[nPortIndex].merge.GetPriority();
+	return true;
+}
 
-	memset(&m_E131DiscoveryPacket, 0, sizeof(struct TE131DiscoveryPacket));
+/**
+ * \a nSource is 0 .. DMX_MERGE_MAX_SOURCES - 1
+ *
+ * @param nPortIndex
+ * @param nSource
+ * @param nPriority the priority of the latest data packet
+ * @param IsPerAddress the source sends per address priorities (START Code 0xDD), these replace nPriority
+ * @return false when the source is not active
+ */
+bool E131Bridge::GetSourcePriority(uint8_t nPortIndex, uint8_t nSource, uint8_t &nPriority, bool &IsPerAddress) const {
+	if ((nPortIndex >= m_nPorts) || (nSource >= DMX_MERGE_MAX_SOURCES)) {
+		return false;
+	}
 
-	// Root Layer (See Section 5)
-	m_E131DiscoveryPacket.RootLayer.PreAmbleSize = __builtin_bswap16(0x10);
-	memcpy(m_E131DiscoveryPacket.RootLayer.ACNPacketIdentifier, ACN_PACKET_IDENTIFIER, E131_PACKET_IDENTIFIER_LENGTH);
-	m_E131DiscoveryPacket.RootLayer.FlagsLength = __builtin_bswap16((0x07 << 12) | (m_State.DiscoveryPacketLength));
-	m_E131DiscoveryPacket.RootLayer.Vector = __builtin_bswap32(E131_VECTOR_ROOT_EXTENDED);
-	memcpy(m_E131DiscoveryPacket.RootLayer.Cid, m_Cid, E131_CID_LENGTH);
+	const struct TDmxMergeSource *pSource = m_pOutputPorts[nPortIndex].merge.GetSource(nSource);
 
+	if (!pSource->IsActive) {
+		return false;
+	}
 
-	// E1.31 Framing Layer (See Section 6)
-	m_E131DiscoveryPacket.FrameLayer.FLagsLength = __builtin_bswap16((0x07 << 12) | (framing_layer_size + discovery_layer_size) );
-	m_E131DiscoveryPacket.FrameLayer.Vector = __builtin_bswap32(E131_VECTOR_EXTENDED_DISCOVERY);
-	memcpy(m_E131DiscoveryPacket.FrameLayer.SourceName, m_SourceName, E131_SOURCE_NAME_LENGTH);
+	nPriority = pSource->nPriority;
+	IsPerAddress = pSource->IsPerSlot;
+	return true;
+}
 
-	// Universe Discovery Layer (See Section 8)
-	m_E131DiscoveryPacket.UniverseDiscoveryLayer.FlagsLength = __builtin_bswap16((0x07 << 12) | discovery_layer_size);
-	m_E131DiscoveryPacket.UniverseDiscoveryLayer.Vector = __builtin_bswap32(VECTOR_UNIVERSE_DISCOVERY_UNIVERSE_LIST);
-	m_E131DiscoveryPacket.UniverseDiscoveryLayer.ListOfUniverses[0] = __builtin_bswap16(m_nUniverse);
+/**
+ * 6.7.1 Network Data Loss : no data packet for any port within the timeout.
+ *
+ * @param nMillis 0 is ignored
+ */
+void E131Bridge::SetNetworkDataLossTimeout(uint32_t nMillis) {
+	if (nMillis != 0) {
+		m_LossPolicy.SetTimeout(nMillis);
+	}
 }
 
 /**
  *
- * @param pData
- * @param nLength
  * @return
  */
-const bool E131Bridge::IsDmxDataChanged(const uint8_t *pData, const uint16_t nLength) {
-	bool isChanged = false;
+uint32_t E131Bridge::GetNetworkDataLossTimeout(void) const {
+	return m_LossPolicy.GetTimeout();
+}
 
-	uint8_t *src = (uint8_t *)pData;
-	uint8_t *dst = (uint8_t *)m_OutputPort.data;
+/**
+ * The output on a network data loss. \ref DMX_LOSS_POLICY_BLACKOUT stops the LightSet, this is the default.
+ *
+ * @param tPolicy
+ * @param nFadeMillis only used with \ref DMX_LOSS_POLICY_FADE
+ */
+void E131Bridge::SetLossPolicy(TDmxLossPolicy tPolicy, uint32_t nFadeMillis) {
+	m_LossPolicy.SetPolicy(tPolicy);
+	m_LossPolicy.SetFadeTime(nFadeMillis);
+}
 
-	if (nLength != m_OutputPort.length) {
-		m_OutputPort.length = nLength;
-		for (unsigned i = 0 ; i < E131_DMX_LENGTH; i++) {
-			*dst++ = *src++;
-		}
-		return true;
+/**
+ *
+ * @return
+ */
+TDmxLossPolicy E131Bridge::GetLossPolicy(void) const {
+	return m_LossPolicy.GetPolicy();
+}
+
+/**
+ * The scene output by \ref DMX_LOSS_POLICY_PRESET.
+ *
+ * @param nPortIndex
+ * @param pData
+ * @param nLength 0 removes the preset, the port holds its last look
+ * @return false when there is no such port
+ */
+bool E131Bridge::SetLossPreset(uint8_t nPortIndex, const uint8_t *pData, uint16_t nLength) {
+	if (nPortIndex >= m_nPorts) {
+		return false;
 	}
 
-	for (unsigned i = 0; i < E131_DMX_LENGTH; i++) {
-		if (*dst != *src) {
-			*dst = *src;
-			isChanged = true;
-		}
-		dst++;
-		src++;
+	return m_LossPolicy.SetPreset(nPortIndex, pData, nLength);
+}
+
+/**
+ * Join the multicast group of a universe only when another source advertises it
+ * with E1.31 Universe Discovery. Unicast data is received regardless.
+ *
+ * @param IsJoinOnDiscovery
+ */
+void E131Bridge::SetJoinOnDiscovery(bool IsJoinOnDiscovery) {
+	if (IsJoinOnDiscovery == (m_pDiscoveryTable != 0)) {
+		return;
 	}
 
-	return isChanged;
+	if (IsJoinOnDiscovery) {
+		m_pDiscoveryTable = new E131DiscoveryTable;
+		assert(m_pDiscoveryTable != 0);
+	} else {
+		delete m_pDiscoveryTable;
+		m_pDiscoveryTable = 0;
+	}
+
+	m_IsGroupsPending = true;
 }
 
 /**
  *
- * @param pData
- * @param nLength
  * @return
  */
-const bool E131Bridge::IsMergedDmxDataChanged(const uint8_t *pData, const uint16_t nLength) {
-	bool isChanged = false;
+bool E131Bridge::IsJoinOnDiscovery(void) const {
+	return m_pDiscoveryTable != 0;
+}
 
-	if (m_OutputPort.mergeMode == E131_MERGE_HTP) {
+/**
+ * Rebuild the universe hash. Must be called whenever the universe of a port changes.
+ * The chains are built backwards so that each chain is in ascending port order.
+ */
+void E131Bridge::UpdateUniverseMap(void) {
+	for (unsigned i = 0; i < E131_UNIVERSE_HASH_SIZE; i++) {
+		m_UniverseHash[i] = E131_PORT_INDEX_NONE;
+	}
 
-		if (nLength != m_OutputPort.length) {
-			m_OutputPort.length = nLength;
-			for (unsigned i = 0; i < nLength; i++) {
-				uint8_t data = MAX(m_OutputPort.sourceA.data[i], m_OutputPort.sourceB.data[i]);
-				m_OutputPort.data[i] = data;
-			}
+	for (int i = m_nPorts - 1; i >= 0; i--) {
+		if (m_pOutputPorts[i].IsEnabled) {
+			const unsigned nBucket = m_pOutputPorts[i].nUniverse & (E131_UNIVERSE_HASH_SIZE - 1);
+			m_pOutputPorts[i].nNextPortIndex = m_UniverseHash[nBucket];
+			m_UniverseHash[nBucket] = (uint8_t) i;
+		} else {
+			m_pOutputPorts[i].nNextPortIndex = E131_PORT_INDEX_NONE;
+		}
+	}
+}
+
+/**
+ * Is the multicast group of \a nUniverse held by a port ?
+ */
+bool E131Bridge::IsGroupJoined(uint16_t nUniverse) const {
+	for (unsigned i = 0; i < m_nPorts; i++) {
+		if (m_pOutputPorts[i].IsJoined && (m_pOutputPorts[i].nJoinedUniverse == nUniverse)) {
 			return true;
 		}
+	}
 
-		for (unsigned i = 0; i < nLength; i++) {
-			uint8_t data = MAX(m_OutputPort.sourceA.data[i], m_OutputPort.sourceB.data[i]);
-			if (data != m_OutputPort.data[i]) {
-				m_OutputPort.data[i] = data;
-				isChanged = true;
-			}
+	return false;
+}
+
+/**
+ * Join the multicast group of each universe once. A group is left when the last port
+ * moves to another universe, or with join on discovery, when no source advertises
+ * the universe anymore. Only the universes advertised by a source are joined then.
+ */
+void E131Bridge::UpdateGroups(void) {
+	if ((m_pDiscoveryTable != 0) && !m_IsDiscoveryJoined) {
+		network_joingroup(m_DiscoveryIpAddress);
+		m_IsDiscoveryJoined = true;
+	} else if ((m_pDiscoveryTable == 0) && m_IsDiscoveryJoined) {
+		network_leavegroup(m_DiscoveryIpAddress);
+		m_IsDiscoveryJoined = false;
+	}
+
+	for (unsigned i = 0; i < m_nPorts; i++) {
+		struct TE131OutputPort *pPort = &m_pOutputPorts[i];
+
+		if (!pPort->IsJoined) {
+			continue;
 		}
 
-		return isChanged;
-	} else {
-		return IsDmxDataChanged(pData, nLength);
+		if (pPort->IsEnabled && (pPort->nJoinedUniverse == pPort->nUniverse) && ((m_pDiscoveryTable == 0) || m_pDiscoveryTable->IsSent(pPort->nUniverse))) {
+			continue;
+		}
+
+		pPort->IsJoined = false;
+
+		if (!IsGroupJoined(pPort->nJoinedUniverse)) {
+			network_leavegroup(universe_to_multicast_ip(pPort->nJoinedUniverse));
+		}
 	}
+
+	for (unsigned i = 0; i < m_nPorts; i++) {
+		struct TE131OutputPort *pPort = &m_pOutputPorts[i];
+
+		if (!pPort->IsEnabled || pPort->IsJoined) {
+			continue;
+		}
+
+		if ((m_pDiscoveryTable != 0) && !m_pDiscoveryTable->IsSent(pPort->nUniverse)) {
+			continue;	// Joined when a source advertises the universe
+		}
+
+		if (!IsGroupJoined(pPort->nUniverse)) {
+			network_joingroup(universe_to_multicast_ip(pPort->nUniverse));
+		}
+
+		pPort->IsJoined = true;
+		pPort->nJoinedUniverse = pPort->nUniverse;
+	}
+
+	m_IsGroupsPending = false;
 }
 
 /**
  *
+ * @return
  */
-void E131Bridge::CheckMergeTimeouts(void) {
-	const uint32_t timeOutA = m_nCurrentPacketMillis - m_OutputPort.sourceA.time;
-	const uint32_t timeOutB = m_nCurrentPacketMillis - m_OutputPort.sourceB.time;
+const uint8_t* E131Bridge::GetCid(void) {
+	return m_Cid;
+}
 
-	if (timeOutA > (uint32_t)(E131_MERGE_TIMEOUT_SECONDS * 1000)) {
-		m_OutputPort.sourceA.ip = 0;
-		m_State.IsMergeMode = false;
-	}
+/**
+ *
+ * @param
+ */
+void E131Bridge::setCid(const uint8_t aCid[E131_CID_LENGTH]) {
+	assert(aCid != 0);
 
-	if (timeOutB > (uint32_t)(E131_MERGE_TIMEOUT_SECONDS * 1000)) {
-		m_OutputPort.sourceB.ip = 0;
-		m_State.IsMergeMode = false;
-	}
+	memcpy(m_Cid, aCid, E131_CID_LENGTH);
+	memcpy(m_E131DiscoveryPacket.RootLayer.Cid, aCid, E131_CID_LENGTH);
 }
 
 /**
  *
  * @return
  */
-const bool E131Bridge::IsPriorityTimeOut(void) {
-	const uint32_t timeOutA = m_nCurrentPacketMillis - m_OutputPort.sourceA.time;
-	const uint32_t timeOutB = m_nCurrentPacketMillis - m_OutputPort.sourceB.time;
+const char* E131Bridge::GetSourceName(void) {
+	return m_SourceName;
+}
 
-	if ( (m_OutputPort.sourceA.ip != 0) && (m_OutputPort.sourceB.ip != 0) ) {
-		if ( (timeOutA < (uint32_t)(E131_PRIORITY_TIMEOUT_SECONDS * 1000)) || (timeOutB < (uint32_t)(E131_PRIORITY_TIMEOUT_SECONDS * 1000)) ) {
-			return false;
-		} else {
-			return true;
-		}
-	} else if ( (m_OutputPort.sourceA.ip != 0) && (m_OutputPort.sourceB.ip == 0) ) {
-		if (timeOutA > (uint32_t)(E131_PRIORITY_TIMEOUT_SECONDS * 1000)) {
-			return true;
-		}
-	} else if ( (m_OutputPort.sourceA.ip == 0) && (m_OutputPort.sourceB.ip != 0) ) {
-		if (timeOutB > (uint32_t)(E131_PRIORITY_TIMEOUT_SECONDS * 1000)) {
-			return true;
-		}
-	}
+/**
+ *
+ * @param
+ */
+void E131Bridge::setSourceName(const char aSourceName[E131_SOURCE_NAME_LENGTH]) {
+	assert(aSourceName != 0);
 
-	return false;
+	// The name can be shorter than E131_SOURCE_NAME_LENGTH
+	strncpy(m_SourceName, aSourceName, E131_SOURCE_NAME_LENGTH);
+	m_SourceName[E131_SOURCE_NAME_LENGTH - 1] = '\0';
+	memcpy(m_E131DiscoveryPacket.FrameLayer.SourceName, m_SourceName, E131_SOURCE_NAME_LENGTH);
 }
 
 /**
  *
- * @param ip
- * @param cid
  * @return
  */
-const bool E131Bridge::isIpCidMatch(const struct TSource *source) {
-	if (source->ip != m_E131.IPAddressFrom) {
-		return false;
+const TMerge E131Bridge::getMergeMode(void) {
+	return m_pOutputPorts[0].merge.GetMode() == DMX_MERGE_LTP ? E131_MERGE_LTP : E131_MERGE_HTP;
+}
+
+/**
+ *
+ * @param mergeMode
+ */
+void E131Bridge::setMergeMode(TMerge mergeMode) {
+	for (unsigned i = 0; i < m_nPorts; i++) {
+		m_pOutputPorts[i].merge.SetMode(mergeMode == E131_MERGE_LTP ? DMX_MERGE_LTP : DMX_MERGE_HTP);
 	}
+}
 
-	if (memcmp(source->cid, m_E131.E131Packet.Raw.RootLayer.Cid, E131_CID_LENGTH) != 0) {
-		return false;
+/**
+ *
+ */
+void E131Bridge::FillDiscoveryPacket(void) {
+	// 8 Universe Discovery Layer : a sorted list of the universes
+	uint16_t universes[E131_MAX_PORTS];
+	unsigned nUniverses = 0;
+
+	for (unsigned i = 0; i < m_nPorts; i++) {
+		if (!m_pOutputPorts[i].IsEnabled) {
+			continue;
+		}
+
+		const uint16_t nUniverse = m_pOutputPorts[i].nUniverse;
+		unsigned j = nUniverses;
+
+		while ((j > 0) && (universes[j - 1] > nUniverse)) {
+			j--;
+		}
+
+		if ((j > 0) && (universes[j - 1] == nUniverse)) {
+			continue;
+		}
+
+		memmove(&universes[j + 1], &universes[j], (nUniverses - j) * sizeof(uint16_t));
+		universes[j] = nUniverse;
+		nUniverses++;
 	}
 
-	return true;
+	// A single page, E131_MAX_PORTS is less than E131_DISCOVERY_UNIVERSES_PER_PAGE
+	m_State.DiscoveryPacketLength = e131_discovery_fill_page(&m_E131DiscoveryPacket, m_Cid, m_SourceName, 0, 0, universes, (uint16_t) nUniverses);
+}
+
+/**
+ * Output the data, passing the slots changed since the latest output.
+ */
+void E131Bridge::SendData(uint8_t nPortIndex) {
+	struct TE131OutputPort *pPort = &m_pOutputPorts[nPortIndex];
+
+	m_pLightSet->SetDataRange(nPortIndex, pPort->merge.GetData(), pPort->merge.GetLength(), pPort->tDirty.nFirst, pPort->tDirty.nLast);
+	dmx_slot_range_clear(&pPort->tDirty);
+	Start();
 }
 
 /**
  *
  */
-void E131Bridge::HandleDmx(void) {
+void E131Bridge::HandleDmx(uint8_t nPortIndex) {
+	struct TE131OutputPort *pPort = &m_pOutputPorts[nPortIndex];
+	const uint8_t nStartCode = m_E131.E131Packet.Data.DMPLayer.PropertyValues[0];
 	const uint8_t *p = &m_E131.E131Packet.Data.DMPLayer.PropertyValues[1];
-	const uint16_t slots = __builtin_bswap16(m_E131.E131Packet.Data.DMPLayer.PropertyValueCount) - (uint16_t)1;
-	const uint32_t ipA = m_OutputPort.sourceA.ip;
-	const uint32_t ipB = m_OutputPort.sourceB.ip;
-	struct TSource *pSourceA = &m_OutputPort.sourceA;
-	struct TSource *pSourceB = &m_OutputPort.sourceB;
-	const bool isSourceA = isIpCidMatch(pSourceA);
-	const bool isSourceB = isIpCidMatch(pSourceB);
+	uint16_t slots = __builtin_bswap16(m_E131.E131Packet.Data.DMPLayer.PropertyValueCount) - (uint16_t)1;
+	uint8_t nSource = pPort->merge.FindSource(m_E131.IPAddressFrom, m_E131.PortFrom);
+	struct TE131Source *pSource = 0;
 
-	bool sendNewData = false;
+	if (slots > E131_DMX_LENGTH) {
+		slots = E131_DMX_LENGTH;
+	}
+
+	if (nSource != DMX_MERGE_SOURCE_NONE) {
+		pSource = &pPort->sources[nSource];
+
+		if (memcmp(pSource->cid, m_E131.E131Packet.Raw.RootLayer.Cid, E131_CID_LENGTH) != 0) {
+			// Another sender on the same address and port
+			(void) pPort->merge.RemoveSource(nSource, &pPort->tDirty);
+			nSource = DMX_MERGE_SOURCE_NONE;
+		}
+	}
 
-	// 6.9.2 Sequence Numbering
+	// 6.7.2 Sequence Numbering
 	// Having first received a packet with sequence number A, a second packet with sequence number B
 	// arrives. If, using signed 8-bit binary arithmetic, B – A is less than or equal to 0, but greater than -20 then
 	// the packet containing sequence number B shall be deemed out of sequence and discarded
-	if (isSourceA) {
-		const int8_t diff = (int8_t) (m_E131.E131Packet.Data.FrameLayer.SequenceNumber - pSourceA->sequenceNumberData);
-		pSourceA->sequenceNumberData = m_E131.E131Packet.Data.FrameLayer.SequenceNumber;
-		if ((diff <= (int8_t) 0) && (diff > (int8_t) -20)) {
-			return;
-		}
-	} else if (isSourceB) {
-		const int8_t diff = (int8_t) (m_E131.E131Packet.Data.FrameLayer.SequenceNumber - pSourceB->sequenceNumberData);
-		pSourceB->sequenceNumberData = m_E131.E131Packet.Data.FrameLayer.SequenceNumber;
+	if (nSource != DMX_MERGE_SOURCE_NONE) {
+		const int8_t diff = (int8_t) (m_E131.E131Packet.Data.FrameLayer.SequenceNumber - pSource->sequenceNumberData);
+
 		if ((diff <= (int8_t) 0) && (diff > (int8_t) -20)) {
+			// A late packet is compared with the latest accepted, so the sequence number is not updated
+			if (diff == 0) {
+				pSource->tStats.nDuplicate++;
+				pPort->tStats.nDuplicate++;
+			} else {
+				pSource->tStats.nOutOfOrder++;
+				pPort->tStats.nOutOfOrder++;
+			}
 			return;
 		}
+
+		pSource->sequenceNumberData = m_E131.E131Packet.Data.FrameLayer.SequenceNumber;
+		pSource->tStats.nAccepted++;
+		pPort->tStats.nAccepted++;
 	}
 
-	// This bit, when set to 1, indicates that the data in this packet is intended for use in visualization or media
-	// server preview applications and shall not be used to generate live output.
-	if ((m_E131.E131Packet.Data.FrameLayer.Options & E131_OPTIONS_MASK_PREVIEW_DATA) != 0) {
+	// Only the levels and the per address priorities are handled
+	if ((nStartCode != E131_START_CODE_DMX) && (nStartCode != E131_START_CODE_PRIORITY)) {
 		return;
 	}
 
 	// Upon receipt of a packet containing this bit set to a value of 1, receiver shall enter network data loss condition.
 	// Any property values in these packets shall be ignored.
 	if ((m_E131.E131Packet.Data.FrameLayer.Options & E131_OPTIONS_MASK_STREAM_TERMINATED) != 0) {
-		if (isSourceA || isSourceB) {
-			if (!m_State.IsMergeMode) {
-				SetNetworkDataLossCondition();
-			}
+		if (nSource != DMX_MERGE_SOURCE_NONE) {
+			HandleStreamTerminated(nPortIndex, nSource);
 		}
 		return;
 	}
@@ -435,109 +731,128 @@ void E131Bridge::HandleDmx(void) {
 	// When set to 1, once synchronization has been lost, components that had been operating in a synchronized state
 	// need not wait for a new E1.31 Synchronization Packet in order to update to the next E1.31 Data Packet.
 	if ((m_E131.E131Packet.Data.FrameLayer.Options & E131_OPTIONS_MASK_FORCE_SYNCHRONIZATION) == 0) {
+		// While synchronized the data is merged and held until the next synchronization packet
 		m_State.IsForcedSynchronized = true;
-		if (m_State.IsSynchronized) {
-			return;
-		}
 	} else {
 		m_State.IsForcedSynchronized = false;
 	}
 
-	if (m_State.IsMergeMode) {
-		CheckMergeTimeouts();
+	// A source timing out changes the output as well
+	bool sendNewData = pPort->merge.CheckTimeouts(m_nCurrentPacketMillis, &pPort->tDirty);
+
+	if (nSource == DMX_MERGE_SOURCE_NONE) {
+		nSource = pPort->merge.AddSource(m_E131.IPAddressFrom, m_E131.PortFrom, m_nCurrentPacketMillis);
+
+		if (nSource == DMX_MERGE_SOURCE_NONE) {
+			return;	// The source table is full, discarding data
+		}
+
+		pSource = &pPort->sources[nSource];
+		memcpy(pSource->cid, m_E131.E131Packet.Data.RootLayer.Cid, E131_CID_LENGTH);
+		pSource->sequenceNumberData = m_E131.E131Packet.Data.FrameLayer.SequenceNumber;
+		pSource->tStats.nAccepted = 1;
+		pSource->tStats.nDuplicate = 0;
+		pSource->tStats.nOutOfOrder = 0;
+		pPort->tStats.nAccepted++;
 	}
 
-	if (m_E131.E131Packet.Data.FrameLayer.Priority < m_State.nPriority ){
-		if (!IsPriorityTimeOut()) {
-			return;
+	// Only data that is merged ends the network data loss, a Stream_Terminated packet must not cancel a fade
+	m_LossPolicy.Received(m_nCurrentPacketMillis);
+
+	// The sources with the highest priority are merged, a lower priority is held until these time out
+	if (__builtin_expect((nStartCode == E131_START_CODE_DMX), 1)) {
+		if (pPort->merge.SetSourceData(nSource, p, slots, m_E131.E131Packet.Data.FrameLayer.Priority, m_nCurrentPacketMillis, &pPort->tDirty)) {
+			sendNewData = true;
 		}
-		m_State.nPriority = m_E131.E131Packet.Data.FrameLayer.Priority;
-	} else if (m_E131.E131Packet.Data.FrameLayer.Priority > m_State.nPriority) {
-		m_OutputPort.sourceA.ip = 0;
-		m_OutputPort.sourceB.ip = 0;
-		m_State.IsMergeMode = false;
-		m_State.nPriority = m_E131.E131Packet.Data.FrameLayer.Priority;
-	}
-
-	if ((ipA == 0) && (ipB == 0)) {
-		//printf("1. First package from Source\n");
-		pSourceA->ip = m_E131.IPAddressFrom;
-		pSourceA->sequenceNumberData = m_E131.E131Packet.Data.FrameLayer.SequenceNumber;
-		memcpy(pSourceA->cid, m_E131.E131Packet.Data.RootLayer.Cid, 16);
-		pSourceA->time = m_nCurrentPacketMillis;
-		memcpy((void *)pSourceA->data, (const void *)p, slots);
-		sendNewData = IsDmxDataChanged(p, slots);
-
-	} else if (isSourceA && (ipB == 0)) {
-		//printf("2. Continue package from SourceA\n");
-		pSourceA->sequenceNumberData = m_E131.E131Packet.Data.FrameLayer.SequenceNumber;
-		pSourceA->time = m_nCurrentPacketMillis;
-		memcpy((void *)pSourceA->data, (const void *)p, slots);
-		sendNewData = IsDmxDataChanged(p, slots);
-
-	} else if ((ipA == 0) && isSourceB) {
-		//printf("3. Continue package from SourceB\n");
-		pSourceB->sequenceNumberData = m_E131.E131Packet.Data.FrameLayer.SequenceNumber;
-		pSourceB->time = m_nCurrentPacketMillis;
-		memcpy((void *)pSourceB->data, (const void *)p, slots);
-		sendNewData = IsDmxDataChanged(p, slots);
-
-	} else if (!isSourceA && (ipB == 0)) {
-		//printf("4. New ip, start merging\n");
-		pSourceB->ip = m_E131.IPAddressFrom;
-		pSourceB->sequenceNumberData = m_E131.E131Packet.Data.FrameLayer.SequenceNumber;
-		memcpy(m_OutputPort.sourceB.cid, m_E131.E131Packet.Data.RootLayer.Cid, 16);
-		pSourceB->time = m_nCurrentPacketMillis;
-		m_State.IsMergeMode = true;
-		memcpy((void *)pSourceB->data, (const void *)p, slots);
-		sendNewData = IsMergedDmxDataChanged(pSourceB->data, slots);
-
-	} else if ((ipA == 0) && !isSourceB) {
-		//printf("5. New ip, start merging\n");
-		pSourceA->ip = m_E131.IPAddressFrom;
-		pSourceA->sequenceNumberData = m_E131.E131Packet.Data.FrameLayer.SequenceNumber;
-		memcpy(m_OutputPort.sourceA.cid, m_E131.E131Packet.Data.RootLayer.Cid, 16);
-		pSourceA->time = m_nCurrentPacketMillis;
-		m_State.IsMergeMode = true;
-		memcpy((void *)pSourceA->data, (const void *)p, slots);
-		sendNewData = IsMergedDmxDataChanged(pSourceA->data, slots);
-
-	} else if (isSourceA && !isSourceB) {
-		//printf("6. Continue merging\n");
-		pSourceA->sequenceNumberData = m_E131.E131Packet.Data.FrameLayer.SequenceNumber;
-		pSourceA->time = m_nCurrentPacketMillis;
-		memcpy((void *)pSourceA->data, (const void *)p, slots);
-		sendNewData = IsMergedDmxDataChanged(pSourceA->data, slots);
-
-	} else if (!isSourceA && isSourceB) {
-		//printf("7. Continue merging\n");
-		pSourceB->sequenceNumberData = m_E131.E131Packet.Data.FrameLayer.SequenceNumber;
-		pSourceB->time = m_nCurrentPacketMillis;
-		memcpy((void *)pSourceB->data, (const void *)p, slots);
-		sendNewData = IsMergedDmxDataChanged(pSourceB->data, slots);
-
-	} else if (isSourceA && isSourceB) {
-		//printf("8. Source matches both buffers, this shouldn't be happening!\n");
-		return;
+	} else if (pPort->merge.SetSourcePriorities(nSource, p, slots, m_nCurrentPacketMillis, &pPort->tDirty)) {
+		sendNewData = true;
+	}
 
-	} else if (!isSourceA && !isSourceB) {
-		//printf("9. More than two sources, discarding data\n");
-		return;
+	// The slots changed within the sampling period are output at its end
+	if (sendNewData && !pPort->IsSampling) {
+		if (!m_State.IsSynchronized) {
+			SendData(nPortIndex);
+		} else {
+			pPort->IsDataPending = true;
+		}
+	}
+}
 
-	} else {
-		//printf("0. No cases matched, this shouldn't happen!\n");
+/**
+ * The source is removed at once, instead of after the merge timeout.
+ * The network data loss condition is entered when no port has a source left,
+ * otherwise a port without sources holds its output.
+ *
+ * @param nPortIndex
+ * @param nSource
+ */
+void E131Bridge::HandleStreamTerminated(uint8_t nPortIndex, uint8_t nSource) {
+	struct TE131OutputPort *pPort = &m_pOutputPorts[nPortIndex];
+
+	const bool IsChanged = pPort->merge.RemoveSource(nSource, &pPort->tDirty);
+
+	if (pPort->merge.GetSources() != 0) {
+		if (IsChanged && !pPort->IsSampling) {
+			if (!m_State.IsSynchronized) {
+				SendData(nPortIndex);
+			} else {
+				pPort->IsDataPending = true;
+			}
+		}
 		return;
 	}
 
-	if (sendNewData) {
+	for (unsigned i = 0; i < m_nPorts; i++) {
+		if (m_pOutputPorts[i].merge.GetSources() != 0) {
+			return;
+		}
+	}
+
+	SetNetworkDataLossCondition();
+}
+
+/**
+ * End the sampling period of the ports, outputting the data received within.
+ */
+void E131Bridge::CheckSampling(void) {
+	for (unsigned i = 0; i < m_nPorts; i++) {
+		struct TE131OutputPort *pPort = &m_pOutputPorts[i];
+
+		if (!pPort->IsSampling || ((m_nCurrentPacketMillis - pPort->nSamplingMillis) < E131_SAMPLING_PERIOD_MILLIS)) {
+			continue;
+		}
+
+		pPort->IsSampling = false;
+		m_nSamplingPorts--;
+
+		if ((pPort->merge.GetSources() == 0) || (pPort->tDirty.nFirst == DMX_SLOT_NONE)) {
+			continue;
+		}
+
 		if (!m_State.IsSynchronized) {
-			m_pLightSet->SetData(0, m_OutputPort.data, m_OutputPort.length);
-			Start();
+			SendData((uint8_t) i);
 		} else {
-			m_OutputPort.IsDataPending = true;
+			pPort->IsDataPending = true;
 		}
+	}
+}
+
+/**
+ * 8 Universe Discovery of the other sources : a newly advertised universe is joined with the next \ref Run.
+ *
+ * @param nLength
+ */
+void E131Bridge::HandleDiscovery(uint16_t nLength) {
+	if (m_pDiscoveryTable == 0) {
+		return;
+	}
 
+	if (memcmp(m_E131.E131Packet.Discovery.RootLayer.Cid, m_Cid, E131_CID_LENGTH) == 0) {
+		return;	// Our own discovery
+	}
 
+	if (m_pDiscoveryTable->Add(&m_E131.E131Packet.Discovery, nLength, m_nCurrentPacketMillis)) {
+		m_IsGroupsPending = true;
 	}
 }
 
@@ -545,17 +860,33 @@ void E131Bridge::HandleDmx(void) {
  *
  */
 void E131Bridge::HandleSynchronization(void) {
-	if (m_E131.E131Packet.Synchronization.FrameLayer.UniverseNumber != __builtin_bswap16(m_nUniverse)) {
+	const uint16_t nUniverse = __builtin_bswap16(m_E131.E131Packet.Synchronization.FrameLayer.UniverseNumber);
+	uint8_t i = m_UniverseHash[nUniverse & (E131_UNIVERSE_HASH_SIZE - 1)];
+
+	while ((i != E131_PORT_INDEX_NONE) && (m_pOutputPorts[i].nUniverse != nUniverse)) {
+		i = m_pOutputPorts[i].nNextPortIndex;
+	}
+
+	if (i == E131_PORT_INDEX_NONE) {
 		return;
 	}
 
 	m_State.IsSynchronized = true;
 	m_State.SynchronizationTime = m_nCurrentPacketMillis;
 
-	if (m_OutputPort.IsDataPending) {
-		m_pLightSet->SetData(0, m_OutputPort.data, m_OutputPort.length);
-		Start();
-		m_OutputPort.IsDataPending = false;
+	// All ports waiting for synchronization are output as one frame
+	bool IsDataSent = false;
+
+	for (i = 0; i < m_nPorts; i++) {
+		if (m_pOutputPorts[i].IsDataPending) {
+			SendData(i);
+			m_pOutputPorts[i].IsDataPending = false;
+			IsDataSent = true;
+		}
+	}
+
+	if (IsDataSent) {
+		m_pLightSet->Sync();
 	}
 }
 
@@ -563,9 +894,17 @@ void E131Bridge::HandleSynchronization(void) {
  *
  */
 void E131Bridge::SetNetworkDataLossCondition(void) {
-	Stop();
-	m_OutputPort.sourceA.ip = (uint32_t) 0;
-	m_OutputPort.sourceB.ip = (uint32_t) 0;
+	for (unsigned i = 0; i < m_nPorts; i++) {
+		m_LossPolicy.SetLook((uint8_t) i, m_pOutputPorts[i].merge.GetData(), m_pOutputPorts[i].merge.GetLength());
+	}
+
+	if (m_LossPolicy.GetPolicy() == DMX_LOSS_POLICY_BLACKOUT) {
+		Stop();
+	} else {
+		Reset();
+	}
+
+	m_LossPolicy.Begin(m_pLightSet, m_nCurrentPacketMillis);
 }
 
 /**
@@ -602,13 +941,6 @@ const bool E131Bridge::IsValidRoot(void) {
 const bool E131Bridge::IsValidDataPacket(void) {
 	// Frame layer
 
-	// 8.2 Association of Multicast Addresses and Universe
-	// Note: The identity of the universe shall be determined by the universe number in the
-	// packet and not assumed from the multicast address.
-	if (m_E131.E131Packet.Data.FrameLayer.Universe != __builtin_bswap16(m_nUniverse)) {
-		return false;
-	}
-
 	// DMP layer
 
 	// The DMP Layer's Vector shall be set to 0x02, which indicates a DMP Set Property message by
@@ -646,27 +978,85 @@ int E131Bridge::Run(void) {
 	uint16_t nForeignPort;
 	uint32_t IPAddressFrom;
 
-	const int nBytesReceived = network_recvfrom((const uint8_t *)packet, (const uint16_t)sizeof(m_E131.E131Packet), &IPAddressFrom, &nForeignPort) ;
+	const uint16_t nBytesReceived = network_recvfrom((const uint8_t *)packet, (const uint16_t)sizeof(m_E131.E131Packet), &IPAddressFrom, &nForeignPort) ;
+
+	m_E131.IPAddressFrom = IPAddressFrom;
+	m_E131.PortFrom = nForeignPort;
+
+	HandleTimers();
+
+	if (nBytesReceived == 0) {
+		return 0;
+	}
+
+	return HandleReceived(nBytesReceived);
+}
+
+/**
+ * A datagram received by the caller on E131_DEFAULT_PORT, e.g. by the Gateway.
+ * The caller calls \ref HandleTimers with every loop as well.
+ *
+ * @param pData
+ * @param nLength
+ * @param nFromIp
+ * @param nFromPort
+ * @return
+ */
+int E131Bridge::HandleDatagram(const uint8_t *pData, uint16_t nLength, uint32_t nFromIp, uint16_t nFromPort) {
+	assert(pData != 0);
+
+	if (nLength > sizeof(m_E131.E131Packet)) {
+		nLength = (uint16_t) sizeof(m_E131.E131Packet);
+	}
+
+	memcpy(&m_E131.E131Packet, pData, nLength);
+
+	m_E131.IPAddressFrom = nFromIp;
+	m_E131.PortFrom = nFromPort;
+
+	return HandleReceived(nLength);
+}
+
+/**
+ * The multicast groups, the network data loss, the sampling period and the Universe Discovery.
+ */
+void E131Bridge::HandleTimers(void) {
+	if (m_IsGroupsPending) {
+		UpdateGroups();
+	}
 
 	m_nCurrentPacketMillis = millis();
 
+	// Checked with every call, so the detection does not depend on the packets received
+	if (m_LossPolicy.IsTimeout(m_nCurrentPacketMillis)) {
+		SetNetworkDataLossCondition();
+	}
+
+	m_LossPolicy.Run(m_pLightSet, m_nCurrentPacketMillis);
+
+	if (m_nSamplingPorts != 0) {
+		CheckSampling();
+	}
+
 	if (m_nCurrentPacketMillis - m_State.DiscoveryTime >= (E131_UNIVERSE_DISCOVERY_INTERVAL_SECONDS * 1000)) {
 		SendDiscoveryPacket();
-	}
 
-	if (nBytesReceived == 0) {
-		if ((m_nCurrentPacketMillis - m_nPreviousPacketMillis) >= (uint32_t)(E131_NETWORK_DATA_LOSS_TIMEOUT_SECONDS * 1000)) {
-			SetNetworkDataLossCondition();
+		if ((m_pDiscoveryTable != 0) && (m_pDiscoveryTable->RemoveExpired(m_nCurrentPacketMillis) != 0)) {
+			m_IsGroupsPending = true;	// The universes of the expired sources are left
 		}
-		return 0;
 	}
+}
 
+/**
+ *
+ * @param nBytesReceived
+ * @return
+ */
+int E131Bridge::HandleReceived(uint16_t nBytesReceived) {
 	if (!IsValidRoot()) {
 		return 0;
 	}
 
-	m_nPreviousPacketMillis = m_nCurrentPacketMillis;
-
 	if (m_State.IsSynchronized && !m_State.IsForcedSynchronized) {
 		if ((m_nCurrentPacketMillis - m_State.SynchronizationTime) >= (E131_NETWORK_DATA_LOSS_TIMEOUT_SECONDS * 1000)) {
 			m_State.IsSynchronized = false;
@@ -679,12 +1069,32 @@ int E131Bridge::Run(void) {
 		if (!IsValidDataPacket()) {
 			return 0;
 		}
-		HandleDmx();
+
+		// This bit, when set to 1, indicates that the data in this packet is intended for use in visualization or media
+		// server preview applications and shall not be used to generate live output.
+		// Rejected before the universe lookup, so none of the sources nor slots of a port are touched.
+		if (__builtin_expect(((m_E131.E131Packet.Data.FrameLayer.Options & E131_OPTIONS_MASK_PREVIEW_DATA) != 0), 0)) {
+			return nBytesReceived;
+		}
+
+		// 8.2 Association of Multicast Addresses and Universe
+		// Note: The identity of the universe shall be determined by the universe number in the
+		// packet and not assumed from the multicast address.
+		const uint16_t nUniverse = __builtin_bswap16(m_E131.E131Packet.Data.FrameLayer.Universe);
+
+		// More than one port can have the same universe
+		for (uint8_t i = m_UniverseHash[nUniverse & (E131_UNIVERSE_HASH_SIZE - 1)]; i != E131_PORT_INDEX_NONE; i = m_pOutputPorts[i].nNextPortIndex) {
+			if (m_pOutputPorts[i].nUniverse == nUniverse) {
+				HandleDmx(i);
+			}
+		}
 	} else if (nRootVector == E131_VECTOR_ROOT_EXTENDED) {
 		const uint32_t nFramingVector = __builtin_bswap32(m_E131.E131Packet.Raw.FrameLayer.Vector);
 
 		if (nFramingVector == E131_VECTOR_EXTENDED_SYNCHRONIZATION) {
 			HandleSynchronization();
+		} else if (nFramingVector == E131_VECTOR_EXTENDED_DISCOVERY) {
+			HandleDiscovery(nBytesReceived);
 		}
 
 	}
@@ -0,0 +1,543 @@
+/**
+ * @file e131controller.cpp
+ *
+ */
+/* Copyright (C) 2018 by Arjan van Vught mailto:info@raspberrypi-dmx.nl
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <stdint.h>
+#include <assert.h>
+#include <netinet/in.h>
+
+extern "C" {
+extern uint32_t millis(void);
+}
+
+#if defined(__linux__) || defined (__CYGWIN__)
+#include <string.h>
+#include <arpa/inet.h>
+#else
+#include "util.h"
+#endif
+
+#include "e131.h"
+#include "e131packets.h"
+#include "e131controller.h"
+#include "e131discovery.h"
+
+#include "dmxkernel.h"
+
+#include "network.h"
+
+static const uint8_t ACN_PACKET_IDENTIFIER[E131_PACKET_IDENTIFIER_LENGTH] = { 0x41, 0x53, 0x43, 0x2d, 0x45, 0x31, 0x2e, 0x31, 0x37, 0x00, 0x00, 0x00 }; ///< 5.3 ACN Packet Identifier
+
+#define DEFAULT_SOURCE_NAME		"Raspberry Pi sACN E1.31 Controller http://www.raspberrypi-dmx.org"
+#define DEFAULT_PRIORITY		100
+#define KEEP_ALIVE_MILLIS		1000	///< Unchanged data is resent within E131_NETWORK_DATA_LOSS_TIMEOUT_SECONDS
+#define ROOT_LAYER_PREAMBLE		16		///< The Root Layer PDU starts after the preamble and postamble sizes and the ACN Packet Identifier
+
+/**
+ * 9.3.1 Allocation of IPv4 Multicast Addresses : 239.255.UHB.ULB
+ */
+static uint32_t universe_to_multicast_ip(const uint16_t nUniverse) {
+	struct in_addr addr;
+	(void)inet_aton("239.255.0.0", &addr);
+
+	return addr.s_addr | ((uint32_t)(((uint32_t)nUniverse & (uint32_t)0xFF) << 24)) | ((uint32_t)(((uint32_t)nUniverse & (uint32_t)0xFF00) << 8));
+}
+
+/**
+ * The Flags and Length of a PDU : low 12 bits = PDU length, high 4 bits = 0x7
+ */
+static uint16_t flags_length(const uint16_t nLength) {
+	return __builtin_bswap16((uint16_t) ((0x07 << 12) | nLength));
+}
+
+E131Controller::E131Controller(void) :
+		m_nPriority(DEFAULT_PRIORITY),
+		m_pUniverses(0),
+		m_pUniverseIndex(0),
+		m_nMaxUniverses(E131_CONTROLLER_MAX_UNIVERSES),
+		m_nUniverses(0),
+		m_nFrameIndex(0),
+		m_nFrameDataCount(0),
+		m_IsStarted(false),
+		m_IsFrameActive(false),
+		m_nFps(E131_CONTROLLER_DEFAULT_FPS),
+		m_nKeepAliveMillis(KEEP_ALIVE_MILLIS),
+		m_nFrameMillis(0),
+		m_nSynchronizationUniverse(0),
+		m_nSynchronizationIp(0),
+		m_pDiscoveryPackets(0),
+		m_pDiscoveryLengths(0),
+		m_nDiscoveryPages(0),
+		m_IsDiscoveryChanged(false),
+		m_nDiscoveryMillis(0)
+{
+	m_nDiscoveryIp = universe_to_multicast_ip(E131_UNIVERSE_DISCOVERY);
+
+	memset(m_Cid, 0, E131_CID_LENGTH);
+	SetSourceName(DEFAULT_SOURCE_NAME);
+
+	struct TE131SynchronizationPacket *pSync = &m_E131SynchronizationPacket;
+
+	memset((void *) pSync, 0, sizeof(struct TE131SynchronizationPacket));
+
+	// Root Layer (See Section 5)
+	pSync->RootLayer.PreAmbleSize = __builtin_bswap16(0x10);
+	memcpy(pSync->RootLayer.ACNPacketIdentifier, ACN_PACKET_IDENTIFIER, E131_PACKET_IDENTIFIER_LENGTH);
+	pSync->RootLayer.FlagsLength = flags_length(sizeof(struct TE131SynchronizationPacket) - ROOT_LAYER_PREAMBLE);
+	pSync->RootLayer.Vector = __builtin_bswap32(E131_VECTOR_ROOT_EXTENDED);
+
+	// E1.31 Synchronization Packet Framing Layer (See Section 6.3)
+	pSync->FrameLayer.FLagsLength = flags_length(sizeof(struct TE131SynchronizationFrameLayer));
+	pSync->FrameLayer.Vector = __builtin_bswap32(E131_VECTOR_EXTENDED_SYNCHRONIZATION);
+}
+
+E131Controller::~E131Controller(void) {
+	delete[] m_pDiscoveryLengths;
+	m_pDiscoveryLengths = 0;
+
+	delete[] m_pDiscoveryPackets;
+	m_pDiscoveryPackets = 0;
+
+	delete[] m_pUniverseIndex;
+	m_pUniverseIndex = 0;
+
+	delete[] m_pUniverses;
+	m_pUniverses = 0;
+}
+
+void E131Controller::Start(void) {
+	m_nFrameMillis = millis();
+	m_nDiscoveryMillis = m_nFrameMillis - (E131_UNIVERSE_DISCOVERY_INTERVAL_SECONDS * 1000);
+	m_IsStarted = true;
+}
+
+/**
+ * 6.2.6 Stream_Terminated : each universe is sent three times with the Stream_Terminated bit set.
+ */
+void E131Controller::Stop(void) {
+	if (!m_IsStarted) {
+		return;
+	}
+
+	m_IsStarted = false;
+	m_IsFrameActive = false;
+
+	const uint32_t nMillis = millis();
+
+	for (unsigned i = 0; i < m_nUniverses; i++) {
+		m_pUniverses[i].E131DataPacket.FrameLayer.Options = E131_OPTIONS_MASK_STREAM_TERMINATED;
+
+		for (unsigned j = 0; j < 3; j++) {
+			SendUniverse(i, nMillis);
+		}
+
+		m_pUniverses[i].E131DataPacket.FrameLayer.Options = 0;
+		m_pUniverses[i].nRepeat = E131_CONTROLLER_REPEAT;
+		m_pUniverses[i].IsDataChanged = true;
+	}
+}
+
+/**
+ * Patches all universes.
+ */
+void E131Controller::SetCid(const uint8_t aCid[E131_CID_LENGTH]) {
+	assert(aCid != 0);
+
+	memcpy(m_Cid, aCid, E131_CID_LENGTH);
+	memcpy(m_E131SynchronizationPacket.RootLayer.Cid, aCid, E131_CID_LENGTH);
+
+	for (unsigned i = 0; i < m_nUniverses; i++) {
+		memcpy(m_pUniverses[i].E131DataPacket.RootLayer.Cid, aCid, E131_CID_LENGTH);
+	}
+
+	m_IsDiscoveryChanged = true;
+}
+
+const uint8_t *E131Controller::GetCid(void) const {
+	return m_Cid;
+}
+
+/**
+ * Patches all universes.
+ */
+void E131Controller::SetSourceName(const char *pSourceName) {
+	assert(pSourceName != 0);
+
+	// The name can be shorter than E131_SOURCE_NAME_LENGTH
+	strncpy(m_SourceName, pSourceName, E131_SOURCE_NAME_LENGTH);
+	m_SourceName[E131_SOURCE_NAME_LENGTH - 1] = '\0';
+
+	for (unsigned i = 0; i < m_nUniverses; i++) {
+		memcpy(m_pUniverses[i].E131DataPacket.FrameLayer.SourceName, m_SourceName, E131_SOURCE_NAME_LENGTH);
+	}
+
+	m_IsDiscoveryChanged = true;
+}
+
+const char *E131Controller::GetSourceName(void) const {
+	return m_SourceName;
+}
+
+/**
+ * 6.4 Priority : 0 to 200. Patches all universes.
+ */
+void E131Controller::SetPriority(uint8_t nPriority) {
+	if (nPriority > E131_PRIORITY_HIGHEST) {
+		return;
+	}
+
+	m_nPriority = nPriority;
+
+	for (unsigned i = 0; i < m_nUniverses; i++) {
+		m_pUniverses[i].E131DataPacket.FrameLayer.Priority = nPriority;
+	}
+}
+
+uint8_t E131Controller::GetPriority(void) const {
+	return m_nPriority;
+}
+
+/**
+ * The size of the universe table. Only before the first \ref SetData.
+ */
+void E131Controller::SetMaxUniverses(uint16_t nMaxUniverses) {
+	if ((m_pUniverses != 0) || (nMaxUniverses == 0) || (nMaxUniverses > E131_UNIVERSE_MAX)) {
+		return;
+	}
+
+	m_nMaxUniverses = nMaxUniverses;
+}
+
+uint16_t E131Controller::GetMaxUniverses(void) const {
+	return m_nMaxUniverses;
+}
+
+uint16_t E131Controller::GetUniverses(void) const {
+	return m_nUniverses;
+}
+
+void E131Controller::SetFps(uint8_t nFps) {
+	if (nFps == 0) {
+		return;
+	}
+
+	m_nFps = nFps;
+}
+
+uint8_t E131Controller::GetFps(void) const {
+	return m_nFps;
+}
+
+void E131Controller::SetKeepAlive(uint16_t nKeepAliveMillis) {
+	m_nKeepAliveMillis = nKeepAliveMillis;
+}
+
+uint16_t E131Controller::GetKeepAlive(void) const {
+	return m_nKeepAliveMillis;
+}
+
+/**
+ * Each frame with data is closed with an E1.31 Synchronization Packet on \a nUniverse.
+ * 0 disables synchronization. Patches all universes.
+ */
+void E131Controller::SetSynchronizationUniverse(uint16_t nUniverse) {
+	if (nUniverse > E131_UNIVERSE_MAX) {
+		return;
+	}
+
+	m_nSynchronizationUniverse = nUniverse;
+	m_nSynchronizationIp = nUniverse != 0 ? universe_to_multicast_ip(nUniverse) : 0;
+	m_E131SynchronizationPacket.FrameLayer.UniverseNumber = __builtin_bswap16(nUniverse);
+
+	for (unsigned i = 0; i < m_nUniverses; i++) {
+		m_pUniverses[i].E131DataPacket.FrameLayer.Reserved = __builtin_bswap16(nUniverse);
+	}
+}
+
+uint16_t E131Controller::GetSynchronizationUniverse(void) const {
+	return m_nSynchronizationUniverse;
+}
+
+/**
+ * Build the layers of a data packet without data.
+ */
+void E131Controller::FillDataPacket(struct TE131DataPacket *pPacket, uint16_t nUniverse) {
+	memset((void *) pPacket, 0, sizeof(struct TE131DataPacket));
+
+	// Root Layer (See Section 5)
+	pPacket->RootLayer.PreAmbleSize = __builtin_bswap16(0x10);
+	memcpy(pPacket->RootLayer.ACNPacketIdentifier, ACN_PACKET_IDENTIFIER, E131_PACKET_IDENTIFIER_LENGTH);
+	pPacket->RootLayer.Vector = __builtin_bswap32(E131_VECTOR_ROOT_DATA);
+	memcpy(pPacket->RootLayer.Cid, m_Cid, E131_CID_LENGTH);
+
+	// E1.31 Framing Layer (See Section 6)
+	pPacket->FrameLayer.Vector = __builtin_bswap32(E131_VECTOR_DATA_PACKET);
+	memcpy(pPacket->FrameLayer.SourceName, m_SourceName, E131_SOURCE_NAME_LENGTH);
+	pPacket->FrameLayer.Priority = m_nPriority;
+	pPacket->FrameLayer.Reserved = __builtin_bswap16(m_nSynchronizationUniverse);	// E1.31-2016 Synchronization Address
+	pPacket->FrameLayer.Universe = __builtin_bswap16(nUniverse);
+
+	// DMP Layer (See Section 7)
+	pPacket->DMPLayer.Vector = E131_VECTOR_DMP_SET_PROPERTY;
+	pPacket->DMPLayer.Type = 0xa1;
+	pPacket->DMPLayer.FirstAddressProperty = __builtin_bswap16(0x0000);
+	pPacket->DMPLayer.AddressIncrement = __builtin_bswap16(0x0001);
+	pPacket->DMPLayer.PropertyValues[0] = E131_START_CODE_DMX;
+
+	SetDataLength(pPacket, 0);
+}
+
+/**
+ * The PDU lengths of the three layers and the property value count.
+ */
+void E131Controller::SetDataLength(struct TE131DataPacket *pPacket, uint16_t nLength) {
+	const uint16_t nSize = (uint16_t) (sizeof(struct TE131DataPacket) - E131_DMX_LENGTH + nLength);
+
+	pPacket->RootLayer.FlagsLength = flags_length(nSize - ROOT_LAYER_PREAMBLE);
+	pPacket->FrameLayer.FLagsLength = flags_length(nSize - sizeof(struct TRootLayer));
+	pPacket->DMPLayer.FlagsLength = flags_length(nSize - sizeof(struct TRootLayer) - sizeof(struct TDataFrameLayer));
+	pPacket->DMPLayer.PropertyValueCount = __builtin_bswap16(nLength + 1);
+}
+
+/**
+ * Store the DMX data of \a nUniverse, it is sent with the next frame.
+ * A new universe is added to the universe table, false when the table is full.
+ */
+bool E131Controller::SetData(uint16_t nUniverse, const uint8_t *pData, uint16_t nLength) {
+	assert(pData != 0);
+
+	if ((nUniverse < E131_UNIVERSE_DEFAULT) || (nUniverse > E131_UNIVERSE_MAX)) {
+		return false;
+	}
+
+	if (nLength > E131_DMX_LENGTH) {
+		nLength = E131_DMX_LENGTH;
+	}
+
+	if (m_pUniverses == 0) {
+		m_pUniverses = new TE131ControllerUniverse[m_nMaxUniverses];
+		assert(m_pUniverses != 0);
+
+		m_pUniverseIndex = new uint16_t[E131_UNIVERSE_MAX + 1];
+		assert(m_pUniverseIndex != 0);
+
+		for (unsigned i = 0; i <= E131_UNIVERSE_MAX; i++) {
+			m_pUniverseIndex[i] = E131_CONTROLLER_UNIVERSE_NONE;
+		}
+
+		const unsigned nPages = (m_nMaxUniverses + E131_DISCOVERY_UNIVERSES_PER_PAGE - 1) / E131_DISCOVERY_UNIVERSES_PER_PAGE;
+
+		m_pDiscoveryPackets = new TE131DiscoveryPacket[nPages];
+		assert(m_pDiscoveryPackets != 0);
+
+		m_pDiscoveryLengths = new uint16_t[nPages];
+		assert(m_pDiscoveryLengths != 0);
+	}
+
+	uint16_t nIndex = m_pUniverseIndex[nUniverse];
+
+	if (nIndex == E131_CONTROLLER_UNIVERSE_NONE) {
+		if (m_nUniverses == m_nMaxUniverses) {
+			return false;
+		}
+
+		nIndex = m_nUniverses++;
+		m_pUniverseIndex[nUniverse] = nIndex;
+
+		struct TE131ControllerUniverse *pUniverse = &m_pUniverses[nIndex];
+
+		FillDataPacket(&pUniverse->E131DataPacket, nUniverse);
+		pUniverse->nMulticastIp = universe_to_multicast_ip(nUniverse);
+		pUniverse->nMillis = 0;
+		pUniverse->nLength = 0;
+		pUniverse->nRepeat = E131_CONTROLLER_REPEAT;
+		pUniverse->IsDataChanged = true;	// A new universe is sent with the next Run, also with length 0
+
+		m_IsDiscoveryChanged = true;
+	}
+
+	struct TE131ControllerUniverse *pUniverse = &m_pUniverses[nIndex];
+	uint8_t *pPropertyValues = &pUniverse->E131DataPacket.DMPLayer.PropertyValues[1];
+
+	if (nLength != pUniverse->nLength) {
+		dmx_kernel_copy_ltp(pPropertyValues, pData, nLength);
+		SetDataLength(&pUniverse->E131DataPacket, nLength);
+		pUniverse->nLength = nLength;
+	} else if (!dmx_kernel_copy_changed(pPropertyValues, pData, nLength, 0)) {
+		return true;
+	}
+
+	pUniverse->nRepeat = E131_CONTROLLER_REPEAT;
+	pUniverse->IsDataChanged = true;
+
+	return true;
+}
+
+void E131Controller::SendUniverse(uint16_t nIndex, uint32_t nMillis) {
+	struct TE131ControllerUniverse *pUniverse = &m_pUniverses[nIndex];
+	struct TE131DataPacket *pPacket = &pUniverse->E131DataPacket;
+
+	pPacket->FrameLayer.SequenceNumber++;
+
+	const uint16_t nSize = (uint16_t) (sizeof(struct TE131DataPacket) - E131_DMX_LENGTH + pUniverse->nLength);
+
+	network_sendto((const uint8_t *) pPacket, nSize, pUniverse->nMulticastIp, (uint16_t) E131_DEFAULT_PORT);
+
+	if (!pUniverse->IsDataChanged && (pUniverse->nRepeat != 0)) {
+		pUniverse->nRepeat--;
+	}
+
+	pUniverse->nMillis = nMillis;
+	pUniverse->IsDataChanged = false;
+	m_nFrameDataCount++;
+}
+
+/**
+ * 6.3 E1.31 Synchronization Packet
+ */
+void E131Controller::SendSync(void) {
+	m_E131SynchronizationPacket.FrameLayer.SequenceNumber++;
+
+	network_sendto((const uint8_t *) &m_E131SynchronizationPacket, sizeof(struct TE131SynchronizationPacket), m_nSynchronizationIp, (uint16_t) E131_DEFAULT_PORT);
+}
+
+/**
+ * 8 Universe Discovery : the universes in ascending order, up to E131_DISCOVERY_UNIVERSES_PER_PAGE per page.
+ * The universe index is in universe order already.
+ */
+void E131Controller::FillDiscoveryPackets(void) {
+	uint16_t universes[E131_DISCOVERY_UNIVERSES_PER_PAGE];
+	const uint8_t nLastPage = (uint8_t) ((m_nUniverses - 1) / E131_DISCOVERY_UNIVERSES_PER_PAGE);
+	uint16_t nCount = 0;
+	uint8_t nPage = 0;
+
+	for (unsigned nUniverse = E131_UNIVERSE_DEFAULT; nUniverse <= E131_UNIVERSE_MAX; nUniverse++) {
+		if (m_pUniverseIndex[nUniverse] == E131_CONTROLLER_UNIVERSE_NONE) {
+			continue;
+		}
+
+		universes[nCount++] = (uint16_t) nUniverse;
+
+		if (nCount == E131_DISCOVERY_UNIVERSES_PER_PAGE) {
+			m_pDiscoveryLengths[nPage] = e131_discovery_fill_page(&m_pDiscoveryPackets[nPage], m_Cid, m_SourceName, nPage, nLastPage, universes, nCount);
+			nPage++;
+			nCount = 0;
+		}
+	}
+
+	if (nCount != 0) {
+		m_pDiscoveryLengths[nPage] = e131_discovery_fill_page(&m_pDiscoveryPackets[nPage], m_Cid, m_SourceName, nPage, nLastPage, universes, nCount);
+		nPage++;
+	}
+
+	m_nDiscoveryPages = nPage;
+	m_IsDiscoveryChanged = false;
+}
+
+/**
+ * All pages every E131_UNIVERSE_DISCOVERY_INTERVAL_SECONDS, rebuilt only when the universes have changed.
+ */
+void E131Controller::SendDiscoveryPackets(void) {
+	const uint32_t nMillis = millis();
+
+	if ((nMillis - m_nDiscoveryMillis) < (E131_UNIVERSE_DISCOVERY_INTERVAL_SECONDS * 1000)) {
+		return;
+	}
+
+	m_nDiscoveryMillis = nMillis;
+
+	if (m_nUniverses == 0) {
+		return;
+	}
+
+	if (m_IsDiscoveryChanged) {
+		FillDiscoveryPackets();
+	}
+
+	for (unsigned i = 0; i < m_nDiscoveryPages; i++) {
+		network_sendto((const uint8_t *) &m_pDiscoveryPackets[i], m_pDiscoveryLengths[i], m_nDiscoveryIp, (uint16_t) E131_DEFAULT_PORT);
+	}
+}
+
+/**
+ * One frame per 1000 / fps milliseconds. Each frame sends the changed universes, the unchanged
+ * universes still to be repeated, and the universes due for a keep-alive, spread over the first
+ * half of the frame time. A frame with data is closed with a synchronization packet.
+ */
+void E131Controller::HandleTransmit(void) {
+	if (m_nUniverses == 0) {
+		return;
+	}
+
+	const uint32_t nMillis = millis();
+	const uint32_t nFrameMillis = 1000 / m_nFps;
+
+	if (!m_IsFrameActive) {
+		if ((nMillis - m_nFrameMillis) < nFrameMillis) {
+			return;
+		}
+
+		// Keep the frame rate, unless too far behind
+		m_nFrameMillis += nFrameMillis;
+		if ((nMillis - m_nFrameMillis) >= nFrameMillis) {
+			m_nFrameMillis = nMillis;
+		}
+
+		m_IsFrameActive = true;
+		m_nFrameIndex = 0;
+		m_nFrameDataCount = 0;
+	}
+
+	const uint32_t nElapsed = nMillis - m_nFrameMillis;
+	const uint32_t nSpread = nFrameMillis / 2;
+	uint32_t nDue = m_nUniverses;
+
+	if (nElapsed < nSpread) {
+		nDue = ((uint32_t) m_nUniverses * (nElapsed + 1)) / (nSpread + 1);
+	}
+
+	for (; m_nFrameIndex < nDue; m_nFrameIndex++) {
+		const struct TE131ControllerUniverse *pUniverse = &m_pUniverses[m_nFrameIndex];
+
+		if (pUniverse->IsDataChanged || (pUniverse->nRepeat != 0) || ((nMillis - pUniverse->nMillis) >= m_nKeepAliveMillis)) {
+			SendUniverse(m_nFrameIndex, nMillis);
+		}
+	}
+
+	if (m_nFrameIndex == m_nUniverses) {
+		if ((m_nSynchronizationUniverse != 0) && (m_nFrameDataCount != 0)) {
+			SendSync();
+		}
+		m_IsFrameActive = false;
+	}
+}
+
+void E131Controller::Run(void) {
+	if (!m_IsStarted) {
+		return;
+	}
+
+	HandleTransmit();
+	SendDiscoveryPackets();
+}
@@ -0,0 +1,263 @@
+/**
+ * @file e131discovery.cpp
+ *
+ */
+/* Copyright (C) 2018 by Arjan van Vught mailto:info@raspberrypi-dmx.nl
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <stdint.h>
+#include <assert.h>
+
+#if defined(__linux__) || defined (__CYGWIN__)
+#include <string.h>
+#else
+#include "util.h"
+#endif
+
+#include "e131.h"
+#include "e131packets.h"
+#include "e131discovery.h"
+
+static const uint8_t ACN_PACKET_IDENTIFIER[E131_PACKET_IDENTIFIER_LENGTH] = { 0x41, 0x53, 0x43, 0x2d, 0x45, 0x31, 0x2e, 0x31, 0x37, 0x00, 0x00, 0x00 }; ///< 5.3 ACN Packet Identifier
+
+#define ROOT_LAYER_PREAMBLE			16		///< The Root Layer PDU starts after the preamble and postamble sizes and the ACN Packet Identifier
+#define DISCOVERY_LAYER_HEADER		8		///< Flags and Length, Vector, Page and Last Page
+#define DISCOVERY_PACKET_HEADER		(sizeof(struct TRootLayer) + sizeof(struct TDiscoveryFrameLayer) + DISCOVERY_LAYER_HEADER)
+
+static inline bool bitmap_get(const uint8_t *pBitmap, uint16_t nUniverse) {
+	return (pBitmap[nUniverse >> 3] & (1 << (nUniverse & 7))) != 0;
+}
+
+static inline void bitmap_set(uint8_t *pBitmap, uint16_t nUniverse, bool IsSet) {
+	if (IsSet) {
+		pBitmap[nUniverse >> 3] |= (uint8_t) (1 << (nUniverse & 7));
+	} else {
+		pBitmap[nUniverse >> 3] &= (uint8_t) ~(1 << (nUniverse & 7));
+	}
+}
+
+uint16_t e131_discovery_fill_page(struct TE131DiscoveryPacket *pPacket, const uint8_t *pCid, const char *pSourceName, uint8_t nPage, uint8_t nLastPage, const uint16_t *pUniverses, uint16_t nUniverses) {
+	assert(nUniverses <= E131_DISCOVERY_UNIVERSES_PER_PAGE);
+
+	const uint16_t nDiscoveryLayerLength = (uint16_t) (DISCOVERY_LAYER_HEADER + (nUniverses * 2));
+	const uint16_t nLength = (uint16_t) (sizeof(struct TRootLayer) + sizeof(struct TDiscoveryFrameLayer) + nDiscoveryLayerLength);
+
+	memset((void *) pPacket, 0, DISCOVERY_PACKET_HEADER);
+
+	// Root Layer (See Section 5)
+	pPacket->RootLayer.PreAmbleSize = __builtin_bswap16(0x10);
+	memcpy(pPacket->RootLayer.ACNPacketIdentifier, ACN_PACKET_IDENTIFIER, E131_PACKET_IDENTIFIER_LENGTH);
+	pPacket->RootLayer.FlagsLength = __builtin_bswap16((0x07 << 12) | (nLength - ROOT_LAYER_PREAMBLE));
+	pPacket->RootLayer.Vector = __builtin_bswap32(E131_VECTOR_ROOT_EXTENDED);
+	memcpy(pPacket->RootLayer.Cid, pCid, E131_CID_LENGTH);
+
+	// E1.31 Framing Layer (See Section 6)
+	pPacket->FrameLayer.FLagsLength = __builtin_bswap16((0x07 << 12) | (nLength - sizeof(struct TRootLayer)));
+	pPacket->FrameLayer.Vector = __builtin_bswap32(E131_VECTOR_EXTENDED_DISCOVERY);
+	strncpy((char *) pPacket->FrameLayer.SourceName, pSourceName, E131_SOURCE_NAME_LENGTH - 1);
+
+	// Universe Discovery Layer (See Section 8)
+	pPacket->UniverseDiscoveryLayer.FlagsLength = __builtin_bswap16((0x07 << 12) | nDiscoveryLayerLength);
+	pPacket->UniverseDiscoveryLayer.Vector = __builtin_bswap32(VECTOR_UNIVERSE_DISCOVERY_UNIVERSE_LIST);
+	pPacket->UniverseDiscoveryLayer.Page = nPage;
+	pPacket->UniverseDiscoveryLayer.LastPage = nLastPage;
+
+	for (unsigned i = 0; i < nUniverses; i++) {
+		pPacket->UniverseDiscoveryLayer.ListOfUniverses[i] = __builtin_bswap16(pUniverses[i]);
+	}
+
+	return nLength;
+}
+
+E131DiscoveryTable::E131DiscoveryTable(void) :
+	m_nSources(0),
+	m_nChanges(0)
+{
+	m_pBitmaps = new uint8_t[E131_DISCOVERY_TABLE_SIZE * E131_DISCOVERY_BITMAP_SIZE];
+	assert(m_pBitmaps != 0);
+
+	for (unsigned i = 0; i < E131_DISCOVERY_TABLE_SIZE; i++) {
+		m_Sources[i].pUniverses = &m_pBitmaps[i * E131_DISCOVERY_BITMAP_SIZE];
+		m_Sources[i].IsActive = false;
+	}
+}
+
+E131DiscoveryTable::~E131DiscoveryTable(void) {
+	delete[] m_pBitmaps;
+	m_pBitmaps = 0;
+}
+
+/**
+ * Store a universe discovery page of \a nLength bytes received at \a nMillis.
+ * Returns true when a universe has been added to or removed from the source.
+ */
+bool E131DiscoveryTable::Add(const struct TE131DiscoveryPacket *pPacket, uint16_t nLength, uint32_t nMillis) {
+	if (nLength < DISCOVERY_PACKET_HEADER) {
+		return false;
+	}
+
+	const struct TUniverseDiscoveryLayer *pLayer = &pPacket->UniverseDiscoveryLayer;
+	const uint16_t nLayerLength = __builtin_bswap16(pLayer->FlagsLength) & 0x0FFF;
+
+	if ((nLayerLength < DISCOVERY_LAYER_HEADER) || (pLayer->Vector != __builtin_bswap32(VECTOR_UNIVERSE_DISCOVERY_UNIVERSE_LIST)) || (pLayer->Page > pLayer->LastPage)) {
+		return false;
+	}
+
+	uint16_t nUniverses = (uint16_t) ((nLayerLength - DISCOVERY_LAYER_HEADER) / 2);
+
+	if (nUniverses > (nLength - DISCOVERY_PACKET_HEADER) / 2) {
+		nUniverses = (uint16_t) ((nLength - DISCOVERY_PACKET_HEADER) / 2);
+	}
+
+	if (nUniverses > E131_DISCOVERY_UNIVERSES_PER_PAGE) {
+		nUniverses = E131_DISCOVERY_UNIVERSES_PER_PAGE;
+	}
+
+	struct TE131DiscoverySource *pSource = 0;
+	struct TE131DiscoverySource *pFree = 0;
+
+	for (unsigned i = 0; i < E131_DISCOVERY_TABLE_SIZE; i++) {
+		if (!m_Sources[i].IsActive) {
+			if (pFree == 0) {
+				pFree = &m_Sources[i];
+			}
+		} else if (memcmp(m_Sources[i].Cid, pPacket->RootLayer.Cid, E131_CID_LENGTH) == 0) {
+			pSource = &m_Sources[i];
+			break;
+		}
+	}
+
+	if (pSource == 0) {
+		if (pFree == 0) {
+			return false;	// The table is full
+		}
+
+		pSource = pFree;
+		memcpy(pSource->Cid, pPacket->RootLayer.Cid, E131_CID_LENGTH);
+		memset(pSource->pUniverses, 0, E131_DISCOVERY_BITMAP_SIZE);
+		pSource->nLastUniverse = 0;
+		pSource->nNextPage = 0;
+		pSource->IsActive = true;
+		m_nSources++;
+	}
+
+	pSource->nMillis = nMillis;
+
+	const uint8_t nPage = pLayer->Page;
+	bool IsChanged = false;
+
+	if ((nPage == 0) || (nPage == pSource->nNextPage)) {
+		// The page replaces the universes from the end of the previous page
+		const uint32_t nFirst = (nPage == 0) ? 0 : (uint32_t) pSource->nLastUniverse + 1;
+		uint32_t nLast = E131_UNIVERSE_MAX;
+
+		if ((nPage != pLayer->LastPage) && (nUniverses != 0)) {
+			nLast = __builtin_bswap16(pLayer->ListOfUniverses[nUniverses - 1]);
+		}
+
+		// The universes listed are not trusted, the bitmap ends at E131_UNIVERSE_MAX
+		if (nLast > E131_UNIVERSE_MAX) {
+			nLast = E131_UNIVERSE_MAX;
+		}
+
+		unsigned j = 0;
+
+		for (uint32_t nUniverse = nFirst; nUniverse <= nLast; nUniverse++) {
+			bool IsListed = false;
+
+			while ((j < nUniverses) && (__builtin_bswap16(pLayer->ListOfUniverses[j]) <= nUniverse)) {
+				IsListed = IsListed || (__builtin_bswap16(pLayer->ListOfUniverses[j]) == nUniverse);
+				j++;
+			}
+
+			if (bitmap_get(pSource->pUniverses, (uint16_t) nUniverse) != IsListed) {
+				bitmap_set(pSource->pUniverses, (uint16_t) nUniverse, IsListed);
+				IsChanged = true;
+			}
+		}
+	}
+
+	// Out of order, or an unsorted list
+	for (unsigned i = 0; i < nUniverses; i++) {
+		const uint16_t nUniverse = __builtin_bswap16(pLayer->ListOfUniverses[i]);
+
+		if ((nUniverse <= E131_UNIVERSE_MAX) && !bitmap_get(pSource->pUniverses, nUniverse)) {
+			bitmap_set(pSource->pUniverses, nUniverse, true);
+			IsChanged = true;
+		}
+	}
+
+	if (nUniverses != 0) {
+		const uint16_t nLastUniverse = __builtin_bswap16(pLayer->ListOfUniverses[nUniverses - 1]);
+		pSource->nLastUniverse = (nLastUniverse > E131_UNIVERSE_MAX) ? (uint16_t) E131_UNIVERSE_MAX : nLastUniverse;
+	} else if (nPage == 0) {
+		pSource->nLastUniverse = 0;
+	}
+
+	pSource->nNextPage = (nPage == pLayer->LastPage) ? 0 : nPage + 1;
+
+	if (IsChanged) {
+		m_nChanges++;
+	}
+
+	return IsChanged;
+}
+
+/**
+ * Remove the sources without a page received within E131_DISCOVERY_EXPIRY_SECONDS.
+ * Returns the number of sources removed.
+ */
+uint8_t E131DiscoveryTable::RemoveExpired(uint32_t nMillis) {
+	uint8_t nRemoved = 0;
+
+	for (unsigned i = 0; i < E131_DISCOVERY_TABLE_SIZE; i++) {
+		struct TE131DiscoverySource *pSource = &m_Sources[i];
+
+		if (pSource->IsActive && ((nMillis - pSource->nMillis) > (uint32_t) (E131_DISCOVERY_EXPIRY_SECONDS * 1000))) {
+			pSource->IsActive = false;
+			m_nSources--;
+			nRemoved++;
+		}
+	}
+
+	if (nRemoved != 0) {
+		m_nChanges++;
+	}
+
+	return nRemoved;
+}
+
+/**
+ * Is \a nUniverse sent by at least one source ?
+ */
+bool E131DiscoveryTable::IsSent(uint16_t nUniverse) const {
+	if (nUniverse > E131_UNIVERSE_MAX) {
+		return false;
+	}
+
+	for (unsigned i = 0; i < E131_DISCOVERY_TABLE_SIZE; i++) {
+		if (m_Sources[i].IsActive && bitmap_get(m_Sources[i].pUniverses, nUniverse)) {
+			return true;
+		}
+	}
+
+	return false;
+}
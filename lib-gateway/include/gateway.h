@@ -0,0 +1,132 @@
+/**
+ * @file gateway.h
+ *
+ */
+/* Copyright (C) 2018 by Arjan van Vught mailto:info@raspberrypi-dmx.nl
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef GATEWAY_H_
+#define GATEWAY_H_
+
+#include <stdint.h>
+
+#include "lightset.h"
+#include "dmxkernel.h"
+#include "dmxmerge.h"
+
+#include "gatewayinput.h"
+
+class ArtNetNode;
+class E131Bridge;
+class OscServer;
+
+enum TGatewayProtocol {
+	GATEWAY_PROTOCOL_ARTNET,	///< ArtNetNode, on ARTNET_UDP_PORT
+	GATEWAY_PROTOCOL_E131,		///< E131Bridge, on E131_DEFAULT_PORT
+	GATEWAY_PROTOCOL_OSC,		///< OscServer, on its incoming port
+	GATEWAY_PROTOCOLS
+};
+
+enum {
+	GATEWAY_MAX_PORTS = 64,			///< The LightSet port index is the port index of each protocol
+	GATEWAY_BUFFER_SIZE = 1472		///< The largest UDP payload of an Ethernet frame
+};
+
+struct TGatewaySocket {
+	int32_t nHandle;				///< \ref network_udp_begin
+	TGatewayProtocol tProtocol;		///< The decoder of the datagrams received
+};
+
+struct TGatewayPort {
+	DmxMerge merge;					///< One source per protocol
+	struct TDmxSlotRange tDirty;	///< Changed since the previous output
+};
+
+/**
+ * One process serving Art-Net, sACN E1.31 and OSC at once.
+ *
+ * The gateway owns a socket per protocol and hands each datagram to the engine of
+ * its socket, so the routing is a table lookup. The engines keep their own handling
+ * (merging of their sources, universes, synchronization, network data loss),
+ * their output is a \ref GatewayInput instead of the LightSet.
+ * Port n of each engine is one source of the merge of port n, which drives the one LightSet,
+ * typically a LightSetChain.
+ *
+ * The sources are HTP merged by default. The sACN source has the priority of the
+ * sources received by the E131Bridge, the others have the priority of \ref SetPriority.
+ * A source is removed when its engine stops the output, e.g. on a network data loss.
+ *
+ * The engines are created and configured by the caller, and must be destroyed before the gateway.
+ * \ref Start starts the ArtNetNode, don't call ArtNetNode::Start nor OscServer::Start.
+ * Only the Linux and Circle network layers have the sockets needed, see \ref network_udp_begin.
+ */
+class Gateway {
+public:
+	Gateway(uint8_t nPorts = 1);
+	~Gateway(void);
+
+	void SetOutput(LightSet *);
+
+	void SetArtNetNode(ArtNetNode *);
+	void SetE131Bridge(E131Bridge *);
+	void SetOscServer(OscServer *);
+
+	uint8_t GetPorts(void) const;
+
+	void SetMergeMode(TDmxMergeMode);
+	TDmxMergeMode GetMergeMode(void) const;
+
+	void SetPriority(TGatewayProtocol, uint8_t);
+	uint8_t GetPriority(TGatewayProtocol) const;
+
+	bool Start(void);
+	void Stop(void);
+
+	int Run(void);
+
+private:
+	friend class GatewayInput;
+
+	void SetSourceData(TGatewayProtocol, uint8_t, const uint8_t *, uint16_t);
+	void RemoveSources(TGatewayProtocol);
+	void Sync(void);
+	void SetStartCodeData(uint8_t, uint8_t, const uint8_t *, uint16_t);
+
+	bool AddSocket(uint16_t, TGatewayProtocol);
+	void SendData(uint8_t);
+
+private:
+	LightSet *m_pLightSet;
+	ArtNetNode *m_pArtNetNode;
+	E131Bridge *m_pE131Bridge;
+	OscServer *m_pOscServer;
+	uint8_t m_nPorts;
+	uint8_t m_nSockets;
+	bool m_IsOutputStarted;
+	TDmxMergeMode m_tMergeMode;
+	uint8_t m_Priorities[GATEWAY_PROTOCOLS];
+	struct TGatewaySocket m_Sockets[GATEWAY_PROTOCOLS];
+	GatewayInput m_Inputs[GATEWAY_PROTOCOLS];
+	struct TGatewayPort *m_pPorts;			///< Pool of m_nPorts ports
+	uint8_t *m_pBuffer;						///< The datagram received, \ref GATEWAY_BUFFER_SIZE
+};
+
+#endif /* GATEWAY_H_ */
@@ -0,0 +1,57 @@
+/**
+ * @file gatewayinput.h
+ *
+ */
+/* Copyright (C) 2018 by Arjan van Vught mailto:info@raspberrypi-dmx.nl
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef GATEWAYINPUT_H_
+#define GATEWAYINPUT_H_
+
+#include <stdint.h>
+
+#include "lightset.h"
+
+class Gateway;
+
+/**
+ * The LightSet of one protocol engine : its output is a source of the merge of the \ref Gateway.
+ */
+class GatewayInput: public LightSet {
+public:
+	GatewayInput(void);
+	~GatewayInput(void);
+
+	void Set(Gateway *pGateway, uint8_t nProtocol);
+
+	void Start(void);
+	void Stop(void);
+
+	void SetData(uint8_t, const uint8_t *, uint16_t);
+	void Sync(void);
+	void SetStartCodeData(uint8_t, uint8_t, const uint8_t *, uint16_t);
+
+private:
+	Gateway *m_pGateway;
+	uint8_t m_nProtocol;		///< TGatewayProtocol
+};
+
+#endif /* GATEWAYINPUT_H_ */
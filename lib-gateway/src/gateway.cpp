@@ -0,0 +1,427 @@
+/**
+ * @file gateway.cpp
+ *
+ */
+/* Copyright (C) 2018 by Arjan van Vught mailto:info@raspberrypi-dmx.nl
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <stdint.h>
+#include <assert.h>
+
+#include "gateway.h"
+#include "gatewayinput.h"
+
+#include "lightset.h"
+#include "dmxkernel.h"
+#include "dmxmerge.h"
+
+#include "artnetnode.h"
+#include "e131bridge.h"
+#include "oscserver.h"
+
+#include "network.h"
+
+extern "C" uint32_t millis(void);
+
+#define GATEWAY_WAIT_MILLIS		1		///< Run : maximum wait for a datagram, the timers of the engines run at least this often
+#define GATEWAY_MAX_BATCH		32		///< Run : maximum number of datagrams handled per socket, the timers run in between
+
+/**
+ *
+ * @param nPorts the number of LightSet ports, 1 .. GATEWAY_MAX_PORTS
+ */
+Gateway::Gateway(uint8_t nPorts) :
+		m_pLightSet(0),
+		m_pArtNetNode(0),
+		m_pE131Bridge(0),
+		m_pOscServer(0),
+		m_nSockets(0),
+		m_IsOutputStarted(false),
+		m_tMergeMode(DMX_MERGE_HTP)
+{
+	m_nPorts = (nPorts == 0) ? 1 : (nPorts > GATEWAY_MAX_PORTS ? GATEWAY_MAX_PORTS : nPorts);
+
+	m_pPorts = new TGatewayPort[m_nPorts];
+	assert(m_pPorts != 0);
+
+	for (unsigned i = 0; i < m_nPorts; i++) {
+		dmx_slot_range_clear(&m_pPorts[i].tDirty);
+	}
+
+	for (unsigned i = 0; i < GATEWAY_PROTOCOLS; i++) {
+		m_Priorities[i] = DMX_MERGE_PRIORITY_DEFAULT;
+		m_Sockets[i].nHandle = -1;
+		m_Sockets[i].tProtocol = (TGatewayProtocol) i;
+		m_Inputs[i].Set(this, (uint8_t) i);
+	}
+
+	m_pBuffer = new uint8_t[GATEWAY_BUFFER_SIZE];
+	assert(m_pBuffer != 0);
+}
+
+Gateway::~Gateway(void) {
+	if (m_IsOutputStarted) {
+		m_pLightSet->Stop();
+		m_IsOutputStarted = false;
+	}
+
+	delete[] m_pBuffer;
+	m_pBuffer = 0;
+
+	delete[] m_pPorts;
+	m_pPorts = 0;
+}
+
+/**
+ *
+ * @param pLightSet typically a LightSetChain
+ */
+void Gateway::SetOutput(LightSet *pLightSet) {
+	assert(pLightSet != 0);
+
+	m_pLightSet = pLightSet;
+}
+
+/**
+ *
+ * @param pArtNetNode
+ */
+void Gateway::SetArtNetNode(ArtNetNode *pArtNetNode) {
+	assert(pArtNetNode != 0);
+
+	m_pArtNetNode = pArtNetNode;
+	m_pArtNetNode->SetOutput(&m_Inputs[GATEWAY_PROTOCOL_ARTNET]);
+}
+
+/**
+ *
+ * @param pE131Bridge
+ */
+void Gateway::SetE131Bridge(E131Bridge *pE131Bridge) {
+	assert(pE131Bridge != 0);
+
+	m_pE131Bridge = pE131Bridge;
+	m_pE131Bridge->SetOutput(&m_Inputs[GATEWAY_PROTOCOL_E131]);
+}
+
+/**
+ *
+ * @param pOscServer
+ */
+void Gateway::SetOscServer(OscServer *pOscServer) {
+	assert(pOscServer != 0);
+
+	m_pOscServer = pOscServer;
+	m_pOscServer->SetOutput(&m_Inputs[GATEWAY_PROTOCOL_OSC]);
+}
+
+/**
+ *
+ * @return
+ */
+uint8_t Gateway::GetPorts(void) const {
+	return m_nPorts;
+}
+
+/**
+ *
+ * @param tMergeMode
+ */
+void Gateway::SetMergeMode(TDmxMergeMode tMergeMode) {
+	m_tMergeMode = tMergeMode;
+
+	for (unsigned i = 0; i < m_nPorts; i++) {
+		m_pPorts[i].merge.SetMode(tMergeMode);
+	}
+}
+
+/**
+ *
+ * @return
+ */
+TDmxMergeMode Gateway::GetMergeMode(void) const {
+	return m_tMergeMode;
+}
+
+/**
+ * The sACN source uses the priority of the sources received by the E131Bridge instead.
+ *
+ * @param tProtocol
+ * @param nPriority
+ */
+void Gateway::SetPriority(TGatewayProtocol tProtocol, uint8_t nPriority) {
+	assert(tProtocol < GATEWAY_PROTOCOLS);
+
+	m_Priorities[tProtocol] = nPriority;
+}
+
+/**
+ *
+ * @param tProtocol
+ * @return
+ */
+uint8_t Gateway::GetPriority(TGatewayProtocol tProtocol) const {
+	assert(tProtocol < GATEWAY_PROTOCOLS);
+
+	return m_Priorities[tProtocol];
+}
+
+/**
+ * Starts the network and opens a socket for each protocol set.
+ *
+ * @return false when no protocol is set, or a socket could not be opened
+ */
+bool Gateway::Start(void) {
+	assert(m_pLightSet != 0);
+
+	if (m_pArtNetNode != 0) {
+		m_pArtNetNode->Start();
+	} else if (m_pE131Bridge != 0) {
+		network_begin(E131_DEFAULT_PORT);
+	} else if (m_pOscServer != 0) {
+		network_begin(m_pOscServer->GetPortIncoming());
+	} else {
+		return false;
+	}
+
+	if ((m_pArtNetNode != 0) && !AddSocket(ARTNET_UDP_PORT, GATEWAY_PROTOCOL_ARTNET)) {
+		return false;
+	}
+
+	if ((m_pE131Bridge != 0) && !AddSocket(E131_DEFAULT_PORT, GATEWAY_PROTOCOL_E131)) {
+		return false;
+	}
+
+	if ((m_pOscServer != 0) && !AddSocket(m_pOscServer->GetPortIncoming(), GATEWAY_PROTOCOL_OSC)) {
+		return false;
+	}
+
+	return true;
+}
+
+/**
+ * Stops the ArtNetNode, removes the sources of all protocols and stops the output.
+ */
+void Gateway::Stop(void) {
+	if (m_pArtNetNode != 0) {
+		m_pArtNetNode->Stop();
+	}
+
+	for (unsigned i = 0; i < GATEWAY_PROTOCOLS; i++) {
+		RemoveSources((TGatewayProtocol) i);
+	}
+
+	if (m_IsOutputStarted) {
+		m_pLightSet->Stop();
+		m_IsOutputStarted = false;
+	}
+
+	m_nSockets = 0;
+}
+
+/**
+ * Waits for a datagram on any socket, runs the timers of the engines,
+ * then handles the datagrams pending on each socket, at most \ref GATEWAY_MAX_BATCH per socket.
+ *
+ * @return the number of datagrams received
+ */
+int Gateway::Run(void) {
+	int32_t Handles[GATEWAY_PROTOCOLS];
+	int nReceived = 0;
+
+	for (unsigned i = 0; i < m_nSockets; i++) {
+		Handles[i] = m_Sockets[i].nHandle;
+	}
+
+	const uint32_t nReady = (m_nSockets == 0) ? 0 : network_udp_wait(Handles, m_nSockets, GATEWAY_WAIT_MILLIS);
+
+	if (m_pArtNetNode != 0) {
+		m_pArtNetNode->HandleTimers();
+	}
+
+	if (m_pE131Bridge != 0) {
+		m_pE131Bridge->HandleTimers();
+	}
+
+	for (unsigned i = 0; i < m_nSockets; i++) {
+		if ((nReady & (1U << i)) == 0) {
+			continue;
+		}
+
+		for (unsigned nBatch = 0; nBatch < GATEWAY_MAX_BATCH; nBatch++) {
+			uint32_t nFromIp;
+			uint16_t nFromPort;
+
+			const uint16_t nLength = network_udp_recvfrom(m_Sockets[i].nHandle, m_pBuffer, GATEWAY_BUFFER_SIZE, &nFromIp, &nFromPort);
+
+			if (nLength == 0) {
+				break;
+			}
+
+			nReceived++;
+
+			switch (m_Sockets[i].tProtocol) {
+			case GATEWAY_PROTOCOL_ARTNET:
+				m_pArtNetNode->HandleDatagram(m_pBuffer, nLength, nFromIp, nFromPort);
+				break;
+			case GATEWAY_PROTOCOL_E131:
+				m_pE131Bridge->HandleDatagram(m_pBuffer, nLength, nFromIp, nFromPort);
+				break;
+			case GATEWAY_PROTOCOL_OSC:
+				m_pOscServer->HandleDatagram(m_pBuffer, nLength, nFromIp, nFromPort);
+				break;
+			default:
+				break;
+			}
+		}
+	}
+
+	return nReceived;
+}
+
+/**
+ * The output of port \a nPort of an engine. The protocol is the source, there is no timeout.
+ *
+ * @param tProtocol
+ * @param nPort
+ * @param pData
+ * @param nLength
+ */
+void Gateway::SetSourceData(TGatewayProtocol tProtocol, uint8_t nPort, const uint8_t *pData, uint16_t nLength) {
+	if (nPort >= m_nPorts) {
+		return;
+	}
+
+	struct TGatewayPort *pPort = &m_pPorts[nPort];
+	uint8_t nPriority = m_Priorities[tProtocol];
+
+	if (tProtocol == GATEWAY_PROTOCOL_E131) {
+		(void) m_pE131Bridge->GetPriority(nPort, nPriority);
+	}
+
+	const uint32_t nMillis = millis();
+
+	uint8_t nSource = pPort->merge.FindSource(0, (uint16_t) tProtocol);
+
+	if (nSource == DMX_MERGE_SOURCE_NONE) {
+		nSource = pPort->merge.AddSource(0, (uint16_t) tProtocol, nMillis);
+
+		if (nSource == DMX_MERGE_SOURCE_NONE) {
+			return;
+		}
+	}
+
+	if (pPort->merge.SetSourceData(nSource, pData, nLength, nPriority, nMillis, &pPort->tDirty)) {
+		SendData(nPort);
+	}
+}
+
+/**
+ * Removes the source of \a tProtocol from all ports. The output is stopped when no source is left.
+ *
+ * @param tProtocol
+ */
+void Gateway::RemoveSources(TGatewayProtocol tProtocol) {
+	bool IsActive = false;
+
+	for (unsigned i = 0; i < m_nPorts; i++) {
+		struct TGatewayPort *pPort = &m_pPorts[i];
+		const uint8_t nSource = pPort->merge.FindSource(0, (uint16_t) tProtocol);
+
+		if (nSource != DMX_MERGE_SOURCE_NONE) {
+			const bool IsChanged = pPort->merge.RemoveSource(nSource, &pPort->tDirty);
+
+			if (pPort->merge.GetSources() == 0) {
+				// The last look is held, the next source outputs all of its slots
+				dmx_slot_range_clear(&pPort->tDirty);
+			} else if (IsChanged) {
+				SendData((uint8_t) i);
+			}
+		}
+
+		if (pPort->merge.GetSources() != 0) {
+			IsActive = true;
+		}
+	}
+
+	if (!IsActive && m_IsOutputStarted) {
+		m_pLightSet->Stop();
+		m_IsOutputStarted = false;
+	}
+}
+
+void Gateway::Sync(void) {
+	if (m_IsOutputStarted) {
+		m_pLightSet->Sync();
+	}
+}
+
+void Gateway::SetStartCodeData(uint8_t nPort, uint8_t nStartCode, const uint8_t *pData, uint16_t nLength) {
+	if ((nPort < m_nPorts) && m_IsOutputStarted) {
+		m_pLightSet->SetStartCodeData(nPort, nStartCode, pData, nLength);
+	}
+}
+
+/**
+ * A port shared by two protocols is rejected : the datagrams would reach one of them only.
+ *
+ * @param nPort UDP port
+ * @param tProtocol
+ * @return
+ */
+bool Gateway::AddSocket(uint16_t nPort, TGatewayProtocol tProtocol) {
+	assert(m_nSockets < GATEWAY_PROTOCOLS);
+
+	const int32_t nHandle = network_udp_begin(nPort);
+
+	if (nHandle < 0) {
+		return false;
+	}
+
+	for (unsigned i = 0; i < m_nSockets; i++) {
+		if (m_Sockets[i].nHandle == nHandle) {
+			return false;
+		}
+	}
+
+	m_Sockets[m_nSockets].nHandle = nHandle;
+	m_Sockets[m_nSockets].tProtocol = tProtocol;
+	m_nSockets++;
+
+	return true;
+}
+
+void Gateway::SendData(uint8_t nPort) {
+	struct TGatewayPort *pPort = &m_pPorts[nPort];
+
+	if (pPort->tDirty.nFirst == DMX_SLOT_NONE) {
+		return;
+	}
+
+	if (!m_IsOutputStarted) {
+		m_pLightSet->Start();
+		m_IsOutputStarted = true;
+	}
+
+	m_pLightSet->SetDataRange(nPort, pPort->merge.GetData(), pPort->merge.GetLength(), pPort->tDirty.nFirst, pPort->tDirty.nLast);
+
+	dmx_slot_range_clear(&pPort->tDirty);
+}
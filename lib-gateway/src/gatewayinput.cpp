@@ -0,0 +1,70 @@
+/**
+ * @file gatewayinput.cpp
+ *
+ */
+/* Copyright (C) 2018 by Arjan van Vught mailto:info@raspberrypi-dmx.nl
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <stdint.h>
+#include <assert.h>
+
+#include "gatewayinput.h"
+#include "gateway.h"
+
+GatewayInput::GatewayInput(void): m_pGateway(0), m_nProtocol(0) {
+}
+
+GatewayInput::~GatewayInput(void) {
+	m_pGateway = 0;
+}
+
+void GatewayInput::Set(Gateway *pGateway, uint8_t nProtocol) {
+	assert(pGateway != 0);
+	assert(nProtocol < GATEWAY_PROTOCOLS);
+
+	m_pGateway = pGateway;
+	m_nProtocol = nProtocol;
+}
+
+/**
+ * The output is started with the first data of any protocol.
+ */
+void GatewayInput::Start(void) {
+}
+
+void GatewayInput::Stop(void) {
+	m_pGateway->RemoveSources((TGatewayProtocol) m_nProtocol);
+}
+
+/**
+ * SetDataRange is not overridden : the merge finds the changed slots itself.
+ */
+void GatewayInput::SetData(uint8_t nPort, const uint8_t *pData, uint16_t nLength) {
+	m_pGateway->SetSourceData((TGatewayProtocol) m_nProtocol, nPort, pData, nLength);
+}
+
+void GatewayInput::Sync(void) {
+	m_pGateway->Sync();
+}
+
+void GatewayInput::SetStartCodeData(uint8_t nPort, uint8_t nStartCode, const uint8_t *pData, uint16_t nLength) {
+	m_pGateway->SetStartCodeData(nPort, nStartCode, pData, nLength);
+}
@@ -40,6 +40,7 @@ extern void sys_time_init(void);
 extern void sys_time_set(/*@out@*/const struct tm *);
 
 extern const uint32_t millis();
+extern const uint32_t micros();
 
 #ifdef __cplusplus
 }
@@ -120,3 +120,15 @@ const uint32_t millis(void) {
 
 	return elapsed;
 }
+
+/**
+ * @ingroup time
+ *
+ */
+const uint32_t micros(void) {
+	dmb();
+	const uint32_t elapsed = (uint32_t) (bcm2835_st_read() - sys_time_init_startup_micros);
+	dmb();
+
+	return elapsed;
+}
@@ -51,7 +51,7 @@ public:
 	}
 
 public: // RDM
-	inline const uint8_t GetDmxStartAddress(void) const {
+	inline uint16_t GetDmxStartAddress(void) const {
 		return m_nDmxStartAddress;
 	}
 
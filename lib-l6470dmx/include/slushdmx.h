@@ -47,6 +47,7 @@ public:
 	void Stop(void);
 
 	void SetData(uint8_t, const uint8_t *, uint16_t);
+	void SetDataRange(uint8_t, const uint8_t *, uint16_t, uint16_t, uint16_t);
 
 public: // RDM
 	bool SetDmxStartAddress(uint16_t nDmxStartAddress);
@@ -57,6 +57,7 @@ public:
 	void Stop(void);
 
 	void SetData(uint8_t, const uint8_t *, uint16_t);
+	void SetDataRange(uint8_t, const uint8_t *, uint16_t, uint16_t, uint16_t);
 
 public:
 	void ReadConfigFiles(void);
@@ -342,13 +342,17 @@ void SparkFunDmx::ReadConfigFiles(void) {
 }
 
 void SparkFunDmx::SetData(uint8_t nPortId, const uint8_t *pData, uint16_t nLength) {
+	SetDataRange(nPortId, pData, nLength, 0, nLength != 0 ? nLength - 1 : 0);
+}
+
+void SparkFunDmx::SetDataRange(uint8_t nPortId, const uint8_t *pData, uint16_t nLength, uint16_t nFirstDirty, uint16_t nLastDirty) {
 	DEBUG_ENTRY;
 
 	assert(pData != 0);
 	assert(nLength <= DMX_MAX_CHANNELS);
 
 	for (int i = 0; i < SPARKFUN_DMX_MAX_MOTORS; i++) {
-		if (m_pL6470DmxModes[i] != 0) {
+		if ((m_pL6470DmxModes[i] != 0) && IsRangeDirty(nFirstDirty, nLastDirty, m_pL6470DmxModes[i]->GetDmxStartAddress() - 1, m_pL6470DmxModes[i]->GetDmxFootPrint())) {
 			m_pL6470DmxModes[i]->DmxData(pData, nLength);
 		}
 	}
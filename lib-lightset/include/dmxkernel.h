@@ -0,0 +1,101 @@
+/**
+ * @file dmxkernel.h
+ *
+ */
+/* Copyright (C) 2018 by Arjan van Vught mailto:info@raspberrypi-dmx.nl
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef DMXKERNEL_H_
+#define DMXKERNEL_H_
+
+#include <stdint.h>
+#ifndef __cplusplus
+#include <stdbool.h>
+#endif
+
+/**
+ * The slots changed by the latest call, both inclusive.
+ * Only valid when the call returned true.
+ */
+struct TDmxSlotRange {
+	uint16_t nFirst;	///< First changed slot
+	uint16_t nLast;		///< Last changed slot
+};
+
+#define DMX_SLOT_NONE	0xFFFF	///< \ref TDmxSlotRange nFirst of an empty range
+
+/**
+ * Set \a pRange to the empty range.
+ */
+inline static void dmx_slot_range_clear(struct TDmxSlotRange *pRange) {
+	pRange->nFirst = DMX_SLOT_NONE;
+	pRange->nLast = 0;
+}
+
+/**
+ * Extend \a pRange with the slots nFirst..nLast.
+ */
+inline static void dmx_slot_range_add(struct TDmxSlotRange *pRange, uint16_t nFirst, uint16_t nLast) {
+	if (nFirst < pRange->nFirst) {
+		pRange->nFirst = nFirst;
+	}
+	if (nLast > pRange->nLast) {
+		pRange->nLast = nLast;
+	}
+}
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Compare \a pSrc with \a pDst and copy the changed slots into \a pDst.
+ * Returns true when at least one slot has changed. \a pRange may be 0.
+ */
+extern bool dmx_kernel_copy_changed(uint8_t *pDst, const uint8_t *pSrc, uint16_t nLength, /*@null@*/struct TDmxSlotRange *pRange);
+
+/**
+ * HTP merge : \a pDst = max(\a pA, \a pB).
+ * Returns true when at least one slot of \a pDst has changed. \a pRange may be 0.
+ */
+extern bool dmx_kernel_merge_htp(uint8_t *pDst, const uint8_t *pA, const uint8_t *pB, uint16_t nLength, /*@null@*/struct TDmxSlotRange *pRange);
+
+/**
+ * LTP : unconditional copy of \a pSrc into \a pDst.
+ */
+extern void dmx_kernel_copy_ltp(uint8_t *pDst, const uint8_t *pSrc, uint16_t nLength);
+
+/**
+ * Compare \a pA with \a pB without modifying either.
+ * Returns true when the buffers differ, \a pRange is the first and last slot that differ.
+ */
+extern bool dmx_kernel_dirty_range(const uint8_t *pA, const uint8_t *pB, uint16_t nLength, struct TDmxSlotRange *pRange);
+
+/**
+ * The variant selected at compile time : "NEON", "SSE2", "Word32" or "Word64".
+ */
+extern const char *dmx_kernel_get_variant(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* DMXKERNEL_H_ */
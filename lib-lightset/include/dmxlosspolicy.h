@@ -0,0 +1,137 @@
+/**
+ * @file dmxlosspolicy.h
+ *
+ */
+/* Copyright (C) 2018 by Arjan van Vught mailto:info@raspberrypi-dmx.nl
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef DMXLOSSPOLICY_H_
+#define DMXLOSSPOLICY_H_
+
+#include <stdint.h>
+
+#include "lightset.h"
+
+#ifndef DMX_LOSS_POLICY_MAX_PORTS
+ #define DMX_LOSS_POLICY_MAX_PORTS	64		///< LightSet ports with a stored look or preset
+#endif
+
+enum TDmxLossPolicy {
+	DMX_LOSS_POLICY_HOLD,		///< Keep outputting the last look
+	DMX_LOSS_POLICY_FADE,		///< Fade the last look to black over the fade time
+	DMX_LOSS_POLICY_PRESET,		///< Output the stored preset scene, the ports without a preset hold
+	DMX_LOSS_POLICY_BLACKOUT	///< LightSet::Stop, done by the node
+};
+
+enum {
+	DMX_LOSS_POLICY_LENGTH = 512,				///< Slots per port
+	DMX_LOSS_POLICY_TIMEOUT_MILLIS = 10000,		///< Default network data loss timeout
+	DMX_LOSS_POLICY_FADE_MILLIS = 2000,			///< Default fade time
+	DMX_LOSS_POLICY_FADE_MAX_MILLIS = 0xFFFFFF	///< The fade level is computed in 32 bits
+};
+
+/**
+ * What the output does when the network data is lost.
+ *
+ * The node calls \ref Received for each DMX packet of its ports, and \ref Run
+ * from its timer path with every loop, whether a packet was received or not.
+ * So the loss is detected within a loop of the timeout, independent of the traffic.
+ *
+ * On a timeout, \ref IsTimeout returns true once. The node then hands over the
+ * last look of each port with \ref SetLook, resets its own state and calls \ref Begin.
+ * The loss ends with the next \ref Received.
+ */
+class DmxLossPolicy {
+public:
+	DmxLossPolicy(void);
+	~DmxLossPolicy(void);
+
+	inline void SetPolicy(TDmxLossPolicy tPolicy) {
+		m_tPolicy = tPolicy;
+	}
+	inline TDmxLossPolicy GetPolicy(void) const {
+		return m_tPolicy;
+	}
+
+	inline void SetTimeout(uint32_t nMillis) {
+		m_nTimeoutMillis = nMillis;
+	}
+	inline uint32_t GetTimeout(void) const {
+		return m_nTimeoutMillis;
+	}
+
+	inline void SetFadeTime(uint32_t nMillis) {
+		m_nFadeMillis = (nMillis < (uint32_t) DMX_LOSS_POLICY_FADE_MAX_MILLIS) ? nMillis : (uint32_t) DMX_LOSS_POLICY_FADE_MAX_MILLIS;
+	}
+	inline uint32_t GetFadeTime(void) const {
+		return m_nFadeMillis;
+	}
+
+	bool SetPreset(uint8_t nPort, const uint8_t *pData, uint16_t nLength);
+	void ClearPreset(uint8_t nPort);
+
+	inline void Received(uint32_t nMillis) {
+		m_nReceivedMillis = nMillis;
+		m_IsReceiving = true;
+		m_IsFading = false;
+	}
+
+	inline bool IsTimeout(uint32_t nMillis) const {
+		return m_IsReceiving && ((nMillis - m_nReceivedMillis) >= m_nTimeoutMillis);
+	}
+
+	void SetLook(uint8_t nPort, const uint8_t *pData, uint16_t nLength);
+	void Begin(LightSet *pLightSet, uint32_t nMillis);
+
+	inline void Run(LightSet *pLightSet, uint32_t nMillis) {
+		if (__builtin_expect(m_IsFading, 0)) {
+			Fade(pLightSet, nMillis);
+		}
+	}
+
+	inline bool IsLoss(void) const {
+		return !m_IsReceiving;
+	}
+
+	inline bool IsFading(void) const {
+		return m_IsFading;
+	}
+
+private:
+	void Fade(LightSet *pLightSet, uint32_t nMillis);
+	void Output(LightSet *pLightSet, uint16_t nLevel);
+
+private:
+	TDmxLossPolicy m_tPolicy;
+	uint32_t m_nTimeoutMillis;
+	uint32_t m_nFadeMillis;
+	uint32_t m_nReceivedMillis;		///< The latest DMX packet of a port
+	uint32_t m_nLossMillis;			///< Start of the loss
+	uint16_t m_nLevel;				///< Fade level output, 256 is the last look
+	bool m_IsReceiving;				///< Data has been received since the previous loss
+	bool m_IsFading;
+	uint8_t *m_pLooks[DMX_LOSS_POLICY_MAX_PORTS];		///< Allocated with the first \ref SetLook for a fade
+	uint16_t m_nLookLength[DMX_LOSS_POLICY_MAX_PORTS];
+	uint8_t *m_pPresets[DMX_LOSS_POLICY_MAX_PORTS];		///< Allocated with the first \ref SetPreset
+	uint16_t m_nPresetLength[DMX_LOSS_POLICY_MAX_PORTS];
+};
+
+#endif /* DMXLOSSPOLICY_H_ */
@@ -0,0 +1,159 @@
+/**
+ * @file dmxmerge.h
+ *
+ */
+/* Copyright (C) 2018 by Arjan van Vught mailto:info@raspberrypi-dmx.nl
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef DMXMERGE_H_
+#define DMXMERGE_H_
+
+#include <stdint.h>
+
+#include "dmxkernel.h"
+
+#ifndef DMX_MERGE_MAX_SOURCES
+ #define DMX_MERGE_MAX_SOURCES	4		///< Size of the source table of a port
+#endif
+
+enum TDmxMergeMode {
+	DMX_MERGE_HTP,		///< Highest Takes Precedence (HTP)
+	DMX_MERGE_LTP		///< Latest Takes Precedence (LTP)
+};
+
+enum {
+	DMX_MERGE_LENGTH = 512,					///< Slots per source
+	DMX_MERGE_SOURCE_NONE = 0xFF,			///< Not found, or the source table is full
+	DMX_MERGE_PRIORITY_DEFAULT = 100,		///< For the protocols without a priority
+	DMX_MERGE_TIMEOUT_MILLIS = 10000		///< Default source timeout
+};
+
+struct TDmxMergeSource {
+	uint8_t data[DMX_MERGE_LENGTH];	///< The latest data received, zero beyond nLength
+	uint16_t nLength;				///< Length of the latest data received
+	uint16_t nPort;					///< UDP source port
+	uint32_t nIp;					///< IP address
+	uint32_t nMillis;				///< The latest time data was received
+	uint32_t nPrioritiesMillis;		///< The latest time per slot priorities were received
+	uint8_t *pPriorities;			///< Per slot priority, 0 is not used. Allocated with the first \ref SetSourcePriorities
+	uint8_t nPriority;				///< Priority of the latest data received
+	bool IsActive;					///< Is the entry in use ?
+	bool IsMerged;					///< Is the source part of the output ?
+	bool IsPerSlot;					///< Are the per slot priorities used instead of nPriority ?
+};
+
+/**
+ * The sources of one output, merged into one DMX frame.
+ *
+ * A source is identified by its IP address and UDP port. Only the sources with
+ * the highest priority are merged, the others are held until these time out.
+ * Merging only revisits the slots changed by the latest data, so the cost
+ * per packet is the number of merged sources times the number of changed slots.
+ *
+ * A source can send a priority per slot instead, see \ref SetSourcePriorities.
+ * Then the highest priority is selected for each slot. This is only done while
+ * at least one source has per slot priorities, otherwise the cost is unchanged.
+ *
+ * Each call changing the output extends the caller's dirty range with the changed slots.
+ */
+class DmxMerge {
+public:
+	DmxMerge(void);
+	~DmxMerge(void);
+
+	void SetMode(TDmxMergeMode tMode);
+	inline TDmxMergeMode GetMode(void) const {
+		return m_tMode;
+	}
+
+	inline void SetTimeout(uint32_t nMillis) {
+		m_nTimeoutMillis = nMillis;
+	}
+	inline uint32_t GetTimeout(void) const {
+		return m_nTimeoutMillis;
+	}
+
+	inline void SetPriorityTimeout(uint32_t nMillis) {
+		m_nPriorityTimeoutMillis = nMillis;
+	}
+	inline uint32_t GetPriorityTimeout(void) const {
+		return m_nPriorityTimeoutMillis;
+	}
+
+	uint8_t FindSource(uint32_t nIp, uint16_t nPort) const;
+	uint8_t AddSource(uint32_t nIp, uint16_t nPort, uint32_t nMillis);
+	bool RemoveSource(uint8_t nSource, struct TDmxSlotRange *pDirty);
+
+	bool SetSourceData(uint8_t nSource, const uint8_t *pData, uint16_t nLength, uint8_t nPriority, uint32_t nMillis, struct TDmxSlotRange *pDirty);
+	bool SetSourcePriorities(uint8_t nSource, const uint8_t *pPriorities, uint16_t nLength, uint32_t nMillis, struct TDmxSlotRange *pDirty);
+
+	bool CheckTimeouts(uint32_t nMillis, struct TDmxSlotRange *pDirty);
+
+	void Clear(void);
+	void Reset(void);
+
+	inline const uint8_t *GetData(void) const {
+		return m_Data;
+	}
+	inline uint16_t GetLength(void) const {
+		return m_nLength;
+	}
+
+	inline uint8_t GetSources(void) const {
+		return m_nSources;
+	}
+	inline const struct TDmxMergeSource *GetSource(uint8_t nSource) const {
+		return &m_Sources[nSource];
+	}
+
+	inline uint8_t GetPriority(void) const {
+		return m_nPriority;
+	}
+
+	inline bool IsMerging(void) const {
+		return m_nMerged > 1;
+	}
+
+	inline bool IsPerSlot(void) const {
+		return m_nPerSlot != 0;
+	}
+
+private:
+	bool Rebuild(struct TDmxSlotRange *pDirty);
+	bool Update(uint16_t nFirst, uint16_t nLast, struct TDmxSlotRange *pDirty);
+	bool UpdatePerSlot(uint16_t nFirst, uint16_t nLast, struct TDmxSlotRange *pDirty);
+
+private:
+	TDmxMergeMode m_tMode;
+	uint32_t m_nTimeoutMillis;
+	uint32_t m_nPriorityTimeoutMillis;	///< Per slot priorities not received within, fall back to the source priority
+	uint16_t m_nLength;				///< Length of the merged data
+	uint8_t m_nPriority;			///< Priority of the merged sources
+	uint8_t m_nSources;				///< Active sources
+	uint8_t m_nMerged;				///< Active sources with priority m_nPriority
+	uint8_t m_nLtpSource;			///< LTP : the source of the output
+	uint8_t m_nPerSlot;				///< Active sources with per slot priorities
+	bool m_IsModeChanged;			///< SetMode : the next SetSourceData merges all slots
+	uint8_t m_Data[DMX_MERGE_LENGTH];
+	struct TDmxMergeSource m_Sources[DMX_MERGE_MAX_SOURCES];
+};
+
+#endif /* DMXMERGE_H_ */
@@ -46,6 +46,15 @@ public:
 
 	virtual void SetData(uint8_t, const uint8_t *, uint16_t)= 0;
 
+public: // Optional
+	// Same as SetData, only slots nFirstDirty..nLastDirty (0 based, inclusive) have changed since the previous call for this port
+	virtual void SetDataRange(uint8_t nPort, const uint8_t *pData, uint16_t nLength, uint16_t nFirstDirty, uint16_t nLastDirty);
+	// End of a synchronized frame (e.g. ArtSync, E1.31 synchronization) : the data of all ports set since the previous Sync must become visible at once.
+	// Not called for unsynchronized data, each SetData and SetDataRange is then shown on its own
+	virtual void Sync(void);
+	// A single packet with a non-zero start code (e.g. text, SIP, manufacturer specific), pData excludes the start code
+	virtual void SetStartCodeData(uint8_t nPort, uint8_t nStartCode, const uint8_t *pData, uint16_t nLength);
+
 public: // RDM Optional
 	virtual bool SetDmxStartAddress(uint16_t nDmxStartAddress);
 	virtual uint16_t GetDmxStartAddress(void);
@@ -53,6 +62,12 @@ public: // RDM Optional
 	virtual uint16_t GetDmxFootprint(void);
 
 	virtual bool GetSlotInfo(uint16_t nSlotOffset, struct TLightSetSlotInfo &tSlotInfo);
+
+protected:
+	// True when the slots nSlot..nSlot+nCount-1 (0 based) overlap with nFirstDirty..nLastDirty
+	inline static bool IsRangeDirty(uint16_t nFirstDirty, uint16_t nLastDirty, uint16_t nSlot, uint16_t nCount) {
+		return (nCount != 0) && ((uint32_t) nFirstDirty < (uint32_t) nSlot + nCount) && (nLastDirty >= nSlot);
+	}
 };
 
 #endif /* LIGHTSET_H_ */
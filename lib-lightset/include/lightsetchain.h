@@ -46,6 +46,9 @@ public:
 	void Stop(void);
 
 	void SetData(uint8_t, const uint8_t *, uint16_t);
+	void SetDataRange(uint8_t, const uint8_t *, uint16_t, uint16_t, uint16_t);
+	void Sync(void);
+	void SetStartCodeData(uint8_t, uint8_t, const uint8_t *, uint16_t);
 
 public: // RDM
 	bool SetDmxStartAddress(uint16_t nDmxStartAddress);
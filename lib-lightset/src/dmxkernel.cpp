@@ -0,0 +1,290 @@
+/**
+ * @file dmxkernel.cpp
+ *
+ */
+/* Copyright (C) 2018 by Arjan van Vught mailto:info@raspberrypi-dmx.nl
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <stdint.h>
+
+#include "dmxkernel.h"
+
+#if defined (__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_BIG_ENDIAN__)
+ #error "dmxkernel : little endian only"
+#endif
+
+#ifndef MAX
+ #define MAX(a,b)	(((a) > (b)) ? (a) : (b))
+#endif
+
+
+/*
+ * A block is the number of slots handled at once. Each variant provides :
+ *   block_load / block_store	: unaligned access
+ *   block_max					: per slot maximum
+ *   block_diff					: true when the blocks differ, with the first and last differing slot within the block
+ */
+
+#if defined (__SSE2__)
+ #include <emmintrin.h>
+
+ #define VARIANT	"SSE2"
+
+typedef __m128i block_t;
+#define BLOCK_SIZE	16
+
+static inline block_t block_load(const uint8_t *p) {
+	return _mm_loadu_si128((const __m128i *) p);
+}
+
+static inline void block_store(uint8_t *p, const block_t b) {
+	_mm_storeu_si128((__m128i *) p, b);
+}
+
+static inline block_t block_max(const block_t a, const block_t b) {
+	return _mm_max_epu8(a, b);
+}
+
+static inline bool block_diff(const block_t a, const block_t b, unsigned *pFirst, unsigned *pLast) {
+	const unsigned nMask = (unsigned) _mm_movemask_epi8(_mm_cmpeq_epi8(a, b)) ^ 0xFFFF;
+
+	if (__builtin_expect((nMask == 0), 1)) {
+		return false;
+	}
+
+	*pFirst = (unsigned) __builtin_ctz(nMask);
+	*pLast = 31 - (unsigned) __builtin_clz(nMask);
+
+	return true;
+}
+
+#elif defined (__ARM_NEON__) || defined (__ARM_NEON)
+ /* GCC vector extensions, arm_neon.h is not available with -nostdinc */
+ #define VARIANT	"NEON"
+
+typedef uint8_t block_t __attribute__ ((vector_size (16)));
+typedef uint32_t block32_t __attribute__ ((vector_size (16)));
+#define BLOCK_SIZE	16
+
+static inline block_t block_load(const uint8_t *p) {
+	block_t b;
+	__builtin_memcpy(&b, p, sizeof(block_t));
+	return b;
+}
+
+static inline void block_store(uint8_t *p, const block_t b) {
+	__builtin_memcpy(p, &b, sizeof(block_t));
+}
+
+static inline block_t block_max(const block_t a, const block_t b) {
+	return a > b ? a : b;
+}
+
+static inline bool block_diff(const block_t a, const block_t b, unsigned *pFirst, unsigned *pLast) {
+	// 32-bit lanes, so that no 64-bit ctz/clz helpers from libgcc are needed
+	const block32_t x = (block32_t) (a ^ b);
+
+	if (__builtin_expect(((x[0] | x[1] | x[2] | x[3]) == 0), 1)) {
+		return false;
+	}
+
+	unsigned i = 0;
+	while (x[i] == 0) {
+		i++;
+	}
+	*pFirst = (i * 4) + (unsigned) __builtin_ctz(x[i]) / 8;
+
+	i = 3;
+	while (x[i] == 0) {
+		i--;
+	}
+	*pLast = (i * 4) + 3 - (unsigned) __builtin_clz(x[i]) / 8;
+
+	return true;
+}
+
+#else
+ /* Portable, a machine word at a time */
+ #if (__SIZEOF_LONG__ == 8)
+  #define VARIANT	"Word64"
+ #else
+  #define VARIANT	"Word32"
+ #endif
+
+typedef unsigned long block_t;
+#define BLOCK_SIZE	(sizeof(block_t))
+
+static const block_t BLOCK_HIGH_BITS = (~(block_t) 0 / 0xFF) * 0x80;	// 0x8080...80
+
+static inline block_t block_load(const uint8_t *p) {
+	block_t b;
+	__builtin_memcpy(&b, p, sizeof(block_t));
+	return b;
+}
+
+static inline void block_store(uint8_t *p, const block_t b) {
+	__builtin_memcpy(p, &b, sizeof(block_t));
+}
+
+static inline block_t block_max(const block_t a, const block_t b) {
+	// Bit 7 of each byte of t is set when the low 7 bits of a are >= the low 7 bits of b
+	const block_t t = (a | BLOCK_HIGH_BITS) - (b & ~BLOCK_HIGH_BITS);
+	// Bit 7 of each byte is set when a >= b
+	const block_t ge = ((a & ~b) | (~(a ^ b) & t)) & BLOCK_HIGH_BITS;
+	const block_t mask = (ge >> 7) * 0xFF;
+
+	return (a & mask) | (b & ~mask);
+}
+
+static inline bool block_diff(const block_t a, const block_t b, unsigned *pFirst, unsigned *pLast) {
+	const block_t x = a ^ b;
+
+	if (__builtin_expect((x == 0), 1)) {
+		return false;
+	}
+
+	*pFirst = (unsigned) __builtin_ctzl(x) / 8;
+	*pLast = (BLOCK_SIZE - 1) - (unsigned) __builtin_clzl(x) / 8;
+
+	return true;
+}
+
+#endif
+
+static inline bool set_range(const unsigned nFirst, const unsigned nLast, struct TDmxSlotRange *pRange) {
+	if (nFirst == DMX_SLOT_NONE) {
+		return false;
+	}
+
+	if (pRange != 0) {
+		pRange->nFirst = (uint16_t) nFirst;
+		pRange->nLast = (uint16_t) nLast;
+	}
+
+	return true;
+}
+
+bool dmx_kernel_copy_changed(uint8_t *pDst, const uint8_t *pSrc, const uint16_t nLength, struct TDmxSlotRange *pRange) {
+	unsigned nFirst = DMX_SLOT_NONE;
+	unsigned nLast = 0;
+	unsigned i = 0;
+
+	for (; i + BLOCK_SIZE <= nLength; i += BLOCK_SIZE) {
+		const block_t src = block_load(&pSrc[i]);
+		unsigned f, l;
+
+		if (block_diff(src, block_load(&pDst[i]), &f, &l)) {
+			block_store(&pDst[i], src);
+			if (nFirst == DMX_SLOT_NONE) {
+				nFirst = i + f;
+			}
+			nLast = i + l;
+		}
+	}
+
+	for (; i < nLength; i++) {
+		if (pDst[i] != pSrc[i]) {
+			pDst[i] = pSrc[i];
+			if (nFirst == DMX_SLOT_NONE) {
+				nFirst = i;
+			}
+			nLast = i;
+		}
+	}
+
+	return set_range(nFirst, nLast, pRange);
+}
+
+bool dmx_kernel_merge_htp(uint8_t *pDst, const uint8_t *pA, const uint8_t *pB, const uint16_t nLength, struct TDmxSlotRange *pRange) {
+	unsigned nFirst = DMX_SLOT_NONE;
+	unsigned nLast = 0;
+	unsigned i = 0;
+
+	for (; i + BLOCK_SIZE <= nLength; i += BLOCK_SIZE) {
+		const block_t merged = block_max(block_load(&pA[i]), block_load(&pB[i]));
+		unsigned f, l;
+
+		if (block_diff(merged, block_load(&pDst[i]), &f, &l)) {
+			block_store(&pDst[i], merged);
+			if (nFirst == DMX_SLOT_NONE) {
+				nFirst = i + f;
+			}
+			nLast = i + l;
+		}
+	}
+
+	for (; i < nLength; i++) {
+		const uint8_t merged = MAX(pA[i], pB[i]);
+		if (pDst[i] != merged) {
+			pDst[i] = merged;
+			if (nFirst == DMX_SLOT_NONE) {
+				nFirst = i;
+			}
+			nLast = i;
+		}
+	}
+
+	return set_range(nFirst, nLast, pRange);
+}
+
+void dmx_kernel_copy_ltp(uint8_t *pDst, const uint8_t *pSrc, const uint16_t nLength) {
+	unsigned i = 0;
+
+	for (; i + BLOCK_SIZE <= nLength; i += BLOCK_SIZE) {
+		block_store(&pDst[i], block_load(&pSrc[i]));
+	}
+
+	for (; i < nLength; i++) {
+		pDst[i] = pSrc[i];
+	}
+}
+
+bool dmx_kernel_dirty_range(const uint8_t *pA, const uint8_t *pB, const uint16_t nLength, struct TDmxSlotRange *pRange) {
+	unsigned nFirst = DMX_SLOT_NONE;
+	unsigned nLast = 0;
+	unsigned i = 0;
+
+	for (; i + BLOCK_SIZE <= nLength; i += BLOCK_SIZE) {
+		unsigned f, l;
+
+		if (block_diff(block_load(&pA[i]), block_load(&pB[i]), &f, &l)) {
+			if (nFirst == DMX_SLOT_NONE) {
+				nFirst = i + f;
+			}
+			nLast = i + l;
+		}
+	}
+
+	for (; i < nLength; i++) {
+		if (pA[i] != pB[i]) {
+			if (nFirst == DMX_SLOT_NONE) {
+				nFirst = i;
+			}
+			nLast = i;
+		}
+	}
+
+	return set_range(nFirst, nLast, pRange);
+}
+
+const char *dmx_kernel_get_variant(void) {
+	return VARIANT;
+}
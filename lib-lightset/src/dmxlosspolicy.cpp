@@ -0,0 +1,207 @@
+/**
+ * @file dmxlosspolicy.cpp
+ *
+ */
+/* Copyright (C) 2018 by Arjan van Vught mailto:info@raspberrypi-dmx.nl
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <stdint.h>
+#include <assert.h>
+
+#include "dmxlosspolicy.h"
+#include "dmxkernel.h"
+#include "lightset.h"
+
+/*
+ * The faded look of a port. Not re-entrant, all ports are handled from the same context.
+ */
+static uint8_t s_Faded[DMX_LOSS_POLICY_LENGTH] __attribute__((aligned(4)));
+
+DmxLossPolicy::DmxLossPolicy(void) :
+	m_tPolicy(DMX_LOSS_POLICY_BLACKOUT),
+	m_nTimeoutMillis(DMX_LOSS_POLICY_TIMEOUT_MILLIS),
+	m_nFadeMillis(DMX_LOSS_POLICY_FADE_MILLIS),
+	m_nReceivedMillis(0),
+	m_nLossMillis(0),
+	m_nLevel(0),
+	m_IsReceiving(false),
+	m_IsFading(false)
+{
+	for (unsigned i = 0; i < DMX_LOSS_POLICY_MAX_PORTS; i++) {
+		m_pLooks[i] = 0;
+		m_nLookLength[i] = 0;
+		m_pPresets[i] = 0;
+		m_nPresetLength[i] = 0;
+	}
+}
+
+DmxLossPolicy::~DmxLossPolicy(void) {
+	for (unsigned i = 0; i < DMX_LOSS_POLICY_MAX_PORTS; i++) {
+		delete[] m_pLooks[i];
+		m_pLooks[i] = 0;
+		delete[] m_pPresets[i];
+		m_pPresets[i] = 0;
+	}
+}
+
+/**
+ * Store the scene output by \ref DMX_LOSS_POLICY_PRESET for \a nPort.
+ * A length of 0 removes the preset.
+ */
+bool DmxLossPolicy::SetPreset(uint8_t nPort, const uint8_t *pData, uint16_t nLength) {
+	if (nPort >= DMX_LOSS_POLICY_MAX_PORTS) {
+		return false;
+	}
+
+	if (nLength == 0) {
+		ClearPreset(nPort);
+		return true;
+	}
+
+	assert(pData != 0);
+
+	if (nLength > DMX_LOSS_POLICY_LENGTH) {
+		nLength = DMX_LOSS_POLICY_LENGTH;
+	}
+
+	if (m_pPresets[nPort] == 0) {
+		m_pPresets[nPort] = new uint8_t[DMX_LOSS_POLICY_LENGTH];
+		assert(m_pPresets[nPort] != 0);
+	}
+
+	dmx_kernel_copy_ltp(m_pPresets[nPort], pData, nLength);
+	m_nPresetLength[nPort] = nLength;
+
+	return true;
+}
+
+void DmxLossPolicy::ClearPreset(uint8_t nPort) {
+	if (nPort < DMX_LOSS_POLICY_MAX_PORTS) {
+		m_nPresetLength[nPort] = 0;
+	}
+}
+
+/**
+ * The look of \a nPort when the loss begins. Only stored for a fade, the other policies don't need it.
+ */
+void DmxLossPolicy::SetLook(uint8_t nPort, const uint8_t *pData, uint16_t nLength) {
+	if ((m_tPolicy != DMX_LOSS_POLICY_FADE) || (nPort >= DMX_LOSS_POLICY_MAX_PORTS)) {
+		return;
+	}
+
+	if (nLength > DMX_LOSS_POLICY_LENGTH) {
+		nLength = DMX_LOSS_POLICY_LENGTH;
+	}
+
+	if ((nLength != 0) && (m_pLooks[nPort] == 0)) {
+		m_pLooks[nPort] = new uint8_t[DMX_LOSS_POLICY_LENGTH];
+		assert(m_pLooks[nPort] != 0);
+	}
+
+	if (nLength != 0) {
+		dmx_kernel_copy_ltp(m_pLooks[nPort], pData, nLength);
+	}
+
+	m_nLookLength[nPort] = nLength;
+}
+
+/**
+ * The loss begins : hold, start the fade, or output the presets.
+ * The node has stopped the LightSet already for \ref DMX_LOSS_POLICY_BLACKOUT.
+ */
+void DmxLossPolicy::Begin(LightSet *pLightSet, uint32_t nMillis) {
+	m_IsReceiving = false;
+	m_IsFading = false;
+	m_nLossMillis = nMillis;
+
+	if (pLightSet == 0) {
+		return;
+	}
+
+	if (m_tPolicy == DMX_LOSS_POLICY_FADE) {
+		m_nLevel = 256;
+		m_IsFading = true;
+		Fade(pLightSet, nMillis);
+	} else if (m_tPolicy == DMX_LOSS_POLICY_PRESET) {
+		bool IsOutput = false;
+
+		for (unsigned i = 0; i < DMX_LOSS_POLICY_MAX_PORTS; i++) {
+			if (m_nPresetLength[i] != 0) {
+				pLightSet->SetData((uint8_t) i, m_pPresets[i], m_nPresetLength[i]);
+				IsOutput = true;
+			}
+		}
+
+		if (IsOutput) {
+			pLightSet->Sync();
+		}
+	}
+}
+
+/**
+ * The level goes linearly from 256 down to 0 over the fade time.
+ * A port is only output when its level has changed, so at most 256 times.
+ */
+void DmxLossPolicy::Fade(LightSet *pLightSet, uint32_t nMillis) {
+	const uint32_t nElapsed = nMillis - m_nLossMillis;
+	uint16_t nLevel = 0;
+
+	if (nElapsed < m_nFadeMillis) {
+		nLevel = (uint16_t) (((m_nFadeMillis - nElapsed) * 256) / m_nFadeMillis);
+	}
+
+	if (nLevel == m_nLevel) {
+		return;
+	}
+
+	m_nLevel = nLevel;
+
+	Output(pLightSet, nLevel);
+
+	if (nLevel == 0) {
+		m_IsFading = false;
+	}
+}
+
+void DmxLossPolicy::Output(LightSet *pLightSet, uint16_t nLevel) {
+	bool IsOutput = false;
+
+	for (unsigned i = 0; i < DMX_LOSS_POLICY_MAX_PORTS; i++) {
+		const uint16_t nLength = m_nLookLength[i];
+
+		if (nLength == 0) {
+			continue;
+		}
+
+		const uint8_t *pLook = m_pLooks[i];
+
+		for (unsigned j = 0; j < nLength; j++) {
+			s_Faded[j] = (uint8_t) (((unsigned) pLook[j] * nLevel) >> 8);
+		}
+
+		pLightSet->SetData((uint8_t) i, s_Faded, nLength);
+		IsOutput = true;
+	}
+
+	if (IsOutput) {
+		pLightSet->Sync();
+	}
+}
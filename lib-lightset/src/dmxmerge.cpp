@@ -0,0 +1,573 @@
+/**
+ * @file dmxmerge.cpp
+ *
+ */
+/* Copyright (C) 2018 by Arjan van Vught mailto:info@raspberrypi-dmx.nl
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <stdint.h>
+#include <assert.h>
+
+#include "dmxmerge.h"
+#include "dmxkernel.h"
+
+/*
+ * HTP of more than two sources : the sources are merged pairwise into this buffer first.
+ * The merge is not re-entrant, all ports are handled from the same context.
+ */
+static uint8_t s_Merged[DMX_MERGE_LENGTH] __attribute__((aligned(4)));
+static const uint8_t s_Zero[DMX_MERGE_LENGTH] = { 0 };
+
+static void clear_data(uint8_t *pData, uint16_t nFirst, uint16_t nLast) {
+	for (unsigned i = nFirst; i <= nLast; i++) {
+		pData[i] = 0;
+	}
+}
+
+DmxMerge::DmxMerge(void) :
+	m_tMode(DMX_MERGE_HTP),
+	m_nTimeoutMillis(DMX_MERGE_TIMEOUT_MILLIS),
+	m_nPriorityTimeoutMillis(DMX_MERGE_TIMEOUT_MILLIS),
+	m_nLength(0),
+	m_nPriority(0),
+	m_nSources(0),
+	m_nMerged(0),
+	m_nLtpSource(DMX_MERGE_SOURCE_NONE),
+	m_nPerSlot(0),
+	m_IsModeChanged(false)
+{
+	clear_data(m_Data, 0, DMX_MERGE_LENGTH - 1);
+
+	for (unsigned i = 0; i < DMX_MERGE_MAX_SOURCES; i++) {
+		m_Sources[i].pPriorities = 0;
+		m_Sources[i].IsActive = false;
+		m_Sources[i].IsMerged = false;
+		m_Sources[i].IsPerSlot = false;
+	}
+}
+
+DmxMerge::~DmxMerge(void) {
+	for (unsigned i = 0; i < DMX_MERGE_MAX_SOURCES; i++) {
+		delete[] m_Sources[i].pPriorities;
+		m_Sources[i].pPriorities = 0;
+	}
+}
+
+/**
+ * Takes effect with the next data received, also when that data has not changed.
+ */
+void DmxMerge::SetMode(TDmxMergeMode tMode) {
+	if (tMode != m_tMode) {
+		m_tMode = tMode;
+		m_IsModeChanged = true;
+	}
+}
+
+uint8_t DmxMerge::FindSource(uint32_t nIp, uint16_t nPort) const {
+	for (unsigned i = 0; i < DMX_MERGE_MAX_SOURCES; i++) {
+		const struct TDmxMergeSource *pSource = &m_Sources[i];
+
+		if (pSource->IsActive && (pSource->nIp == nIp) && (pSource->nPort == nPort)) {
+			return (uint8_t) i;
+		}
+	}
+
+	return DMX_MERGE_SOURCE_NONE;
+}
+
+/**
+ * A new source does not change the output until its first \ref SetSourceData.
+ * Returns DMX_MERGE_SOURCE_NONE when the source table is full.
+ */
+uint8_t DmxMerge::AddSource(uint32_t nIp, uint16_t nPort, uint32_t nMillis) {
+	for (unsigned i = 0; i < DMX_MERGE_MAX_SOURCES; i++) {
+		struct TDmxMergeSource *pSource = &m_Sources[i];
+
+		if (pSource->IsActive) {
+			continue;
+		}
+
+		clear_data(pSource->data, 0, DMX_MERGE_LENGTH - 1);
+		pSource->nLength = 0;
+		pSource->nPort = nPort;
+		pSource->nIp = nIp;
+		pSource->nMillis = nMillis;
+		pSource->nPriority = 0;
+		pSource->IsActive = true;
+		pSource->IsMerged = false;
+		pSource->IsPerSlot = false;
+
+		m_nSources++;
+
+		return (uint8_t) i;
+	}
+
+	return DMX_MERGE_SOURCE_NONE;
+}
+
+/**
+ * The output holds its data when the last source is removed.
+ */
+bool DmxMerge::RemoveSource(uint8_t nSource, struct TDmxSlotRange *pDirty) {
+	assert(nSource < DMX_MERGE_MAX_SOURCES);
+
+	struct TDmxMergeSource *pSource = &m_Sources[nSource];
+
+	if (!pSource->IsActive) {
+		return false;
+	}
+
+	pSource->IsActive = false;
+	m_nSources--;
+
+	if (pSource->IsPerSlot) {
+		pSource->IsPerSlot = false;
+		m_nPerSlot--;
+	} else if (!pSource->IsMerged) {
+		return false;
+	}
+
+	pSource->IsMerged = false;
+
+	return Rebuild(pDirty);
+}
+
+/**
+ * Store the data of \a nSource and update the output with the slots that have changed.
+ * Returns true when the output has changed.
+ */
+bool DmxMerge::SetSourceData(uint8_t nSource, const uint8_t *pData, uint16_t nLength, uint8_t nPriority, uint32_t nMillis, struct TDmxSlotRange *pDirty) {
+	assert(nSource < DMX_MERGE_MAX_SOURCES);
+	assert(nLength <= DMX_MERGE_LENGTH);
+
+	struct TDmxMergeSource *pSource = &m_Sources[nSource];
+	struct TDmxSlotRange tChanged;
+	struct TDmxSlotRange tRange;
+
+	assert(pSource->IsActive);
+
+	const bool IsPriorityChanged = (nPriority != pSource->nPriority);
+
+	pSource->nMillis = nMillis;
+	pSource->nPriority = nPriority;
+
+	dmx_slot_range_clear(&tChanged);
+
+	if (dmx_kernel_copy_changed(pSource->data, pData, nLength, &tRange)) {
+		dmx_slot_range_add(&tChanged, tRange.nFirst, tRange.nLast);
+	}
+
+	if (nLength < pSource->nLength) {
+		// Keep the slots beyond the length at zero for HTP
+		clear_data(pSource->data, nLength, pSource->nLength - 1);
+		dmx_slot_range_add(&tChanged, nLength, pSource->nLength - 1);
+	}
+
+	const bool IsLengthChanged = (nLength != pSource->nLength);
+	pSource->nLength = nLength;
+
+	if (__builtin_expect(m_IsModeChanged, 0)) {
+		// All slots are merged again, for LTP starting with this source
+		m_IsModeChanged = false;
+		m_nLtpSource = nSource;
+		return Rebuild(pDirty);
+	}
+
+	if (m_nPerSlot != 0) {
+		if (IsPriorityChanged || IsLengthChanged || (m_tMode == DMX_MERGE_LTP)) {
+			// The priority of each slot, the slots used of this source, or the latest source can have changed
+			return Update(0, DMX_MERGE_LENGTH - 1, pDirty);
+		}
+		if (tChanged.nFirst == DMX_SLOT_NONE) {
+			return false;
+		}
+		return Update(tChanged.nFirst, tChanged.nLast, pDirty);
+	}
+
+	uint8_t nTop = 0;
+
+	for (unsigned i = 0; i < DMX_MERGE_MAX_SOURCES; i++) {
+		if (m_Sources[i].IsActive && (m_Sources[i].nPriority > nTop)) {
+			nTop = m_Sources[i].nPriority;
+		}
+	}
+
+	const bool IsMerged = (nPriority == nTop);
+
+	if ((nTop != m_nPriority) || (IsMerged != pSource->IsMerged)) {
+		// The set of merged sources has changed
+		if (IsMerged) {
+			m_nLtpSource = nSource;
+		}
+		return Rebuild(pDirty);
+	}
+
+	if (!IsMerged) {
+		return false;	// Held until the sources with a higher priority time out
+	}
+
+	if ((m_tMode == DMX_MERGE_LTP) && (m_nLtpSource != nSource)) {
+		// The output switches to this source
+		m_nLtpSource = nSource;
+		return Update(0, DMX_MERGE_LENGTH - 1, pDirty);
+	}
+
+	if (tChanged.nFirst == DMX_SLOT_NONE) {
+		if (!IsLengthChanged) {
+			return false;
+		}
+		tChanged.nFirst = 0;
+		tChanged.nLast = 0;
+	}
+
+	return Update(tChanged.nFirst, tChanged.nLast, pDirty);
+}
+
+/**
+ * Store the per slot priorities of \a nSource, these replace its priority of \ref SetSourceData.
+ * Priority 0 means that the source is not used for that slot. The slots beyond
+ * \a nLength have priority 0. Without new priorities within the priority timeout
+ * the source priority is used again.
+ * Returns true when the output has changed.
+ */
+bool DmxMerge::SetSourcePriorities(uint8_t nSource, const uint8_t *pPriorities, uint16_t nLength, uint32_t nMillis, struct TDmxSlotRange *pDirty) {
+	assert(nSource < DMX_MERGE_MAX_SOURCES);
+	assert(nLength <= DMX_MERGE_LENGTH);
+
+	struct TDmxMergeSource *pSource = &m_Sources[nSource];
+	struct TDmxSlotRange tChanged;
+	struct TDmxSlotRange tRange;
+
+	assert(pSource->IsActive);
+
+	if (pSource->pPriorities == 0) {
+		// Kept with the entry, only the sources sending per slot priorities pay for these
+		pSource->pPriorities = new uint8_t[DMX_MERGE_LENGTH];
+		assert(pSource->pPriorities != 0);
+		clear_data(pSource->pPriorities, 0, DMX_MERGE_LENGTH - 1);
+	}
+
+	pSource->nPrioritiesMillis = nMillis;
+
+	if (!pSource->IsPerSlot) {
+		(void) dmx_kernel_copy_changed(pSource->pPriorities, pPriorities, nLength, 0);
+		clear_data(pSource->pPriorities, nLength, DMX_MERGE_LENGTH - 1);
+
+		pSource->IsPerSlot = true;
+		m_nPerSlot++;
+
+		return Update(0, DMX_MERGE_LENGTH - 1, pDirty);
+	}
+
+	dmx_slot_range_clear(&tChanged);
+
+	if (dmx_kernel_copy_changed(pSource->pPriorities, pPriorities, nLength, &tRange)) {
+		dmx_slot_range_add(&tChanged, tRange.nFirst, tRange.nLast);
+	}
+
+	if ((nLength < DMX_MERGE_LENGTH) && dmx_kernel_copy_changed(&pSource->pPriorities[nLength], s_Zero, DMX_MERGE_LENGTH - nLength, &tRange)) {
+		dmx_slot_range_add(&tChanged, nLength + tRange.nFirst, nLength + tRange.nLast);
+	}
+
+	if (tChanged.nFirst == DMX_SLOT_NONE) {
+		return false;
+	}
+
+	return Update(tChanged.nFirst, tChanged.nLast, pDirty);
+}
+
+/**
+ * Remove the sources from which no data has been received within the timeout.
+ * The sources without per slot priorities within the priority timeout fall back to their source priority.
+ */
+bool DmxMerge::CheckTimeouts(uint32_t nMillis, struct TDmxSlotRange *pDirty) {
+	bool IsRebuild = false;
+
+	for (unsigned i = 0; i < DMX_MERGE_MAX_SOURCES; i++) {
+		struct TDmxMergeSource *pSource = &m_Sources[i];
+
+		if (!pSource->IsActive) {
+			continue;
+		}
+
+		if ((nMillis - pSource->nMillis) > m_nTimeoutMillis) {
+			pSource->IsActive = false;
+			m_nSources--;
+
+			if (pSource->IsMerged) {
+				IsRebuild = true;
+			}
+
+			pSource->IsMerged = false;
+		}
+
+		if (pSource->IsPerSlot && (!pSource->IsActive || ((nMillis - pSource->nPrioritiesMillis) > m_nPriorityTimeoutMillis))) {
+			pSource->IsPerSlot = false;
+			m_nPerSlot--;
+			IsRebuild = true;
+		}
+	}
+
+	if (IsRebuild) {
+		return Rebuild(pDirty);
+	}
+
+	return false;
+}
+
+/**
+ * Remove all sources and set all slots to zero. The length is kept.
+ */
+void DmxMerge::Clear(void) {
+	const uint16_t nLength = m_nLength;
+
+	clear_data(m_Data, 0, DMX_MERGE_LENGTH - 1);
+	Reset();
+
+	m_nLength = nLength;
+}
+
+/**
+ * Remove all sources. The next data received updates all slots.
+ */
+void DmxMerge::Reset(void) {
+	for (unsigned i = 0; i < DMX_MERGE_MAX_SOURCES; i++) {
+		m_Sources[i].IsActive = false;
+		m_Sources[i].IsMerged = false;
+		m_Sources[i].IsPerSlot = false;
+	}
+
+	m_nLength = 0;
+	m_nPriority = 0;
+	m_nSources = 0;
+	m_nMerged = 0;
+	m_nLtpSource = DMX_MERGE_SOURCE_NONE;
+	m_nPerSlot = 0;
+}
+
+/**
+ * Select the merged sources and update all slots.
+ */
+bool DmxMerge::Rebuild(struct TDmxSlotRange *pDirty) {
+	uint8_t nTop = 0;
+
+	for (unsigned i = 0; i < DMX_MERGE_MAX_SOURCES; i++) {
+		if (m_Sources[i].IsActive && (m_Sources[i].nPriority > nTop)) {
+			nTop = m_Sources[i].nPriority;
+		}
+	}
+
+	m_nPriority = nTop;
+	m_nMerged = 0;
+
+	for (unsigned i = 0; i < DMX_MERGE_MAX_SOURCES; i++) {
+		struct TDmxMergeSource *pSource = &m_Sources[i];
+
+		pSource->IsMerged = pSource->IsActive && (pSource->nPriority == nTop);
+
+		if (pSource->IsMerged) {
+			m_nMerged++;
+		}
+	}
+
+	if ((m_nLtpSource == DMX_MERGE_SOURCE_NONE) || !m_Sources[m_nLtpSource].IsMerged) {
+		// LTP : continue with the merged source received most recently
+		m_nLtpSource = DMX_MERGE_SOURCE_NONE;
+
+		for (unsigned i = 0; i < DMX_MERGE_MAX_SOURCES; i++) {
+			if (!m_Sources[i].IsMerged) {
+				continue;
+			}
+			if ((m_nLtpSource == DMX_MERGE_SOURCE_NONE) || ((int32_t) (m_Sources[i].nMillis - m_Sources[m_nLtpSource].nMillis) > 0)) {
+				m_nLtpSource = (uint8_t) i;
+			}
+		}
+	}
+
+	return Update(0, DMX_MERGE_LENGTH - 1, pDirty);
+}
+
+/**
+ * Merge the slots nFirst..nLast of the merged sources into the output.
+ * A length change updates all slots.
+ */
+bool DmxMerge::Update(uint16_t nFirst, uint16_t nLast, struct TDmxSlotRange *pDirty) {
+	if (__builtin_expect((m_nPerSlot != 0), 0)) {
+		return UpdatePerSlot(nFirst, nLast, pDirty);
+	}
+
+	const uint8_t *pMerged[DMX_MERGE_MAX_SOURCES];
+	unsigned nMerged = 0;
+	uint16_t nLength = 0;
+
+	if ((m_tMode == DMX_MERGE_LTP) && (m_nLtpSource != DMX_MERGE_SOURCE_NONE)) {
+		pMerged[nMerged++] = m_Sources[m_nLtpSource].data;
+		nLength = m_Sources[m_nLtpSource].nLength;
+	} else {
+		for (unsigned i = 0; i < DMX_MERGE_MAX_SOURCES; i++) {
+			if (m_Sources[i].IsMerged) {
+				pMerged[nMerged++] = m_Sources[i].data;
+				if (m_Sources[i].nLength > nLength) {
+					nLength = m_Sources[i].nLength;
+				}
+			}
+		}
+	}
+
+	if (nMerged == 0) {
+		return false;	// Hold the output
+	}
+
+	bool IsChanged = false;
+
+	if (nLength != m_nLength) {
+		m_nLength = nLength;
+		dmx_slot_range_add(pDirty, 0, nLength != 0 ? nLength - 1 : 0);
+		nFirst = 0;
+		nLast = DMX_MERGE_LENGTH - 1;
+		IsChanged = true;
+	}
+
+	if (nLength == 0) {
+		return IsChanged;
+	}
+
+	if (nLast >= nLength) {
+		nLast = nLength - 1;
+	}
+
+	if (nFirst > nLast) {
+		return IsChanged;
+	}
+
+	uint8_t *pDst = &m_Data[nFirst];
+	const uint16_t nSlots = nLast - nFirst + 1;
+	struct TDmxSlotRange tRange;
+
+	bool IsSlotChanged;
+
+	if (nMerged == 1) {
+		IsSlotChanged = dmx_kernel_copy_changed(pDst, pMerged[0] + nFirst, nSlots, &tRange);
+	} else {
+		const uint8_t *pA = pMerged[0] + nFirst;
+
+		for (unsigned i = 1; i < nMerged - 1; i++) {
+			dmx_kernel_merge_htp(&s_Merged[nFirst], pA, pMerged[i] + nFirst, nSlots, 0);
+			pA = &s_Merged[nFirst];
+		}
+
+		IsSlotChanged = dmx_kernel_merge_htp(pDst, pA, pMerged[nMerged - 1] + nFirst, nSlots, &tRange);
+	}
+
+	if (IsSlotChanged) {
+		dmx_slot_range_add(pDirty, nFirst + tRange.nFirst, nFirst + tRange.nLast);
+		IsChanged = true;
+	}
+
+	return IsChanged;
+}
+
+/**
+ * \ref Update with per slot priorities : for each slot the sources with the highest priority
+ * for that slot are merged. A source is only used for the slots within its length.
+ */
+bool DmxMerge::UpdatePerSlot(uint16_t nFirst, uint16_t nLast, struct TDmxSlotRange *pDirty) {
+	const struct TDmxMergeSource *pActive[DMX_MERGE_MAX_SOURCES];
+	unsigned nActive = 0;
+	uint16_t nLength = 0;
+
+	for (unsigned i = 0; i < DMX_MERGE_MAX_SOURCES; i++) {
+		if (m_Sources[i].IsActive) {
+			pActive[nActive++] = &m_Sources[i];
+			if (m_Sources[i].nLength > nLength) {
+				nLength = m_Sources[i].nLength;
+			}
+		}
+	}
+
+	if (nActive == 0) {
+		return false;	// Hold the output
+	}
+
+	bool IsChanged = false;
+
+	if (nLength != m_nLength) {
+		m_nLength = nLength;
+		dmx_slot_range_add(pDirty, 0, nLength != 0 ? nLength - 1 : 0);
+		nFirst = 0;
+		nLast = DMX_MERGE_LENGTH - 1;
+		IsChanged = true;
+	}
+
+	if (nLength == 0) {
+		return IsChanged;
+	}
+
+	if (nLast >= nLength) {
+		nLast = nLength - 1;
+	}
+
+	for (unsigned nSlot = nFirst; nSlot <= nLast; nSlot++) {
+		const struct TDmxMergeSource *pTop = 0;
+		uint8_t nTop = 0;
+		uint8_t nValue = 0;
+
+		for (unsigned i = 0; i < nActive; i++) {
+			const struct TDmxMergeSource *pSource = pActive[i];
+
+			if (nSlot >= pSource->nLength) {
+				continue;
+			}
+
+			uint8_t nPriority = pSource->nPriority;
+
+			if (pSource->IsPerSlot) {
+				nPriority = pSource->pPriorities[nSlot];
+				if (nPriority == 0) {
+					continue;
+				}
+			}
+
+			if ((pTop == 0) || (nPriority > nTop)) {
+				pTop = pSource;
+				nTop = nPriority;
+				nValue = pSource->data[nSlot];
+			} else if (nPriority == nTop) {
+				if (m_tMode == DMX_MERGE_HTP) {
+					if (pSource->data[nSlot] > nValue) {
+						nValue = pSource->data[nSlot];
+					}
+				} else if ((int32_t) (pSource->nMillis - pTop->nMillis) > 0) {
+					pTop = pSource;
+					nValue = pSource->data[nSlot];
+				}
+			}
+		}
+
+		if (m_Data[nSlot] != nValue) {
+			m_Data[nSlot] = nValue;
+			dmx_slot_range_add(pDirty, (uint16_t) nSlot, (uint16_t) nSlot);
+			IsChanged = true;
+		}
+	}
+
+	return IsChanged;
+}
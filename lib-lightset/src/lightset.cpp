@@ -31,6 +31,18 @@ LightSet::~LightSet(void) {
 
 }
 
+void LightSet::SetDataRange(uint8_t nPort, const uint8_t *pData, uint16_t nLength, uint16_t nFirstDirty, uint16_t nLastDirty) {
+	SetData(nPort, pData, nLength);
+}
+
+void LightSet::Sync(void) {
+
+}
+
+void LightSet::SetStartCodeData(uint8_t nPort, uint8_t nStartCode, const uint8_t *pData, uint16_t nLength) {
+
+}
+
 uint16_t LightSet::GetDmxStartAddress(void) {
 	return 1;
 }
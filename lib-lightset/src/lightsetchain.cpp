@@ -74,6 +74,28 @@ void LightSetChain::SetData(uint8_t nPort, const uint8_t *pData, uint16_t nSize)
 	}
 }
 
+void LightSetChain::SetDataRange(uint8_t nPort, const uint8_t *pData, uint16_t nSize, uint16_t nFirstDirty, uint16_t nLastDirty) {
+	assert(pData != 0);
+
+	for (unsigned i = 0; i < m_nSize; i++) {
+		m_pTable[i].pLightSet->SetDataRange(nPort, pData, nSize, nFirstDirty, nLastDirty);
+	}
+}
+
+void LightSetChain::Sync(void) {
+	for (unsigned i = 0; i < m_nSize; i++) {
+		m_pTable[i].pLightSet->Sync();
+	}
+}
+
+void LightSetChain::SetStartCodeData(uint8_t nPort, uint8_t nStartCode, const uint8_t *pData, uint16_t nSize) {
+	assert(pData != 0);
+
+	for (unsigned i = 0; i < m_nSize; i++) {
+		m_pTable[i].pLightSet->SetStartCodeData(nPort, nStartCode, pData, nSize);
+	}
+}
+
 bool LightSetChain::SetDmxStartAddress(uint16_t nDmxStartAddress) {
 	DEBUG1_ENTRY
 
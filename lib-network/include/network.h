@@ -37,6 +37,8 @@
 #define NETWORK_IP_SIZE		4
 #define NETWORK_MAC_SIZE	6
 
+#define NETWORK_MAX_SOCKETS	4	///< Including the socket of network_begin, which is handle 0
+
 #ifndef IP2STR
 #define IP2STR(addr) (uint8_t)(addr & 0xFF), (uint8_t)((addr >> 8) & 0xFF), (uint8_t)((addr >> 16) & 0xFF), (uint8_t)((addr >> 24) & 0xFF)
 #define IPSTR "%d.%d.%d.%d"
@@ -52,6 +54,17 @@
 #define MACSTR "%.2x:%.2x:%.2x:%.2x:%.2x:%.2x"
 #endif
 
+/**
+ * One entry of a \ref network_recvmmsg batch.
+ */
+struct TNetworkDatagram {
+	uint8_t *pData;			///< Receive buffer, set by the caller
+	uint16_t nSize;			///< Size of the receive buffer, set by the caller
+	uint16_t nLength;		///< Bytes received
+	uint32_t nFromIp;		///< Source IP address
+	uint16_t nFromPort;		///< Source UDP port
+};
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -65,8 +78,14 @@ extern bool network_is_dhcp_used(void);
 
 extern void network_begin(const uint16_t);
 extern uint16_t network_recvfrom(const uint8_t *, const uint16_t, uint32_t *, uint16_t *);
+extern uint16_t network_recvmmsg(struct TNetworkDatagram *, const uint16_t, const uint32_t);
 extern void network_sendto(const uint8_t *, const uint16_t, const uint32_t, const uint16_t);
 extern void network_joingroup(const uint32_t);
+extern void network_leavegroup(const uint32_t);
+
+extern int32_t network_udp_begin(const uint16_t);
+extern uint16_t network_udp_recvfrom(const int32_t, const uint8_t *, const uint16_t, uint32_t *, uint16_t *);
+extern uint32_t network_udp_wait(const int32_t *, const uint16_t, const uint32_t);
 
 extern void network_set_ip(const uint32_t);
 
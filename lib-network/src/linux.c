@@ -23,6 +23,9 @@
  * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
  * THE SOFTWARE.
  */
+#if defined(__linux__)
+ #define _GNU_SOURCE	// recvmmsg
+#endif
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -36,6 +39,7 @@
 #include <unistd.h>
 #include <sys/ioctl.h>
 #include <sys/socket.h>
+#include <poll.h>
 #include <limits.h>
 #include <errno.h>
 
@@ -51,6 +55,10 @@ static uint32_t _broadcast_ip;
 static bool _is_dhcp_used;
 
 static int _socket = -1;
+static uint16_t _port;
+
+static int _udp_sockets[NETWORK_MAX_SOCKETS] = { -1, -1, -1, -1 };	///< Index 0 is not used, that is _socket
+static uint16_t _udp_ports[NETWORK_MAX_SOCKETS];
 
 #if defined(__linux__)
 static bool is_dhclient(const char *if_name) {
@@ -229,6 +237,74 @@ void network_begin(const uint16_t port) {
 		perror("bind");
 		exit(EXIT_FAILURE);
 	}
+
+	_port = port;
+}
+
+static int udp_socket(const uint16_t port) {
+	struct sockaddr_in si_me;
+	int true_flag = true;
+	int fd;
+
+	if ((fd = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP)) == -1) {
+		perror("socket");
+		return -1;
+	}
+
+	if (setsockopt(fd, SOL_SOCKET, SO_BROADCAST, (char*) &true_flag, sizeof(int)) == -1) {
+		perror("setsockopt(SO_BROADCAST)");
+		close(fd);
+		return -1;
+	}
+
+	memset((char *) &si_me, 0, sizeof(si_me));
+
+	si_me.sin_family = AF_INET;
+	si_me.sin_port = htons(port);
+	si_me.sin_addr.s_addr = htonl(INADDR_ANY);
+
+	if (bind(fd, (struct sockaddr*) &si_me, sizeof(si_me)) == -1) {
+		perror("bind");
+		close(fd);
+		return -1;
+	}
+
+	return fd;
+}
+
+/**
+ * A socket receiving on \a port, next to the one of network_begin. Sending is always done with the latter.
+ * Returns the handle for network_udp_recvfrom, 0 when \a port is the port of network_begin, -1 on failure.
+ */
+int32_t network_udp_begin(const uint16_t port) {
+	int32_t i;
+
+	if ((_socket != -1) && (port == _port)) {
+		return 0;
+	}
+
+	for (i = 1; i < NETWORK_MAX_SOCKETS; i++) {
+		if ((_udp_sockets[i] != -1) && (_udp_ports[i] == port)) {
+			return i;
+		}
+	}
+
+	for (i = 1; i < NETWORK_MAX_SOCKETS; i++) {
+		if (_udp_sockets[i] == -1) {
+			const int fd = udp_socket(port);
+
+			if (fd == -1) {
+				return -1;
+			}
+
+			_udp_sockets[i] = fd;
+			_udp_ports[i] = port;
+
+			return i;
+		}
+	}
+
+	return -1;
 }
 
 const bool network_get_macaddr(/*@out@*/const uint8_t *macaddr) {
@@ -287,6 +363,149 @@ uint16_t network_recvfrom(const uint8_t *packet, const uint16_t size, uint32_t *
 	return recv_len;
 }
 
+/**
+ * Does not wait, returns 0 when no datagram is pending on the socket of \a handle.
+ */
+uint16_t network_udp_recvfrom(const int32_t handle, const uint8_t *packet, const uint16_t size, uint32_t *from_ip, uint16_t *from_port) {
+	assert((handle >= 0) && (handle < NETWORK_MAX_SOCKETS));
+	assert(packet != NULL);
+
+	const int fd = (handle == 0) ? _socket : _udp_sockets[handle];
+	struct sockaddr_in si_other;
+	socklen_t slen = sizeof(si_other);
+	int recv_len;
+
+	if ((recv_len = recvfrom(fd, (void *)packet, size, MSG_DONTWAIT, (struct sockaddr *) &si_other, &slen)) == -1) {
+		if ((errno != EAGAIN) && (errno != EWOULDBLOCK)) {
+			perror("recvfrom");
+		}
+		return 0;
+	}
+
+	*from_ip = si_other.sin_addr.s_addr;
+	*from_port = ntohs(si_other.sin_port);
+
+	return recv_len;
+}
+
+/**
+ * Waits at most \a timeout_millis for a datagram on any of the \a count sockets of \a handles, 0 = do not wait.
+ * Returns a bit per entry of \a handles with a datagram pending, 0 on timeout.
+ */
+uint32_t network_udp_wait(const int32_t *handles, const uint16_t count, const uint32_t timeout_millis) {
+	assert(handles != NULL);
+	assert(count <= NETWORK_MAX_SOCKETS);
+
+	struct pollfd pfds[NETWORK_MAX_SOCKETS];
+	uint32_t ready = 0;
+	unsigned i;
+
+	for (i = 0; i < count; i++) {
+		assert((handles[i] >= 0) && (handles[i] < NETWORK_MAX_SOCKETS));
+
+		pfds[i].fd = (handles[i] == 0) ? _socket : _udp_sockets[handles[i]];
+		pfds[i].events = POLLIN;
+		pfds[i].revents = 0;
+	}
+
+	if (poll(pfds, count, (int) timeout_millis) <= 0) {
+		return 0;
+	}
+
+	for (i = 0; i < count; i++) {
+		if ((pfds[i].revents & POLLIN) != 0) {
+			ready |= (uint32_t) 1 << i;
+		}
+	}
+
+	return ready;
+}
+
+#if defined(__linux__)
+ #define NETWORK_MAX_BATCH	64
+#endif
+
+/**
+ * Receive up to \a count datagrams.
+ * When no datagram is pending, wait at most \a timeout_millis for one to arrive, 0 = do not wait.
+ * Returns the number of datagrams received.
+ */
+uint16_t network_recvmmsg(struct TNetworkDatagram *datagrams, const uint16_t count, const uint32_t timeout_millis) {
+	assert(datagrams != NULL);
+	assert(_socket != -1);
+
+	uint16_t received = 0;
+	bool is_waited = false;
+
+	for (;;) {
+#if defined(__linux__)
+		struct mmsghdr msgs[NETWORK_MAX_BATCH];
+		struct iovec iovecs[NETWORK_MAX_BATCH];
+		struct sockaddr_in si_other[NETWORK_MAX_BATCH];
+
+		const unsigned n = (count > NETWORK_MAX_BATCH) ? NETWORK_MAX_BATCH : count;
+		unsigned i;
+
+		for (i = 0; i < n; i++) {
+			iovecs[i].iov_base = datagrams[i].pData;
+			iovecs[i].iov_len = datagrams[i].nSize;
+			memset(&msgs[i].msg_hdr, 0, sizeof(struct msghdr));
+			msgs[i].msg_hdr.msg_iov = &iovecs[i];
+			msgs[i].msg_hdr.msg_iovlen = 1;
+			msgs[i].msg_hdr.msg_name = &si_other[i];
+			msgs[i].msg_hdr.msg_namelen = sizeof(struct sockaddr_in);
+		}
+
+		const int msgs_len = recvmmsg(_socket, msgs, n, MSG_DONTWAIT, NULL);
+
+		if (msgs_len > 0) {
+			for (i = 0; i < (unsigned) msgs_len; i++) {
+				datagrams[i].nLength = (uint16_t) msgs[i].msg_len;
+				datagrams[i].nFromIp = si_other[i].sin_addr.s_addr;
+				datagrams[i].nFromPort = ntohs(si_other[i].sin_port);
+			}
+			received = (uint16_t) msgs_len;
+		} else if ((msgs_len == -1) && (errno != EAGAIN) && (errno != EWOULDBLOCK)) {
+			perror("recvmmsg");
+		}
+#else
+		while (received < count) {
+			struct sockaddr_in si_other;
+			socklen_t slen = sizeof(si_other);
+
+			const int recv_len = recvfrom(_socket, (void *) datagrams[received].pData, datagrams[received].nSize, MSG_DONTWAIT, (struct sockaddr *) &si_other, &slen);
+
+			if (recv_len == -1) {
+				if ((errno != EAGAIN) && (errno != EWOULDBLOCK)) {
+					perror("recvfrom");
+				}
+				break;
+			}
+
+			datagrams[received].nLength = (uint16_t) recv_len;
+			datagrams[received].nFromIp = si_other.sin_addr.s_addr;
+			datagrams[received].nFromPort = ntohs(si_other.sin_port);
+			received++;
+		}
+#endif
+
+		if ((received != 0) || (timeout_millis == 0) || is_waited) {
+			return received;
+		}
+
+		struct pollfd pfd;
+		pfd.fd = _socket;
+		pfd.events = POLLIN;
+		pfd.revents = 0;
+
+		if (poll(&pfd, 1, (int) timeout_millis) <= 0) {
+			return 0;
+		}
+
+		is_waited = true;
+	}
+}
+
 void network_sendto(const uint8_t *packet, const uint16_t size, const uint32_t to_ip, const uint16_t remote_port) {
 	struct sockaddr_in si_other;
 	int slen = sizeof(si_other);
@@ -321,6 +540,19 @@ void network_joingroup(const uint32_t ip) {
 	}
 }
 
+void network_leavegroup(const uint32_t ip) {
+	struct ip_mreq mreq;
+
+	assert(_socket != -1);
+
+	mreq.imr_multiaddr.s_addr = ip;
+	mreq.imr_interface.s_addr = htonl(INADDR_ANY);
+
+	if (setsockopt(_socket, IPPROTO_IP, IP_DROP_MEMBERSHIP, &mreq, sizeof(mreq)) < 0) {
+		perror("setsockopt(IP_DROP_MEMBERSHIP)");
+	}
+}
+
 #if defined(__linux__)
 void network_set_ip(const uint32_t ip) {
     struct ifreq ifr;
@@ -364,6 +596,8 @@ void network_set_ip(const uint32_t ip) {
 #endif
 
 void network_end(void) {
+	int i;
+
 #ifndef NDEBUG
 	printf("network_end, _socket = %d\n", _socket);
 #endif
@@ -374,6 +608,13 @@ void network_end(void) {
 
 	_socket = -1;
 
+	for (i = 1; i < NETWORK_MAX_SOCKETS; i++) {
+		if (_udp_sockets[i] != -1) {
+			close(_udp_sockets[i]);
+			_udp_sockets[i] = -1;
+		}
+	}
+
 	_local_ip = 0;
 	_gw = 0;
 	_netmask = 0;
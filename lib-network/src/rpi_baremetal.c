@@ -41,6 +41,7 @@ static uint32_t _local_ip;
 static uint32_t _netmask;
 static uint32_t _broadcast_ip;
 static bool _is_dhcp_used;
+static uint16_t _port;
 
 void network_init(void) {
 	struct ip_info info;;
@@ -57,6 +58,7 @@ void network_init(void) {
 
 void network_begin(const uint16_t port) {
 	wifi_udp_begin(port);
+	_port = port;
 }
 
 const bool network_get_macaddr(/*@out@*/const uint8_t *macaddr) {
@@ -90,6 +92,24 @@ uint16_t network_recvfrom(const uint8_t *packet, const uint16_t size, uint32_t *
 	return wifi_udp_recvfrom(packet, size, from_ip, from_port);
 }
 
+uint16_t network_recvmmsg(struct TNetworkDatagram *datagrams, const uint16_t count, const uint32_t timeout_millis) {
+	uint16_t received = 0;
+
+	// No batch receive available, the main loop is polling : timeout_millis is not used
+	while (received < count) {
+		const uint16_t length = network_recvfrom(datagrams[received].pData, datagrams[received].nSize, &datagrams[received].nFromIp, &datagrams[received].nFromPort);
+
+		if ((length == 0) || (length > datagrams[received].nSize)) {
+			break;
+		}
+
+		datagrams[received].nLength = length;
+		received++;
+	}
+
+	return received;
+}
+
 void network_sendto(const uint8_t *packet, const uint16_t size, const uint32_t to_ip, const uint16_t remote_port) {
 	wifi_udp_sendto(packet, size, to_ip, remote_port);
 }
@@ -98,6 +118,35 @@ void network_joingroup(const uint32_t ip) {
 	wifi_udp_joingroup(ip);
 }
 
+/**
+ * The ESP8266 has no command to leave a group, its 4 bits command set is full.
+ * The group stays joined until the ESP8266 is reset.
+ */
+void network_leavegroup(const uint32_t ip) {
+}
+
+/**
+ * The ESP8266 bridge has one UDP port : only the port of network_begin is available.
+ */
+int32_t network_udp_begin(const uint16_t port) {
+	return (port == _port) ? 0 : -1;
+}
+
+uint16_t network_udp_recvfrom(const int32_t handle, const uint8_t *packet, const uint16_t size, uint32_t *from_ip, uint16_t *from_port) {
+	assert(handle == 0);
+
+	return network_recvfrom(packet, size, from_ip, from_port);
+}
+
+/**
+ * No wait available, the main loop is polling : each handle is reported, timeout_millis is not used.
+ */
+uint32_t network_udp_wait(const int32_t *handles, const uint16_t count, const uint32_t timeout_millis) {
+	assert(count <= NETWORK_MAX_SOCKETS);
+
+	return ((uint32_t) 1 << count) - 1;
+}
+
 void network_end(void) {
 
 }
@@ -51,6 +51,10 @@ static bool _is_dhcp_used;
 
 static CNetSubSystem *_pNet;
 static CSocket *_pSocket = 0;
+static uint16_t _nPort;
+
+static CSocket *_pSockets[NETWORK_MAX_SOCKETS];	///< Index 0 is not used, that is _pSocket
+static uint16_t _nPorts[NETWORK_MAX_SOCKETS];
 
 static const char FromArtNetNet[] = "network";
 
@@ -107,6 +111,47 @@ void network_begin(const uint16_t port) {
 #if CIRCLE_MAJOR_VERSION >= 27
 	_pSocket->SetOptionBroadcast(TRUE);
 #endif
+
+	_nPort = port;
+}
+
+/**
+ * A socket receiving on \a port, next to the one of network_begin. Sending is always done with the latter.
+ * Returns the handle for network_udp_recvfrom, 0 when \a port is the port of network_begin, -1 on failure.
+ */
+int32_t network_udp_begin(const uint16_t port) {
+	if ((_pSocket != 0) && (port == _nPort)) {
+		return 0;
+	}
+
+	for (int32_t i = 1; i < NETWORK_MAX_SOCKETS; i++) {
+		if ((_pSockets[i] != 0) && (_nPorts[i] == port)) {
+			return i;
+		}
+	}
+
+	for (int32_t i = 1; i < NETWORK_MAX_SOCKETS; i++) {
+		if (_pSockets[i] == 0) {
+			CSocket *pSocket = new CSocket(_pNet, IPPROTO_UDP);
+
+			if (pSocket == 0) {
+				return -1;
+			}
+
+			if (pSocket->Bind(port) < 0) {
+				CLogger::Get()->Write(FromArtNetNet, LogError, "Cannot bind socket (port %u)", port);
+				delete pSocket;
+				return -1;
+			}
+
+			_pSockets[i] = pSocket;
+			_nPorts[i] = port;
+
+			return i;
+		}
+	}
+
+	return -1;
 }
 
 const bool network_get_macaddr(/*@out@*/const uint8_t *macaddr) {
@@ -154,6 +199,60 @@ uint16_t network_recvfrom(const uint8_t *packet, const uint16_t size, uint32_t *
 	return bytes_received;
 }
 
+/**
+ * Does not wait, returns 0 when no datagram is pending on the socket of \a handle.
+ */
+uint16_t network_udp_recvfrom(const int32_t handle, const uint8_t *packet, const uint16_t size, uint32_t *from_ip, uint16_t *from_port) {
+	assert((handle >= 0) && (handle < NETWORK_MAX_SOCKETS));
+
+	if (handle == 0) {
+		return network_recvfrom(packet, size, from_ip, from_port);
+	}
+
+	CIPAddress IPAddressFrom;
+	uint32_t ip = 0;
+
+	const int bytes_received = _pSockets[handle]->ReceiveFrom((void *) packet, size, MSG_DONTWAIT, &IPAddressFrom, (u16 *) from_port);
+
+	if (bytes_received < 0) 	{
+		CLogger::Get()->Write(FromArtNetNet, LogError, "Cannot receive -> %u", bytes_received);
+		return 0;
+	} else if (bytes_received > 0) {
+		ip = IPAddressFrom;
+	}
+
+	*from_ip = ip;
+
+	return bytes_received;
+}
+
+/**
+ * No wait available, the main loop is polling : each handle is reported, timeout_millis is not used.
+ */
+uint32_t network_udp_wait(const int32_t *handles, const uint16_t count, const uint32_t timeout_millis) {
+	assert(count <= NETWORK_MAX_SOCKETS);
+
+	return ((uint32_t) 1 << count) - 1;
+}
+
+uint16_t network_recvmmsg(struct TNetworkDatagram *datagrams, const uint16_t count, const uint32_t timeout_millis) {
+	uint16_t received = 0;
+
+	// No batch receive available, the main loop is polling : timeout_millis is not used
+	while (received < count) {
+		const uint16_t length = network_recvfrom(datagrams[received].pData, datagrams[received].nSize, &datagrams[received].nFromIp, &datagrams[received].nFromPort);
+
+		if ((length == 0) || (length > datagrams[received].nSize)) {
+			break;
+		}
+
+		datagrams[received].nLength = length;
+		received++;
+	}
+
+	return received;
+}
+
 void network_sendto(const uint8_t *packet, const uint16_t size, const uint32_t to_ip, const uint16_t remote_port) {
 	CIPAddress DestinationIP(to_ip);
 
@@ -162,6 +261,15 @@ void network_sendto(const uint8_t *packet, const uint16_t size, const uint32_t t
 	}
 }
 
+/**
+ * Circle has no IGMP : the multicast groups are not joined, and there is nothing to leave.
+ */
+void network_joingroup(const uint32_t ip) {
+}
+
+void network_leavegroup(const uint32_t ip) {
+}
+
 void network_end(void) {
 
 }
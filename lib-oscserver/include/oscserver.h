@@ -29,6 +29,7 @@
 #include <stdint.h>
 
 #include "lightset.h"
+#include "dmxkernel.h"
 
 #define OSCSERVER_DEFAULT_PORT_INCOMING	8000
 #define OSCSERVER_DEFAULT_PORT_OUTGOING	9000
@@ -51,7 +52,11 @@ public:
 
 	int Run(void);
 
+	// When the datagrams are received by the caller
+	int HandleDatagram(const uint8_t *, uint16_t, uint32_t, uint16_t);
+
 private:
+	int HandleReceived(int, uint32_t);
 	int GetChannel(const char *p);
 	const bool IsDmxDataChanged(const uint8_t *pData, uint16_t nStart, uint16_t nLength);
 
@@ -63,6 +68,7 @@ private:
 	uint8_t *m_pData;
 	uint8_t *m_pOsc;
 	bool m_IsBlackout;
+	struct TDmxSlotRange m_tDirty;
 };
 
 
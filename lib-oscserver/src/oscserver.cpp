@@ -27,9 +27,18 @@
 #include <stdio.h>
 #include <assert.h>
 
+#ifdef __circle__
+#include <circle/util.h>
+#elif defined(__linux__) || defined (__CYGWIN__)
+#include <string.h>
+#else
+#include "util.h"
+#endif
+
 #include "oscserver.h"
 
 #include "lightset.h"
+#include "dmxkernel.h"
 
 #include "oscmessage.h"
 #include "oscsend.h"
@@ -132,26 +141,15 @@ int OscServer::GetChannel(const char* p) {
 
 const bool OscServer::IsDmxDataChanged(const uint8_t* pData, uint16_t nStart, uint16_t nLength) {
 	assert(nLength <= 512);
+	assert(nStart + nLength <= 513);
 
-	bool isChanged = false;
-
-	uint8_t *src = (uint8_t *)pData;
-	uint8_t *dst = (uint8_t *)&m_pData[--nStart];
-
-	uint16_t nEnd = nStart + nLength;
-
-	assert(nEnd <= 512);
-
-	for (unsigned i = nStart; i < nEnd; i++) {
-		if (*dst != *src) {
-			*dst = *src;
-			isChanged = true;
-		}
-		dst++;
-		src++;
+	if (dmx_kernel_copy_changed(&m_pData[nStart - 1], pData, nLength, &m_tDirty)) {
+		m_tDirty.nFirst += nStart - 1;
+		m_tDirty.nLast += nStart - 1;
+		return true;
 	}
 
-	return isChanged;
+	return false;
 }
 
 int OscServer::Run(void) {
@@ -164,6 +162,25 @@ int OscServer::Run(void) {
 		return 0;
 	}
 
+	return HandleReceived(nBytesReceived, nRemoteIp);
+}
+
+/**
+ * A datagram received by the caller on the incoming port, e.g. by the Gateway.
+ */
+int OscServer::HandleDatagram(const uint8_t *pData, uint16_t nLength, uint32_t nFromIp, uint16_t nFromPort) {
+	assert(pData != 0);
+
+	if (nLength > OSCSERVER_MAX_BUFFER) {
+		nLength = OSCSERVER_MAX_BUFFER;
+	}
+
+	memcpy(m_pBuffer, pData, nLength);
+
+	return HandleReceived(nLength, nFromIp);
+}
+
+int OscServer::HandleReceived(int nBytesReceived, uint32_t nRemoteIp) {
 	if (OSC::isMatch((const char*) m_pBuffer, "/ping")) {
 		OSCSend MsgSend(nRemoteIp, m_nPortOutgoing, "/pong", 0);
 	} else {
@@ -206,7 +223,7 @@ int OscServer::Run(void) {
 #endif
 					}
 					if (IsDmxDataChanged(&nData, nChannel, 1)) {
-						m_pLightSet->SetData(0, m_pData, 512);
+						m_pLightSet->SetDataRange(0, m_pData, 512, m_tDirty.nFirst, m_tDirty.nLast);
 					}
 				} else {
 					if ((nChannel + nArgc) <= 513) {
@@ -221,7 +238,7 @@ int OscServer::Run(void) {
 						puts("");
 #endif
 						if (IsDmxDataChanged(m_pOsc	, nChannel, nArgc)) {
-							m_pLightSet->SetData(0, m_pData, 512);
+							m_pLightSet->SetDataRange(0, m_pData, 512, m_tDirty.nFirst, m_tDirty.nLast);
 						}
 					} else { // Too many channels
 #ifndef NDEBUG
@@ -267,7 +284,7 @@ int OscServer::Run(void) {
 				puts("");
 #endif
 				if (IsDmxDataChanged(m_pOsc	, nFirstChannel, nArgc - 1)) {
-					m_pLightSet->SetData(0, m_pData, 512);
+					m_pLightSet->SetDataRange(0, m_pData, 512, m_tDirty.nFirst, m_tDirty.nLast);
 				}
 			}
 		}
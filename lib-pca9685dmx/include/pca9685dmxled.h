@@ -41,6 +41,7 @@ public:
 	void Stop(void);
 
 	void SetData(uint8_t nPort, const uint8_t *pDmxData, uint16_t nLength);
+	void SetDataRange(uint8_t nPort, const uint8_t *pDmxData, uint16_t nLength, uint16_t nFirstDirty, uint16_t nLastDirty);
 
 public: // RDM
 	bool SetDmxStartAddress(uint16_t nDmxStartAddress);
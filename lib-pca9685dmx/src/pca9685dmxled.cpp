@@ -36,6 +36,11 @@
 #define DMX_MAX_CHANNELS	512
 #define BOARD_INSTANCES_MAX	32
 
+#ifndef MAX
+ #define MAX(a,b)	(((a) > (b)) ? (a) : (b))
+ #define MIN(a,b)	(((a) < (b)) ? (a) : (b))
+#endif
+
 static unsigned long ceil(float f) {
 	int i = (int) f;
 	if (f == (float) i) {
@@ -97,6 +102,10 @@ void PCA9685DmxLed::Stop(void) {
 }
 
 void PCA9685DmxLed::SetData(uint8_t nPort, const uint8_t* pDmxData, uint16_t nLength) {
+	SetDataRange(nPort, pDmxData, nLength, 0, nLength != 0 ? nLength - 1 : 0);
+}
+
+void PCA9685DmxLed::SetDataRange(uint8_t nPort, const uint8_t* pDmxData, uint16_t nLength, uint16_t nFirstDirty, uint16_t nLastDirty) {
 	assert(pDmxData != 0);
 	assert(nLength <= DMX_MAX_CHANNELS);
 
@@ -104,28 +113,25 @@ void PCA9685DmxLed::SetData(uint8_t nPort, const uint8_t* pDmxData, uint16_t nLe
 		Start();
 	}
 
-	uint8_t *p = (uint8_t *)pDmxData + m_nDmxStartAddress - 1;
-	uint8_t *q = m_pDmxData;
+	if (nLength == 0) {
+		return;
+	}
+
+	// Only the changed slots within the footprint are visited
+	const unsigned nFootprintFirst = m_nDmxStartAddress - 1;
+	const unsigned nFirst = MAX(nFirstDirty, nFootprintFirst);
+	const unsigned nLast = MIN(MIN(nLastDirty, (unsigned) nLength - 1), nFootprintFirst + m_nDmxFootprint - 1);
 
-	uint16_t nChannel = m_nDmxStartAddress;
+	for (unsigned nSlot = nFirst; nSlot <= nLast; nSlot++) {
+		const unsigned nOffset = nSlot - nFootprintFirst;
 
-	for (unsigned j = 0; j < m_nBoardInstances; j++) {
-		for (unsigned i = 0; i < PCA9685_PWM_CHANNELS; i++) {
-			if ((nChannel >= (m_nDmxFootprint + m_nDmxStartAddress)) || (nChannel > nLength)) {
-				j = m_nBoardInstances;
-				break;
-			}
-			if (*p != *q) {
-				uint8_t value = *p;
+		if (pDmxData[nSlot] != m_pDmxData[nOffset]) {
+			const uint8_t value = pDmxData[nSlot];
 #ifndef NDEBUG
-				printf("m_pPWMLed[%d]->SetDmx(CHANNEL(%d), %d)\n", (int) j, (int) i, (int) value);
+			printf("m_pPWMLed[%d]->SetDmx(CHANNEL(%d), %d)\n", (int) (nOffset / PCA9685_PWM_CHANNELS), (int) (nOffset % PCA9685_PWM_CHANNELS), (int) value);
 #endif
-				m_pPWMLed[j]->Set(CHANNEL(i), value);
-			}
-			*q = *p;
-			p++;
-			q++;
-			nChannel++;
+			m_pPWMLed[nOffset / PCA9685_PWM_CHANNELS]->Set(CHANNEL(nOffset % PCA9685_PWM_CHANNELS), value);
+			m_pDmxData[nOffset] = value;
 		}
 	}
 }
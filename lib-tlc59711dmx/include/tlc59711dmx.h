@@ -46,6 +46,7 @@ public:
 	void Stop(void);
 
 	void SetData(uint8_t nPort, const uint8_t *pDmxData, uint16_t nLength);
+	void SetDataRange(uint8_t nPort, const uint8_t *pDmxData, uint16_t nLength, uint16_t nFirstDirty, uint16_t nLastDirty);
 
 	void SetLEDType(TTLC59711Type tTLC59711Type);
 	TTLC59711Type GetLEDType(void) const;
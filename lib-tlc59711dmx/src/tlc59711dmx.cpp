@@ -83,6 +83,10 @@ void TLC59711Dmx::Stop(void) {
 }
 
 void TLC59711Dmx::SetData(uint8_t nPort, const uint8_t* pDmxData, uint16_t nLength) {
+	SetDataRange(nPort, pDmxData, nLength, 0, nLength != 0 ? nLength - 1 : 0);
+}
+
+void TLC59711Dmx::SetDataRange(uint8_t nPort, const uint8_t* pDmxData, uint16_t nLength, uint16_t nFirstDirty, uint16_t nLastDirty) {
 	assert(pDmxData != 0);
 	assert(nLength <= DMX_MAX_CHANNELS);
 
@@ -90,6 +94,11 @@ void TLC59711Dmx::SetData(uint8_t nPort, const uint8_t* pDmxData, uint16_t nLeng
 		Start();
 	}
 
+	// No SPI transfer when nothing within the footprint has changed
+	if (!IsRangeDirty(nFirstDirty, nLastDirty, m_nDmxStartAddress - 1, m_nDmxFootprint)) {
+		return;
+	}
+
 	uint8_t *p = (uint8_t *)pDmxData + m_nDmxStartAddress - 1;
 
 	unsigned nDmxAddress = m_nDmxStartAddress;
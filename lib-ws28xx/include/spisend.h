@@ -49,6 +49,8 @@ public:
 	void Stop(void);
 
 	void SetData(uint8_t, const uint8_t *, uint16_t);
+	void SetDataRange(uint8_t, const uint8_t *, uint16_t, uint16_t, uint16_t);
+	void Sync(void);
 
 	void SetLEDType(const TWS28XXType);
 	TWS28XXType GetLEDType(void) const;
@@ -56,6 +58,9 @@ public:
 	void SetLEDCount(uint16_t);
 	uint16_t GetLEDCount(void) const;
 
+private:
+	void Update(void);
+
 #if defined (__circle__)
 private:
 	CInterruptSystem	*m_pInterrupt;
@@ -63,6 +68,9 @@ private:
 
 private:
 	bool m_bIsStarted;
+	bool m_bIsSyncMode;			///< The source calls Sync, the update is done once per frame
+	bool m_bIsPending;			///< LEDs are set since the latest update
+	bool m_bIsLastPortPending;	///< The port completing the stripe is set since the latest update
 
 private:
 	WS28XXStripe	*m_pLEDStripe;
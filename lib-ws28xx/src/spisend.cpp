@@ -49,6 +49,9 @@ SPISend::SPISend(CInterruptSystem *pInterruptSystem) :
 SPISend::SPISend(void) :
 #endif
 	m_bIsStarted(false),
+	m_bIsSyncMode(false),
+	m_bIsPending(false),
+	m_bIsLastPortPending(false),
 	m_pLEDStripe(0),
 	m_LEDType(WS2801),
 	m_nLEDCount(170),
@@ -103,6 +106,10 @@ void SPISend::Stop(void) {
 }
 
 void SPISend::SetData(uint8_t nPortId, const uint8_t *data, uint16_t length) {
+	SetDataRange(nPortId, data, length, 0, length != 0 ? length - 1 : 0);
+}
+
+void SPISend::SetDataRange(uint8_t nPortId, const uint8_t *data, uint16_t length, uint16_t nFirstDirty, uint16_t nLastDirty) {
 	uint16_t i = 0;
 	uint16_t j = 0;
 
@@ -150,22 +157,58 @@ void SPISend::SetData(uint8_t nPortId, const uint8_t *data, uint16_t length) {
 		// wait for completion
 	}
 
+	// Only the LEDs covering the changed slots are set again
+	const uint16_t nFirstLed = beginIndex + (nFirstDirty / m_nChannelsPerLed);
+	const uint16_t nEndLed = MIN(endIndex, (uint16_t) (beginIndex + (nLastDirty / m_nChannelsPerLed) + 1));
+
+	i = (nFirstLed - beginIndex) * m_nChannelsPerLed;
+
 	if (m_LEDType == SK6812W) {
-		for (j = beginIndex; j < endIndex; j++) {
+		for (j = nFirstLed; j < nEndLed; j++) {
 			m_pLEDStripe->SetLED(j, data[i], data[i + 1], data[i + 2], data[i + 3]);
 			i = i + 4;
 		}
 	} else {
-		for (j = beginIndex; j < endIndex; j++) {
+		for (j = nFirstLed; j < nEndLed; j++) {
 			m_pLEDStripe->SetLED(j, data[i], data[i + 1], data[i + 2]);
 			i = i + 3;
 		}
 	}
 
-	if (bUpdate) {
-		m_pLEDStripe->Update();
-		m_bIsStarted = true;
+	if (m_bIsSyncMode && bUpdate && m_bIsLastPortPending) {
+		// The stripe is completed twice without a Sync : the source no longer synchronizes
+		m_bIsSyncMode = false;
 	}
+
+	if (m_bIsSyncMode) {
+		m_bIsPending = true;
+		m_bIsLastPortPending = m_bIsLastPortPending || bUpdate;
+	} else if (bUpdate) {
+		Update();
+	} else {
+		m_bIsPending = true;
+	}
+}
+
+/**
+ * End of a synchronized frame : all ports are sent with one update.
+ * The next frames wait for their Sync, until the source stops synchronizing.
+ */
+void SPISend::Sync(void) {
+	m_bIsSyncMode = true;
+
+	if (!m_bIsPending || (m_pLEDStripe == 0)) {
+		return;
+	}
+
+	Update();
+}
+
+void SPISend::Update(void) {
+	m_pLEDStripe->Update();
+	m_bIsPending = false;
+	m_bIsLastPortPending = false;
+	m_bIsStarted = true;
 }
 
 void SPISend::SetLEDType(TWS28XXType type) {
@@ -127,15 +127,16 @@ int main(int argc, char **argv) {
 	printf(" Net          : %d\n", node.GetNetSwitch());
 	printf(" Sub-Net      : %d\n", node.GetSubnetSwitch());
 	printf(" Universe     : %d\n", node.GetUniverseSwitch(0));
-	printf(" Active ports : %d\n\n", node.GetActiveOutputPorts());
+	printf(" Active ports : %d\n", node.GetActiveOutputPorts());
+	printf(" Memory       : %d bytes per port, %d bytes for %d ports\n\n", (int) node.GetMemoryPerPort(), (int) node.GetMemoryUsed(), (int) node.GetPorts());
 
 	node.Start();
 
 	for (;;) {
-		int bytes = node.HandlePacket();
-		if (bytes > 0) {
+		const int packets = node.HandlePackets();
+		if (packets > 0) {
 #ifndef NDEBUG
-			printf("(%d)\n", bytes);
+			printf("(%d)\n", packets);
 #endif
 		}
 	}
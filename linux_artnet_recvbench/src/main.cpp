@@ -0,0 +1,219 @@
+/**
+ * @file main.cpp
+ *
+ */
+/* Copyright (C) 2018 by Arjan van Vught mailto:info@raspberrypi-dmx.nl
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <sys/resource.h>
+#include <arpa/inet.h>
+
+#include "artnetnode.h"
+#include "packets.h"
+
+#include "lightset.h"
+
+#include "network.h"
+
+#include "syscalls.h"
+
+extern "C" {
+extern int network_init(const char *);
+extern uint32_t millis(void);
+}
+
+#define DEFAULT_UNIVERSES	200
+#define DEFAULT_FPS			44
+#define DEFAULT_SECONDS		5
+#define DRAIN_MILLIS		200		///< After the sender has finished
+
+/**
+ * The output is not part of the measurement
+ */
+class NullLightSet: public LightSet {
+public:
+	NullLightSet(void) {
+	}
+	~NullLightSet(void) {
+	}
+
+	void Start(void) {
+	}
+	void Stop(void) {
+	}
+	void SetData(uint8_t nPort, const uint8_t *pData, uint16_t nLength) {
+	}
+};
+
+static double cpu_seconds(clockid_t clock) {
+	struct timespec ts;
+	clock_gettime(clock, &ts);
+	return (double) ts.tv_sec + (double) ts.tv_nsec / 1e9;
+}
+
+/**
+ * A child process sends an ArtDmx for each universe, each frame. With nFps 0 the frames are not paced.
+ */
+static void sender(uint32_t nIp, uint16_t nUniverses, uint16_t nFps, unsigned nSeconds) {
+	const int nSocket = socket(AF_INET, SOCK_DGRAM, 0);
+	struct sockaddr_in si_to;
+	struct TArtDmx tDmx;
+
+	memset(&si_to, 0, sizeof(struct sockaddr_in));
+	si_to.sin_family = AF_INET;
+	si_to.sin_port = htons(ARTNET_UDP_PORT);
+	si_to.sin_addr.s_addr = nIp;
+
+	memset(&tDmx, 0, sizeof(struct TArtDmx));
+	memcpy(tDmx.Id, "Art-Net", 8);
+	tDmx.OpCode = OP_DMX;
+	tDmx.ProtVerLo = 14;
+	tDmx.LengthHi = (uint8_t) (ARTNET_DMX_LENGTH >> 8);
+	tDmx.Length = (uint8_t) ARTNET_DMX_LENGTH;
+
+	const uint32_t nFrames = (nFps == 0) ? (uint32_t) ~0 : (uint32_t) nFps * nSeconds;
+	const uint32_t nEndMillis = millis() + nSeconds * 1000;
+	struct timespec tNext;
+
+	clock_gettime(CLOCK_MONOTONIC, &tNext);
+
+	for (uint32_t nFrame = 0; (nFrame < nFrames) && ((int32_t) (millis() - nEndMillis) < 0); nFrame++) {
+		tDmx.Data[0] = (uint8_t) nFrame;
+
+		for (uint16_t nUniverse = 0; nUniverse < nUniverses; nUniverse++) {
+			tDmx.PortAddress = nUniverse;
+			(void) sendto(nSocket, &tDmx, sizeof(struct TArtDmx), 0, (struct sockaddr *) &si_to, sizeof(struct sockaddr_in));
+		}
+
+		if (nFps != 0) {
+			tNext.tv_nsec += 1000000000L / nFps;
+			if (tNext.tv_nsec >= 1000000000L) {
+				tNext.tv_nsec -= 1000000000L;
+				tNext.tv_sec++;
+			}
+			(void) clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &tNext, 0);
+		}
+	}
+
+	close(nSocket);
+	_exit(0);
+}
+
+static void usage(const char *pName) {
+	fprintf(stderr, "Usage: %s [-b] [-u universes] [-f fps] [-t seconds] interface_name|ip_address\n", pName);
+	fprintf(stderr, "  -b  HandlePackets, default HandlePacket\n");
+	fprintf(stderr, "  -u  universes, default %u\n", DEFAULT_UNIVERSES);
+	fprintf(stderr, "  -f  frames per second, 0 is as fast as possible, default %u\n", DEFAULT_FPS);
+	fprintf(stderr, "  -t  seconds, default %u\n", DEFAULT_SECONDS);
+}
+
+int main(int argc, char **argv) {
+	bool IsBatch = false;
+	uint16_t nUniverses = DEFAULT_UNIVERSES;
+	uint16_t nFps = DEFAULT_FPS;
+	unsigned nSeconds = DEFAULT_SECONDS;
+	int c;
+
+	while ((c = getopt(argc, argv, "bu:f:t:")) != -1) {
+		switch (c) {
+		case 'b':
+			IsBatch = true;
+			break;
+		case 'u':
+			nUniverses = (uint16_t) atoi(optarg);
+			break;
+		case 'f':
+			nFps = (uint16_t) atoi(optarg);
+			break;
+		case 't':
+			nSeconds = (unsigned) atoi(optarg);
+			break;
+		default:
+			usage(argv[0]);
+			return -1;
+		}
+	}
+
+	if (optind >= argc) {
+		usage(argv[0]);
+		return -1;
+	}
+
+	if (network_init(argv[optind]) < 0) {
+		fprintf(stderr, "Not able to start the network\n");
+		return -1;
+	}
+
+	NullLightSet lightSet;
+	ArtNetNode node;
+
+	node.SetOutput(&lightSet);
+	node.SetUniverseSwitch(0, ARTNET_OUTPUT_PORT, 0);
+	node.Start();
+
+	const pid_t pid = fork();
+
+	if (pid == 0) {
+		sender(network_get_ip(), nUniverses, nFps, nSeconds);
+	}
+
+	const double fCpuStart = cpu_seconds(CLOCK_PROCESS_CPUTIME_ID);
+	const uint32_t nEndMillis = millis() + nSeconds * 1000 + DRAIN_MILLIS;
+	uint32_t nPackets = 0;
+	struct rusage tUsage;
+
+	while ((int32_t) (millis() - nEndMillis) < 0) {
+		if (IsBatch) {
+			nPackets += (uint32_t) node.HandlePackets();
+		} else if (node.HandlePacket() > 0) {
+			nPackets++;
+		}
+	}
+
+	const double fCpu = cpu_seconds(CLOCK_PROCESS_CPUTIME_ID) - fCpuStart;
+
+	(void) waitpid(pid, 0, 0);
+	(void) getrusage(RUSAGE_SELF, &tUsage);
+
+	struct TSyscalls tSyscalls;
+	syscalls_get(&tSyscalls);
+
+	const uint32_t nCalls = tSyscalls.nRecvfrom + tSyscalls.nRecvmmsg + tSyscalls.nPoll;
+
+	printf("%-13s %u universes %u fps %u s : %u packets, %.0f packets/s\n", IsBatch ? "HandlePackets" : "HandlePacket", (unsigned) nUniverses, (unsigned) nFps, nSeconds, nPackets, (double) nPackets / nSeconds);
+	printf("  recvfrom %u (%u empty), recvmmsg %u (%u empty), poll %u : %u syscalls, %.2f per packet\n",
+			tSyscalls.nRecvfrom, tSyscalls.nRecvfromEmpty, tSyscalls.nRecvmmsg, tSyscalls.nRecvmmsgEmpty, tSyscalls.nPoll, nCalls, (nPackets == 0) ? 0.0 : (double) nCalls / nPackets);
+	printf("  cpu %.3f s (%.1f %%), user %.3f s, system %.3f s, %ld voluntary context switches\n",
+			fCpu, 100.0 * fCpu / (nSeconds + DRAIN_MILLIS / 1000.0),
+			(double) tUsage.ru_utime.tv_sec + (double) tUsage.ru_utime.tv_usec / 1e6,
+			(double) tUsage.ru_stime.tv_sec + (double) tUsage.ru_stime.tv_usec / 1e6, tUsage.ru_nvcsw);
+
+	return 0;
+}
@@ -0,0 +1,79 @@
+/**
+ * @file syscalls.c
+ *
+ */
+/* Copyright (C) 2018 by Arjan van Vught mailto:info@raspberrypi-dmx.nl
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef _GNU_SOURCE
+ #define _GNU_SOURCE	// recvmmsg
+#endif
+
+#include <stdint.h>
+#include <errno.h>
+#include <poll.h>
+#include <sys/socket.h>
+
+#include "syscalls.h"
+
+/*
+ * Linked with -Wl,--wrap : each receive call of lib-network is counted
+ */
+
+static struct TSyscalls s_tSyscalls;
+
+extern ssize_t __real_recvfrom(int, void *, size_t, int, struct sockaddr *, socklen_t *);
+extern int __real_recvmmsg(int, struct mmsghdr *, unsigned int, int, struct timespec *);
+extern int __real_poll(struct pollfd *, nfds_t, int);
+
+ssize_t __wrap_recvfrom(int sockfd, void *buf, size_t len, int flags, struct sockaddr *src_addr, socklen_t *addrlen) {
+	const ssize_t n = __real_recvfrom(sockfd, buf, len, flags, src_addr, addrlen);
+
+	s_tSyscalls.nRecvfrom++;
+
+	if (n < 0) {
+		s_tSyscalls.nRecvfromEmpty++;
+	}
+
+	return n;
+}
+
+int __wrap_recvmmsg(int sockfd, struct mmsghdr *msgvec, unsigned int vlen, int flags, struct timespec *timeout) {
+	const int n = __real_recvmmsg(sockfd, msgvec, vlen, flags, timeout);
+
+	s_tSyscalls.nRecvmmsg++;
+
+	if (n <= 0) {
+		s_tSyscalls.nRecvmmsgEmpty++;
+	}
+
+	return n;
+}
+
+int __wrap_poll(struct pollfd *fds, nfds_t nfds, int timeout) {
+	s_tSyscalls.nPoll++;
+
+	return __real_poll(fds, nfds, timeout);
+}
+
+void syscalls_get(struct TSyscalls *pSyscalls) {
+	*pSyscalls = s_tSyscalls;
+}
@@ -0,0 +1,86 @@
+/**
+ * @file fuzz_artnetnode.cpp
+ *
+ */
+/* Copyright (C) 2018 by Arjan van Vught mailto:info@raspberrypi-dmx.nl
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "artnetnode.h"
+
+#include "recorder.h"
+
+#include "fakenetwork.h"
+#include "fakemillis.h"
+
+/*
+ * Every field of a received packet is untrusted : each input is one datagram, handled by
+ * ArtNetNode::HandleDatagram (GetType, then the handler of the OpCode).
+ * The node has output and input ports, so the merge, sync and input paths are reached.
+ */
+
+static ArtNetNode *s_pNode;
+static Recorder s_Recorder;
+static TriggerRecorder s_TriggerRecorder;
+static TimeCodeRecorder s_TimeCodeRecorder;
+
+static void setup(void) {
+	Recorder::SetQuiet(true);
+
+	network_fake_reset();
+	millis_fake_set(1000000);
+
+	s_pNode = new ArtNetNode(2);
+
+	s_pNode->SetOutput(&s_Recorder);
+	s_pNode->SetTriggerHandler(&s_TriggerRecorder);
+	s_pNode->SetTimeCodeHandler(&s_TimeCodeRecorder);
+
+	s_pNode->SetUniverseSwitch(0, ARTNET_OUTPUT_PORT, 0);
+	s_pNode->SetUniverseSwitch(1, ARTNET_OUTPUT_PORT, 1);
+	s_pNode->SetUniverseSwitch(2, ARTNET_OUTPUT_PORT, 1);
+	s_pNode->SetUniverseSwitch(3, ARTNET_INPUT_PORT, 2);
+	s_pNode->SetUniverseSwitch(4, ARTNET_OUTPUT_PORT, 0);
+
+	s_pNode->Start();
+}
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *pData, size_t nSize) {
+	if (s_pNode == 0) {
+		setup();
+	}
+
+	if (nSize > NETWORK_FAKE_DATAGRAM_SIZE) {
+		nSize = NETWORK_FAKE_DATAGRAM_SIZE;
+	}
+
+	// Two sources, so the merge is reached
+	const uint32_t nFromIp = ((nSize & 1) != 0) ? 0x0A02A8C0 : 0x0B02A8C0;
+
+	s_pNode->HandleDatagram(pData, (uint16_t) nSize, nFromIp, ARTNET_UDP_PORT);
+
+	millis_fake_advance(1);
+	s_pNode->HandleTimers();
+
+	return 0;
+}
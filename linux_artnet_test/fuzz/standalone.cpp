@@ -0,0 +1,57 @@
+/**
+ * @file standalone.cpp
+ *
+ */
+/* Copyright (C) 2018 by Arjan van Vught mailto:info@raspberrypi-dmx.nl
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+
+/*
+ * Runs LLVMFuzzerTestOneInput on the files given, without libFuzzer.
+ * For a regression run of the corpus where clang is not available.
+ */
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *pData, size_t nSize);
+
+int main(int argc, char **argv) {
+	static uint8_t Buffer[65536];
+
+	for (int i = 1; i < argc; i++) {
+		FILE *pFile = fopen(argv[i], "rb");
+
+		if (pFile == 0) {
+			perror(argv[i]);
+			return 1;
+		}
+
+		const size_t nSize = fread(Buffer, 1, sizeof(Buffer), pFile);
+		fclose(pFile);
+
+		LLVMFuzzerTestOneInput(Buffer, nSize);
+	}
+
+	printf("%d inputs\n", argc - 1);
+
+	return 0;
+}
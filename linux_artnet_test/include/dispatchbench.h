@@ -0,0 +1,43 @@
+/**
+ * @file dispatchbench.h
+ *
+ */
+/* Copyright (C) 2018 by Arjan van Vught mailto:info@raspberrypi-dmx.nl
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef DISPATCHBENCH_H_
+#define DISPATCHBENCH_H_
+
+#include <stdint.h>
+
+enum {
+	DISPATCH_BENCH_UNIVERSES = 256,	///< Port-Addresses 0..255 on the wire, round robin
+	DISPATCH_BENCH_ROUNDS = 1000
+};
+
+/**
+ * The cost of HandlePacket for an ArtDmx, with 4, 32 and 64 output ports.
+ * 64 ports is the maximum of a node : ARTNET_MAX_PAGES pages of ARTNET_MAX_PORTS ports.
+ * Each round sends one ArtDmx with changed data for each of the universes.
+ */
+extern void dispatch_bench(uint32_t nRounds);
+
+#endif /* DISPATCHBENCH_H_ */
@@ -0,0 +1,70 @@
+/**
+ * @file fakenetwork.h
+ *
+ */
+/* Copyright (C) 2018 by Arjan van Vught mailto:info@raspberrypi-dmx.nl
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef FAKENETWORK_H_
+#define FAKENETWORK_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "network.h"
+
+#define NETWORK_FAKE_QUEUE_SIZE		64		///< Datagrams pending per socket
+#define NETWORK_FAKE_DATAGRAM_SIZE	1472	///< The largest UDP payload of an Ethernet frame
+#define NETWORK_FAKE_MAX_GROUPS		64		///< Multicast groups joined at the same time
+
+/**
+ * Called for each datagram sent with network_sendto.
+ */
+typedef void (*network_fake_sendto_t)(const uint8_t *, uint16_t, uint32_t, uint16_t);
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * The fake replaces lib-network at link time : all network_* functions of network.h are defined.
+ * Datagrams are queued with network_fake_receive, instead of a socket.
+ * network_recvmmsg and network_udp_wait waiting for a datagram advance the clock of fakemillis.h by their timeout.
+ */
+
+extern void network_fake_reset(void);
+
+extern void network_fake_set_ip(const uint32_t);
+extern void network_fake_set_sendto(network_fake_sendto_t);
+
+extern bool network_fake_receive(const int32_t, const uint8_t *, const uint16_t, const uint32_t, const uint16_t);
+extern uint16_t network_fake_get_pending(const int32_t);
+
+extern uint32_t network_fake_get_sent(void);
+extern uint32_t network_fake_get_joined(void);
+extern uint32_t network_fake_get_left(void);
+extern bool network_fake_is_joined(const uint32_t);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* FAKENETWORK_H_ */
@@ -0,0 +1,102 @@
+/**
+ * @file pcap.h
+ *
+ */
+/* Copyright (C) 2018 by Arjan van Vught mailto:info@raspberrypi-dmx.nl
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef PCAP_H_
+#define PCAP_H_
+
+#include <stdint.h>
+#include <stdio.h>
+
+enum {
+	PCAP_LINKTYPE_NULL = 0,			///< BSD loopback
+	PCAP_LINKTYPE_ETHERNET = 1,
+	PCAP_LINKTYPE_RAW = 101,		///< IPv4 without a link layer header
+	PCAP_LINKTYPE_LINUX_SLL = 113	///< Linux "any" device
+};
+
+enum {
+	PCAP_SNAPLEN = 1536
+};
+
+struct TPcapDatagram {
+	uint64_t nMicros;		///< Capture time stamp
+	uint32_t nFromIp;		///< Network byte order, as network_recvfrom
+	uint16_t nFromPort;
+	uint32_t nToIp;
+	uint16_t nToPort;
+	uint16_t nLength;		///< UDP payload length
+	const uint8_t *pData;	///< UDP payload, valid until the next \ref PcapReader::Read
+};
+
+/**
+ * Reads the UDP/IPv4 datagrams of a libpcap capture file, microsecond or nanosecond time stamps.
+ * Other frames, and IP fragments, are skipped.
+ */
+class PcapReader {
+public:
+	PcapReader(void);
+	~PcapReader(void);
+
+	bool Open(const char *pFileName);
+	void Close(void);
+
+	bool Read(struct TPcapDatagram &tDatagram);
+
+	inline uint32_t GetSkipped(void) const {
+		return m_nSkipped;
+	}
+
+private:
+	uint32_t Swap(uint32_t n) const;
+	bool Decode(const uint8_t *pFrame, uint32_t nLength, struct TPcapDatagram &tDatagram) const;
+
+private:
+	FILE *m_pFile;
+	uint32_t m_nLinkType;
+	bool m_IsSwapped;
+	bool m_IsNanoseconds;
+	uint32_t m_nSkipped;
+	uint8_t m_Frame[PCAP_SNAPLEN];
+};
+
+/**
+ * Writes datagrams as Ethernet/IPv4/UDP frames, so a synthetic replay can be opened with Wireshark and replayed again.
+ */
+class PcapWriter {
+public:
+	PcapWriter(void);
+	~PcapWriter(void);
+
+	bool Open(const char *pFileName);
+	void Close(void);
+
+	void Write(const struct TPcapDatagram &tDatagram);
+
+private:
+	FILE *m_pFile;
+	uint16_t m_nId;
+};
+
+#endif /* PCAP_H_ */
@@ -0,0 +1,86 @@
+/**
+ * @file recorder.h
+ *
+ */
+/* Copyright (C) 2018 by Arjan van Vught mailto:info@raspberrypi-dmx.nl
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef RECORDER_H_
+#define RECORDER_H_
+
+#include <stdint.h>
+
+#include "lightset.h"
+#include "artnettrigger.h"
+#include "artnettimecode.h"
+
+/**
+ * The output of a replay, one line per call, compared with the golden files.
+ * Each line starts with the milliseconds since \ref SetStartMillis.
+ */
+class Recorder: public LightSet {
+public:
+	Recorder(void);
+	~Recorder(void);
+
+	void Start(void);
+	void Stop(void);
+
+	void SetData(uint8_t, const uint8_t *, uint16_t);
+	void SetDataRange(uint8_t, const uint8_t *, uint16_t, uint16_t, uint16_t);
+	void Sync(void);
+	void SetStartCodeData(uint8_t, uint8_t, const uint8_t *, uint16_t);
+
+	static void SetQuiet(bool);
+	static void SetStartMillis(uint32_t);
+
+	static void Printf(const char *, ...) __attribute__((format(printf, 1, 2)));
+
+	// network_fake_sendto_t
+	static void SendTo(const uint8_t *, uint16_t, uint32_t, uint16_t);
+
+	static const char *GetOpCodeName(uint16_t);
+	static uint16_t GetOpCode(const uint8_t *, uint16_t);
+
+private:
+	static void Data(const char *, uint8_t, const uint8_t *, uint16_t);
+};
+
+class TriggerRecorder: public ArtNetTrigger {
+public:
+	TriggerRecorder(void);
+	~TriggerRecorder(void);
+
+	void Handler(const struct TArtNetTrigger *);
+};
+
+class TimeCodeRecorder: public ArtNetTimeCode {
+public:
+	TimeCodeRecorder(void);
+	~TimeCodeRecorder(void);
+
+	void Start(void);
+	void Stop(void);
+
+	void Handler(const struct TArtNetTimeCode *);
+};
+
+#endif /* RECORDER_H_ */
@@ -0,0 +1,97 @@
+/**
+ * @file replay.h
+ *
+ */
+/* Copyright (C) 2018 by Arjan van Vught mailto:info@raspberrypi-dmx.nl
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef REPLAY_H_
+#define REPLAY_H_
+
+#include <stdint.h>
+
+#include "artnetnode.h"
+
+#include "recorder.h"
+#include "pcap.h"
+
+enum {
+	REPLAY_MAX_OPCODES = 24,		///< Statistics table size
+	REPLAY_START_MILLIS = 1000		///< The fake clock at the start of a scenario
+};
+
+struct TReplayOpCodeStats {
+	uint16_t nOpCode;
+	uint32_t nPackets;
+	uint64_t nNanos;				///< Time spent in ArtNetNode::HandlePacket
+};
+
+/**
+ * Runs a scenario file : a node configuration followed by synthetic packets,
+ * recorded pcap files and waits, all received through the fake of lib-network.
+ * The output of the node is written by the \ref Recorder.
+ *
+ * Each packet is handled with its own HandlePacket call, and timed.
+ * After "defer" the packets are queued and handled by one HandlePackets call with "batch".
+ */
+class Replay {
+public:
+	Replay(void);
+	~Replay(void);
+
+	void SetPcapWriter(PcapWriter *);
+	void SetSeedDirectory(const char *);
+
+	bool Run(const char *pFileName);
+
+	void DumpStats(void) const;
+
+private:
+	bool Command(char *pLine);
+	bool CreateNode(uint8_t nPages);
+	bool ReplayPcap(const char *pFileName);
+
+	void Receive(const uint8_t *pData, uint16_t nLength, uint32_t nFromIp, uint16_t nFromPort = ARTNET_UDP_PORT);
+	void Wait(uint32_t nMillis);
+	void Batch(uint16_t nMaxBatch);
+
+	void AddStats(uint16_t nOpCode, uint64_t nNanos);
+
+private:
+	ArtNetNode *m_pNode;
+	Recorder m_Recorder;
+	TriggerRecorder m_TriggerRecorder;
+	TimeCodeRecorder m_TimeCodeRecorder;
+	PcapWriter *m_pPcapWriter;
+	const char *m_pSeedDirectory;
+	uint32_t m_nSeeds;
+	const char *m_pFileName;
+	unsigned m_nLine;
+	bool m_IsDeferred;
+	uint32_t m_nPackets;
+	uint64_t m_nNanos;
+	uint32_t m_nBatchPackets;
+	uint64_t m_nBatchNanos;
+	unsigned m_nOpCodes;
+	struct TReplayOpCodeStats m_OpCodeStats[REPLAY_MAX_OPCODES];
+};
+
+#endif /* REPLAY_H_ */
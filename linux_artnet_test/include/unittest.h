@@ -0,0 +1,81 @@
+/**
+ * @file unittest.h
+ *
+ */
+/* Copyright (C) 2018 by Arjan van Vught mailto:info@raspberrypi-dmx.nl
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef UNITTEST_H_
+#define UNITTEST_H_
+
+#include <stdint.h>
+
+#include "lightset.h"
+
+/**
+ * The tests of the E1.31 and Gateway classes, against the fake of lib-network and the fake clock.
+ * A failed check prints its file, line and expression, and the test continues.
+ */
+#define UNITTEST_CHECK(x)	unittest_check((x), #x, __FILE__, __LINE__)
+
+extern void unittest_check(bool IsOk, const char *pExpression, const char *pFile, int nLine);
+
+/**
+ * Runs all tests, returns the number of failed checks
+ */
+extern unsigned unittest_run(void);
+
+enum {
+	UNITTEST_PORTS = 8		///< Ports kept by \ref UnitTestLightSet
+};
+
+/**
+ * Keeps the latest data of each port and counts the calls, without output.
+ */
+class UnitTestLightSet: public LightSet {
+public:
+	UnitTestLightSet(void);
+	~UnitTestLightSet(void);
+
+	void Start(void);
+	void Stop(void);
+
+	void SetData(uint8_t, const uint8_t *, uint16_t);
+	void SetDataRange(uint8_t, const uint8_t *, uint16_t, uint16_t, uint16_t);
+	void Sync(void);
+
+	void Clear(void);
+
+public:
+	bool IsStarted;
+	unsigned nOutputs[UNITTEST_PORTS];	///< SetData and SetDataRange calls
+	unsigned nSyncs;
+	uint16_t nLength[UNITTEST_PORTS];
+	uint8_t Data[UNITTEST_PORTS][512];
+};
+
+// One function per class tested
+extern void e131discovery_test(void);
+extern void e131bridge_test(void);
+extern void e131controller_test(void);
+extern void gateway_test(void);
+
+#endif /* UNITTEST_H_ */
@@ -0,0 +1,292 @@
+/**
+ * @file fakenetwork.c
+ *
+ */
+/* Copyright (C) 2018 by Arjan van Vught mailto:info@raspberrypi-dmx.nl
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <assert.h>
+
+#include "network.h"
+#include "fakenetwork.h"
+#include "fakemillis.h"
+
+struct queue {
+	uint8_t data[NETWORK_FAKE_QUEUE_SIZE][NETWORK_FAKE_DATAGRAM_SIZE];
+	uint16_t length[NETWORK_FAKE_QUEUE_SIZE];
+	uint32_t from_ip[NETWORK_FAKE_QUEUE_SIZE];
+	uint16_t from_port[NETWORK_FAKE_QUEUE_SIZE];
+	uint16_t head;
+	uint16_t count;
+};
+
+static struct queue _queues[NETWORK_MAX_SOCKETS];
+static uint16_t _ports[NETWORK_MAX_SOCKETS];	///< 0 is not opened
+static uint32_t _ip = 0x6402A8C0;			///< 192.168.2.100
+static network_fake_sendto_t _sendto;
+static uint32_t _sent;
+static uint32_t _joined;
+static uint32_t _left;
+static uint32_t _groups[NETWORK_FAKE_MAX_GROUPS];	///< The multicast groups joined
+static uint16_t _groups_count;
+
+static uint16_t dequeue(struct queue *q, const uint8_t *packet, const uint16_t size, uint32_t *from_ip, uint16_t *from_port) {
+	if (q->count == 0) {
+		return 0;
+	}
+
+	const uint16_t length = (q->length[q->head] < size) ? q->length[q->head] : size;
+
+	memcpy((void *) packet, q->data[q->head], length);
+	*from_ip = q->from_ip[q->head];
+	*from_port = q->from_port[q->head];
+
+	q->head = (q->head + 1) % NETWORK_FAKE_QUEUE_SIZE;
+	q->count--;
+
+	return length;
+}
+
+void network_fake_reset(void) {
+	memset(_queues, 0, sizeof(_queues));
+	memset(_ports, 0, sizeof(_ports));
+	_ip = 0x6402A8C0;
+	_sendto = 0;
+	_sent = 0;
+	_joined = 0;
+	_left = 0;
+	_groups_count = 0;
+}
+
+void network_fake_set_ip(const uint32_t ip) {
+	_ip = ip;
+}
+
+void network_fake_set_sendto(network_fake_sendto_t sendto) {
+	_sendto = sendto;
+}
+
+/**
+ * Queue a datagram for the socket \a handle, 0 is the socket of network_begin.
+ * Returns false when the queue is full.
+ */
+bool network_fake_receive(const int32_t handle, const uint8_t *packet, const uint16_t size, const uint32_t from_ip, const uint16_t from_port) {
+	assert((handle >= 0) && (handle < NETWORK_MAX_SOCKETS));
+
+	struct queue *q = &_queues[handle];
+
+	if (q->count == NETWORK_FAKE_QUEUE_SIZE) {
+		return false;
+	}
+
+	const uint16_t tail = (q->head + q->count) % NETWORK_FAKE_QUEUE_SIZE;
+	const uint16_t length = (size < NETWORK_FAKE_DATAGRAM_SIZE) ? size : NETWORK_FAKE_DATAGRAM_SIZE;
+
+	memcpy(q->data[tail], packet, length);
+	q->length[tail] = length;
+	q->from_ip[tail] = from_ip;
+	q->from_port[tail] = from_port;
+	q->count++;
+
+	return true;
+}
+
+uint16_t network_fake_get_pending(const int32_t handle) {
+	assert((handle >= 0) && (handle < NETWORK_MAX_SOCKETS));
+
+	return _queues[handle].count;
+}
+
+uint32_t network_fake_get_sent(void) {
+	return _sent;
+}
+
+uint32_t network_fake_get_joined(void) {
+	return _joined;
+}
+
+uint32_t network_fake_get_left(void) {
+	return _left;
+}
+
+bool network_fake_is_joined(const uint32_t ip) {
+	uint16_t i;
+
+	for (i = 0; i < _groups_count; i++) {
+		if (_groups[i] == ip) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
+int network_init(const char *s) {
+	return 0;
+}
+
+void network_begin(const uint16_t port) {
+	_ports[0] = port;
+}
+
+void network_end(void) {
+	memset(_ports, 0, sizeof(_ports));
+}
+
+int32_t network_udp_begin(const uint16_t port) {
+	int32_t i;
+
+	for (i = 0; i < NETWORK_MAX_SOCKETS; i++) {
+		if (_ports[i] == port) {
+			return i;
+		}
+	}
+
+	for (i = 1; i < NETWORK_MAX_SOCKETS; i++) {
+		if (_ports[i] == 0) {
+			_ports[i] = port;
+			return i;
+		}
+	}
+
+	return -1;
+}
+
+const bool network_get_macaddr(const uint8_t *macaddr) {
+	static const uint8_t mac[NETWORK_MAC_SIZE] = { 0x02, 0x00, 0x00, 0x02, 0xA8, 0x64 };
+	memcpy((void *) macaddr, mac, NETWORK_MAC_SIZE);
+	return true;
+}
+
+const uint32_t network_get_ip(void) {
+	return _ip;
+}
+
+const uint32_t network_get_netmask(void) {
+	return 0x00FFFFFF;
+}
+
+const uint32_t network_get_bcast(void) {
+	return _ip | ~network_get_netmask();
+}
+
+const uint32_t network_get_gw(void) {
+	return (_ip & network_get_netmask()) | 0x01000000;
+}
+
+const char *network_get_hostname(void) {
+	return "fakenetwork";
+}
+
+bool network_is_dhcp_used(void) {
+	return false;
+}
+
+uint16_t network_recvfrom(const uint8_t *packet, const uint16_t size, uint32_t *from_ip, uint16_t *from_port) {
+	return dequeue(&_queues[0], packet, size, from_ip, from_port);
+}
+
+uint16_t network_udp_recvfrom(const int32_t handle, const uint8_t *packet, const uint16_t size, uint32_t *from_ip, uint16_t *from_port) {
+	assert((handle >= 0) && (handle < NETWORK_MAX_SOCKETS));
+
+	return dequeue(&_queues[handle], packet, size, from_ip, from_port);
+}
+
+/**
+ * When nothing is pending, the wait is done by advancing the clock with \a timeout_millis.
+ */
+uint32_t network_udp_wait(const int32_t *handles, const uint16_t count, const uint32_t timeout_millis) {
+	uint32_t ready = 0;
+	uint16_t i;
+
+	for (i = 0; i < count; i++) {
+		assert((handles[i] >= 0) && (handles[i] < NETWORK_MAX_SOCKETS));
+
+		if (_queues[handles[i]].count != 0) {
+			ready |= (uint32_t) 1 << i;
+		}
+	}
+
+	if (ready == 0) {
+		millis_fake_advance(timeout_millis);
+	}
+
+	return ready;
+}
+
+/**
+ * When nothing is pending, the wait is done by advancing the clock with \a timeout_millis.
+ */
+uint16_t network_recvmmsg(struct TNetworkDatagram *datagrams, const uint16_t count, const uint32_t timeout_millis) {
+	uint16_t received = 0;
+
+	if (_queues[0].count == 0) {
+		millis_fake_advance(timeout_millis);
+	}
+
+	while ((received < count) && (_queues[0].count != 0)) {
+		struct TNetworkDatagram *d = &datagrams[received];
+		d->nLength = dequeue(&_queues[0], d->pData, d->nSize, &d->nFromIp, &d->nFromPort);
+		received++;
+	}
+
+	return received;
+}
+
+void network_sendto(const uint8_t *packet, const uint16_t size, const uint32_t to_ip, const uint16_t remote_port) {
+	_sent++;
+
+	if (_sendto != 0) {
+		_sendto(packet, size, to_ip, remote_port);
+	}
+}
+
+/**
+ * A group joined twice is kept once, network_fake_get_joined counts each join
+ */
+void network_joingroup(const uint32_t ip) {
+	_joined++;
+
+	if (!network_fake_is_joined(ip)) {
+		assert(_groups_count < NETWORK_FAKE_MAX_GROUPS);
+		_groups[_groups_count++] = ip;
+	}
+}
+
+void network_leavegroup(const uint32_t ip) {
+	uint16_t i;
+
+	_left++;
+
+	for (i = 0; i < _groups_count; i++) {
+		if (_groups[i] == ip) {
+			_groups[i] = _groups[--_groups_count];
+			return;
+		}
+	}
+}
+
+void network_set_ip(const uint32_t ip) {
+	_ip = ip;
+}
@@ -0,0 +1,147 @@
+/**
+ * @file dispatchbench.cpp
+ *
+ */
+/* Copyright (C) 2018 by Arjan van Vught mailto:info@raspberrypi-dmx.nl
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <assert.h>
+
+#include "dispatchbench.h"
+
+#include "artnetnode.h"
+#include "packets.h"
+
+#include "lightset.h"
+
+#include "fakenetwork.h"
+#include "fakemillis.h"
+
+static const uint8_t s_Ports[] = { 4, 32, ARTNET_MAX_PAGES * ARTNET_MAX_PORTS };
+
+/**
+ * The output is not part of the dispatch
+ */
+class NullLightSet: public LightSet {
+public:
+	NullLightSet(void) {
+	}
+	~NullLightSet(void) {
+	}
+
+	void Start(void) {
+	}
+	void Stop(void) {
+	}
+	void SetData(uint8_t nPort, const uint8_t *pData, uint16_t nLength) {
+	}
+	void SetDataRange(uint8_t nPort, const uint8_t *pData, uint16_t nLength, uint16_t nFirstDirty, uint16_t nLastDirty) {
+	}
+	void Sync(void) {
+	}
+};
+
+static uint64_t nanos(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t) ts.tv_sec * 1000000000 + (uint64_t) ts.tv_nsec;
+}
+
+/**
+ * Page p has Sub-Net p, its ports the universes 0..3 : Port-Addresses 16p..16p+3
+ */
+static bool is_bound(uint16_t nPortAddress, uint8_t nPorts) {
+	return ((nPortAddress & 0x0F) < ARTNET_MAX_PORTS) && ((nPortAddress >> 4) < (nPorts / ARTNET_MAX_PORTS));
+}
+
+static void run(uint8_t nPorts, uint32_t nRounds) {
+	const uint8_t nPages = (uint8_t) (nPorts / ARTNET_MAX_PORTS);
+	NullLightSet lightSet;
+	ArtNetNode *pNode = new ArtNetNode(nPages);
+	assert(pNode != 0);
+
+	network_fake_reset();
+	network_fake_set_sendto(0);
+	millis_fake_set((uint64_t) 1000 * 1000);
+
+	pNode->SetOutput(&lightSet);
+
+	for (uint8_t nPage = 0; nPage < nPages; nPage++) {
+		pNode->SetSubnetSwitch(nPage, nPage);
+
+		for (uint8_t i = 0; i < ARTNET_MAX_PORTS; i++) {
+			(void) pNode->SetUniverseSwitch((uint8_t) (nPage * ARTNET_MAX_PORTS + i), ARTNET_OUTPUT_PORT, i);
+		}
+	}
+
+	pNode->Start();
+
+	struct TArtDmx tDmx;
+
+	memset(&tDmx, 0, sizeof(struct TArtDmx));
+	memcpy(tDmx.Id, "Art-Net", 8);
+	tDmx.OpCode = OP_DMX;
+	tDmx.ProtVerLo = 14;
+	tDmx.LengthHi = (uint8_t) (ARTNET_DMX_LENGTH >> 8);
+	tDmx.Length = (uint8_t) ARTNET_DMX_LENGTH;
+
+	uint64_t nNanos[2] = { 0, 0 };
+	uint32_t nPackets[2] = { 0, 0 };
+
+	for (uint32_t nRound = 0; nRound < nRounds; nRound++) {
+		// Changed data, each ArtDmx for a bound universe is output
+		tDmx.Data[0] = (uint8_t) nRound;
+		tDmx.Data[1] = (uint8_t) (nRound >> 8);
+
+		for (uint16_t nPortAddress = 0; nPortAddress < DISPATCH_BENCH_UNIVERSES; nPortAddress++) {
+			tDmx.PortAddress = nPortAddress;
+			(void) network_fake_receive(0, (const uint8_t *) &tDmx, (uint16_t) sizeof(struct TArtDmx), 0x0200000A, ARTNET_UDP_PORT);
+
+			const uint64_t nStart = nanos();
+			pNode->HandlePacket();
+			const uint64_t nElapsed = nanos() - nStart;
+
+			const unsigned nBound = is_bound(nPortAddress, nPorts) ? 1 : 0;
+			nNanos[nBound] += nElapsed;
+			nPackets[nBound]++;
+		}
+	}
+
+	printf("%5u %10u %10.0f %10.0f %10.0f\n", (unsigned) nPorts, nPackets[0] + nPackets[1],
+			(double) (nNanos[0] + nNanos[1]) / (nPackets[0] + nPackets[1]),
+			(double) nNanos[1] / nPackets[1],
+			(double) nNanos[0] / nPackets[0]);
+
+	delete pNode;
+}
+
+void dispatch_bench(uint32_t nRounds) {
+	printf("ArtDmx for %u universes, ns per HandlePacket\n", (unsigned) DISPATCH_BENCH_UNIVERSES);
+	printf("%5s %10s %10s %10s %10s\n", "ports", "packets", "all", "bound", "not bound");
+
+	for (unsigned i = 0; i < sizeof(s_Ports) / sizeof(s_Ports[0]); i++) {
+		run(s_Ports[i], nRounds);
+	}
+}
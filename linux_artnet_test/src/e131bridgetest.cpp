@@ -0,0 +1,211 @@
+/**
+ * @file e131bridgetest.cpp
+ *
+ */
+/* Copyright (C) 2018 by Arjan van Vught mailto:info@raspberrypi-dmx.nl
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <stdint.h>
+#include <string.h>
+
+#include "unittest.h"
+
+#include "e131.h"
+#include "e131packets.h"
+#include "e131bridge.h"
+#include "e131discovery.h"
+
+#include "fakenetwork.h"
+#include "fakemillis.h"
+
+#define FROM_IP		0x0A02A8C0	///< 192.168.2.10
+
+static const uint8_t ACN_PACKET_IDENTIFIER[E131_PACKET_IDENTIFIER_LENGTH] = { 0x41, 0x53, 0x43, 0x2d, 0x45, 0x31, 0x2e, 0x31, 0x37, 0x00, 0x00, 0x00 };
+
+static void root_layer(struct TRootLayer *pRootLayer, uint16_t nLength, uint32_t nVector) {
+	pRootLayer->PreAmbleSize = __builtin_bswap16(0x10);
+	memcpy(pRootLayer->ACNPacketIdentifier, ACN_PACKET_IDENTIFIER, E131_PACKET_IDENTIFIER_LENGTH);
+	pRootLayer->FlagsLength = __builtin_bswap16((uint16_t) ((0x07 << 12) | (nLength - 16)));
+	pRootLayer->Vector = __builtin_bswap32(nVector);
+	memset(pRootLayer->Cid, 0xB0, E131_CID_LENGTH);
+}
+
+/**
+ * A data packet of 512 slots set to \a nValue
+ */
+static void data(E131Bridge &Bridge, uint16_t nUniverse, uint8_t nSequence, uint8_t nOptions, uint8_t nValue) {
+	struct TE131DataPacket Packet;
+	const uint16_t nLength = (uint16_t) sizeof(struct TE131DataPacket);
+
+	memset(&Packet, 0, sizeof(Packet));
+	root_layer(&Packet.RootLayer, nLength, E131_VECTOR_ROOT_DATA);
+
+	Packet.FrameLayer.FLagsLength = __builtin_bswap16((uint16_t) ((0x07 << 12) | (nLength - sizeof(struct TRootLayer))));
+	Packet.FrameLayer.Vector = __builtin_bswap32(E131_VECTOR_DATA_PACKET);
+	Packet.FrameLayer.Priority = 100;
+	Packet.FrameLayer.SequenceNumber = nSequence;
+	Packet.FrameLayer.Options = nOptions;
+	Packet.FrameLayer.Universe = __builtin_bswap16(nUniverse);
+
+	Packet.DMPLayer.FlagsLength = __builtin_bswap16((uint16_t) ((0x07 << 12) | (nLength - sizeof(struct TRootLayer) - sizeof(struct TDataFrameLayer))));
+	Packet.DMPLayer.Vector = E131_VECTOR_DMP_SET_PROPERTY;
+	Packet.DMPLayer.Type = 0xa1;
+	Packet.DMPLayer.AddressIncrement = __builtin_bswap16(1);
+	Packet.DMPLayer.PropertyValueCount = __builtin_bswap16(E131_DMX_LENGTH + 1);
+	memset(&Packet.DMPLayer.PropertyValues[1], nValue, E131_DMX_LENGTH);
+
+	Bridge.HandleDatagram((const uint8_t *) &Packet, nLength, FROM_IP, E131_DEFAULT_PORT);
+}
+
+static void synchronization(E131Bridge &Bridge, uint16_t nUniverse, uint8_t nSequence) {
+	struct TE131SynchronizationPacket Packet;
+	const uint16_t nLength = (uint16_t) sizeof(struct TE131SynchronizationPacket);
+
+	memset(&Packet, 0, sizeof(Packet));
+	root_layer(&Packet.RootLayer, nLength, E131_VECTOR_ROOT_EXTENDED);
+
+	Packet.FrameLayer.FLagsLength = __builtin_bswap16((uint16_t) ((0x07 << 12) | (nLength - sizeof(struct TRootLayer))));
+	Packet.FrameLayer.Vector = __builtin_bswap32(E131_VECTOR_EXTENDED_SYNCHRONIZATION);
+	Packet.FrameLayer.SequenceNumber = nSequence;
+	Packet.FrameLayer.UniverseNumber = __builtin_bswap16(nUniverse);
+
+	Bridge.HandleDatagram((const uint8_t *) &Packet, nLength, FROM_IP, E131_DEFAULT_PORT);
+}
+
+/**
+ * 239.255.UHB.ULB
+ */
+static uint32_t group(uint16_t nUniverse) {
+	return 0x0000FFEF | ((uint32_t) (nUniverse >> 8) << 16) | ((uint32_t) (nUniverse & 0xFF) << 24);
+}
+
+static void discovery(E131Bridge &Bridge, const uint16_t *pUniverses, uint16_t nUniverses) {
+	struct TE131DiscoveryPacket Packet;
+	uint8_t Cid[E131_CID_LENGTH];
+
+	memset(Cid, 0xA0, sizeof(Cid));
+
+	const uint16_t nLength = e131_discovery_fill_page(&Packet, Cid, "e131bridgetest", 0, 0, pUniverses, nUniverses);
+	Bridge.HandleDatagram((const uint8_t *) &Packet, nLength, FROM_IP, E131_DEFAULT_PORT);
+}
+
+static void wait_discovery_intervals(E131Bridge &Bridge, unsigned nIntervals) {
+	while (nIntervals-- != 0) {
+		millis_fake_advance(E131_UNIVERSE_DISCOVERY_INTERVAL_SECONDS * 1000);
+		Bridge.HandleTimers();
+	}
+}
+
+/**
+ * The multicast groups follow the universes of the ports, and with join on discovery the universes advertised
+ */
+static void groups(void) {
+	UnitTestLightSet LightSet;
+	E131Bridge Bridge(2);
+
+	Bridge.SetOutput(&LightSet);
+
+	Bridge.SetUniverse(1, 2);
+	Bridge.HandleTimers();
+	UNITTEST_CHECK(network_fake_is_joined(group(1)) && network_fake_is_joined(group(2)));
+	UNITTEST_CHECK(network_fake_get_joined() == 2);
+
+	// Port 1 moves to the universe of port 0
+	Bridge.SetUniverse(1, 1);
+	Bridge.HandleTimers();
+	UNITTEST_CHECK(network_fake_is_joined(group(1)) && !network_fake_is_joined(group(2)));
+	UNITTEST_CHECK((network_fake_get_joined() == 2) && (network_fake_get_left() == 1));
+
+	// Universe 1 is left with its last port
+	Bridge.SetUniverse(0, 3);
+	Bridge.HandleTimers();
+	UNITTEST_CHECK(network_fake_is_joined(group(1)) && network_fake_is_joined(group(3)));
+	Bridge.SetUniverse(1, 3);
+	Bridge.HandleTimers();
+	UNITTEST_CHECK(!network_fake_is_joined(group(1)) && network_fake_is_joined(group(3)));
+	UNITTEST_CHECK((network_fake_get_joined() == 3) && (network_fake_get_left() == 2));
+
+	// Join on discovery : universe 3 is not advertised yet
+	Bridge.SetJoinOnDiscovery(true);
+	Bridge.HandleTimers();
+	UNITTEST_CHECK(network_fake_is_joined(group(E131_UNIVERSE_DISCOVERY)));
+	UNITTEST_CHECK(!network_fake_is_joined(group(3)));
+
+	const uint16_t Universes[] = { 3, 4 };
+	discovery(Bridge, Universes, 2);
+	Bridge.HandleTimers();
+	UNITTEST_CHECK(network_fake_is_joined(group(3)) && !network_fake_is_joined(group(4)));
+
+	// The source stops advertising universe 3
+	discovery(Bridge, &Universes[1], 1);
+	Bridge.HandleTimers();
+	UNITTEST_CHECK(!network_fake_is_joined(group(3)));
+
+	discovery(Bridge, Universes, 2);
+	Bridge.HandleTimers();
+	UNITTEST_CHECK(network_fake_is_joined(group(3)));
+
+	// The source expires
+	wait_discovery_intervals(Bridge, E131_DISCOVERY_EXPIRY_SECONDS / E131_UNIVERSE_DISCOVERY_INTERVAL_SECONDS + 1);
+	Bridge.HandleTimers();
+	UNITTEST_CHECK(!network_fake_is_joined(group(3)));
+
+	Bridge.SetJoinOnDiscovery(false);
+	Bridge.HandleTimers();
+	UNITTEST_CHECK(!network_fake_is_joined(group(E131_UNIVERSE_DISCOVERY)));
+	UNITTEST_CHECK(network_fake_is_joined(group(3)));
+	UNITTEST_CHECK(network_fake_get_joined() - network_fake_get_left() == 1);
+}
+
+/**
+ * While synchronized, data with Force_Synchronization 0 is merged and output with the next synchronization packet
+ */
+static void synchronized(void) {
+	UnitTestLightSet LightSet;
+	E131Bridge Bridge(1);
+
+	Bridge.SetOutput(&LightSet);
+
+	// The end of the sampling period
+	millis_fake_advance(E131_SAMPLING_PERIOD_MILLIS);
+	Bridge.HandleTimers();
+
+	data(Bridge, 1, 1, 0, 10);
+	UNITTEST_CHECK((LightSet.nOutputs[0] == 1) && (LightSet.Data[0][0] == 10) && (LightSet.nSyncs == 0));
+
+	synchronization(Bridge, 1, 1);
+	data(Bridge, 1, 2, 0, 20);
+	UNITTEST_CHECK(LightSet.nOutputs[0] == 1);
+
+	synchronization(Bridge, 1, 2);
+	UNITTEST_CHECK((LightSet.nOutputs[0] == 2) && (LightSet.Data[0][511] == 20) && (LightSet.nSyncs == 1));
+
+	data(Bridge, 1, 3, E131_OPTIONS_MASK_FORCE_SYNCHRONIZATION, 30);
+	UNITTEST_CHECK(LightSet.nOutputs[0] == 2);
+
+	synchronization(Bridge, 1, 3);
+	UNITTEST_CHECK((LightSet.nOutputs[0] == 3) && (LightSet.Data[0][0] == 30) && (LightSet.nSyncs == 2));
+}
+
+void e131bridge_test(void) {
+	groups();
+	synchronized();
+}
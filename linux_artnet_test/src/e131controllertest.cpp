@@ -0,0 +1,324 @@
+/**
+ * @file e131controllertest.cpp
+ *
+ */
+/* Copyright (C) 2018 by Arjan van Vught mailto:info@raspberrypi-dmx.nl
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <stdint.h>
+#include <string.h>
+
+#include "unittest.h"
+
+#include "e131.h"
+#include "e131packets.h"
+#include "e131controller.h"
+#include "e131bridge.h"
+
+#include "fakenetwork.h"
+#include "fakemillis.h"
+
+enum {
+	MAX_SENT = 256
+};
+
+#define ROOT_LAYER_PREAMBLE		16
+#define DATA_PACKET_HEADER		((uint16_t) (sizeof(struct TE131DataPacket) - E131_DMX_LENGTH))
+
+struct TSent {
+	uint8_t Data[sizeof(struct TE131DataPacket)];
+	uint16_t nLength;
+	uint32_t nToIp;
+	uint16_t nToPort;
+	uint32_t nMillis;
+};
+
+static struct TSent s_Sent[MAX_SENT];
+static unsigned s_nSent;
+
+// network_fake_sendto_t
+static void sendto(const uint8_t *pData, uint16_t nLength, uint32_t nToIp, uint16_t nToPort) {
+	if (s_nSent == MAX_SENT) {
+		return;
+	}
+
+	struct TSent *pSent = &s_Sent[s_nSent++];
+
+	memcpy(pSent->Data, pData, (nLength < sizeof(pSent->Data)) ? nLength : sizeof(pSent->Data));
+	pSent->nLength = nLength;
+	pSent->nToIp = nToIp;
+	pSent->nToPort = nToPort;
+	pSent->nMillis = millis();
+}
+
+/**
+ * 239.255.UHB.ULB
+ */
+static uint32_t group(uint16_t nUniverse) {
+	return 0x0000FFEF | ((uint32_t) (nUniverse >> 8) << 16) | ((uint32_t) (nUniverse & 0xFF) << 24);
+}
+
+static uint16_t pdu_length(uint16_t nFlagsLength) {
+	return __builtin_bswap16(nFlagsLength) & 0x0FFF;
+}
+
+static void run(E131Controller &Controller, uint32_t nMillis) {
+	while (nMillis-- != 0) {
+		millis_fake_advance(1);
+		Controller.Run();
+	}
+}
+
+/**
+ * The data packets sent to \a nUniverse from \a nFirst, the index of the first in \a nIndex
+ */
+static unsigned count_data(uint16_t nUniverse, unsigned nFirst, unsigned &nIndex) {
+	unsigned nCount = 0;
+
+	nIndex = s_nSent;
+
+	for (unsigned i = nFirst; i < s_nSent; i++) {
+		if ((s_Sent[i].nToIp == group(nUniverse)) && (s_Sent[i].nLength >= DATA_PACKET_HEADER)) {
+			if (nCount++ == 0) {
+				nIndex = i;
+			}
+		}
+	}
+
+	return nCount;
+}
+
+static const struct TE131DataPacket *last_data(uint16_t nUniverse) {
+	for (unsigned i = s_nSent; i-- != 0;) {
+		if ((s_Sent[i].nToIp == group(nUniverse)) && (s_Sent[i].nLength >= DATA_PACKET_HEADER)) {
+			return (const struct TE131DataPacket *) s_Sent[i].Data;
+		}
+	}
+
+	return 0;
+}
+
+/**
+ * The PDU lengths follow the data length, and the packets are accepted by E131Bridge
+ */
+static void pdu_lengths(void) {
+	E131Controller Controller;
+	UnitTestLightSet LightSet;
+	E131Bridge Bridge(1);
+	uint8_t Data[E131_DMX_LENGTH];
+
+	Bridge.SetOutput(&LightSet);
+	millis_fake_advance(E131_SAMPLING_PERIOD_MILLIS);
+	Bridge.HandleTimers();
+
+	Controller.Start();
+	// The first frame starts a frame period after Start, a single universe is sent halfway its frame spread
+	run(Controller, 1000 / E131_CONTROLLER_DEFAULT_FPS);
+
+	const uint16_t Lengths[] = { 100, E131_DMX_LENGTH, 1 };
+
+	for (unsigned i = 0; i < sizeof(Lengths) / sizeof(Lengths[0]); i++) {
+		const uint16_t nLength = Lengths[i];
+
+		memset(Data, (int) (i + 1), sizeof(Data));
+		UNITTEST_CHECK(Controller.SetData(1, Data, nLength));
+
+		const unsigned nFirst = s_nSent;
+		run(Controller, 1000 / E131_CONTROLLER_DEFAULT_FPS);
+
+		unsigned nIndex;
+		UNITTEST_CHECK(count_data(1, nFirst, nIndex) == 1);
+
+		if (nIndex == s_nSent) {
+			continue;
+		}
+
+		const struct TSent *pSent = &s_Sent[nIndex];
+		const struct TE131DataPacket *pPacket = (const struct TE131DataPacket *) pSent->Data;
+
+		UNITTEST_CHECK(pSent->nLength == DATA_PACKET_HEADER + nLength);
+		UNITTEST_CHECK(pSent->nToPort == E131_DEFAULT_PORT);
+		UNITTEST_CHECK(pdu_length(pPacket->RootLayer.FlagsLength) == pSent->nLength - ROOT_LAYER_PREAMBLE);
+		UNITTEST_CHECK(pdu_length(pPacket->FrameLayer.FLagsLength) == pSent->nLength - sizeof(struct TRootLayer));
+		UNITTEST_CHECK(pdu_length(pPacket->DMPLayer.FlagsLength) == pSent->nLength - sizeof(struct TRootLayer) - sizeof(struct TDataFrameLayer));
+		UNITTEST_CHECK(__builtin_bswap16(pPacket->DMPLayer.PropertyValueCount) == nLength + 1);
+		UNITTEST_CHECK(__builtin_bswap16(pPacket->FrameLayer.Universe) == 1);
+
+		Bridge.HandleDatagram(pSent->Data, pSent->nLength, network_get_ip(), E131_DEFAULT_PORT);
+		UNITTEST_CHECK((LightSet.nLength[0] == nLength) && (LightSet.Data[0][nLength - 1] == i + 1));
+	}
+}
+
+/**
+ * A change is sent, then repeated E131_CONTROLLER_REPEAT times at the frame rate, then at the keep-alive rate.
+ * The sequence number of a universe increments with each packet.
+ */
+static void repeat_keepalive(void) {
+	E131Controller Controller;
+	uint8_t Data[E131_DMX_LENGTH];
+	const uint32_t nFrameMillis = 1000 / E131_CONTROLLER_DEFAULT_FPS;
+	const uint16_t nKeepAliveMillis = 1000;
+
+	memset(Data, 0, sizeof(Data));
+
+	Controller.SetKeepAlive(nKeepAliveMillis);
+	Controller.Start();
+	Controller.SetData(1, Data, sizeof(Data));
+	Controller.SetData(2, Data, sizeof(Data));
+
+	run(Controller, 3 * nKeepAliveMillis);
+
+	for (uint16_t nUniverse = 1; nUniverse <= 2; nUniverse++) {
+		uint32_t Millis[MAX_SENT];
+		uint8_t Sequence[MAX_SENT];
+		unsigned nCount = 0;
+
+		for (unsigned i = 0; i < s_nSent; i++) {
+			if (s_Sent[i].nToIp == group(nUniverse)) {
+				Millis[nCount] = s_Sent[i].nMillis;
+				Sequence[nCount] = ((const struct TE131DataPacket *) s_Sent[i].Data)->FrameLayer.SequenceNumber;
+				nCount++;
+			}
+		}
+
+		// 1 + E131_CONTROLLER_REPEAT at the frame rate, then at least 2 keep-alives
+		UNITTEST_CHECK(nCount >= 1 + E131_CONTROLLER_REPEAT + 2);
+
+		for (unsigned i = 1; i < nCount; i++) {
+			const uint32_t nInterval = Millis[i] - Millis[i - 1];
+
+			if (i <= E131_CONTROLLER_REPEAT) {
+				UNITTEST_CHECK(nInterval == nFrameMillis);
+			} else {
+				UNITTEST_CHECK((nInterval >= nKeepAliveMillis) && (nInterval < nKeepAliveMillis + nFrameMillis));
+			}
+
+			UNITTEST_CHECK(Sequence[i] == (uint8_t) (Sequence[i - 1] + 1));
+		}
+	}
+
+	// A change restarts the repeats
+	const unsigned nFirst = s_nSent;
+	Data[0] = 1;
+	Controller.SetData(1, Data, sizeof(Data));
+	run(Controller, (1 + E131_CONTROLLER_REPEAT) * nFrameMillis);
+
+	unsigned nIndex;
+	UNITTEST_CHECK(count_data(1, nFirst, nIndex) == 1 + E131_CONTROLLER_REPEAT);
+	UNITTEST_CHECK((last_data(1) != 0) && (last_data(1)->DMPLayer.PropertyValues[1] == 1));
+
+	// The universe discovery, once at the start and every interval
+	unsigned nDiscovery = 0;
+
+	for (unsigned i = 0; i < s_nSent; i++) {
+		if (s_Sent[i].nToIp == group(E131_UNIVERSE_DISCOVERY)) {
+			nDiscovery++;
+		}
+	}
+
+	UNITTEST_CHECK(nDiscovery == 1);
+}
+
+/**
+ * A frame with data ends with a synchronization packet, a frame without data has none
+ */
+static void synchronization(void) {
+	E131Controller Controller;
+	uint8_t Data[E131_DMX_LENGTH];
+	const uint32_t nFrameMillis = 1000 / E131_CONTROLLER_DEFAULT_FPS;
+
+	memset(Data, 0, sizeof(Data));
+
+	Controller.SetSynchronizationUniverse(7);
+	Controller.Start();
+	Controller.SetData(1, Data, sizeof(Data));
+	Controller.SetData(2, Data, sizeof(Data));
+
+	run(Controller, (2 + E131_CONTROLLER_REPEAT) * nFrameMillis);
+
+	unsigned nSyncs = 0;
+	uint8_t nSequence = 0;
+
+	for (unsigned i = 0; i < s_nSent; i++) {
+		if (s_Sent[i].nToIp != group(7)) {
+			continue;
+		}
+
+		const struct TE131SynchronizationPacket *pSync = (const struct TE131SynchronizationPacket *) s_Sent[i].Data;
+
+		UNITTEST_CHECK(s_Sent[i].nLength == sizeof(struct TE131SynchronizationPacket));
+		UNITTEST_CHECK(pdu_length(pSync->RootLayer.FlagsLength) == s_Sent[i].nLength - ROOT_LAYER_PREAMBLE);
+		UNITTEST_CHECK(pdu_length(pSync->FrameLayer.FLagsLength) == s_Sent[i].nLength - sizeof(struct TRootLayer));
+		UNITTEST_CHECK(__builtin_bswap16(pSync->FrameLayer.UniverseNumber) == 7);
+
+		// Both universes of the frame precede it
+		UNITTEST_CHECK((i >= 2) && (s_Sent[i - 1].nToIp == group(2)) && (s_Sent[i - 2].nToIp == group(1)));
+
+		if (nSyncs != 0) {
+			UNITTEST_CHECK(pSync->FrameLayer.SequenceNumber == (uint8_t) (nSequence + 1));
+		}
+
+		nSequence = pSync->FrameLayer.SequenceNumber;
+		nSyncs++;
+	}
+
+	UNITTEST_CHECK(nSyncs == 1 + E131_CONTROLLER_REPEAT);
+
+	const struct TE131DataPacket *pPacket = last_data(1);
+	UNITTEST_CHECK((pPacket != 0) && (__builtin_bswap16(pPacket->FrameLayer.Reserved) == 7));
+}
+
+/**
+ * Stop sends three Stream_Terminated packets per universe
+ */
+static void stop(void) {
+	E131Controller Controller;
+	uint8_t Data[E131_DMX_LENGTH];
+
+	memset(Data, 0, sizeof(Data));
+
+	Controller.Start();
+	Controller.SetData(1, Data, sizeof(Data));
+	run(Controller, 1000 / E131_CONTROLLER_DEFAULT_FPS);
+
+	const unsigned nFirst = s_nSent;
+	Controller.Stop();
+
+	unsigned nIndex;
+	UNITTEST_CHECK(count_data(1, nFirst, nIndex) == 3);
+
+	for (unsigned i = nFirst; i < s_nSent; i++) {
+		const struct TE131DataPacket *pPacket = (const struct TE131DataPacket *) s_Sent[i].Data;
+		UNITTEST_CHECK((pPacket->FrameLayer.Options & E131_OPTIONS_MASK_STREAM_TERMINATED) != 0);
+	}
+}
+
+void e131controller_test(void) {
+	void (*Tests[])(void) = { pdu_lengths, repeat_keepalive, synchronization, stop };
+
+	for (unsigned i = 0; i < sizeof(Tests) / sizeof(Tests[0]); i++) {
+		network_fake_reset();
+		network_fake_set_sendto(sendto);
+		s_nSent = 0;
+
+		Tests[i]();
+	}
+}
@@ -0,0 +1,90 @@
+/**
+ * @file e131discoverytest.cpp
+ *
+ */
+/* Copyright (C) 2018 by Arjan van Vught mailto:info@raspberrypi-dmx.nl
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <stdint.h>
+#include <string.h>
+
+#include "unittest.h"
+
+#include "e131.h"
+#include "e131packets.h"
+#include "e131discovery.h"
+
+static void add_page(E131DiscoveryTable &Table, uint8_t nCid, uint8_t nPage, uint8_t nLastPage, const uint16_t *pUniverses, uint16_t nUniverses, uint32_t nMillis = 0) {
+	struct TE131DiscoveryPacket Packet;
+	uint8_t Cid[E131_CID_LENGTH];
+
+	memset(Cid, nCid, sizeof(Cid));
+
+	const uint16_t nLength = e131_discovery_fill_page(&Packet, Cid, "e131discoverytest", nPage, nLastPage, pUniverses, nUniverses);
+	Table.Add(&Packet, nLength, nMillis);
+}
+
+void e131discovery_test(void) {
+	E131DiscoveryTable Table;
+
+	// Two pages, then the first page without universe 1
+	const uint16_t Page0[] = { 1, 2 };
+	const uint16_t Page1[] = { 5 };
+	const uint16_t Page0Changed[] = { 2 };
+
+	add_page(Table, 0xA0, 0, 1, Page0, 2);
+	add_page(Table, 0xA0, 1, 1, Page1, 1);
+	UNITTEST_CHECK(Table.GetSources() == 1);
+	UNITTEST_CHECK(Table.IsSent(1) && Table.IsSent(2) && Table.IsSent(5));
+	UNITTEST_CHECK(!Table.IsSent(3) && !Table.IsSent(6));
+
+	add_page(Table, 0xA0, 0, 1, Page0Changed, 1);
+	UNITTEST_CHECK(!Table.IsSent(1) && Table.IsSent(2) && Table.IsSent(5));
+
+	// A page after its last page is not valid
+	const uint16_t Invalid[] = { 7 };
+	add_page(Table, 0xA0, 2, 1, Invalid, 1);
+	UNITTEST_CHECK(!Table.IsSent(7));
+
+	// The bitmap of the first source is followed by the bitmap of the second source.
+	// A universe above E131_UNIVERSE_MAX, which is not the last page, must not reach it.
+	const uint16_t Second[] = { 1 };
+	const uint16_t Above[] = { 65535 };
+	const uint16_t Max[] = { E131_UNIVERSE_MAX };
+
+	add_page(Table, 0xB0, 0, 0, Second, 1);
+	UNITTEST_CHECK(Table.GetSources() == 2);
+
+	add_page(Table, 0xA0, 0, 1, Above, 1);
+	add_page(Table, 0xA0, 1, 1, Above, 1);
+	UNITTEST_CHECK(Table.IsSent(1));
+	UNITTEST_CHECK(!Table.IsSent(65535 - (E131_DISCOVERY_BITMAP_SIZE * 8)));
+	UNITTEST_CHECK(!Table.IsSent(2) && !Table.IsSent(5));
+
+	add_page(Table, 0xA0, 0, 1, Max, 1);
+	UNITTEST_CHECK(Table.IsSent(E131_UNIVERSE_MAX));
+
+	// Expired
+	add_page(Table, 0xB0, 0, 0, Second, 1, E131_DISCOVERY_EXPIRY_SECONDS * 1000);
+	UNITTEST_CHECK(Table.RemoveExpired(E131_DISCOVERY_EXPIRY_SECONDS * 1000 + 1) == 1);
+	UNITTEST_CHECK(Table.GetSources() == 1);
+	UNITTEST_CHECK(Table.IsSent(1) && !Table.IsSent(E131_UNIVERSE_MAX));
+}
@@ -0,0 +1,254 @@
+/**
+ * @file gatewaytest.cpp
+ *
+ */
+/* Copyright (C) 2018 by Arjan van Vught mailto:info@raspberrypi-dmx.nl
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <stdint.h>
+#include <string.h>
+
+#include "unittest.h"
+
+#include "gateway.h"
+
+#include "artnetnode.h"
+#include "packets.h"
+#include "e131.h"
+#include "e131packets.h"
+#include "e131bridge.h"
+#include "oscserver.h"
+
+#include "fakenetwork.h"
+#include "fakemillis.h"
+
+#define FROM_IP		0x0A02A8C0	///< 192.168.2.10
+
+static const uint8_t ACN_PACKET_IDENTIFIER[E131_PACKET_IDENTIFIER_LENGTH] = { 0x41, 0x53, 0x43, 0x2d, 0x45, 0x31, 0x2e, 0x31, 0x37, 0x00, 0x00, 0x00 };
+
+/**
+ * An ArtDmx of 512 slots, queued on the socket of ARTNET_UDP_PORT
+ */
+static void artdmx(uint8_t nUniverse, uint16_t nSlot, uint8_t nValue) {
+	struct TArtDmx Packet;
+
+	memset(&Packet, 0, sizeof(Packet));
+	memcpy(Packet.Id, "Art-Net", 8);
+	Packet.OpCode = OP_DMX;
+	Packet.ProtVerLo = 14;
+	Packet.PortAddress = nUniverse;
+	Packet.LengthHi = (uint8_t) (ARTNET_DMX_LENGTH >> 8);
+	Packet.Length = (uint8_t) ARTNET_DMX_LENGTH;
+	Packet.Data[nSlot] = nValue;
+
+	UNITTEST_CHECK(network_fake_receive(network_udp_begin(ARTNET_UDP_PORT), (const uint8_t *) &Packet, sizeof(Packet), FROM_IP, ARTNET_UDP_PORT));
+}
+
+/**
+ * An E1.31 data packet of 512 slots, queued on the socket of E131_DEFAULT_PORT
+ */
+static void e131(uint16_t nUniverse, uint8_t nSequence, uint8_t nOptions, uint16_t nSlot, uint8_t nValue) {
+	struct TE131DataPacket Packet;
+	const uint16_t nLength = (uint16_t) sizeof(struct TE131DataPacket);
+
+	memset(&Packet, 0, sizeof(Packet));
+
+	Packet.RootLayer.PreAmbleSize = __builtin_bswap16(0x10);
+	memcpy(Packet.RootLayer.ACNPacketIdentifier, ACN_PACKET_IDENTIFIER, E131_PACKET_IDENTIFIER_LENGTH);
+	Packet.RootLayer.FlagsLength = __builtin_bswap16((uint16_t) ((0x07 << 12) | (nLength - 16)));
+	Packet.RootLayer.Vector = __builtin_bswap32(E131_VECTOR_ROOT_DATA);
+	memset(Packet.RootLayer.Cid, 0xB0, E131_CID_LENGTH);
+
+	Packet.FrameLayer.FLagsLength = __builtin_bswap16((uint16_t) ((0x07 << 12) | (nLength - sizeof(struct TRootLayer))));
+	Packet.FrameLayer.Vector = __builtin_bswap32(E131_VECTOR_DATA_PACKET);
+	Packet.FrameLayer.Priority = DMX_MERGE_PRIORITY_DEFAULT;
+	Packet.FrameLayer.SequenceNumber = nSequence;
+	Packet.FrameLayer.Options = nOptions;
+	Packet.FrameLayer.Universe = __builtin_bswap16(nUniverse);
+
+	Packet.DMPLayer.FlagsLength = __builtin_bswap16((uint16_t) ((0x07 << 12) | (nLength - sizeof(struct TRootLayer) - sizeof(struct TDataFrameLayer))));
+	Packet.DMPLayer.Vector = E131_VECTOR_DMP_SET_PROPERTY;
+	Packet.DMPLayer.Type = 0xa1;
+	Packet.DMPLayer.AddressIncrement = __builtin_bswap16(1);
+	Packet.DMPLayer.PropertyValueCount = __builtin_bswap16(E131_DMX_LENGTH + 1);
+	Packet.DMPLayer.PropertyValues[1 + nSlot] = nValue;
+
+	UNITTEST_CHECK(network_fake_receive(network_udp_begin(E131_DEFAULT_PORT), (const uint8_t *) &Packet, nLength, FROM_IP, E131_DEFAULT_PORT));
+}
+
+/**
+ * /dmx1/<channel> with one int32 argument, queued on the socket of the OscServer
+ */
+static void osc(uint16_t nSlot, uint8_t nValue) {
+	uint8_t Packet[16];
+
+	memset(Packet, 0, sizeof(Packet));
+	memcpy(Packet, "/dmx1/", 6);
+	Packet[6] = (uint8_t) ('0' + nSlot + 1);	// Channels start at 1
+	memcpy(&Packet[8], ",i", 2);
+	Packet[15] = nValue;						// Big endian
+
+	UNITTEST_CHECK(network_fake_receive(network_udp_begin(OSCSERVER_DEFAULT_PORT_INCOMING), Packet, sizeof(Packet), FROM_IP, OSCSERVER_DEFAULT_PORT_OUTGOING));
+}
+
+/**
+ * Runs the gateway for \a nMillis, the waits without a datagram advance the clock.
+ * A Run that does not wait would never get there, the number of calls is limited.
+ */
+static void run(Gateway &Gw, uint32_t nMillis) {
+	const uint32_t nEnd = millis() + nMillis;
+	uint32_t nRuns = nMillis + NETWORK_MAX_SOCKETS * NETWORK_FAKE_QUEUE_SIZE;
+
+	while (((int32_t) (millis() - nEnd) < 0) && (nRuns-- != 0)) {
+		(void) Gw.Run();
+	}
+
+	UNITTEST_CHECK((int32_t) (millis() - nEnd) >= 0);
+}
+
+/**
+ * The engines are destroyed before the gateway, the gateway before its output
+ */
+struct TGatewayTest {
+	UnitTestLightSet LightSet;
+	Gateway Gw;
+	ArtNetNode Node;
+	E131Bridge Bridge;
+	OscServer Osc;
+
+	TGatewayTest(uint8_t nPorts): Gw(nPorts), Bridge(nPorts) {
+		for (uint8_t i = 0; i < nPorts; i++) {
+			(void) Node.SetUniverseSwitch(i, ARTNET_OUTPUT_PORT, (uint8_t) (1 + i));
+			(void) Bridge.SetUniverse(i, (uint16_t) (1 + i));
+		}
+
+		Gw.SetOutput(&LightSet);
+		Gw.SetArtNetNode(&Node);
+		Gw.SetE131Bridge(&Bridge);
+		Gw.SetOscServer(&Osc);
+
+		UNITTEST_CHECK(Gw.Start());
+
+		// The sampling period of the E131Bridge
+		run(Gw, E131_SAMPLING_PERIOD_MILLIS);
+	}
+};
+
+/**
+ * Each datagram reaches the engine of its socket, Run waits when nothing is pending
+ */
+static void dispatch(void) {
+	TGatewayTest Test(1);
+
+	artdmx(1, 0, 10);
+	e131(1, 1, 0, 1, 20);
+	osc(2, 30);
+
+	UNITTEST_CHECK(Test.Gw.Run() == 3);
+	run(Test.Gw, 1);
+
+	UNITTEST_CHECK(Test.LightSet.IsStarted);
+	UNITTEST_CHECK(Test.LightSet.Data[0][0] == 10);
+	UNITTEST_CHECK(Test.LightSet.Data[0][1] == 20);
+	UNITTEST_CHECK(Test.LightSet.Data[0][2] == 30);
+
+	const uint32_t nMillis = millis();
+	UNITTEST_CHECK(Test.Gw.Run() == 0);
+	UNITTEST_CHECK(millis() != nMillis);
+}
+
+/**
+ * A Run handles all the datagrams pending on each socket
+ */
+static void drain(void) {
+	TGatewayTest Test(1);
+
+	for (uint8_t i = 0; i < 10; i++) {
+		artdmx(1, 0, (uint8_t) (1 + i));
+		e131(1, (uint8_t) (1 + i), 0, 1, (uint8_t) (1 + i));
+	}
+
+	const uint32_t nMillis = millis();
+	UNITTEST_CHECK(Test.Gw.Run() == 20);
+	UNITTEST_CHECK(millis() == nMillis);
+
+	UNITTEST_CHECK(network_fake_get_pending(network_udp_begin(ARTNET_UDP_PORT)) == 0);
+	UNITTEST_CHECK(network_fake_get_pending(network_udp_begin(E131_DEFAULT_PORT)) == 0);
+
+	run(Test.Gw, 1);
+	UNITTEST_CHECK((Test.LightSet.Data[0][0] == 10) && (Test.LightSet.Data[0][1] == 10));
+}
+
+/**
+ * Port n of each protocol is merged into port n of the output, HTP by default
+ */
+static void merge(void) {
+	TGatewayTest Test(2);
+
+	artdmx(1, 0, 100);
+	e131(1, 1, 0, 0, 50);
+	run(Test.Gw, 1);
+	UNITTEST_CHECK(Test.LightSet.Data[0][0] == 100);
+
+	artdmx(1, 0, 10);
+	run(Test.Gw, 1);
+	UNITTEST_CHECK(Test.LightSet.Data[0][0] == 50);
+
+	artdmx(2, 0, 77);
+	run(Test.Gw, 1);
+	UNITTEST_CHECK(Test.LightSet.Data[1][0] == 77);
+	UNITTEST_CHECK(Test.LightSet.Data[0][0] == 50);
+
+	Test.Gw.SetMergeMode(DMX_MERGE_LTP);
+	e131(1, 2, 0, 0, 5);
+	run(Test.Gw, 1);
+	UNITTEST_CHECK(Test.LightSet.Data[0][0] == 5);
+}
+
+/**
+ * The source of a protocol is removed when its engine stops the output, Stop removes them all
+ */
+static void remove_sources(void) {
+	TGatewayTest Test(1);
+
+	artdmx(1, 0, 10);
+	e131(1, 1, 0, 0, 50);
+	run(Test.Gw, 1);
+	UNITTEST_CHECK(Test.LightSet.Data[0][0] == 50);
+
+	e131(1, 2, E131_OPTIONS_MASK_STREAM_TERMINATED, 0, 0);
+	run(Test.Gw, 1);
+	UNITTEST_CHECK(Test.LightSet.Data[0][0] == 10);
+	UNITTEST_CHECK(Test.LightSet.IsStarted);
+
+	Test.Gw.Stop();
+	UNITTEST_CHECK(!Test.LightSet.IsStarted);
+}
+
+void gateway_test(void) {
+	void (*Tests[])(void) = { dispatch, drain, merge, remove_sources };
+
+	for (unsigned i = 0; i < sizeof(Tests) / sizeof(Tests[0]); i++) {
+		network_fake_reset();
+
+		Tests[i]();
+	}
+}
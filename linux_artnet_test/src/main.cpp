@@ -0,0 +1,115 @@
+/**
+ * @file main.cpp
+ *
+ */
+/* Copyright (C) 2018 by Arjan van Vught mailto:info@raspberrypi-dmx.nl
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "replay.h"
+#include "dispatchbench.h"
+#include "unittest.h"
+#include "recorder.h"
+#include "pcap.h"
+
+static void usage(const char *pName) {
+	fprintf(stderr, "Usage: %s [-q] [-s] [-r repeat] [-w file.pcap] [-o directory] scenario...\n", pName);
+	fprintf(stderr, "       %s -b [rounds]\n", pName);
+	fprintf(stderr, "       %s -t\n", pName);
+	fprintf(stderr, "  -q  no output log\n");
+	fprintf(stderr, "  -s  packets per second and cost per OpCode, on stderr\n");
+	fprintf(stderr, "  -r  run the scenarios repeat times\n");
+	fprintf(stderr, "  -w  write the datagrams received to a pcap file\n");
+	fprintf(stderr, "  -o  write each datagram received to a file in directory, e.g. a fuzzing corpus\n");
+	fprintf(stderr, "  -b  the ArtDmx dispatch cost with 4, 32 and 64 output ports\n");
+	fprintf(stderr, "  -t  the E1.31 and Gateway unit tests\n");
+}
+
+int main(int argc, char **argv) {
+	bool IsStats = false;
+	unsigned nRepeat = 1;
+	const char *pPcapFile = 0;
+	const char *pSeedDirectory = 0;
+	int c;
+
+	while ((c = getopt(argc, argv, "btqsr:w:o:")) != -1) {
+		switch (c) {
+		case 'b':
+			dispatch_bench((optind < argc) ? (uint32_t) atoi(argv[optind]) : DISPATCH_BENCH_ROUNDS);
+			return 0;
+		case 't':
+			return (unittest_run() == 0) ? 0 : 1;
+		case 'q':
+			Recorder::SetQuiet(true);
+			break;
+		case 's':
+			IsStats = true;
+			break;
+		case 'r':
+			nRepeat = (unsigned) atoi(optarg);
+			break;
+		case 'w':
+			pPcapFile = optarg;
+			break;
+		case 'o':
+			pSeedDirectory = optarg;
+			break;
+		default:
+			usage(argv[0]);
+			return -1;
+		}
+	}
+
+	if (optind >= argc) {
+		usage(argv[0]);
+		return -1;
+	}
+
+	Replay replay;
+	PcapWriter writer;
+
+	if (pPcapFile != 0) {
+		if (!writer.Open(pPcapFile)) {
+			return -1;
+		}
+		replay.SetPcapWriter(&writer);
+	}
+
+	replay.SetSeedDirectory(pSeedDirectory);
+
+	for (unsigned n = 0; n < nRepeat; n++) {
+		for (int i = optind; i < argc; i++) {
+			if (!replay.Run(argv[i])) {
+				return 1;
+			}
+		}
+	}
+
+	if (IsStats) {
+		replay.DumpStats();
+	}
+
+	return 0;
+}
@@ -0,0 +1,338 @@
+/**
+ * @file pcap.cpp
+ *
+ */
+/* Copyright (C) 2018 by Arjan van Vught mailto:info@raspberrypi-dmx.nl
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+
+#include "pcap.h"
+
+enum {
+	PCAP_MAGIC_MICROS = 0xA1B2C3D4,
+	PCAP_MAGIC_NANOS = 0xA1B23C4D
+};
+
+enum {
+	ETHERTYPE_IPV4 = 0x0800,
+	ETHERTYPE_VLAN = 0x8100,
+	IP_PROTOCOL_UDP = 17,
+	IP_HEADER_SIZE = 20,
+	UDP_HEADER_SIZE = 8,
+	ETHERNET_HEADER_SIZE = 14
+};
+
+struct TPcapFileHeader {
+	uint32_t nMagic;
+	uint16_t nVersionMajor;
+	uint16_t nVersionMinor;
+	int32_t nThisZone;
+	uint32_t nSigFigs;
+	uint32_t nSnapLen;
+	uint32_t nLinkType;
+};
+
+struct TPcapRecordHeader {
+	uint32_t nSeconds;
+	uint32_t nFraction;		///< Microseconds or nanoseconds
+	uint32_t nCapturedLength;
+	uint32_t nLength;
+};
+
+static inline uint16_t get_be16(const uint8_t *p) {
+	return (uint16_t) ((p[0] << 8) | p[1]);
+}
+
+static inline void put_be16(uint8_t *p, uint16_t n) {
+	p[0] = (uint8_t) (n >> 8);
+	p[1] = (uint8_t) n;
+}
+
+PcapReader::PcapReader(void) : m_pFile(0), m_nLinkType(0), m_IsSwapped(false), m_IsNanoseconds(false), m_nSkipped(0) {
+}
+
+PcapReader::~PcapReader(void) {
+	Close();
+}
+
+bool PcapReader::Open(const char *pFileName) {
+	assert(pFileName != 0);
+
+	Close();
+
+	m_pFile = fopen(pFileName, "rb");
+
+	if (m_pFile == 0) {
+		perror(pFileName);
+		return false;
+	}
+
+	struct TPcapFileHeader tHeader;
+
+	if (fread(&tHeader, sizeof(struct TPcapFileHeader), 1, m_pFile) != 1) {
+		fprintf(stderr, "%s: not a pcap file\n", pFileName);
+		Close();
+		return false;
+	}
+
+	m_IsSwapped = (tHeader.nMagic == __builtin_bswap32(PCAP_MAGIC_MICROS)) || (tHeader.nMagic == __builtin_bswap32(PCAP_MAGIC_NANOS));
+
+	const uint32_t nMagic = Swap(tHeader.nMagic);
+
+	if ((nMagic != PCAP_MAGIC_MICROS) && (nMagic != PCAP_MAGIC_NANOS)) {
+		fprintf(stderr, "%s: not a pcap file (pcapng is not supported)\n", pFileName);
+		Close();
+		return false;
+	}
+
+	m_IsNanoseconds = (nMagic == PCAP_MAGIC_NANOS);
+	m_nLinkType = Swap(tHeader.nLinkType);
+	m_nSkipped = 0;
+
+	if ((m_nLinkType != PCAP_LINKTYPE_NULL) && (m_nLinkType != PCAP_LINKTYPE_ETHERNET) && (m_nLinkType != PCAP_LINKTYPE_RAW) && (m_nLinkType != PCAP_LINKTYPE_LINUX_SLL)) {
+		fprintf(stderr, "%s: link type %u is not supported\n", pFileName, m_nLinkType);
+		Close();
+		return false;
+	}
+
+	return true;
+}
+
+void PcapReader::Close(void) {
+	if (m_pFile != 0) {
+		fclose(m_pFile);
+		m_pFile = 0;
+	}
+}
+
+uint32_t PcapReader::Swap(uint32_t n) const {
+	return m_IsSwapped ? __builtin_bswap32(n) : n;
+}
+
+/**
+ * @return false at the end of the file
+ */
+bool PcapReader::Read(struct TPcapDatagram &tDatagram) {
+	if (m_pFile == 0) {
+		return false;
+	}
+
+	for (;;) {
+		struct TPcapRecordHeader tRecord;
+
+		if (fread(&tRecord, sizeof(struct TPcapRecordHeader), 1, m_pFile) != 1) {
+			return false;
+		}
+
+		const uint32_t nCaptured = Swap(tRecord.nCapturedLength);
+
+		if (nCaptured > PCAP_SNAPLEN) {
+			if (fseek(m_pFile, nCaptured, SEEK_CUR) != 0) {
+				return false;
+			}
+			m_nSkipped++;
+			continue;
+		}
+
+		if (fread(m_Frame, 1, nCaptured, m_pFile) != nCaptured) {
+			return false;
+		}
+
+		const uint32_t nFraction = Swap(tRecord.nFraction);
+		tDatagram.nMicros = (uint64_t) Swap(tRecord.nSeconds) * 1000000 + (m_IsNanoseconds ? nFraction / 1000 : nFraction);
+
+		if (Decode(m_Frame, nCaptured, tDatagram)) {
+			return true;
+		}
+
+		m_nSkipped++;
+	}
+}
+
+bool PcapReader::Decode(const uint8_t *pFrame, uint32_t nLength, struct TPcapDatagram &tDatagram) const {
+	uint32_t nOffset;
+	uint16_t nEtherType = ETHERTYPE_IPV4;
+
+	switch (m_nLinkType) {
+	case PCAP_LINKTYPE_NULL:
+		nOffset = 4;
+		break;
+	case PCAP_LINKTYPE_ETHERNET:
+		if (nLength < ETHERNET_HEADER_SIZE) {
+			return false;
+		}
+		nEtherType = get_be16(&pFrame[12]);
+		nOffset = ETHERNET_HEADER_SIZE;
+		if ((nEtherType == ETHERTYPE_VLAN) && (nLength >= ETHERNET_HEADER_SIZE + 4)) {
+			nEtherType = get_be16(&pFrame[16]);
+			nOffset += 4;
+		}
+		break;
+	case PCAP_LINKTYPE_LINUX_SLL:
+		if (nLength < 16) {
+			return false;
+		}
+		nEtherType = get_be16(&pFrame[14]);
+		nOffset = 16;
+		break;
+	default:
+		nOffset = 0;
+		break;
+	}
+
+	if ((nEtherType != ETHERTYPE_IPV4) || (nLength < nOffset + IP_HEADER_SIZE + UDP_HEADER_SIZE)) {
+		return false;
+	}
+
+	const uint8_t *pIp = &pFrame[nOffset];
+	const uint32_t nIpHeader = (uint32_t) (pIp[0] & 0x0F) * 4;
+
+	if (((pIp[0] >> 4) != 4) || (nIpHeader < IP_HEADER_SIZE) || (pIp[9] != IP_PROTOCOL_UDP)) {
+		return false;
+	}
+
+	// More fragments, or not the first fragment
+	if ((get_be16(&pIp[6]) & 0x3FFF) != 0) {
+		return false;
+	}
+
+	if (nLength < nOffset + nIpHeader + UDP_HEADER_SIZE) {
+		return false;
+	}
+
+	const uint8_t *pUdp = pIp + nIpHeader;
+	const uint16_t nUdpLength = get_be16(&pUdp[4]);
+
+	if ((nUdpLength < UDP_HEADER_SIZE) || ((nOffset + nIpHeader + nUdpLength) > nLength)) {
+		return false;
+	}
+
+	memcpy(&tDatagram.nFromIp, &pIp[12], 4);
+	memcpy(&tDatagram.nToIp, &pIp[16], 4);
+	tDatagram.nFromPort = get_be16(&pUdp[0]);
+	tDatagram.nToPort = get_be16(&pUdp[2]);
+	tDatagram.nLength = nUdpLength - UDP_HEADER_SIZE;
+	tDatagram.pData = pUdp + UDP_HEADER_SIZE;
+
+	return true;
+}
+
+PcapWriter::PcapWriter(void) : m_pFile(0), m_nId(0) {
+}
+
+PcapWriter::~PcapWriter(void) {
+	Close();
+}
+
+bool PcapWriter::Open(const char *pFileName) {
+	assert(pFileName != 0);
+
+	Close();
+
+	m_pFile = fopen(pFileName, "wb");
+
+	if (m_pFile == 0) {
+		perror(pFileName);
+		return false;
+	}
+
+	struct TPcapFileHeader tHeader;
+
+	tHeader.nMagic = PCAP_MAGIC_MICROS;
+	tHeader.nVersionMajor = 2;
+	tHeader.nVersionMinor = 4;
+	tHeader.nThisZone = 0;
+	tHeader.nSigFigs = 0;
+	tHeader.nSnapLen = PCAP_SNAPLEN;
+	tHeader.nLinkType = PCAP_LINKTYPE_ETHERNET;
+
+	if (fwrite(&tHeader, sizeof(struct TPcapFileHeader), 1, m_pFile) != 1) {
+		Close();
+		return false;
+	}
+
+	return true;
+}
+
+void PcapWriter::Close(void) {
+	if (m_pFile != 0) {
+		fclose(m_pFile);
+		m_pFile = 0;
+	}
+}
+
+void PcapWriter::Write(const struct TPcapDatagram &tDatagram) {
+	if (m_pFile == 0) {
+		return;
+	}
+
+	uint8_t Frame[ETHERNET_HEADER_SIZE + IP_HEADER_SIZE + UDP_HEADER_SIZE];
+	uint16_t nLength = tDatagram.nLength;
+
+	if (nLength > (PCAP_SNAPLEN - sizeof(Frame))) {
+		nLength = PCAP_SNAPLEN - sizeof(Frame);
+	}
+
+	memset(Frame, 0, sizeof(Frame));
+
+	// Ethernet : broadcast destination, locally administered source
+	memset(&Frame[0], 0xFF, 6);
+	Frame[6] = 0x02;
+	memcpy(&Frame[8], &tDatagram.nFromIp, 4);
+	put_be16(&Frame[12], ETHERTYPE_IPV4);
+
+	uint8_t *pIp = &Frame[ETHERNET_HEADER_SIZE];
+	pIp[0] = 0x45;
+	put_be16(&pIp[2], (uint16_t) (IP_HEADER_SIZE + UDP_HEADER_SIZE + nLength));
+	put_be16(&pIp[4], m_nId++);
+	pIp[8] = 64;
+	pIp[9] = IP_PROTOCOL_UDP;
+	memcpy(&pIp[12], &tDatagram.nFromIp, 4);
+	memcpy(&pIp[16], &tDatagram.nToIp, 4);
+
+	uint32_t nSum = 0;
+	for (unsigned i = 0; i < IP_HEADER_SIZE; i += 2) {
+		nSum += get_be16(&pIp[i]);
+	}
+	while ((nSum >> 16) != 0) {
+		nSum = (nSum & 0xFFFF) + (nSum >> 16);
+	}
+	put_be16(&pIp[10], (uint16_t) ~nSum);
+
+	uint8_t *pUdp = &pIp[IP_HEADER_SIZE];
+	put_be16(&pUdp[0], tDatagram.nFromPort);
+	put_be16(&pUdp[2], tDatagram.nToPort);
+	put_be16(&pUdp[4], (uint16_t) (UDP_HEADER_SIZE + nLength));	// The UDP checksum 0 is not used
+
+	struct TPcapRecordHeader tRecord;
+	tRecord.nSeconds = (uint32_t) (tDatagram.nMicros / 1000000);
+	tRecord.nFraction = (uint32_t) (tDatagram.nMicros % 1000000);
+	tRecord.nCapturedLength = sizeof(Frame) + nLength;
+	tRecord.nLength = tRecord.nCapturedLength;
+
+	fwrite(&tRecord, sizeof(struct TPcapRecordHeader), 1, m_pFile);
+	fwrite(Frame, 1, sizeof(Frame), m_pFile);
+	fwrite(tDatagram.pData, 1, nLength, m_pFile);
+}
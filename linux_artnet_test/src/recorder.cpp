@@ -0,0 +1,219 @@
+/**
+ * @file recorder.cpp
+ *
+ */
+/* Copyright (C) 2018 by Arjan van Vught mailto:info@raspberrypi-dmx.nl
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdarg.h>
+#include <string.h>
+#include <ctype.h>
+
+#include "recorder.h"
+
+#include "packets.h"
+#include "network.h"
+
+#include "fakemillis.h"
+
+static bool s_IsQuiet;
+static uint32_t s_nStartMillis;
+
+struct TOpCodeName {
+	uint16_t nOpCode;
+	const char *pName;
+};
+
+static const struct TOpCodeName s_OpCodeNames[] = {
+		{ OP_POLL, "OpPoll" },
+		{ OP_POLLREPLY, "OpPollReply" },
+		{ OP_DIAGDATA, "OpDiagData" },
+		{ OP_DMX, "OpDmx" },
+		{ OP_NZS, "OpNzs" },
+		{ OP_SYNC, "OpSync" },
+		{ OP_ADDRESS, "OpAddress" },
+		{ OP_TODREQUEST, "OpTodRequest" },
+		{ OP_TODDATA, "OpTodData" },
+		{ OP_TODCONTROL, "OpTodControl" },
+		{ OP_RDM, "OpRdm" },
+		{ OP_TIMECODE, "OpTimeCode" },
+		{ OP_TIMESYNC, "OpTimeSync" },
+		{ OP_TRIGGER, "OpTrigger" },
+		{ OP_IPPROG, "OpIpProg" },
+		{ OP_IPPROGREPLY, "OpIpProgReply" }
+};
+
+/**
+ * FNV-1a, to compare all the slots in one golden line
+ */
+static uint32_t hash(const uint8_t *pData, uint16_t nLength) {
+	uint32_t h = 2166136261U;
+
+	for (unsigned i = 0; i < nLength; i++) {
+		h = (h ^ pData[i]) * 16777619U;
+	}
+
+	return h;
+}
+
+Recorder::Recorder(void) {
+}
+
+Recorder::~Recorder(void) {
+}
+
+void Recorder::SetQuiet(bool IsQuiet) {
+	s_IsQuiet = IsQuiet;
+}
+
+void Recorder::SetStartMillis(uint32_t nMillis) {
+	s_nStartMillis = nMillis;
+}
+
+void Recorder::Printf(const char *pFormat, ...) {
+	if (s_IsQuiet) {
+		return;
+	}
+
+	va_list arp;
+
+	printf("[%6u] ", millis() - s_nStartMillis);
+
+	va_start(arp, pFormat);
+	vprintf(pFormat, arp);
+	va_end(arp);
+
+	putchar('\n');
+}
+
+const char *Recorder::GetOpCodeName(uint16_t nOpCode) {
+	for (unsigned i = 0; i < sizeof(s_OpCodeNames) / sizeof(s_OpCodeNames[0]); i++) {
+		if (s_OpCodeNames[i].nOpCode == nOpCode) {
+			return s_OpCodeNames[i].pName;
+		}
+	}
+
+	return "OpNotDefined";
+}
+
+/**
+ * The OpCode of a datagram, OP_NOT_DEFINED when the Id is not Art-Net
+ */
+uint16_t Recorder::GetOpCode(const uint8_t *pData, uint16_t nLength) {
+	if ((nLength < 10) || (memcmp(pData, "Art-Net", 8) != 0)) {
+		return OP_NOT_DEFINED;
+	}
+
+	return (uint16_t) (pData[8] | (pData[9] << 8));
+}
+
+void Recorder::SendTo(const uint8_t *pData, uint16_t nLength, uint32_t nToIp, uint16_t nToPort) {
+	const uint16_t nOpCode = GetOpCode(pData, nLength);
+
+	if (nOpCode == OP_DMX) {
+		const struct TArtDmx *pDmx = (const struct TArtDmx *) pData;
+		Printf("tx %s " IPSTR ":%u length %u port-address %u", GetOpCodeName(nOpCode), IP2STR(nToIp), (unsigned) nToPort, (unsigned) nLength, (unsigned) pDmx->PortAddress);
+	} else {
+		Printf("tx %s " IPSTR ":%u length %u", GetOpCodeName(nOpCode), IP2STR(nToIp), (unsigned) nToPort, (unsigned) nLength);
+	}
+}
+
+void Recorder::Data(const char *pPrefix, uint8_t nPort, const uint8_t *pData, uint16_t nLength) {
+	char Slots[3 * 8 + 1];
+	unsigned nOffset = 0;
+
+	Slots[0] = '\0';
+
+	for (unsigned i = 0; (i < 8) && (i < nLength); i++) {
+		nOffset += (unsigned) snprintf(&Slots[nOffset], sizeof(Slots) - nOffset, " %.2x", pData[i]);
+	}
+
+	Printf("%s port %u length %u hash %.8x :%s", pPrefix, (unsigned) nPort, (unsigned) nLength, hash(pData, nLength), Slots);
+}
+
+void Recorder::Start(void) {
+	Printf("Start");
+}
+
+void Recorder::Stop(void) {
+	Printf("Stop");
+}
+
+void Recorder::SetData(uint8_t nPort, const uint8_t *pData, uint16_t nLength) {
+	Data("SetData", nPort, pData, nLength);
+}
+
+void Recorder::SetDataRange(uint8_t nPort, const uint8_t *pData, uint16_t nLength, uint16_t nFirstDirty, uint16_t nLastDirty) {
+	char Prefix[32];
+
+	snprintf(Prefix, sizeof(Prefix), "SetDataRange %u..%u", (unsigned) nFirstDirty, (unsigned) nLastDirty);
+	Data(Prefix, nPort, pData, nLength);
+}
+
+void Recorder::Sync(void) {
+	Printf("Sync");
+}
+
+void Recorder::SetStartCodeData(uint8_t nPort, uint8_t nStartCode, const uint8_t *pData, uint16_t nLength) {
+	char Prefix[32];
+
+	snprintf(Prefix, sizeof(Prefix), "SetStartCodeData %.2x", (unsigned) nStartCode);
+	Data(Prefix, nPort, pData, nLength);
+}
+
+TriggerRecorder::TriggerRecorder(void) {
+}
+
+TriggerRecorder::~TriggerRecorder(void) {
+}
+
+void TriggerRecorder::Handler(const struct TArtNetTrigger *pTrigger) {
+	char Text[17];
+	unsigned i;
+
+	for (i = 0; (i < sizeof(Text) - 1) && (pTrigger->Data[i] != 0); i++) {
+		Text[i] = isprint(pTrigger->Data[i]) ? (char) pTrigger->Data[i] : '.';
+	}
+
+	Text[i] = '\0';
+
+	Recorder::Printf("Trigger key %u subkey %u data \"%s\" hash %.8x", (unsigned) pTrigger->Key, (unsigned) pTrigger->SubKey, Text, hash(pTrigger->Data, sizeof(pTrigger->Data)));
+}
+
+TimeCodeRecorder::TimeCodeRecorder(void) {
+}
+
+TimeCodeRecorder::~TimeCodeRecorder(void) {
+}
+
+void TimeCodeRecorder::Start(void) {
+	Recorder::Printf("TimeCode Start");
+}
+
+void TimeCodeRecorder::Stop(void) {
+	Recorder::Printf("TimeCode Stop");
+}
+
+void TimeCodeRecorder::Handler(const struct TArtNetTimeCode *pTimeCode) {
+	Recorder::Printf("TimeCode %.2u:%.2u:%.2u.%.2u type %u", (unsigned) pTimeCode->Hours, (unsigned) pTimeCode->Minutes, (unsigned) pTimeCode->Seconds, (unsigned) pTimeCode->Frames, (unsigned) pTimeCode->Type);
+}
@@ -0,0 +1,567 @@
+/**
+ * @file replay.cpp
+ *
+ */
+/* Copyright (C) 2018 by Arjan van Vught mailto:info@raspberrypi-dmx.nl
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <assert.h>
+#include <arpa/inet.h>
+
+#include "replay.h"
+
+#include "artnetnode.h"
+#include "packets.h"
+
+#include "recorder.h"
+#include "pcap.h"
+
+#include "fakenetwork.h"
+#include "fakemillis.h"
+
+#define SEPARATORS		" \t\r\n"
+#define MAX_LINE		1024
+#define MAX_PATH		512
+
+static uint64_t nanos(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t) ts.tv_sec * 1000000000 + (uint64_t) ts.tv_nsec;
+}
+
+static bool next_number(uint32_t &nValue) {
+	const char *pToken = strtok(0, SEPARATORS);
+
+	if (pToken == 0) {
+		return false;
+	}
+
+	char *pEnd;
+	nValue = (uint32_t) strtoul(pToken, &pEnd, 0);
+
+	return (*pEnd == '\0');
+}
+
+static bool next_ip(uint32_t &nIp) {
+	const char *pToken = strtok(0, SEPARATORS);
+
+	return (pToken != 0) && (inet_pton(AF_INET, pToken, &nIp) == 1);
+}
+
+/**
+ * The remaining values of the line, the last value fills up to \a nLength
+ */
+static bool next_values(uint8_t *pData, uint16_t nLength) {
+	const char *pToken;
+	uint16_t nCount = 0;
+	uint8_t nValue = 0;
+
+	while ((pToken = strtok(0, SEPARATORS)) != 0) {
+		char *pEnd;
+		nValue = (uint8_t) strtoul(pToken, &pEnd, 0);
+
+		if (*pEnd != '\0') {
+			return false;
+		}
+
+		if (nCount < nLength) {
+			pData[nCount++] = nValue;
+		}
+	}
+
+	while (nCount < nLength) {
+		pData[nCount++] = nValue;
+	}
+
+	return true;
+}
+
+static void set_header(uint8_t *pPacket, uint16_t nOpCode) {
+	memcpy(pPacket, "Art-Net", 8);
+	pPacket[8] = (uint8_t) nOpCode;
+	pPacket[9] = (uint8_t) (nOpCode >> 8);
+	pPacket[10] = 0;		// ProtVerHi
+	pPacket[11] = 14;		// ProtVerLo
+}
+
+Replay::Replay(void) :
+		m_pNode(0),
+		m_pPcapWriter(0),
+		m_pSeedDirectory(0),
+		m_nSeeds(0),
+		m_pFileName(0),
+		m_nLine(0),
+		m_IsDeferred(false),
+		m_nPackets(0),
+		m_nNanos(0),
+		m_nBatchPackets(0),
+		m_nBatchNanos(0),
+		m_nOpCodes(0)
+{
+	memset(m_OpCodeStats, 0, sizeof(m_OpCodeStats));
+}
+
+Replay::~Replay(void) {
+	delete m_pNode;
+	m_pNode = 0;
+}
+
+void Replay::SetPcapWriter(PcapWriter *pPcapWriter) {
+	m_pPcapWriter = pPcapWriter;
+}
+
+void Replay::SetSeedDirectory(const char *pSeedDirectory) {
+	m_pSeedDirectory = pSeedDirectory;
+}
+
+/**
+ * @return false when the scenario could not be read, or has an error
+ */
+bool Replay::Run(const char *pFileName) {
+	FILE *pFile = fopen(pFileName, "r");
+
+	if (pFile == 0) {
+		perror(pFileName);
+		return false;
+	}
+
+	network_fake_reset();
+	network_fake_set_sendto(Recorder::SendTo);
+	millis_fake_set((uint64_t) REPLAY_START_MILLIS * 1000);
+	Recorder::SetStartMillis(REPLAY_START_MILLIS);
+
+	m_pFileName = pFileName;
+	m_nLine = 0;
+	m_IsDeferred = false;
+
+	char Line[MAX_LINE];
+	bool IsOk = true;
+
+	while (IsOk && (fgets(Line, sizeof(Line), pFile) != 0)) {
+		m_nLine++;
+
+		char *pComment = strchr(Line, '#');
+		if (pComment != 0) {
+			*pComment = '\0';
+		}
+
+		IsOk = Command(Line);
+	}
+
+	fclose(pFile);
+
+	if (IsOk && m_IsDeferred) {
+		Batch(ARTNET_MAX_BATCH);
+	}
+
+	Recorder::Printf("# end of %s", pFileName);
+
+	delete m_pNode;
+	m_pNode = 0;
+
+	return IsOk;
+}
+
+bool Replay::CreateNode(uint8_t nPages) {
+	if (m_pNode != 0) {
+		return false;
+	}
+
+	m_pNode = new ArtNetNode(nPages);
+	assert(m_pNode != 0);
+
+	m_pNode->SetOutput(&m_Recorder);
+	m_pNode->SetTriggerHandler(&m_TriggerRecorder);
+	m_pNode->SetTimeCodeHandler(&m_TimeCodeRecorder);
+
+	return true;
+}
+
+bool Replay::Command(char *pLine) {
+	const char *pCommand = strtok(pLine, SEPARATORS);
+
+	if (pCommand == 0) {
+		return true;
+	}
+
+	if ((m_pNode == 0) && (strcmp(pCommand, "pages") != 0)) {
+		CreateNode(1);
+	}
+
+	uint8_t Packet[NETWORK_FAKE_DATAGRAM_SIZE];
+	uint32_t nIp = 0, a = 0, b = 0, c = 0, d = 0, e = 0;
+	bool IsOk = true;
+
+	memset(Packet, 0, sizeof(Packet));
+
+	if (strcmp(pCommand, "pages") == 0) {
+		IsOk = next_number(a) && CreateNode((uint8_t) a);
+	} else if ((strcmp(pCommand, "output") == 0) || (strcmp(pCommand, "input") == 0)) {
+		IsOk = next_number(a) && next_number(b);
+		if (IsOk) {
+			IsOk = m_pNode->SetUniverseSwitch((uint8_t) a, (pCommand[0] == 'o') ? ARTNET_OUTPUT_PORT : ARTNET_INPUT_PORT, (uint8_t) b) == 0;
+		}
+	} else if ((strcmp(pCommand, "net") == 0) || (strcmp(pCommand, "subnet") == 0)) {
+		IsOk = next_number(a);
+		if (!next_number(b)) {
+			b = 0;
+		}
+		if (IsOk && (pCommand[0] == 'n')) {
+			m_pNode->SetNetSwitch((uint8_t) a, (uint8_t) b);
+		} else if (IsOk) {
+			m_pNode->SetSubnetSwitch((uint8_t) a, (uint8_t) b);
+		}
+	} else if (strcmp(pCommand, "direct") == 0) {
+		IsOk = next_number(a);
+		m_pNode->SetDirectUpdate(a != 0);
+	} else if (strcmp(pCommand, "timeout") == 0) {
+		IsOk = next_number(a);
+		m_pNode->SetNetworkTimeoutMillis(a);
+	} else if (strcmp(pCommand, "deadline") == 0) {
+		IsOk = next_number(a);
+		m_pNode->SetFrameDeadline((uint16_t) a);
+	} else if (strcmp(pCommand, "synctimeout") == 0) {
+		IsOk = next_number(a);
+		m_pNode->SetSyncTimeout((uint16_t) a);
+	} else if (strcmp(pCommand, "backoff") == 0) {
+		IsOk = next_number(a);
+		m_pNode->SetPollReplyBackoff((uint16_t) a);
+	} else if (strcmp(pCommand, "policy") == 0) {
+		const char *pPolicy = strtok(0, SEPARATORS);
+		if (!next_number(a)) {
+			a = DMX_LOSS_POLICY_FADE_MILLIS;
+		}
+		if (pPolicy == 0) {
+			IsOk = false;
+		} else if (strcmp(pPolicy, "hold") == 0) {
+			m_pNode->SetLossPolicy(DMX_LOSS_POLICY_HOLD, a);
+		} else if (strcmp(pPolicy, "fade") == 0) {
+			m_pNode->SetLossPolicy(DMX_LOSS_POLICY_FADE, a);
+		} else if (strcmp(pPolicy, "preset") == 0) {
+			m_pNode->SetLossPolicy(DMX_LOSS_POLICY_PRESET, a);
+		} else if (strcmp(pPolicy, "blackout") == 0) {
+			m_pNode->SetLossPolicy(DMX_LOSS_POLICY_BLACKOUT, a);
+		} else {
+			IsOk = false;
+		}
+	} else if (strcmp(pCommand, "preset") == 0) {
+		IsOk = next_number(a) && next_values(Packet, ARTNET_DMX_LENGTH) && m_pNode->SetLossPreset((uint8_t) a, Packet, ARTNET_DMX_LENGTH);
+	} else if (strcmp(pCommand, "start") == 0) {
+		m_pNode->Start();
+	} else if (strcmp(pCommand, "dmx") == 0) {
+		// dmx <ip> <port-address> <length> <values>
+		struct TArtDmx *pDmx = (struct TArtDmx *) Packet;
+		IsOk = next_ip(nIp) && next_number(a) && next_number(b) && (b <= ARTNET_DMX_LENGTH) && next_values(pDmx->Data, (uint16_t) b);
+		if (IsOk) {
+			set_header(Packet, OP_DMX);
+			pDmx->PortAddress = (uint16_t) a;
+			pDmx->LengthHi = (uint8_t) (b >> 8);
+			pDmx->Length = (uint8_t) b;
+			Receive(Packet, (uint16_t) (sizeof(struct TArtDmx) - ARTNET_DMX_LENGTH + b), nIp);
+		}
+	} else if (strcmp(pCommand, "nzs") == 0) {
+		// nzs <ip> <port-address> <start code> <length> <values>
+		struct TArtNzs *pNzs = (struct TArtNzs *) Packet;
+		IsOk = next_ip(nIp) && next_number(a) && next_number(b) && next_number(c) && (c <= ARTNET_DMX_LENGTH) && next_values(pNzs->Data, (uint16_t) c);
+		if (IsOk) {
+			set_header(Packet, OP_NZS);
+			pNzs->StartCode = (uint8_t) b;
+			pNzs->PortAddress = (uint16_t) a;
+			pNzs->LengthHi = (uint8_t) (c >> 8);
+			pNzs->Length = (uint8_t) c;
+			Receive(Packet, (uint16_t) (sizeof(struct TArtNzs) - ARTNET_DMX_LENGTH + c), nIp);
+		}
+	} else if (strcmp(pCommand, "sync") == 0) {
+		IsOk = next_ip(nIp);
+		if (IsOk) {
+			set_header(Packet, OP_SYNC);
+			Receive(Packet, sizeof(struct TArtSync), nIp);
+		}
+	} else if (strcmp(pCommand, "poll") == 0) {
+		// poll <ip> [talk to me]
+		IsOk = next_ip(nIp);
+		if (IsOk) {
+			set_header(Packet, OP_POLL);
+			Packet[12] = next_number(a) ? (uint8_t) a : 0;
+			Receive(Packet, sizeof(struct TArtPoll), nIp);
+		}
+	} else if (strcmp(pCommand, "address") == 0) {
+		// address <ip> <command>
+		struct TArtAddress *pAddress = (struct TArtAddress *) Packet;
+		IsOk = next_ip(nIp) && next_number(a);
+		if (IsOk) {
+			set_header(Packet, OP_ADDRESS);
+			pAddress->NetSwitch = 0x7F;
+			memset(pAddress->SwIn, 0x7F, sizeof(pAddress->SwIn));
+			memset(pAddress->SwOut, 0x7F, sizeof(pAddress->SwOut));
+			pAddress->SubSwitch = 0x7F;
+			pAddress->Command = (uint8_t) a;
+			Receive(Packet, sizeof(struct TArtAddress), nIp);
+		}
+	} else if (strcmp(pCommand, "trigger") == 0) {
+		// trigger <ip> <oem> <key> <subkey> [text]
+		struct TArtTrigger *pTrigger = (struct TArtTrigger *) Packet;
+		IsOk = next_ip(nIp) && next_number(a) && next_number(b) && next_number(c);
+		if (IsOk) {
+			set_header(Packet, OP_TRIGGER);
+			pTrigger->OemCodeHi = (uint8_t) (a >> 8);
+			pTrigger->OemCodeLo = (uint8_t) a;
+			pTrigger->Key = (uint8_t) b;
+			pTrigger->SubKey = (uint8_t) c;
+			const char *pText = strtok(0, "\r\n");
+			uint16_t nLength = (uint16_t) __builtin_offsetof(struct TArtTrigger, Data);
+			if (pText != 0) {
+				while ((*pText == ' ') || (*pText == '\t')) {
+					pText++;
+				}
+				const size_t nText = strnlen(pText, sizeof(pTrigger->Data));
+				memcpy(pTrigger->Data, pText, nText);
+				nLength = (uint16_t) (nLength + nText);
+			}
+			Receive(Packet, nLength, nIp);
+		}
+	} else if (strcmp(pCommand, "timecode") == 0) {
+		// timecode <ip> <hours> <minutes> <seconds> <frames> <type>
+		struct TArtTimeCode *pTimeCode = (struct TArtTimeCode *) Packet;
+		IsOk = next_ip(nIp) && next_number(a) && next_number(b) && next_number(c) && next_number(d) && next_number(e);
+		if (IsOk) {
+			set_header(Packet, OP_TIMECODE);
+			pTimeCode->Hours = (uint8_t) a;
+			pTimeCode->Minutes = (uint8_t) b;
+			pTimeCode->Seconds = (uint8_t) c;
+			pTimeCode->Frames = (uint8_t) d;
+			pTimeCode->Type = (uint8_t) e;
+			Receive(Packet, sizeof(struct TArtTimeCode), nIp);
+		}
+	} else if (strcmp(pCommand, "raw") == 0) {
+		// raw <ip> <bytes>, the datagram as captured
+		const char *pToken;
+		uint16_t nLength = 0;
+		IsOk = next_ip(nIp);
+		while (IsOk && ((pToken = strtok(0, SEPARATORS)) != 0)) {
+			char *pEnd;
+			Packet[nLength++] = (uint8_t) strtoul(pToken, &pEnd, 16);
+			IsOk = (*pEnd == '\0') && (nLength < sizeof(Packet));
+		}
+		if (IsOk) {
+			Receive(Packet, nLength, nIp);
+		}
+	} else if (strcmp(pCommand, "wait") == 0) {
+		IsOk = next_number(a);
+		Wait(a);
+	} else if (strcmp(pCommand, "defer") == 0) {
+		m_IsDeferred = true;
+	} else if (strcmp(pCommand, "batch") == 0) {
+		if (!next_number(a)) {
+			a = ARTNET_MAX_BATCH;
+		}
+		Batch((uint16_t) a);
+	} else if (strcmp(pCommand, "pcap") == 0) {
+		const char *pName = strtok(0, SEPARATORS);
+		IsOk = (pName != 0) && ReplayPcap(pName);
+	} else if (strcmp(pCommand, "invalid") == 0) {
+		Recorder::Printf("PacketsInvalid %u", m_pNode->GetPacketsInvalid());
+	} else if (strcmp(pCommand, "syncstats") == 0) {
+		struct TArtNetSyncStats tStats;
+		m_pNode->GetSyncStats(tStats);
+		Recorder::Printf("SyncStats sync %u fallback %u dmx/frame %u", tStats.nFramesSync, tStats.nFramesFallback, (unsigned) tStats.nDmxPerFrame);
+	} else if (strcmp(pCommand, "echo") == 0) {
+		const char *pText = strtok(0, "\r\n");
+		Recorder::Printf("# %s", (pText != 0) ? pText : "");
+	} else {
+		IsOk = false;
+	}
+
+	if (!IsOk) {
+		fprintf(stderr, "%s:%u: error in '%s'\n", m_pFileName, m_nLine, pCommand);
+	}
+
+	return IsOk;
+}
+
+/**
+ * The pcap file name is relative to the scenario file
+ */
+bool Replay::ReplayPcap(const char *pFileName) {
+	char Path[MAX_PATH];
+	const char *pSlash = strrchr(m_pFileName, '/');
+
+	if ((pFileName[0] != '/') && (pSlash != 0)) {
+		snprintf(Path, sizeof(Path), "%.*s/%s", (int) (pSlash - m_pFileName), m_pFileName, pFileName);
+	} else {
+		snprintf(Path, sizeof(Path), "%s", pFileName);
+	}
+
+	PcapReader Reader;
+
+	if (!Reader.Open(Path)) {
+		return false;
+	}
+
+	struct TPcapDatagram tDatagram;
+	uint64_t nFirstMicros = 0;
+	const uint32_t nStartMillis = millis();
+	bool IsFirst = true;
+
+	while (Reader.Read(tDatagram)) {
+		if (tDatagram.nToPort != ARTNET_UDP_PORT) {
+			continue;
+		}
+
+		if (IsFirst) {
+			nFirstMicros = tDatagram.nMicros;
+			IsFirst = false;
+		}
+
+		// The timers run each millisecond of the capture
+		const uint32_t nMillis = nStartMillis + (uint32_t) ((tDatagram.nMicros - nFirstMicros) / 1000);
+
+		if ((int32_t) (nMillis - millis()) > 0) {
+			Wait(nMillis - millis());
+		}
+
+		Receive(tDatagram.pData, tDatagram.nLength, tDatagram.nFromIp, tDatagram.nFromPort);
+	}
+
+	return true;
+}
+
+void Replay::Receive(const uint8_t *pData, uint16_t nLength, uint32_t nFromIp, uint16_t nFromPort) {
+	if (m_pPcapWriter != 0) {
+		struct TPcapDatagram tDatagram;
+
+		tDatagram.nMicros = millis_fake_get_micros();
+		tDatagram.nFromIp = nFromIp;
+		tDatagram.nFromPort = nFromPort;
+		tDatagram.nToIp = network_get_ip();
+		tDatagram.nToPort = ARTNET_UDP_PORT;
+		tDatagram.nLength = nLength;
+		tDatagram.pData = pData;
+
+		m_pPcapWriter->Write(tDatagram);
+	}
+
+	if (m_pSeedDirectory != 0) {
+		char Path[MAX_PATH];
+
+		snprintf(Path, sizeof(Path), "%s/seed-%.4u", m_pSeedDirectory, m_nSeeds++);
+
+		FILE *pFile = fopen(Path, "wb");
+
+		if (pFile != 0) {
+			fwrite(pData, 1, nLength, pFile);
+			fclose(pFile);
+		}
+	}
+
+	if (m_IsDeferred && (network_fake_get_pending(0) == NETWORK_FAKE_QUEUE_SIZE)) {
+		Batch(ARTNET_MAX_BATCH);
+		m_IsDeferred = true;
+	}
+
+	network_fake_receive(0, pData, nLength, nFromIp, nFromPort);
+
+	if (m_IsDeferred) {
+		return;
+	}
+
+	const uint64_t nStart = nanos();
+	m_pNode->HandlePacket();
+	AddStats(Recorder::GetOpCode(pData, nLength), nanos() - nStart);
+}
+
+/**
+ * Runs the timers each millisecond
+ */
+void Replay::Wait(uint32_t nMillis) {
+	while (nMillis-- != 0) {
+		millis_fake_advance(1);
+		m_pNode->HandlePacket();
+	}
+}
+
+/**
+ * Handles the queued packets with HandlePackets, and leaves the deferred mode
+ */
+void Replay::Batch(uint16_t nMaxBatch) {
+	m_IsDeferred = false;
+
+	while (network_fake_get_pending(0) != 0) {
+		const uint64_t nStart = nanos();
+		const int nHandled = m_pNode->HandlePackets(nMaxBatch);
+		m_nBatchNanos += nanos() - nStart;
+		m_nBatchPackets += (uint32_t) nHandled;
+
+		Recorder::Printf("HandlePackets %d", nHandled);
+	}
+}
+
+void Replay::AddStats(uint16_t nOpCode, uint64_t nNanos) {
+	m_nPackets++;
+	m_nNanos += nNanos;
+
+	unsigned i;
+
+	for (i = 0; i < m_nOpCodes; i++) {
+		if (m_OpCodeStats[i].nOpCode == nOpCode) {
+			break;
+		}
+	}
+
+	if (i == m_nOpCodes) {
+		if (m_nOpCodes == REPLAY_MAX_OPCODES) {
+			return;
+		}
+		m_OpCodeStats[m_nOpCodes++].nOpCode = nOpCode;
+	}
+
+	m_OpCodeStats[i].nPackets++;
+	m_OpCodeStats[i].nNanos += nNanos;
+}
+
+/**
+ * Printed to stderr, the golden output on stdout does not depend on the host
+ */
+void Replay::DumpStats(void) const {
+	fprintf(stderr, "HandlePacket  : %u packets in %.3f ms", m_nPackets, (double) m_nNanos / 1e6);
+	if (m_nNanos != 0) {
+		fprintf(stderr, ", %.0f packets/s", (double) m_nPackets * 1e9 / (double) m_nNanos);
+	}
+	fputc('\n', stderr);
+
+	if (m_nBatchPackets != 0) {
+		fprintf(stderr, "HandlePackets : %u packets in %.3f ms, %.0f packets/s\n", m_nBatchPackets, (double) m_nBatchNanos / 1e6, (double) m_nBatchPackets * 1e9 / (double) m_nBatchNanos);
+	}
+
+	if (m_nOpCodes != 0) {
+		fprintf(stderr, "%-14s %10s %12s\n", "OpCode", "packets", "ns/packet");
+	}
+
+	for (unsigned i = 0; i < m_nOpCodes; i++) {
+		const struct TReplayOpCodeStats *pStats = &m_OpCodeStats[i];
+		fprintf(stderr, "%-14s %10u %12.0f\n", Recorder::GetOpCodeName(pStats->nOpCode), pStats->nPackets, (double) pStats->nNanos / pStats->nPackets);
+	}
+}
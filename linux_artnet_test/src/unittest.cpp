@@ -0,0 +1,116 @@
+/**
+ * @file unittest.cpp
+ *
+ */
+/* Copyright (C) 2018 by Arjan van Vught mailto:info@raspberrypi-dmx.nl
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "unittest.h"
+
+#include "fakenetwork.h"
+#include "fakemillis.h"
+
+struct TUnitTest {
+	const char *pName;
+	void (*pTest)(void);
+};
+
+static const struct TUnitTest s_Tests[] = {
+		{ "e131discovery", e131discovery_test },
+		{ "e131bridge", e131bridge_test },
+		{ "e131controller", e131controller_test },
+		{ "gateway", gateway_test }
+};
+
+static unsigned s_nFailed;
+
+UnitTestLightSet::UnitTestLightSet(void) {
+	Clear();
+}
+
+UnitTestLightSet::~UnitTestLightSet(void) {
+}
+
+void UnitTestLightSet::Start(void) {
+	IsStarted = true;
+}
+
+void UnitTestLightSet::Stop(void) {
+	IsStarted = false;
+}
+
+void UnitTestLightSet::SetData(uint8_t nPort, const uint8_t *pData, uint16_t nLength) {
+	if (nPort >= UNITTEST_PORTS) {
+		return;
+	}
+
+	if (nLength > sizeof(Data[0])) {
+		nLength = sizeof(Data[0]);
+	}
+
+	memcpy(Data[nPort], pData, nLength);
+	this->nLength[nPort] = nLength;
+	nOutputs[nPort]++;
+}
+
+void UnitTestLightSet::SetDataRange(uint8_t nPort, const uint8_t *pData, uint16_t nLength, uint16_t nFirstDirty, uint16_t nLastDirty) {
+	SetData(nPort, pData, nLength);
+}
+
+void UnitTestLightSet::Sync(void) {
+	nSyncs++;
+}
+
+void UnitTestLightSet::Clear(void) {
+	IsStarted = false;
+	nSyncs = 0;
+	memset(nOutputs, 0, sizeof(nOutputs));
+	memset(nLength, 0, sizeof(nLength));
+	memset(Data, 0, sizeof(Data));
+}
+
+void unittest_check(bool IsOk, const char *pExpression, const char *pFile, int nLine) {
+	if (!IsOk) {
+		printf("%s:%d: check failed '%s'\n", pFile, nLine, pExpression);
+		s_nFailed++;
+	}
+}
+
+unsigned unittest_run(void) {
+	unsigned nFailed = 0;
+
+	for (unsigned i = 0; i < sizeof(s_Tests) / sizeof(s_Tests[0]); i++) {
+		network_fake_reset();
+		millis_fake_set(0);
+
+		s_nFailed = 0;
+		s_Tests[i].pTest();
+
+		printf("%s %s\n", (s_nFailed == 0) ? "PASS" : "FAIL", s_Tests[i].pName);
+		nFailed += s_nFailed;
+	}
+
+	return nFailed;
+}
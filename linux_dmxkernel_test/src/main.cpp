@@ -0,0 +1,270 @@
+/**
+ * @file main.cpp
+ *
+ */
+/* Copyright (C) 2018 by Arjan van Vught mailto:info@raspberrypi-dmx.nl
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#if defined (__x86_64__) || defined (__i386__)
+ #include <x86intrin.h>
+#endif
+
+#include "dmxkernel.h"
+
+#define DMX_LENGTH		512
+#define MAX_OFFSET		16		///< The buffers are checked at each alignment within a block
+#define BUFFER_SIZE		(MAX_OFFSET + DMX_LENGTH + MAX_OFFSET)
+
+#define CHECK_ROUNDS	20000
+#define BENCH_ROUNDS	200000
+
+static unsigned s_nChecks;
+static unsigned s_nErrors;
+
+static uint32_t s_nRandom = 1;
+
+static uint8_t random_byte(void) {
+	// xorshift32, the same sequence on each host
+	s_nRandom ^= s_nRandom << 13;
+	s_nRandom ^= s_nRandom >> 17;
+	s_nRandom ^= s_nRandom << 5;
+	return (uint8_t) s_nRandom;
+}
+
+static unsigned random_below(unsigned n) {
+	return ((unsigned) random_byte() | ((unsigned) random_byte() << 8)) % n;
+}
+
+/*
+ * The byte at a time references
+ */
+
+static bool reference_dirty_range(const uint8_t *pA, const uint8_t *pB, uint16_t nLength, struct TDmxSlotRange *pRange) {
+	dmx_slot_range_clear(pRange);
+
+	for (unsigned i = 0; i < nLength; i++) {
+		if (pA[i] != pB[i]) {
+			dmx_slot_range_add(pRange, (uint16_t) i, (uint16_t) i);
+		}
+	}
+
+	return pRange->nFirst != DMX_SLOT_NONE;
+}
+
+static void reference_merge_htp(uint8_t *pDst, const uint8_t *pA, const uint8_t *pB, uint16_t nLength) {
+	for (unsigned i = 0; i < nLength; i++) {
+		pDst[i] = (pA[i] > pB[i]) ? pA[i] : pB[i];
+	}
+}
+
+static void check(bool IsOk, const char *pFunction, uint16_t nLength, unsigned nOffset) {
+	s_nChecks++;
+
+	if (!IsOk) {
+		if (s_nErrors < 10) {
+			fprintf(stderr, "%s : error with length %u offset %u\n", pFunction, (unsigned) nLength, nOffset);
+		}
+		s_nErrors++;
+	}
+}
+
+static bool is_same_range(bool IsChanged, const struct TDmxSlotRange *pRange, bool IsExpected, const struct TDmxSlotRange *pExpected) {
+	if (IsChanged != IsExpected) {
+		return false;
+	}
+
+	return !IsChanged || ((pRange->nFirst == pExpected->nFirst) && (pRange->nLast == pExpected->nLast));
+}
+
+/**
+ * Random data and lengths, unaligned buffers, and sparse changes : most blocks are equal
+ */
+static void check_variant(void) {
+	static uint8_t a[BUFFER_SIZE], b[BUFFER_SIZE], dst[BUFFER_SIZE], expected[BUFFER_SIZE];
+
+	for (unsigned nRound = 0; nRound < CHECK_ROUNDS; nRound++) {
+		const uint16_t nLength = (uint16_t) random_below(DMX_LENGTH + 1);
+		const unsigned nOffset = random_below(MAX_OFFSET);
+		uint8_t *pA = &a[nOffset];
+		uint8_t *pB = &b[random_below(MAX_OFFSET)];
+		uint8_t *pDst = &dst[random_below(MAX_OFFSET)];
+		struct TDmxSlotRange tRange, tExpected;
+
+		for (unsigned i = 0; i < BUFFER_SIZE; i++) {
+			a[i] = random_byte();
+			b[i] = random_byte();
+		}
+
+		if ((nRound & 1) != 0) {
+			// A few slots changed
+			memcpy(pB, pA, DMX_LENGTH);
+			for (unsigned n = random_below(4); n != 0; n--) {
+				pB[random_below(DMX_LENGTH)] ^= (uint8_t) (1 + random_below(255));
+			}
+		}
+
+		// dmx_kernel_dirty_range
+		const bool IsDirty = dmx_kernel_dirty_range(pA, pB, nLength, &tRange);
+		check(is_same_range(IsDirty, &tRange, reference_dirty_range(pA, pB, nLength, &tExpected), &tExpected), "dmx_kernel_dirty_range", nLength, nOffset);
+
+		// dmx_kernel_copy_changed, the slots beyond nLength are not written
+		memcpy(dst, b, BUFFER_SIZE);
+		memcpy(expected, dst, BUFFER_SIZE);
+		const bool IsExpected = reference_dirty_range(pDst, pA, nLength, &tExpected);
+		memcpy(&expected[pDst - dst], pA, nLength);
+		const bool IsChanged = dmx_kernel_copy_changed(pDst, pA, nLength, &tRange);
+		check(is_same_range(IsChanged, &tRange, IsExpected, &tExpected) && (memcmp(dst, expected, BUFFER_SIZE) == 0), "dmx_kernel_copy_changed", nLength, nOffset);
+
+		// dmx_kernel_merge_htp, the output partly merged already
+		memcpy(dst, a, BUFFER_SIZE);
+		if ((nRound & 2) != 0) {
+			reference_merge_htp(pDst, pA, pB, nLength);
+			pDst[random_below(DMX_LENGTH)] ^= 0x55;
+		}
+		memcpy(expected, dst, BUFFER_SIZE);
+		reference_merge_htp(&expected[pDst - dst], pA, pB, nLength);
+		const bool IsMergeExpected = reference_dirty_range(pDst, &expected[pDst - dst], nLength, &tExpected);
+		const bool IsMerged = dmx_kernel_merge_htp(pDst, pA, pB, nLength, &tRange);
+		check(is_same_range(IsMerged, &tRange, IsMergeExpected, &tExpected) && (memcmp(dst, expected, BUFFER_SIZE) == 0), "dmx_kernel_merge_htp", nLength, nOffset);
+
+		// dmx_kernel_copy_ltp
+		memcpy(dst, b, BUFFER_SIZE);
+		memcpy(expected, dst, BUFFER_SIZE);
+		memcpy(&expected[pDst - dst], pA, nLength);
+		dmx_kernel_copy_ltp(pDst, pA, nLength);
+		check(memcmp(dst, expected, BUFFER_SIZE) == 0, "dmx_kernel_copy_ltp", nLength, nOffset);
+	}
+
+	// All 256 x 256 values of the HTP maximum, these are the carries of the word variant
+	static uint8_t x[256 * 256], y[256 * 256], merged[256 * 256], merged_expected[256 * 256];
+
+	for (unsigned i = 0; i < 256 * 256; i++) {
+		x[i] = (uint8_t) i;
+		y[i] = (uint8_t) (i >> 8);
+	}
+
+	for (unsigned i = 0; i < 256 * 256; i += DMX_LENGTH) {
+		reference_merge_htp(&merged_expected[i], &x[i], &y[i], DMX_LENGTH);
+		(void) dmx_kernel_merge_htp(&merged[i], &x[i], &y[i], DMX_LENGTH, 0);
+	}
+
+	check(memcmp(merged, merged_expected, sizeof(merged)) == 0, "dmx_kernel_merge_htp all values", DMX_LENGTH, 0);
+}
+
+static inline uint64_t cycles(void) {
+#if defined (__x86_64__) || defined (__i386__)
+	return __rdtsc();
+#else
+	return 0;
+#endif
+}
+
+static uint64_t nanos(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t) ts.tv_sec * 1000000000 + (uint64_t) ts.tv_nsec;
+}
+
+static void report(const char *pFunction, uint64_t nCycles, uint64_t nNanos, unsigned nChanged) {
+	printf("%-8s %-32s %10.1f %10.1f %8u\n", dmx_kernel_get_variant(), pFunction, (double) nCycles / BENCH_ROUNDS, (double) nNanos / BENCH_ROUNDS, nChanged);
+}
+
+#define BENCH(pFunction, statement)																		\
+	do {																								\
+		unsigned nChanged = 0;																			\
+		const uint64_t nStartNanos = nanos();															\
+		const uint64_t nStartCycles = cycles();															\
+		for (unsigned nRound = 0; nRound < BENCH_ROUNDS; nRound++) {									\
+			statement;																					\
+		}																								\
+		const uint64_t nCycles = cycles() - nStartCycles;												\
+		report(pFunction, nCycles, nanos() - nStartNanos, nChanged);									\
+	} while (0)
+
+/**
+ * One universe per call. The data is changed each round where the case needs it, so that the calls are not hoisted.
+ */
+static void bench_variant(void) {
+	static uint8_t a[DMX_LENGTH], b[DMX_LENGTH], dst[DMX_LENGTH];
+	struct TDmxSlotRange tRange;
+
+	for (unsigned i = 0; i < DMX_LENGTH; i++) {
+		a[i] = random_byte();
+		b[i] = random_byte();
+	}
+
+	memcpy(dst, a, DMX_LENGTH);
+
+	BENCH("copy_changed, not changed", nChanged += dmx_kernel_copy_changed(dst, a, DMX_LENGTH, &tRange) ? 1 : 0; __asm__ __volatile__("" : : "r"(dst) : "memory"));
+	BENCH("copy_changed, one slot", a[nRound % DMX_LENGTH]++; nChanged += dmx_kernel_copy_changed(dst, a, DMX_LENGTH, &tRange) ? 1 : 0);
+	BENCH("copy_changed, all slots", a[nRound % DMX_LENGTH]++; nChanged += dmx_kernel_copy_changed(dst, (nRound & 1) ? a : b, DMX_LENGTH, &tRange) ? 1 : 0);
+	BENCH("merge_htp", a[nRound % DMX_LENGTH]++; nChanged += dmx_kernel_merge_htp(dst, a, b, DMX_LENGTH, &tRange) ? 1 : 0);
+	BENCH("copy_ltp", a[nRound % DMX_LENGTH]++; dmx_kernel_copy_ltp(dst, a, DMX_LENGTH); __asm__ __volatile__("" : : "r"(dst) : "memory"));
+	BENCH("dirty_range", b[nRound % DMX_LENGTH]++; nChanged += dmx_kernel_dirty_range(a, b, DMX_LENGTH, &tRange) ? 1 : 0);
+}
+
+static void usage(const char *pName) {
+	fprintf(stderr, "Usage: %s [-c] [-b]\n", pName);
+	fprintf(stderr, "  -c  check the variant against the byte at a time reference (default)\n");
+	fprintf(stderr, "  -b  cycles and ns per universe of each function\n");
+}
+
+int main(int argc, char **argv) {
+	bool IsCheck = false;
+	bool IsBench = false;
+	int c;
+
+	while ((c = getopt(argc, argv, "cb")) != -1) {
+		switch (c) {
+		case 'c':
+			IsCheck = true;
+			break;
+		case 'b':
+			IsBench = true;
+			break;
+		default:
+			usage(argv[0]);
+			return -1;
+		}
+	}
+
+	if (!IsBench) {
+		IsCheck = true;
+	}
+
+	if (IsCheck) {
+		check_variant();
+		printf("%-8s %u checks, %u errors\n", dmx_kernel_get_variant(), s_nChecks, s_nErrors);
+	}
+
+	if (IsBench) {
+		printf("%-8s %-32s %10s %10s %8s\n", "variant", "per universe (512 slots)", "cycles", "ns", "changed");
+		bench_variant();
+	}
+
+	return (s_nErrors == 0) ? 0 : 1;
+}
@@ -99,7 +99,6 @@ int main(int argc, char **argv) {
 	(void)inet_aton("239.255.0.0", &group_ip);
 	const uint16_t universe = e131params.GetUniverse();
 	group_ip.s_addr = group_ip.s_addr | ((uint32_t)(((uint32_t)universe & (uint32_t)0xFF) << 24)) | ((uint32_t)(((uint32_t)universe & (uint32_t)0xFF00) << 8));
-	network_joingroup(group_ip.s_addr);
 
 	E131Bridge bridge;
 
@@ -83,12 +83,12 @@ private:
 	ArtNetController *m_pArtNetController;
 	InputSet *m_pInput;
 	Display *m_pDisplay;
-	uint8_t	m_nStartIndex;
+	uint16_t m_nStartIndex;
 	TState m_State;
 	time_t m_nTimePrevious;
 	uint8_t	m_nCursorRow;
 	uint8_t	m_nCursorCol;
-	uint8_t m_ShowDetailIndex;
+	uint16_t m_ShowDetailIndex;
 	uint8_t m_IPAddress[4];
 	uint32_t m_nIPAddress;
 	uint8_t m_Submask[4];
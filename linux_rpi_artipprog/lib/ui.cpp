@@ -95,7 +95,7 @@ void Ui::Show(void) {
 
 void Ui::Update(void) {
 	uint8_t line = 1;
-	uint8_t i;
+	uint16_t i;
 
 	time_t now = time(NULL);
 
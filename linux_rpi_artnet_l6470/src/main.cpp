@@ -147,10 +147,10 @@ int main(int argc, char **argv) {
 	node.Start();
 
 	for (;;) {
-		int bytes = node.HandlePacket();
-		if (bytes > 0) {
+		const int packets = node.HandlePackets();
+		if (packets > 0) {
 #ifndef NDEBUG
-			printf("(%d)\n", bytes);
+			printf("(%d)\n", packets);
 #endif
 		}
 	}
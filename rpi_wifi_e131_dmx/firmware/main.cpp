@@ -128,7 +128,6 @@ void notmain(void) {
 	(void)inet_aton("239.255.0.0", &group_ip);
 	const uint16_t universe = e131params.GetUniverse();
 	group_ip.s_addr = group_ip.s_addr | ((uint32_t)(((uint32_t)universe & (uint32_t)0xFF) << 24)) | ((uint32_t)(((uint32_t)universe & (uint32_t)0xFF00) << 8));
-	network_joingroup(group_ip.s_addr);
 
 	bridge.setCid(uuid);
 	bridge.setUniverse(universe);